@@ -0,0 +1,143 @@
+// Checks KAsyncFile reads, writes & scatter/gather, and compares sequential read throughput at queue depth 1 and 8.
+
+#include "TestHelpers.h"
+#include <atomic>
+
+class AsyncFileTest : public KApplication
+{
+	const wchar_t* path = L"AsyncFileTest.bin";
+
+	// 128 MB in 128 KB requests.
+	enum { BlockSize = 128 * 1024, BlockCount = 1024 };
+
+	void testScatterGather() noexcept
+	{
+		KAsyncFile file;
+		RFC_TEST_CHECK(file.openFile(path, KFile::KBOTH, CREATE_ALWAYS));
+
+		BYTE parts[3][1000];
+		for (int i = 0; i < 3000; i++)
+			parts[i / 1000][i % 1000] = (BYTE)(i * 7);
+
+		const KAsyncFileBuffer writeBuffers[3] = { { parts[0], 1000 }, { parts[1], 1000 }, { parts[2], 1000 } };
+		std::atomic<DWORD> writtenSize{ 0 };
+		RFC_TEST_CHECK(file.writeGather(100, writeBuffers, 3, [&writtenSize](DWORD bytesTransferred, DWORD errorCode) {
+			writtenSize = (errorCode == ERROR_SUCCESS) ? bytesTransferred : 0;
+		}));
+		file.waitForIdle();
+		RFC_TEST_CHECK(writtenSize.load() == 3000);
+		RFC_TEST_CHECK(file.getFileSize() == 3100);
+
+		// other split than the write
+		BYTE first[1500], second[1500];
+		const KAsyncFileBuffer readBuffers[2] = { { first, 1500 }, { second, 1500 } };
+		std::atomic<DWORD> readSize{ 0 };
+		RFC_TEST_CHECK(file.readScatter(100, readBuffers, 2, [&readSize](DWORD bytesTransferred, DWORD errorCode) {
+			readSize = (errorCode == ERROR_SUCCESS) ? bytesTransferred : 0;
+		}));
+		file.waitForIdle();
+		RFC_TEST_CHECK(readSize.load() == 3000);
+		RFC_TEST_CHECK((::memcmp(first, parts[0], 1000) == 0) && (::memcmp(first + 1000, parts[1], 500) == 0));
+		RFC_TEST_CHECK((::memcmp(second, parts[1] + 500, 500) == 0) && (::memcmp(second + 500, parts[2], 1000) == 0));
+
+		std::atomic<DWORD> endError{ ERROR_SUCCESS };
+		RFC_TEST_CHECK(file.read(3100, first, 100, [&endError](DWORD bytesTransferred, DWORD errorCode) {
+			endError = errorCode;
+		}));
+		file.waitForIdle();
+		RFC_TEST_CHECK(endError.load() == ERROR_HANDLE_EOF);
+		RFC_TEST_CHECK(file.getPendingCount() == 0);
+
+		file.closeFile();
+		KFile::deleteFile(path);
+	}
+
+	// the file holds the uint32 index of each 4 byte word.
+	bool writeTestFile(uint32_t* data) noexcept
+	{
+		for (uint32_t i = 0; i < ((uint32_t)BlockSize / 4) * BlockCount; i++)
+			data[i] = i;
+
+		KAsyncFile file;
+		if (!file.openFile(path, KFile::KWRITE, CREATE_ALWAYS))
+			return false;
+
+		std::atomic<int> failedCount{ 0 };
+		for (int i = 0; i < BlockCount; i++)
+		{
+			file.write((uint64_t)i * BlockSize, (BYTE*)data + ((size_t)i * BlockSize), BlockSize, [&failedCount](DWORD bytesTransferred, DWORD errorCode) {
+				if ((errorCode != ERROR_SUCCESS) || (bytesTransferred != BlockSize))
+					failedCount++;
+			});
+		}
+
+		file.closeFile(); // waits for the writes
+		return failedCount.load() == 0;
+	}
+
+	// submits all the blocks at once. the file keeps at most queueDepth of them in flight.
+	double readTestFile(int queueDepth, uint32_t* data) noexcept
+	{
+		::memset(data, 0, (size_t)BlockSize * BlockCount);
+
+		KAsyncFile file;
+		RFC_TEST_CHECK(file.openFile(path, KFile::KREAD, OPEN_EXISTING));
+		file.setQueueDepth(queueDepth);
+		RFC_TEST_CHECK(file.getQueueDepth() == queueDepth);
+
+		std::atomic<int> failedCount{ 0 };
+
+		KPerformanceCounter counter;
+		counter.startCounter();
+
+		for (int i = 0; i < BlockCount; i++)
+		{
+			file.read((uint64_t)i * BlockSize, (BYTE*)data + ((size_t)i * BlockSize), BlockSize, [&failedCount](DWORD bytesTransferred, DWORD errorCode) {
+				if ((errorCode != ERROR_SUCCESS) || (bytesTransferred != BlockSize))
+					failedCount++;
+			});
+		}
+
+		file.waitForIdle();
+		const double milliseconds = counter.endCounter();
+
+		RFC_TEST_CHECK(failedCount.load() == 0);
+
+		int wrongCount = 0;
+		for (uint32_t i = 0; i < ((uint32_t)BlockSize / 4) * BlockCount; i++)
+			wrongCount += (data[i] == i) ? 0 : 1;
+		RFC_TEST_CHECK(wrongCount == 0);
+
+		return milliseconds;
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		testScatterGather();
+
+		uint32_t* data = (uint32_t*)::malloc((size_t)BlockSize * BlockCount);
+		RFC_TEST_CHECK(writeTestFile(data));
+
+		// the file was just written, so it is read from the system cache. this measures the request pipeline, not the disk.
+		const double megabytes = ((double)BlockSize * BlockCount) / (1024.0 * 1024.0);
+		::printf("sequential read, %.0f MB in %d KB requests:\n", megabytes, BlockSize / 1024);
+
+		const int queueDepths[] = { 1, 8 };
+		for (int i = 0; i < 2; i++)
+		{
+			char name[64];
+			::sprintf(name, "queue depth %d", queueDepths[i]);
+
+			const double milliseconds = readTestFile(queueDepths[i], data);
+			::printf("  %-40s %10.3f ms %8.1f MB/s\n", name, milliseconds, megabytes / (milliseconds / 1000.0));
+		}
+
+		::free(data);
+		KFile::deleteFile(path);
+
+		return finishTest("AsyncFileTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(AsyncFileTest)
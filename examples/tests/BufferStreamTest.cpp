@@ -0,0 +1,188 @@
+// Checks flatten/detach/writeTo of KBufferWriteStream in both modes, and measures serializing 1M ints.
+
+#include "TestHelpers.h"
+
+// the old KBufferWriteStream behavior. reallocates to the exact size on every write.
+class ExactReallocStream : public KStream
+{
+public:
+	BYTE* bufferPtr = nullptr;
+	DWORD bufferSize = 0;
+
+	bool readStream(BYTE* buffer, DWORD bytesToRead) noexcept override
+	{
+		return false;
+	}
+
+	bool writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept override
+	{
+		BYTE* newBuffer = (BYTE*)::realloc(bufferPtr, bufferSize + bytesToWrite);
+		if (newBuffer == nullptr)
+			return false;
+
+		bufferPtr = newBuffer;
+		::memcpy(bufferPtr + bufferSize, buffer, bytesToWrite);
+		bufferSize += bytesToWrite;
+		return true;
+	}
+
+	~ExactReallocStream() noexcept
+	{
+		::free(bufferPtr);
+	}
+};
+
+class BufferStreamTest : public KApplication
+{
+	// byte at i is (i * 7) & 0xFF
+	static bool writePattern(KStream* stream, DWORD size, DWORD writeSize) noexcept
+	{
+		BYTE block[256];
+		for (DWORD position = 0; position < size; position += writeSize)
+		{
+			const DWORD count = ((size - position) < writeSize) ? (size - position) : writeSize;
+			for (DWORD i = 0; i < count; i++)
+				block[i] = (BYTE)((position + i) * 7);
+
+			if (!stream->writeStream(block, count))
+				return false;
+		}
+		return true;
+	}
+
+	static bool hasPattern(const BYTE* data, DWORD size) noexcept
+	{
+		for (DWORD i = 0; i < size; i++)
+		{
+			if (data[i] != (BYTE)(i * 7))
+				return false;
+		}
+		return true;
+	}
+
+	void testContiguous() noexcept
+	{
+		KBufferWriteStream stream;
+		RFC_TEST_CHECK(stream.detach() == nullptr); // no data
+
+		RFC_TEST_CHECK(writePattern(&stream, 1000, 3));
+		RFC_TEST_CHECK((stream.dataSize() == 1000) && (stream.capacity() >= 1000));
+		RFC_TEST_CHECK(hasPattern(stream.data(), 1000));
+		RFC_TEST_CHECK(stream.flatten()); // nothing to do
+
+		RFC_TEST_CHECK(stream.reserve(5000) && (stream.capacity() == 5000));
+		const BYTE* reservedBuffer = stream.data();
+		RFC_TEST_CHECK(writePattern(&stream, 4000, 200));
+		RFC_TEST_CHECK((stream.data() == reservedBuffer) && (stream.dataSize() == 5000));
+
+		DWORD size = 0;
+		BYTE* buffer = stream.detach(&size);
+		RFC_TEST_CHECK((buffer == reservedBuffer) && (size == 5000)); // no copy
+		RFC_TEST_CHECK(hasPattern(buffer, 1000));
+		RFC_TEST_CHECK((stream.dataSize() == 0) && (stream.data() == nullptr));
+		::free(buffer);
+
+		RFC_TEST_CHECK(writePattern(&stream, 10, 10)); // usable after detach
+		RFC_TEST_CHECK((stream.dataSize() == 10) && hasPattern(stream.data(), 10));
+	}
+
+	void testChunked() noexcept
+	{
+		// 100 byte chunks. writes of 33 and 256 bytes cross the chunk boundaries.
+		const DWORD size = 10000;
+
+		{
+			KBufferWriteStream stream(true, 100);
+			RFC_TEST_CHECK(stream.isChunked());
+			RFC_TEST_CHECK(writePattern(&stream, size, 33));
+			RFC_TEST_CHECK((stream.dataSize() == size) && (stream.data() == nullptr));
+
+			KBufferWriteStream target;
+			RFC_TEST_CHECK(stream.writeTo(&target));
+			RFC_TEST_CHECK((target.dataSize() == size) && hasPattern(target.data(), size));
+
+			RFC_TEST_CHECK(stream.flatten());
+			RFC_TEST_CHECK(!stream.isChunked() && (stream.capacity() == size));
+			RFC_TEST_CHECK(hasPattern(stream.data(), size));
+
+			KBufferWriteStream flatTarget;
+			RFC_TEST_CHECK(stream.writeTo(&flatTarget) && (flatTarget.dataSize() == size));
+		}
+
+		{
+			KBufferWriteStream stream(true, 100);
+			RFC_TEST_CHECK(writePattern(&stream, size, 256));
+
+			DWORD detachedSize = 0;
+			BYTE* buffer = stream.detach(&detachedSize);
+			RFC_TEST_CHECK((buffer != nullptr) && (detachedSize == size) && hasPattern(buffer, size));
+			RFC_TEST_CHECK(!stream.isChunked() && (stream.dataSize() == 0));
+			::free(buffer);
+		}
+
+		{
+			KBufferWriteStream stream(true, 100);
+			KBufferWriteStream target;
+			RFC_TEST_CHECK(stream.writeTo(&target) && (target.dataSize() == 0)); // empty
+			RFC_TEST_CHECK(stream.flatten() && (stream.data() == nullptr));
+		}
+	}
+
+	template<typename Stream>
+	static double serializeInts(Stream& stream, int count) noexcept
+	{
+		KPerformanceCounter counter;
+		counter.startCounter();
+
+		for (int i = 0; i < count; i++)
+			stream.writeStream((const BYTE*)&i, sizeof(int));
+
+		return counter.endCounter();
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		testContiguous();
+		testChunked();
+
+		const int intCount = 1000000;
+		::printf("serialize %d ints:\n", intCount);
+
+		{
+			ExactReallocStream stream;
+			printBenchmark("exact realloc per write (old)", serializeInts(stream, intCount), intCount);
+			RFC_TEST_CHECK(stream.bufferSize == (intCount * sizeof(int)));
+		}
+
+		{
+			KBufferWriteStream stream;
+			printBenchmark("KBufferWriteStream", serializeInts(stream, intCount), intCount);
+			RFC_TEST_CHECK(stream.dataSize() == (intCount * sizeof(int)));
+		}
+
+		{
+			KBufferWriteStream stream;
+			stream.reserve(intCount * sizeof(int));
+			printBenchmark("KBufferWriteStream, reserved", serializeInts(stream, intCount), intCount);
+			RFC_TEST_CHECK(stream.capacity() == (intCount * sizeof(int)));
+		}
+
+		{
+			KBufferWriteStream stream(true);
+			printBenchmark("KBufferWriteStream, chunked", serializeInts(stream, intCount), intCount);
+
+			KPerformanceCounter counter;
+			counter.startCounter();
+			RFC_TEST_CHECK(stream.flatten());
+			printBenchmark("flatten", counter.endCounter());
+
+			const int* values = (const int*)stream.data();
+			RFC_TEST_CHECK((values[0] == 0) && (values[intCount - 1] == (intCount - 1)));
+		}
+
+		return finishTest("BufferStreamTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(BufferStreamTest)
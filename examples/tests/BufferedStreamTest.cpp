@@ -0,0 +1,172 @@
+// Checks reads & writes through KBufferedStream, and compares KFile calls and throughput with and without it.
+
+#include "TestHelpers.h"
+
+// forwards to another stream and counts the calls. (each one is a ReadFile/WriteFile call when the target is a KFile)
+class CountingStream : public KStream
+{
+public:
+	KStream* target;
+	int readCount = 0;
+	int writeCount = 0;
+
+	CountingStream(KStream* target) noexcept : target(target) {}
+
+	bool readStream(BYTE* buffer, DWORD bytesToRead) noexcept override
+	{
+		++readCount;
+		return target->readStream(buffer, bytesToRead);
+	}
+
+	bool writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept override
+	{
+		++writeCount;
+		return target->writeStream(buffer, bytesToWrite);
+	}
+
+	DWORD readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept override
+	{
+		++readCount;
+		return target->readStreamUpTo(buffer, maxBytesToRead);
+	}
+};
+
+class BufferedStreamTest : public KApplication
+{
+	const wchar_t* path = L"BufferedStreamTest.bin";
+
+	// small, block sized and larger than block writes & reads mixed. 100 byte blocks.
+	void testMixedSizes() noexcept
+	{
+		BYTE data[1000];
+		for (int i = 0; i < 1000; i++)
+			data[i] = (BYTE)(i * 7);
+
+		const DWORD sizes[] = { 1, 3, 100, 250, 40, 99, 7, 500 };
+		DWORD totalSize = 0;
+
+		KFile::deleteFile(path);
+		{
+			KFile file;
+			RFC_TEST_CHECK(file.openFile(path, KFile::KWRITE));
+
+			CountingStream counter(&file);
+			KBufferedStream stream(&counter, 100);
+
+			for (int i = 0; i < 8; i++)
+			{
+				RFC_TEST_CHECK(stream.writeStream(data + totalSize, sizes[i]));
+				totalSize += sizes[i];
+			}
+
+			RFC_TEST_CHECK(stream.flush());
+			RFC_TEST_CHECK(counter.writeCount < 8);
+		}
+
+		KFile file;
+		RFC_TEST_CHECK(file.openFile(path, KFile::KREAD));
+		RFC_TEST_CHECK(file.getFileSize() == totalSize);
+
+		KBufferedStream stream(&file, 100);
+		BYTE readData[1000];
+		DWORD position = 0;
+
+		for (int i = 7; i >= 0; i--) // other order than the writes
+		{
+			RFC_TEST_CHECK(stream.readStream(readData + position, sizes[i]));
+			position += sizes[i];
+		}
+
+		RFC_TEST_CHECK(::memcmp(readData, data, totalSize) == 0);
+		RFC_TEST_CHECK(!stream.readStream(readData, 1)); // end of file
+		RFC_TEST_CHECK(stream.readStreamUpTo(readData, 10) == 0);
+
+		file.closeFile();
+		KFile::deleteFile(path);
+	}
+
+	// writes & reads ints one by one. @returns the time in milliseconds.
+	double writeInts(int count, bool buffered, int& callCount) noexcept
+	{
+		KFile::deleteFile(path);
+		KFile file;
+		RFC_TEST_CHECK(file.openFile(path, KFile::KWRITE));
+
+		CountingStream counter(&file);
+		KBufferedStream bufferedStream(buffered ? &counter : nullptr);
+		KStream* stream = buffered ? (KStream*)&bufferedStream : (KStream*)&counter;
+
+		KPerformanceCounter timer;
+		timer.startCounter();
+
+		for (int i = 0; i < count; i++)
+			stream->writeStream((const BYTE*)&i, sizeof(int));
+
+		if (buffered)
+			RFC_TEST_CHECK(bufferedStream.flush());
+
+		const double milliseconds = timer.endCounter();
+		callCount = counter.writeCount;
+		return milliseconds;
+	}
+
+	double readInts(int count, bool buffered, int& callCount) noexcept
+	{
+		KFile file;
+		RFC_TEST_CHECK(file.openFile(path, KFile::KREAD));
+
+		CountingStream counter(&file);
+		KBufferedStream bufferedStream(buffered ? &counter : nullptr);
+		KStream* stream = buffered ? (KStream*)&bufferedStream : (KStream*)&counter;
+
+		KPerformanceCounter timer;
+		timer.startCounter();
+
+		int wrongCount = 0;
+		for (int i = 0; i < count; i++)
+		{
+			int value = -1;
+			stream->readStream((BYTE*)&value, sizeof(int));
+			wrongCount += (value == i) ? 0 : 1;
+		}
+
+		const double milliseconds = timer.endCounter();
+		RFC_TEST_CHECK(wrongCount == 0);
+		callCount = counter.readCount;
+		return milliseconds;
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		testMixedSizes();
+
+		const int intCount = 1000000;
+		int callCount = 0;
+		char name[64];
+
+		::printf("%d ints, 4 bytes per call:\n", intCount);
+
+		double milliseconds = writeInts(intCount, false, callCount);
+		::sprintf(name, "KFile write, %d calls", callCount);
+		printBenchmark(name, milliseconds, intCount);
+
+		milliseconds = readInts(intCount, false, callCount);
+		::sprintf(name, "KFile read, %d calls", callCount);
+		printBenchmark(name, milliseconds, intCount);
+
+		milliseconds = writeInts(intCount, true, callCount);
+		::sprintf(name, "KBufferedStream write, %d calls", callCount);
+		printBenchmark(name, milliseconds, intCount);
+		RFC_TEST_CHECK(callCount == ((intCount * 4 + KBufferedStream::DEFAULT_BLOCK_SIZE - 1) / KBufferedStream::DEFAULT_BLOCK_SIZE));
+
+		milliseconds = readInts(intCount, true, callCount);
+		::sprintf(name, "KBufferedStream read, %d calls", callCount);
+		printBenchmark(name, milliseconds, intCount);
+
+		KFile::deleteFile(path);
+		return finishTest("BufferedStreamTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(BufferedStreamTest)
@@ -0,0 +1,105 @@
+// Checks reserve/shrinkToFit/addRange of KVector & KPointerList, and compares geometric growth with the old linear growth.
+
+#include "TestHelpers.h"
+
+class ContainerGrowthTest : public KApplication
+{
+	template<KGrowthPolicy GrowthPolicy>
+	static double appendInts(int count) noexcept
+	{
+		KPerformanceCounter counter;
+		counter.startCounter();
+
+		KVector<int, 10, false, GrowthPolicy> vector;
+		for (int i = 0; i < count; i++)
+			vector.add(i);
+
+		const double milliseconds = counter.endCounter();
+		RFC_TEST_CHECK(vector.size() == count);
+		RFC_TEST_CHECK(vector.get(count - 1) == (count - 1));
+		return milliseconds;
+	}
+
+	void testVector() noexcept
+	{
+		KVector<int, 4, false> vector;
+		RFC_TEST_CHECK(vector.getCapacity() == 4);
+
+		RFC_TEST_CHECK(vector.reserve(1000));
+		RFC_TEST_CHECK(vector.getCapacity() >= 1000);
+
+		for (int i = 0; i < 1000; i++)
+			vector.add(i);
+
+		RFC_TEST_CHECK(vector.getCapacity() == 1000); // reserved room is enough. no reallocation.
+
+		const int values[] = { 1, 2, 3 };
+		RFC_TEST_CHECK(vector.addRange(values, 3));
+		RFC_TEST_CHECK(vector.size() == 1003);
+		RFC_TEST_CHECK(vector.get(1002) == 3);
+
+		// source is the list itself. it is moved by the reallocation.
+		vector.shrinkToFit();
+		RFC_TEST_CHECK(vector.getCapacity() == 1003);
+		RFC_TEST_CHECK(vector.addRange(vector.begin(), 1003));
+		RFC_TEST_CHECK(vector.size() == 2006);
+		RFC_TEST_CHECK((vector.get(1003) == 0) && (vector.get(2005) == 3));
+
+		vector.removeAll();
+		vector.add(7);
+		vector.add(vector.get(0)); // aliasing add
+		vector.shrinkToFit(); // fits into the small buffer
+		RFC_TEST_CHECK(vector.getCapacity() == 4);
+		RFC_TEST_CHECK((vector.size() == 2) && (vector.get(1) == 7));
+	}
+
+	void testPointerList() noexcept
+	{
+		int items[64];
+		KPointerList<int*, 4, false> list;
+
+		for (int i = 0; i < 64; i++)
+			list.add(&items[i]);
+
+		RFC_TEST_CHECK(list.size() == 64);
+		RFC_TEST_CHECK(list.getCapacity() >= 64);
+
+		list.shrinkToFit();
+		RFC_TEST_CHECK(list.getCapacity() == 64);
+
+		int* range[] = { &items[0], &items[1] };
+		RFC_TEST_CHECK(list.addRange(range, 2));
+		RFC_TEST_CHECK((list.size() == 66) && (list.get(65) == &items[1]));
+
+		RFC_TEST_CHECK(list.reserve(500));
+		RFC_TEST_CHECK(list.getCapacity() >= 500);
+
+		list.removeAll();
+		list.add(&items[0]);
+		list.shrinkToFit();
+		RFC_TEST_CHECK(list.getCapacity() == 4);
+		RFC_TEST_CHECK(list.get(0) == &items[0]);
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		testVector();
+		testPointerList();
+
+		::printf("append ints:\n");
+		const int itemCounts[] = { 1000, 100000, 1000000 };
+		for (int i = 0; i < 3; i++)
+		{
+			char name[64];
+			::sprintf(name, "linear growth, %d items", itemCounts[i]);
+			printBenchmark(name, appendInts<KGrowthPolicy::Linear>(itemCounts[i]), itemCounts[i]);
+			::sprintf(name, "geometric growth, %d items", itemCounts[i]);
+			printBenchmark(name, appendInts<KGrowthPolicy::Geometric>(itemCounts[i]), itemCounts[i]);
+		}
+
+		return finishTest("ContainerGrowthTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(ContainerGrowthTest)
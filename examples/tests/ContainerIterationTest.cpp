@@ -0,0 +1,106 @@
+// Checks the forEach visitors and range-for of KVector & KPointerList, and compares them with a std::function callback.
+
+#include "TestHelpers.h"
+#include <functional>
+
+class ContainerIterationTest : public KApplication
+{
+	void testVisitors() noexcept
+	{
+		KVector<int, 8, false> vector;
+		for (int i = 0; i < 100; i++)
+			vector.add(i);
+
+		int sum = 0;
+		vector.forEach([&sum](int& item) { sum += item; });
+		RFC_TEST_CHECK(sum == 4950);
+
+		bool indexMatches = true;
+		vector.forEachWithIndex([&indexMatches](int& item, int index) { indexMatches &= (item == index); });
+		RFC_TEST_CHECK(indexMatches);
+
+		int visited = 0;
+		const bool completed = vector.forEachUntil([&visited](int& item) { ++visited; return item < 9; });
+		RFC_TEST_CHECK(!completed && (visited == 10));
+
+		int expected = 99;
+		bool reverseOrder = true;
+		vector.forEachReverse([&](int& item) { reverseOrder &= (item == expected--); });
+		RFC_TEST_CHECK(reverseOrder);
+
+		sum = 0;
+		for (int item : vector)
+			sum += item;
+		RFC_TEST_CHECK(sum == 4950);
+
+		// std::function is still accepted.
+		std::function<void(int&)> callback = [&sum](int& item) { sum -= item; };
+		vector.forEach(callback);
+		RFC_TEST_CHECK(sum == 0);
+
+		int items[3] = {};
+		KPointerList<int*, 4, true> threadSafeList;
+		threadSafeList.add(&items[0]);
+		threadSafeList.add(&items[1]);
+		threadSafeList.add(&items[2]);
+
+		int count = 0;
+		for (int* item : threadSafeList.lockedView())
+			count += (item == &items[count]) ? 1 : 0;
+		RFC_TEST_CHECK(count == 3);
+
+		count = 0;
+		threadSafeList.forEachReverse([&](int* item) { count += (item == &items[2 - count]) ? 1 : 0; });
+		RFC_TEST_CHECK(count == 3);
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		testVisitors();
+
+		const int itemCount = 1000000;
+		const int passCount = 20;
+
+		KVector<int, 8, false> vector;
+		vector.reserve(itemCount);
+		for (int i = 0; i < itemCount; i++)
+			vector.add(i & 0x0F); // keeps the sum in int range
+
+		KPerformanceCounter counter;
+		volatile int sink = 0;
+		int sum = 0;
+
+		::printf("sum of 1M ints, %d passes:\n", passCount);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+		{
+			std::function<void(int&)> callback = [&sum](int& item) { sum += item; };
+			vector.forEach(callback); // type erased call per item. (old forEach)
+		}
+		printBenchmark("forEach with std::function", counter.endCounter(), itemCount * passCount);
+		sink = sum;
+
+		sum = 0;
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			vector.forEach([&sum](int& item) { sum += item; });
+		printBenchmark("forEach with lambda", counter.endCounter(), itemCount * passCount);
+		RFC_TEST_CHECK(sum == sink);
+
+		sum = 0;
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+		{
+			for (int item : vector)
+				sum += item;
+		}
+		printBenchmark("range-for", counter.endCounter(), itemCount * passCount);
+		RFC_TEST_CHECK(sum == sink);
+
+		return finishTest("ContainerIterationTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(ContainerIterationTest)
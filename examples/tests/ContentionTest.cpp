@@ -0,0 +1,182 @@
+// Checks KSPSCQueue & KMPMCQueue under concurrent use, and measures the thread safe containers at 1-16 threads.
+
+#include "TestHelpers.h"
+#include <atomic>
+
+class ContentionTest : public KApplication
+{
+	enum { MaxThreadCount = 16 };
+
+	// runs func(threadIndex) on threadCount new threads. @returns the time until all of them finished.
+	template<typename Func>
+	static double runThreads(int threadCount, Func&& func) noexcept
+	{
+		KThread* threads = new KThread[threadCount];
+
+		KPerformanceCounter counter;
+		counter.startCounter();
+
+		for (int i = 0; i < threadCount; i++)
+		{
+			threads[i].onRun = [&func, i](KThread* thread) { func(i); };
+			threads[i].start();
+		}
+
+		for (int i = 0; i < threadCount; i++)
+			threads[i].waitUntilThreadFinish();
+
+		const double milliseconds = counter.endCounter();
+		delete[] threads;
+		return milliseconds;
+	}
+
+	// read-mostly access. one of 64 operations is a write.
+	template<int IsThreadSafe>
+	static double readMostly(int threadCount, int operationsPerThread) noexcept
+	{
+		KVector<int, 16, IsThreadSafe> vector;
+		for (int i = 0; i < 1024; i++)
+			vector.add(i);
+
+		std::atomic<int> sum{ 0 };
+		const double milliseconds = runThreads(threadCount, [&vector, &sum, operationsPerThread](int threadIndex) {
+			int localSum = 0;
+			for (int i = 0; i < operationsPerThread; i++)
+			{
+				const int index = (i * 7 + threadIndex) & 1023;
+				if ((i & 63) == 0)
+					vector.set(index, index);
+				else
+					localSum += vector.get(index);
+			}
+			sum.fetch_add(localSum, std::memory_order_relaxed);
+		});
+
+		RFC_TEST_CHECK(sum.load() > 0);
+		return milliseconds;
+	}
+
+	// threadCount / 2 producers & consumers. values 1..itemCount are passed through the queue.
+	static double transferMPMC(int threadCount, int itemCount) noexcept
+	{
+		KMPMCQueue<int, 1024>* queue = new KMPMCQueue<int, 1024>();
+		const int producerCount = threadCount / 2;
+		const int itemsPerProducer = itemCount / producerCount;
+
+		std::atomic<int> consumedCount{ 0 };
+		std::atomic<long long> consumedSum{ 0 };
+
+		const double milliseconds = runThreads(threadCount, [=, &consumedCount, &consumedSum](int threadIndex) {
+			if (threadIndex < producerCount)
+			{
+				const int first = threadIndex * itemsPerProducer + 1;
+				for (int value = first; value < (first + itemsPerProducer); value++)
+				{
+					while (!queue->enqueue(value))
+						::SwitchToThread();
+				}
+			}
+			else
+			{
+				long long localSum = 0;
+				int value;
+				while (consumedCount.load(std::memory_order_relaxed) < (itemsPerProducer * producerCount))
+				{
+					if (queue->dequeue(value))
+					{
+						localSum += value;
+						consumedCount.fetch_add(1, std::memory_order_relaxed);
+					}
+					else
+					{
+						::SwitchToThread();
+					}
+				}
+				consumedSum.fetch_add(localSum, std::memory_order_relaxed);
+			}
+		});
+
+		const long long total = (long long)itemsPerProducer * producerCount;
+		RFC_TEST_CHECK(consumedCount.load() == total);
+		RFC_TEST_CHECK(consumedSum.load() == ((total * (total + 1)) / 2)); // every value exactly once
+		RFC_TEST_CHECK(queue->isEmpty());
+
+		delete queue;
+		return milliseconds;
+	}
+
+	// one producer, one consumer. the consumer checks the order.
+	static double transferSPSC(int itemCount) noexcept
+	{
+		KSPSCQueue<int, 1024>* queue = new KSPSCQueue<int, 1024>();
+		std::atomic<int> outOfOrderCount{ 0 };
+
+		const double milliseconds = runThreads(2, [=, &outOfOrderCount](int threadIndex) {
+			if (threadIndex == 0)
+			{
+				for (int value = 1; value <= itemCount; value++)
+				{
+					while (!queue->enqueue(value))
+						::SwitchToThread();
+				}
+			}
+			else
+			{
+				int expected = 1;
+				int value;
+				while (expected <= itemCount)
+				{
+					if (queue->dequeue(value))
+					{
+						if (value != expected)
+							outOfOrderCount++;
+						expected++;
+					}
+					else
+					{
+						::SwitchToThread();
+					}
+				}
+			}
+		});
+
+		RFC_TEST_CHECK(outOfOrderCount.load() == 0);
+		RFC_TEST_CHECK(queue->isEmpty());
+
+		delete queue;
+		return milliseconds;
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		const int threadCounts[] = { 1, 2, 4, 8, 16 };
+		const int operationsPerThread = 200000;
+		char name[64];
+
+		::printf("KVector get/set, 1/64 writes, %d operations per thread:\n", operationsPerThread);
+		for (int i = 0; i < 5; i++)
+		{
+			const int operationCount = threadCounts[i] * operationsPerThread;
+
+			::sprintf(name, "Exclusive, %d threads", threadCounts[i]);
+			printBenchmark(name, readMostly<KThreadSafety::Exclusive>(threadCounts[i], operationsPerThread), operationCount);
+			::sprintf(name, "ReaderWriter, %d threads", threadCounts[i]);
+			printBenchmark(name, readMostly<KThreadSafety::ReaderWriter>(threadCounts[i], operationsPerThread), operationCount);
+		}
+
+		const int itemCount = 1000000;
+		::printf("queue transfer, %d items:\n", itemCount);
+		printBenchmark("KSPSCQueue, 1 producer & 1 consumer", transferSPSC(itemCount), itemCount);
+
+		for (int i = 1; i < 5; i++) // needs at least one producer & one consumer
+		{
+			::sprintf(name, "KMPMCQueue, %d threads", threadCounts[i]);
+			printBenchmark(name, transferMPMC(threadCounts[i], itemCount), itemCount);
+		}
+
+		return finishTest("ContentionTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(ContentionTest)
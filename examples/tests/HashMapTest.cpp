@@ -0,0 +1,172 @@
+// Checks KHashMap & KHashSet against a plain array model, and compares map lookups with a linear search.
+
+#include "TestHelpers.h"
+
+class HashMapTest : public KApplication
+{
+	unsigned int randomState = 12345;
+
+	unsigned int nextRandom() noexcept
+	{
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return randomState;
+	}
+
+	void testSemantics() noexcept
+	{
+		KHashMap<int, int, 8, false> map;
+
+		RFC_TEST_CHECK(map.add(1, 100));
+		RFC_TEST_CHECK(!map.add(1, 200)); // first value is kept
+
+		int value = 0;
+		RFC_TEST_CHECK(map.get(1, value) && (value == 100));
+
+		map.put(1, 300); // put replaces
+		RFC_TEST_CHECK(map.get(1, value) && (value == 300));
+		RFC_TEST_CHECK(map.size() == 1);
+
+		map.getOrAdd(2) += 5;
+		RFC_TEST_CHECK((map.find(2) != nullptr) && (*map.find(2) == 5));
+		RFC_TEST_CHECK(map.remove(2) && !map.remove(2));
+		RFC_TEST_CHECK(map.find(2) == nullptr);
+
+		// KString keys compare by content.
+		KHashMap<KString, int, 4, true> stringMap;
+		RFC_TEST_CHECK(stringMap.add(KString(L"font"), 1));
+		RFC_TEST_CHECK(!stringMap.add(KString(L"fo") + KString(L"nt"), 2));
+		RFC_TEST_CHECK(stringMap.get(KString(L"font"), value) && (value == 1));
+		RFC_TEST_CHECK((stringMap.size() == 1) && !stringMap.isEmpty());
+
+		KHashMap<int, int, 4, KThreadSafety::ReaderWriter> sharedMap;
+		RFC_TEST_CHECK(sharedMap.add(1, 1) && (sharedMap.size() == 1) && (sharedMap.getCapacity() >= 4));
+
+		KHashSet<void*, 4, false> set;
+		RFC_TEST_CHECK(set.add(this) && !set.add(this));
+		RFC_TEST_CHECK(set.contains(this) && (set.size() == 1));
+		RFC_TEST_CHECK(set.remove(this) && set.isEmpty());
+	}
+
+	// random operations on a small key range, so the keys are added & removed many times.
+	void testAgainstModel() noexcept
+	{
+		const int keyRange = 4096;
+		bool present[keyRange] = {};
+		int values[keyRange] = {};
+		int presentCount = 0;
+
+		KHashMap<int, int, 16, false> map;
+
+		for (int round = 0; round < 500000; round++)
+		{
+			const int key = nextRandom() % ((round < 250000) ? keyRange : 64); // second half shrinks back to a few keys
+			const int value = (int)(nextRandom() & 0xFFFF);
+
+			switch (nextRandom() % 4)
+			{
+			case 0:
+				RFC_TEST_CHECK(map.add(key, value) == !present[key]);
+				if (!present[key])
+				{
+					present[key] = true;
+					values[key] = value;
+					++presentCount;
+				}
+				break;
+			case 1:
+				map.put(key, value);
+				if (!present[key])
+					++presentCount;
+				present[key] = true;
+				values[key] = value;
+				break;
+			case 2:
+				RFC_TEST_CHECK(map.remove(key) == present[key]);
+				if (present[key])
+					--presentCount;
+				present[key] = false;
+				break;
+			default:
+			{
+				int mapValue = -1;
+				RFC_TEST_CHECK(map.get(key, mapValue) == present[key]);
+				RFC_TEST_CHECK(!present[key] || (mapValue == values[key]));
+			}
+			}
+		}
+
+		RFC_TEST_CHECK(map.size() == presentCount);
+
+		int visitedCount = 0;
+		map.forEach([&](const int& key, int& value) {
+			RFC_TEST_CHECK(present[key] && (values[key] == value));
+			++visitedCount;
+		});
+		RFC_TEST_CHECK(visitedCount == presentCount);
+
+		map.removeAll();
+		RFC_TEST_CHECK(map.isEmpty() && !map.contains(0));
+	}
+
+	static int makeKey(int index) noexcept
+	{
+		return (int)(index * 2654435761u); // distinct for every index
+	}
+
+	static int lookupIndex(int lookup, int keyCount) noexcept
+	{
+		return (int)(((long long)lookup * 7919) % keyCount);
+	}
+
+	// lookups are spread over the whole list. linear search gets too slow for 1M lookups on big lists, so it does fewer of them.
+	void benchmarkLookup(int keyCount) noexcept
+	{
+		KVector<int, 16, false> list;
+		KHashMap<int, int, 16, false> map;
+		for (int i = 0; i < keyCount; i++)
+		{
+			list.add(makeKey(i));
+			map.add(makeKey(i), i);
+		}
+
+		const int mapLookupCount = 1000000;
+		const int listLookupCount = (keyCount > 1000) ? 1000 : mapLookupCount;
+
+		KPerformanceCounter counter;
+		int foundCount = 0;
+		char name[64];
+
+		::printf("%d keys:\n", keyCount);
+
+		counter.startCounter();
+		for (int i = 0; i < listLookupCount; i++)
+			foundCount += (list.getIndex(makeKey(lookupIndex(i, keyCount))) != -1) ? 1 : 0;
+		::sprintf(name, "KVector::getIndex, %d lookups", listLookupCount);
+		printBenchmark(name, counter.endCounter(), listLookupCount);
+
+		counter.startCounter();
+		for (int i = 0; i < mapLookupCount; i++)
+			foundCount += map.contains(makeKey(lookupIndex(i, keyCount))) ? 1 : 0;
+		::sprintf(name, "KHashMap::contains, %d lookups", mapLookupCount);
+		printBenchmark(name, counter.endCounter(), mapLookupCount);
+
+		RFC_TEST_CHECK(foundCount == (listLookupCount + mapLookupCount));
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		testSemantics();
+		testAgainstModel();
+
+		benchmarkLookup(10);
+		benchmarkLookup(1000);
+		benchmarkLookup(1000000);
+
+		return finishTest("HashMapTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(HashMapTest)
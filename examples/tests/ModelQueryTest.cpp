@@ -0,0 +1,129 @@
+// Checks KModelQuery predicates with and without a KModelIndex. The elements only keep the key attribute.
+
+#include "TestHelpers.h"
+
+enum class QueryElementType : int
+{
+	Root = 1,
+	Group,
+	Item
+};
+
+class QueryElement : public KModelElement
+{
+public:
+	KString key;
+
+	void setAttribute(const wchar_t* name, UINT nameLength, const wchar_t* value, UINT valueLength) noexcept override
+	{
+		if (::wcscmp(name, L"key") == 0)
+			key = KString(value, KStringBehaviour::MAKE_A_COPY, (int)valueLength);
+	}
+
+	bool matchesAttribute(const wchar_t* name, UINT nameLength, const wchar_t* value, UINT valueLength) noexcept override
+	{
+		return (::wcscmp(name, L"key") == 0) && (key.length() == (int)valueLength) && (::wcscmp(key, value) == 0);
+	}
+};
+
+class QueryElementFactory : public KModelElementFactory
+{
+public:
+	KModelElement* createModelElement(const wchar_t* elementName, UINT length) noexcept override
+	{
+		QueryElement* element = createElement<QueryElement>();
+		if (element == nullptr)
+			return nullptr;
+
+		if (::wcscmp(elementName, L"root") == 0)
+			element->elementType = (int)QueryElementType::Root;
+		else if (::wcscmp(elementName, L"group") == 0)
+			element->elementType = (int)QueryElementType::Group;
+		else if (::wcscmp(elementName, L"item") == 0)
+			element->elementType = (int)QueryElementType::Item;
+
+		return element;
+	}
+};
+
+class ModelQueryTest : public KApplication
+{
+	QueryElementFactory factory;
+
+	KModelElement* findFirst(const wchar_t* path, KModelElement* root, KModelIndex* index) noexcept
+	{
+		KModelQuery query;
+		RFC_TEST_CHECK(query.compile(path, &factory));
+		return query.findFirst(root, index);
+	}
+
+	int findAll(const wchar_t* path, KModelElement* root, KModelIndex* index) noexcept
+	{
+		KModelQuery query;
+		RFC_TEST_CHECK(query.compile(path, &factory));
+
+		KModelElementList results;
+		return query.findAll(root, &results, index);
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		const wchar_t* text =
+			L"<root id='r'>"
+			L"<item id='a' key='1'/>"
+			L"<group><item id='x' key='2'/><item id='y' key='2'/></group>"
+			L"<item id='b'/>"
+			L"</root>";
+
+		KModelDocument document;
+		KModelIndex index;
+		KXMLReader reader;
+		reader.setIndex(&index);
+
+		RFC_TEST_CHECK(reader.loadFromString(text));
+		RFC_TEST_CHECK(reader.parse(&factory, &document));
+
+		KModelElement* root = document.getRootElement();
+		RFC_TEST_CHECK(root != nullptr);
+		if (root == nullptr)
+			return finishTest("ModelQueryTest");
+
+		KModelElement* itemA = root->firstChild;
+		KModelElement* itemX = itemA->next->firstChild;
+		KModelElement* itemY = itemX->next;
+		RFC_TEST_CHECK(index.findById(L"x") == itemX);
+
+		// id predicate of the last step. the index gives the candidate, the elements do not keep the id.
+		RFC_TEST_CHECK(findFirst(L"//item[@id='x']", root, &index) == itemX);
+		RFC_TEST_CHECK(findFirst(L"/root/item[@id='a']", root, &index) == itemA);
+		RFC_TEST_CHECK(findFirst(L"/root/item[@id='x']", root, &index) == nullptr); // inside the group
+		RFC_TEST_CHECK(findFirst(L"//*[@id='y']", root, &index) == itemY);
+		RFC_TEST_CHECK(findFirst(L"//item[@id='missing']", root, &index) == nullptr);
+		RFC_TEST_CHECK(findFirst(L"//group[@id='x']", root, &index) == nullptr); // other element type
+
+		// id predicate together with a predicate of the element
+		RFC_TEST_CHECK(findFirst(L"//item[@id='x'][@key='2']", root, &index) == itemX);
+		RFC_TEST_CHECK(findFirst(L"//item[@id='x'][@key='1']", root, &index) == nullptr);
+
+		// id predicate of another step. checked with the index while matching the path.
+		RFC_TEST_CHECK(findAll(L"/root[@id='r']//item", root, &index) == 4);
+		RFC_TEST_CHECK(findAll(L"/root[@id='a']//item", root, &index) == 0);
+		RFC_TEST_CHECK(findAll(L"/root[@id='r']/*", root, &index) == 3); // walks the tree
+		RFC_TEST_CHECK(findAll(L"//item[@key='2']", root, &index) == 2);
+
+		KModelQuery query;
+		RFC_TEST_CHECK(query.compile(L"//item[@id='x']", &factory));
+		RFC_TEST_CHECK(query.matches(itemX, root, &index) && !query.matches(itemY, root, &index));
+
+		// without the index, only the attributes kept by the elements can be matched.
+		RFC_TEST_CHECK(findFirst(L"//item[@id='x']", root, nullptr) == nullptr);
+		RFC_TEST_CHECK(findAll(L"//item[@key='2']", root, nullptr) == 2);
+		RFC_TEST_CHECK(findFirst(L"/root/item[@key='1']", root, nullptr) == itemA);
+
+		index.clear();
+		return finishTest("ModelQueryTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(ModelQueryTest)
@@ -0,0 +1,100 @@
+// Checks the order of KPointerQueue single & batch operations, and compares pooled nodes and batches with plain push/pop.
+
+#include "TestHelpers.h"
+
+class PointerQueueTest : public KApplication
+{
+	int items[256];
+
+	void testOrder() noexcept
+	{
+		KPointerQueue<int*, false> queue;
+		RFC_TEST_CHECK(queue.pop() == nullptr);
+
+		queue.push(&items[0]);
+		int* batch[] = { &items[1], &items[2], &items[3] };
+		queue.pushBatch(batch, 3);
+		queue.push(&items[4]);
+		RFC_TEST_CHECK(queue.size() == 5);
+
+		RFC_TEST_CHECK(queue.pop() == &items[0]);
+
+		int* out[8] = {};
+		RFC_TEST_CHECK(queue.popBatch(out, 2) == 2);
+		RFC_TEST_CHECK((out[0] == &items[1]) && (out[1] == &items[2]));
+
+		// func runs without the lock. pushed items go after the drained ones.
+		int next = 3;
+		const size_t drained = queue.popAll([&](int* item) {
+			RFC_TEST_CHECK(item == &items[next]);
+			++next;
+			queue.push(&items[10]);
+		});
+		RFC_TEST_CHECK((drained == 2) && (next == 5));
+		RFC_TEST_CHECK(queue.size() == 2);
+
+		RFC_TEST_CHECK(queue.popBatch(out, 8) == 2);
+		RFC_TEST_CHECK(queue.isEmpty());
+
+		queue.releasePooledNodes();
+		queue.push(&items[5]);
+		RFC_TEST_CHECK(queue.pop() == &items[5]);
+	}
+
+	template<class Queue>
+	double pushPopRounds(Queue& queue, int roundCount, int itemsPerRound) noexcept
+	{
+		KPerformanceCounter counter;
+		counter.startCounter();
+
+		for (int round = 0; round < roundCount; round++)
+		{
+			for (int i = 0; i < itemsPerRound; i++)
+				queue.push(&items[i]);
+
+			for (int i = 0; i < itemsPerRound; i++)
+				RFC_TEST_CHECK(queue.pop() == &items[i]);
+		}
+
+		return counter.endCounter();
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		testOrder();
+
+		const int roundCount = 20000;
+		const int itemsPerRound = 64;
+		const int operationCount = roundCount * itemsPerRound;
+
+		::printf("thread safe queue, %d rounds of %d push + pop:\n", roundCount, itemsPerRound);
+
+		KPointerQueue<int*, true> unpooledQueue(0);
+		printBenchmark("push/pop, new/delete per node", pushPopRounds(unpooledQueue, roundCount, itemsPerRound), operationCount);
+
+		KPointerQueue<int*, true> pooledQueue;
+		printBenchmark("push/pop, pooled nodes", pushPopRounds(pooledQueue, roundCount, itemsPerRound), operationCount);
+
+		int* batch[itemsPerRound];
+		for (int i = 0; i < itemsPerRound; i++)
+			batch[i] = &items[i];
+
+		int* out[itemsPerRound];
+		KPerformanceCounter counter;
+		counter.startCounter();
+
+		for (int round = 0; round < roundCount; round++)
+		{
+			pooledQueue.pushBatch(batch, itemsPerRound);
+			RFC_TEST_CHECK(pooledQueue.popBatch(out, itemsPerRound) == itemsPerRound);
+		}
+
+		printBenchmark("pushBatch/popBatch, pooled nodes", counter.endCounter(), operationCount);
+		RFC_TEST_CHECK(out[itemsPerRound - 1] == &items[itemsPerRound - 1]);
+
+		return finishTest("PointerQueueTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(PointerQueueTest)
@@ -0,0 +1,225 @@
+// Writes a PS01 file, converts it to PS02 and checks that KPSIndexedReader returns the same objects as KPSReader.
+// Also compares the PS01 full load with the PS02 open & single object fetch.
+
+#include "TestHelpers.h"
+
+class PropertyStorageTest : public KApplication
+{
+	static GUID makeObjectID(unsigned int index) noexcept
+	{
+		GUID objectID = {};
+		objectID.Data1 = index * 2654435761u; // not sorted in the file
+		objectID.Data2 = (unsigned short)index;
+		objectID.Data4[7] = (unsigned char)index;
+		return objectID;
+	}
+
+	static void writeText(KFile& file, const KString& text) noexcept
+	{
+		const int length = text.length();
+		file.writeFile(&length, sizeof(int));
+		file.writeFile((const wchar_t*)text, sizeof(wchar_t) * length);
+	}
+
+	// same layout as the PS Editor tool writes. every property type is used.
+	static bool writePS01(const wchar_t* path, unsigned int objectCount, int propertyCount) noexcept
+	{
+		KFile::deleteFile(path);
+
+		KFile file;
+		if (!file.openFile(path, KFile::KWRITE))
+			return false;
+
+		char fileHeader[4] = PS_V1_HEADER;
+		file.writeFile(fileHeader, 4);
+		file.writeFile(&objectCount, sizeof(unsigned int));
+
+		for (unsigned int objectIndex = 0; objectIndex < objectCount; ++objectIndex)
+		{
+			const GUID objectID = makeObjectID(objectIndex);
+			file.writeFile(&objectID, sizeof(GUID));
+			writeText(file, KString(L"object") + KString((int)objectIndex));
+
+			file.writeFile(&propertyCount, sizeof(unsigned int));
+
+			for (int propertyIndex = 0; propertyIndex < propertyCount; ++propertyIndex)
+			{
+				writeText(file, KString(L"property") + KString(propertyIndex));
+
+				const int type = propertyIndex % 7;
+				file.writeFile(&type, sizeof(int));
+
+				const int value = (int)(objectIndex * 1000) + propertyIndex;
+				if (type == KPSPropertyTypes::STRING)
+				{
+					writeText(file, KString(L"value") + KString(value));
+				}
+				else if (type == KPSPropertyTypes::INTEGER)
+				{
+					file.writeFile(&value, sizeof(int));
+				}
+				else if (type == KPSPropertyTypes::DWORD)
+				{
+					const DWORD dwordValue = (DWORD)value;
+					file.writeFile(&dwordValue, sizeof(DWORD));
+				}
+				else if (type == KPSPropertyTypes::FLOAT)
+				{
+					const float floatValue = value * 0.5f;
+					file.writeFile(&floatValue, sizeof(float));
+				}
+				else if (type == KPSPropertyTypes::INT_ARRAY)
+				{
+					const int intArray[3] = { value, value + 1, value + 2 };
+					const int intArraySize = value % 4; // also writes empty arrays
+					file.writeFile(&intArraySize, sizeof(int));
+					file.writeFile(intArray, sizeof(int) * intArraySize);
+				}
+				else if (type == KPSPropertyTypes::GUID)
+				{
+					const GUID guidValue = makeObjectID(value);
+					file.writeFile(&guidValue, sizeof(GUID));
+				}
+				else // file
+				{
+					writeText(file, KString(L"file") + KString(value) + KString(L".bin"));
+
+					unsigned char fileData[64];
+					const DWORD fileDataSize = value % 65;
+					for (DWORD i = 0; i < fileDataSize; i++)
+						fileData[i] = (unsigned char)(value + i);
+
+					file.writeFile(&fileDataSize, sizeof(DWORD));
+					file.writeFile(fileData, fileDataSize);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	static bool equalText(const wchar_t* text1, int length1, const wchar_t* text2, int length2) noexcept
+	{
+		return (length1 == length2) && ((length1 == 0) || (::memcmp(text1, text2, sizeof(wchar_t) * length1) == 0));
+	}
+
+	static bool equalProperty(KPSProperty* property1, KPSProperty* property2) noexcept
+	{
+		if (!equalText(property1->name, property1->nameLength, property2->name, property2->nameLength) ||
+			(property1->type != property2->type))
+			return false;
+
+		switch (property1->type)
+		{
+		case KPSPropertyTypes::STRING:
+			return equalText(property1->strValue, property1->strValueLength, property2->strValue, property2->strValueLength);
+		case KPSPropertyTypes::INTEGER:
+			return property1->intValue == property2->intValue;
+		case KPSPropertyTypes::DWORD:
+			return property1->dwordValue == property2->dwordValue;
+		case KPSPropertyTypes::FLOAT:
+			return property1->floatValue == property2->floatValue;
+		case KPSPropertyTypes::INT_ARRAY:
+			return (property1->intArraySize == property2->intArraySize) &&
+				((property1->intArraySize == 0) || (::memcmp(property1->intArray, property2->intArray, sizeof(int) * property1->intArraySize) == 0));
+		case KPSPropertyTypes::GUID:
+			return ::memcmp(&property1->guidValue, &property2->guidValue, sizeof(GUID)) == 0;
+		default:
+			return equalText(property1->fileName, property1->fileNameLength, property2->fileName, property2->fileNameLength) &&
+				(property1->fileDataSize == property2->fileDataSize) &&
+				((property1->fileDataSize == 0) || (::memcmp(property1->fileData, property2->fileData, property1->fileDataSize) == 0));
+		}
+	}
+
+	static bool equalObject(KPSObject* object1, KPSObject* object2) noexcept
+	{
+		if ((object1 == nullptr) || (object2 == nullptr) ||
+			(::memcmp(&object1->objectID, &object2->objectID, sizeof(GUID)) != 0) ||
+			!equalText(object1->name, object1->nameLength, object2->name, object2->nameLength) ||
+			(object1->propertyList.size() != object2->propertyList.size()))
+			return false;
+
+		for (int i = 0; i < object1->propertyList.size(); i++)
+		{
+			if (!equalProperty(object1->propertyList.get(i), object2->propertyList.get(i)))
+				return false;
+		}
+
+		return true;
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		const wchar_t* ps01Path = L"PropertyStorageTest.ps01";
+		const wchar_t* ps02Path = L"PropertyStorageTest.ps02";
+		const unsigned int objectCount = 20000;
+
+		RFC_TEST_CHECK(writePS01(ps01Path, objectCount, 20));
+		RFC_TEST_CHECK(KPSIndexedWriter::convertFromPS01(ps01Path, ps02Path));
+
+		KPSReader reader;
+		RFC_TEST_CHECK(reader.loadFromFile(ps01Path));
+
+		KPSReader arenaReader;
+		RFC_TEST_CHECK(arenaReader.loadFromFile(ps01Path, true, true));
+
+		KPSIndexedReader indexedReader;
+		RFC_TEST_CHECK(indexedReader.openFile(ps02Path));
+		RFC_TEST_CHECK(indexedReader.getObjectCount() == objectCount);
+		RFC_TEST_CHECK(reader.psObjectList->size() == (int)objectCount);
+
+		if (testFailCount == 0)
+		{
+			int equalCount = 0;
+			for (unsigned int i = 0; i < objectCount; i++)
+			{
+				KPSObject* psObject = reader.psObjectList->get(i);
+				equalCount += equalObject(psObject, indexedReader.getPSObject(psObject->objectID)) ? 1 : 0;
+				equalCount += equalObject(psObject, arenaReader.psObjectList->get(i)) ? 1 : 0;
+			}
+			RFC_TEST_CHECK(equalCount == (int)(objectCount * 2));
+
+			const GUID missingID = makeObjectID(objectCount + 1);
+			RFC_TEST_CHECK(indexedReader.getPSObject(missingID) == NULL);
+		}
+
+		indexedReader.closeFile();
+
+		::printf("%u objects with 20 properties:\n", objectCount);
+
+		KPerformanceCounter counter;
+		const GUID lastID = makeObjectID(objectCount - 1);
+
+		counter.startCounter();
+		{
+			KPSReader benchmarkReader;
+			benchmarkReader.loadFromFile(ps01Path);
+			RFC_TEST_CHECK(benchmarkReader.getPSObject(lastID) != NULL);
+		}
+		printBenchmark("PS01 load, find & unload", counter.endCounter());
+
+		counter.startCounter();
+		{
+			KPSReader benchmarkReader;
+			benchmarkReader.loadFromFile(ps01Path, true, true);
+			RFC_TEST_CHECK(benchmarkReader.getPSObject(lastID) != NULL);
+		}
+		printBenchmark("PS01 arena load, find & unload", counter.endCounter());
+
+		counter.startCounter();
+		{
+			KPSIndexedReader benchmarkReader;
+			benchmarkReader.openFile(ps02Path);
+			RFC_TEST_CHECK(benchmarkReader.getPSObject(lastID) != NULL);
+		}
+		printBenchmark("PS02 open, fetch & close", counter.endCounter());
+
+		KFile::deleteFile(ps01Path);
+		KFile::deleteFile(ps02Path);
+
+		return finishTest("PropertyStorageTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(PropertyStorageTest)
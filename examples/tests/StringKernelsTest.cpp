@@ -0,0 +1,188 @@
+// Compares KStringKernels with plain loops & the system functions on random text, and measures their throughput.
+
+#include "TestHelpers.h"
+
+class StringKernelsTest : public KApplication
+{
+	unsigned int randomState = 12345;
+
+	unsigned int nextRandom() noexcept
+	{
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return randomState;
+	}
+
+	// small alphabet, so the searches find matches. includes line breaks and non-ASCII letters.
+	void fillRandom(wchar_t* text, int length) noexcept
+	{
+		static const wchar_t alphabet[] = { L'a', L'b', L'A', L'B', L'z', L'\r', L'\n', 0x00E9, 0x00C9, 0x0416 };
+		const bool asciiOnly = (nextRandom() % 2) == 0;
+
+		for (int i = 0; i < length; i++)
+			text[i] = alphabet[nextRandom() % (asciiOnly ? 7 : 10)];
+	}
+
+	static int referenceFindChar(const wchar_t* text, int length, wchar_t character) noexcept
+	{
+		for (int i = 0; i < length; i++)
+		{
+			if (text[i] == character)
+				return i;
+		}
+		return -1;
+	}
+
+	static int referenceFindLastChar(const wchar_t* text, int length, wchar_t character) noexcept
+	{
+		for (int i = length - 1; i >= 0; i--)
+		{
+			if (text[i] == character)
+				return i;
+		}
+		return -1;
+	}
+
+	static int referenceFindLineBreak(const wchar_t* text, int length) noexcept
+	{
+		for (int i = 0; i < length; i++)
+		{
+			if ((text[i] == L'\r') || (text[i] == L'\n'))
+				return i;
+		}
+		return -1;
+	}
+
+	static int referenceFindString(const wchar_t* text, int length, const wchar_t* pattern, int patternLength) noexcept
+	{
+		for (int i = 0; i <= (length - patternLength); i++)
+		{
+			int j = 0;
+			while ((j < patternLength) && (text[i + j] == pattern[j]))
+				j++;
+
+			if (j == patternLength)
+				return i;
+		}
+		return -1;
+	}
+
+	void testKernels() noexcept
+	{
+		const int maxLength = 300;
+		wchar_t* buffer1 = (wchar_t*)::malloc((maxLength + 1) * sizeof(wchar_t));
+		wchar_t* buffer2 = (wchar_t*)::malloc((maxLength + 1) * sizeof(wchar_t));
+		wchar_t* expected = (wchar_t*)::malloc((maxLength + 1) * sizeof(wchar_t));
+
+		for (int round = 0; round < 20000; round++)
+		{
+			const int offset = nextRandom() % 2; // unaligned buffers
+			const int length = nextRandom() % (maxLength - offset);
+			wchar_t* text = buffer1 + offset;
+			fillRandom(text, length);
+
+			const wchar_t character = (nextRandom() % 2) ? L'B' : 0x0416;
+			RFC_TEST_CHECK(KStringKernels::findChar(text, length, character) == referenceFindChar(text, length, character));
+			RFC_TEST_CHECK(KStringKernels::findLastChar(text, length, character) == referenceFindLastChar(text, length, character));
+			RFC_TEST_CHECK(KStringKernels::findLineBreak(text, length) == referenceFindLineBreak(text, length));
+
+			// pattern is a part of the text or random.
+			wchar_t pattern[24];
+			const int patternLength = 1 + (nextRandom() % 20);
+			if ((length >= patternLength) && (nextRandom() % 2))
+				::memcpy(pattern, text + (nextRandom() % (length - patternLength + 1)), patternLength * sizeof(wchar_t));
+			else
+				fillRandom(pattern, patternLength);
+
+			RFC_TEST_CHECK(KStringKernels::findString(text, length, pattern, patternLength) ==
+				referenceFindString(text, length, pattern, patternLength));
+
+			// same text with changed case, and sometimes one different character.
+			::memcpy(buffer2, text, length * sizeof(wchar_t));
+			for (int i = 0; i < length; i++)
+			{
+				if (nextRandom() % 2)
+					buffer2[i] = (buffer2[i] == L'a') ? L'A' : (buffer2[i] == 0x00E9) ? 0x00C9 : buffer2[i];
+			}
+
+			if (length && (nextRandom() % 2))
+				buffer2[nextRandom() % length] = L'q';
+
+			RFC_TEST_CHECK(KStringKernels::equalsIgnoreCase(text, buffer2, length) == (::_wcsnicmp(text, buffer2, length) == 0));
+
+			::memcpy(expected, text, length * sizeof(wchar_t));
+			::CharUpperBuffW(expected, (DWORD)length);
+			KStringKernels::toUpperCase(text, length);
+			RFC_TEST_CHECK(::memcmp(text, expected, length * sizeof(wchar_t)) == 0);
+
+			::CharLowerBuffW(expected, (DWORD)length);
+			KStringKernels::toLowerCase(text, length);
+			RFC_TEST_CHECK(::memcmp(text, expected, length * sizeof(wchar_t)) == 0);
+		}
+
+		::free(buffer1);
+		::free(buffer2);
+		::free(expected);
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		const KSIMDLevel level = KStringKernels::getSIMDLevel();
+		::printf("simd level: %s\n", (level == KSIMDLevel::AVX2) ? "AVX2" : (level == KSIMDLevel::SSE2) ? "SSE2" : "scalar");
+
+		testKernels();
+
+		// 1M chars of ASCII text. the searched items are at the end.
+		const int length = 1024 * 1024;
+		const int passCount = 20;
+		wchar_t* text = (wchar_t*)::malloc(length * sizeof(wchar_t));
+		for (int i = 0; i < length; i++)
+			text[i] = (wchar_t)(L'a' + (i % 23));
+
+		const wchar_t pattern[] = { L'n', L'e', L'e', L'd', L'l', L'e' };
+		::memcpy(text + length - 6, pattern, sizeof(pattern));
+
+		KPerformanceCounter counter;
+		volatile int sink = 0;
+
+		::printf("1M chars, %d passes:\n", passCount);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = referenceFindChar(text, length, L'z');
+		printBenchmark("findChar, plain loop", counter.endCounter(), length * passCount);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = KStringKernels::findChar(text, length, L'z');
+		printBenchmark("findChar", counter.endCounter(), length * passCount);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = referenceFindString(text, length, pattern, 6);
+		printBenchmark("findString, plain loop", counter.endCounter(), length * passCount);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = KStringKernels::findString(text, length, pattern, 6);
+		printBenchmark("findString", counter.endCounter(), length * passCount);
+		RFC_TEST_CHECK(sink == (length - 6));
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			::CharUpperBuffW(text, (DWORD)length);
+		printBenchmark("CharUpperBuffW", counter.endCounter(), length * passCount);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			KStringKernels::toUpperCase(text, length);
+		printBenchmark("toUpperCase", counter.endCounter(), length * passCount);
+
+		::free(text);
+		return finishTest("StringKernelsTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(StringKernelsTest)
@@ -0,0 +1,27 @@
+// Shared by the test & benchmark programs in this folder.
+
+#pragma once
+
+#include "rfc.h" // generate using build_tests.bat
+#include <stdio.h>
+
+inline int testFailCount = 0;
+
+// prints the failed condition and continues. main returns non zero if any check failed.
+#define RFC_TEST_CHECK(condition) \
+	do { if (!(condition)) { ++testFailCount; ::printf("FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); } } while (0)
+
+inline int finishTest(const char* testName) noexcept
+{
+	::printf("%s: %s\n", testName, (testFailCount == 0) ? "passed" : "FAILED");
+	return (testFailCount == 0) ? 0 : 1;
+}
+
+// milliseconds is the time of the whole run. operationCount is used to print the time per operation.
+inline void printBenchmark(const char* name, double milliseconds, int operationCount = 1) noexcept
+{
+	if (operationCount > 1)
+		::printf("  %-40s %10.3f ms %10.2f ns/op\n", name, milliseconds, (milliseconds * 1000000.0) / operationCount);
+	else
+		::printf("  %-40s %10.3f ms\n", name, milliseconds);
+}
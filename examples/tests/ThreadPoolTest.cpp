@@ -0,0 +1,121 @@
+// Checks that KThreadPool runs every submitted task and parallelFor index, and compares task dispatch with a thread per task.
+
+#include "TestHelpers.h"
+#include <atomic>
+
+class CounterRunnable : public KRunnable
+{
+public:
+	std::atomic<int> runCount{ 0 };
+
+	void run(KThread* thread) noexcept override
+	{
+		runCount.fetch_add(1, std::memory_order_relaxed);
+	}
+};
+
+class ThreadPoolTest : public KApplication
+{
+	void testTasks(KThreadPool& pool) noexcept
+	{
+		std::atomic<int> runCount{ 0 };
+		for (int i = 0; i < 10000; i++)
+		{
+			RFC_TEST_CHECK(pool.submit([&runCount]() { runCount.fetch_add(1, std::memory_order_relaxed); }));
+		}
+
+		// tasks which submit more tasks. (go to the worker's own deque)
+		for (int i = 0; i < 100; i++)
+		{
+			pool.submit([&pool, &runCount]() {
+				for (int j = 0; j < 10; j++)
+					pool.submit([&runCount]() { runCount.fetch_add(1, std::memory_order_relaxed); });
+			});
+		}
+
+		CounterRunnable runnable;
+		for (int i = 0; i < 100; i++)
+			pool.submit(&runnable);
+
+		pool.waitForIdle();
+		RFC_TEST_CHECK(runCount.load() == 11000);
+		RFC_TEST_CHECK(runnable.runCount.load() == 100);
+
+		// a task cannot stop its own pool.
+		std::atomic<int> stopResult{ -1 };
+		pool.submit([&pool, &stopResult]() { stopResult = pool.stop() ? 1 : 0; });
+		pool.waitForIdle();
+		RFC_TEST_CHECK(stopResult.load() == 0);
+		RFC_TEST_CHECK(pool.submit([]() {})); // still running
+		pool.waitForIdle();
+	}
+
+	void testParallelFor(KThreadPool& pool) noexcept
+	{
+		const int count = 1000000;
+		unsigned char* visited = (unsigned char*)::calloc(count, 1);
+
+		pool.parallelFor(0, count, [visited](int index) { visited[index]++; });
+
+		int visitedOnce = 0;
+		for (int i = 0; i < count; i++)
+			visitedOnce += (visited[i] == 1) ? 1 : 0;
+		RFC_TEST_CHECK(visitedOnce == count);
+		::free(visited);
+
+		// nested parallelFor inside the tasks must not starve the pool.
+		std::atomic<int> sum{ 0 };
+		pool.parallelFor(0, 64, [&pool, &sum](int outer) {
+			pool.parallelFor(0, 100, [&sum](int inner) { sum.fetch_add(inner, std::memory_order_relaxed); }, 10);
+		}, 1);
+		RFC_TEST_CHECK(sum.load() == (64 * 4950));
+
+		pool.parallelFor(5, 5, [&sum](int index) { sum = -1; }); // empty range
+		RFC_TEST_CHECK(sum.load() == (64 * 4950));
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		KThreadPool pool;
+		RFC_TEST_CHECK(pool.start());
+		RFC_TEST_CHECK(!pool.start()); // already started
+
+		testTasks(pool);
+		testParallelFor(pool);
+
+		const int taskCount = 2000;
+		std::atomic<int> runCount{ 0 };
+
+		::printf("%d workers, %d empty tasks:\n", pool.getWorkerCount(), taskCount);
+
+		KPerformanceCounter counter;
+		counter.startCounter();
+
+		for (int i = 0; i < taskCount; i++)
+		{
+			KThread thread;
+			thread.onRun = [&runCount](KThread* thread) { runCount.fetch_add(1, std::memory_order_relaxed); };
+			thread.start();
+			thread.waitUntilThreadFinish();
+		}
+
+		printBenchmark("new KThread per task", counter.endCounter(), taskCount);
+
+		counter.startCounter();
+
+		for (int i = 0; i < taskCount; i++)
+			pool.submit([&runCount]() { runCount.fetch_add(1, std::memory_order_relaxed); });
+		pool.waitForIdle();
+
+		printBenchmark("KThreadPool::submit", counter.endCounter(), taskCount);
+		RFC_TEST_CHECK(runCount.load() == (taskCount * 2));
+
+		RFC_TEST_CHECK(pool.stop());
+		RFC_TEST_CHECK(!pool.submit([]() {}));
+
+		return finishTest("ThreadPoolTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(ThreadPoolTest)
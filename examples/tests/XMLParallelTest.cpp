@@ -0,0 +1,222 @@
+// Checks that KXMLReader::parseParallel builds the same tree as parse on random documents, and compares their speed.
+
+#include "TestHelpers.h"
+
+// records every callback, so two trees can be compared as text.
+class RecordElement : public KModelElement
+{
+public:
+	KString record;
+
+	void setAttribute(const wchar_t* name, UINT nameLength, const wchar_t* value, UINT valueLength) noexcept override
+	{
+		record = record + KString(L" @") + KString(name, KStringBehaviour::MAKE_A_COPY, (int)nameLength) +
+			KString(L"=") + KString(value, KStringBehaviour::MAKE_A_COPY, (int)valueLength);
+	}
+
+	void setContent(const wchar_t* content, UINT length) noexcept override
+	{
+		record = record + KString(L" #") + KString(content, KStringBehaviour::MAKE_A_COPY, (int)length);
+	}
+};
+
+// createElement is thread safe. so the factory can be used by parseParallel.
+class RecordElementFactory : public KModelElementFactory
+{
+public:
+	KModelElement* createModelElement(const wchar_t* elementName, UINT length) noexcept override
+	{
+		RecordElement* element = createElement<RecordElement>();
+		if (element)
+			element->record = KString(elementName, KStringBehaviour::MAKE_A_COPY, (int)length);
+
+		return element;
+	}
+};
+
+class XMLParallelTest : public KApplication
+{
+	unsigned int randomState = 12345;
+
+	unsigned int nextRandom() noexcept
+	{
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return randomState;
+	}
+
+	static void appendText(KBufferWriteStream& stream, const char* text) noexcept
+	{
+		stream.writeStream((const BYTE*)text, (DWORD)::strlen(text));
+	}
+
+	static void appendInt(KBufferWriteStream& stream, unsigned int value) noexcept
+	{
+		char text[16];
+		::sprintf(text, "%u", value);
+		appendText(stream, text);
+	}
+
+	// nested elements with attributes, text, entities, comments & CDATA.
+	void appendElement(KBufferWriteStream& stream, int depth) noexcept
+	{
+		static const char* names[] = { "item", "group", "ns:value", "Label" };
+		const char* name = names[nextRandom() % 4];
+
+		appendText(stream, "<");
+		appendText(stream, name);
+
+		const int attributeCount = nextRandom() % 3;
+		for (int i = 0; i < attributeCount; i++)
+		{
+			appendText(stream, (i == 0) ? " id=\"" : " key='");
+			appendInt(stream, nextRandom() % 1000);
+			appendText(stream, (nextRandom() % 4) ? "" : "&amp;&#x41;");
+			appendText(stream, (i == 0) ? "\"" : "'");
+		}
+
+		if ((depth > 4) || ((nextRandom() % 3) == 0))
+		{
+			appendText(stream, "/>");
+			return;
+		}
+
+		appendText(stream, ">");
+
+		const int childCount = nextRandom() % 4;
+		for (int i = 0; i < childCount; i++)
+		{
+			switch (nextRandom() % 5)
+			{
+			case 0:
+				appendText(stream, "text &lt;");
+				appendInt(stream, nextRandom() % 100);
+				appendText(stream, "&gt;");
+				break;
+			case 1:
+				appendText(stream, "<!-- comment <a> -->");
+				break;
+			case 2:
+				appendText(stream, "<![CDATA[ <raw> & ]]>");
+				break;
+			default:
+				appendElement(stream, depth + 1);
+			}
+		}
+
+		appendText(stream, "</");
+		appendText(stream, name);
+		appendText(stream, ">");
+	}
+
+	void createDocument(KBufferWriteStream& stream, int topLevelCount) noexcept
+	{
+		appendText(stream, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<root version='2'>\n");
+
+		for (int i = 0; i < topLevelCount; i++)
+		{
+			appendElement(stream, 1);
+			appendText(stream, (nextRandom() % 2) ? "\n  " : " tail text "); // text between the top level children
+		}
+
+		appendText(stream, "</root>");
+	}
+
+	// depth, record & the links of every element in document order.
+	static KString serialize(KModelElement* root) noexcept
+	{
+		KStringBuilder builder;
+
+		for (KModelElement* element = root; element; element = element->getNextElement(root))
+		{
+			int depth = 0;
+			for (KModelElement* parent = element->parent; parent; parent = parent->parent)
+				++depth;
+
+			const bool linksValid = ((element->next == nullptr) || (element->next->prev == element)) &&
+				((element->firstChild == nullptr) || (element->firstChild->parent == element)) &&
+				((element->next == nullptr) || (element->next->parent == element->parent));
+
+			builder.appendInt(depth);
+			builder.append(linksValid ? L" " : L" BROKEN LINKS ");
+			builder.append(((RecordElement*)element)->record);
+			builder.appendChar(L'\n');
+		}
+
+		return builder.toString();
+	}
+
+	void testEquivalence(KThreadPool& pool) noexcept
+	{
+		RecordElementFactory factory;
+		KXMLReader reader;
+		KModelDocument document;
+
+		for (int round = 0; round < 200; round++)
+		{
+			KBufferWriteStream stream;
+			createDocument(stream, 1 + (nextRandom() % 60));
+			RFC_TEST_CHECK(reader.loadFromData(stream.data(), stream.dataSize()));
+
+			KModelElement* serialRoot = reader.parse(&factory);
+			const KString expected = serialize(serialRoot);
+			delete serialRoot;
+
+			KModelElement* parallelRoot = reader.parseParallel(&factory, &pool);
+			RFC_TEST_CHECK(serialize(parallelRoot) == expected);
+			delete parallelRoot;
+
+			RFC_TEST_CHECK(reader.parseParallel(&factory, &pool, &document));
+			RFC_TEST_CHECK(serialize(document.getRootElement()) == expected);
+
+			RFC_TEST_CHECK(reader.parse(&factory, &document));
+			RFC_TEST_CHECK(serialize(document.getRootElement()) == expected);
+		}
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		KThreadPool pool;
+		pool.start();
+		testEquivalence(pool);
+		pool.stop();
+
+		KBufferWriteStream stream;
+		createDocument(stream, 200000);
+
+		RecordElementFactory factory;
+		KXMLReader reader;
+		reader.loadFromData(stream.data(), stream.dataSize());
+
+		::printf("%.1f MB document with 200k top level items:\n", stream.dataSize() / (1024.0 * 1024.0));
+
+		KPerformanceCounter counter;
+		KModelDocument document;
+
+		counter.startCounter();
+		RFC_TEST_CHECK(reader.parse(&factory, &document));
+		printBenchmark("parse into document", counter.endCounter());
+
+		// parseParallel against the same document at each worker count.
+		for (int workerCount = 1; workerCount <= 8; workerCount++)
+		{
+			RFC_TEST_CHECK(pool.start(workerCount));
+			RFC_TEST_CHECK(pool.getWorkerCount() == workerCount);
+
+			char name[64];
+			::sprintf(name, "parseParallel into document, %d workers", workerCount);
+
+			counter.startCounter();
+			RFC_TEST_CHECK(reader.parseParallel(&factory, &pool, &document));
+			printBenchmark(name, counter.endCounter());
+
+			pool.stop();
+		}
+
+		return finishTest("XMLParallelTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(XMLParallelTest)
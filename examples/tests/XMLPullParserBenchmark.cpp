@@ -0,0 +1,257 @@
+/*
+	Measures KXMLPullParser on a large generated document (400k items, about 76 MB of UTF-8).
+	Only needs the parser header, so it builds on any platform. On Windows the same document is also read with XmlLite,
+	the reader KXMLReader used before, and the element & attribute counts are compared.
+
+	g++ -std=c++17 -O2 -Wall -Wextra XMLPullParserBenchmark.cpp -o XMLPullParserBenchmark
+	cl /nologo /O2 /std:c++17 XMLPullParserBenchmark.cpp
+*/
+
+#include "../../rfc/xml/KXMLPullParser.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <xmllite.h>
+	#include <shlwapi.h>
+	#pragma comment(lib, "xmllite.lib")
+	#pragma comment(lib, "shlwapi.lib")
+#else
+	#include <time.h>
+#endif
+
+static int failCount = 0;
+
+#define BENCHMARK_CHECK(condition) \
+	do { if (!(condition)) { ++failCount; ::printf("FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); } } while (0)
+
+static double getMilliseconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	::QueryPerformanceCounter(&counter);
+	::QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+	timespec time;
+	::clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec * 1000.0 + (double)time.tv_nsec / 1000000.0;
+#endif
+}
+
+static void printBenchmark(const char* name, double milliseconds, size_t byteCount)
+{
+	::printf("  %-40s %10.1f ms %8.1f MB/s\n", name, milliseconds, ((double)byteCount / (1024.0 * 1024.0)) / (milliseconds / 1000.0));
+}
+
+struct Counts
+{
+	size_t elementCount = 0;
+	size_t attributeCount = 0;
+	size_t textLength = 0; // code units, or code points after decoding. whitespace only text is not counted
+};
+
+enum { ItemCount = 400000 };
+
+// each item has 4 elements & 5 attributes, entity references and a non-ASCII character.
+static char* generateDocument(size_t* length)
+{
+	const size_t capacity = (size_t)ItemCount * 256;
+	char* document = (char*)::malloc(capacity);
+	size_t size = (size_t)::sprintf(document, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<root>\n");
+
+	for (int i = 0; i < ItemCount; i++)
+	{
+		size += (size_t)::sprintf(document + size,
+			"  <item id=\"%d\" type=\"widget\" name=\"Item &amp; %d\">\n"
+			"    <title>Title number %d \xC3\xA9</title>\n"
+			"    <desc>Some description text &lt;b&gt; here</desc>\n"
+			"    <pos x=\"%d\" y=\"%d\"/>\n"
+			"  </item>\n", i, i, i, i * 3, i * 7);
+	}
+
+	size += (size_t)::sprintf(document + size, "</root>\n");
+	*length = size;
+	return document;
+}
+
+// the generated document only has ASCII & 2 byte UTF-8 sequences, so each code point is one UTF-16 unit.
+static char16_t* toUTF16(const char* document, size_t length, size_t* utf16Length)
+{
+	char16_t* result = (char16_t*)::malloc(length * sizeof(char16_t));
+	size_t index = 0, size = 0;
+
+	while (index < length)
+	{
+		unsigned int codePoint = 0;
+		index += KXMLPullParser<char>::readCodePoint(document + index, length - index, &codePoint);
+		result[size++] = (char16_t)codePoint;
+	}
+
+	*utf16Length = size;
+	return result;
+}
+
+template<typename CharT>
+static size_t decodedLength(const KXMLSlice<CharT>& slice)
+{
+	size_t index = 0, count = 0;
+	while (index < slice.length)
+	{
+		unsigned int codePoint = 0;
+		size_t used = 0;
+
+		if (slice.text[index] == '&')
+			used = KXMLPullParser<CharT>::readEntity(slice.text + index, slice.length - index, &codePoint);
+
+		if (used == 0)
+			used = KXMLPullParser<CharT>::readCodePoint(slice.text + index, slice.length - index, &codePoint);
+
+		index += used;
+		++count;
+	}
+	return count;
+}
+
+// visits every element, attribute & text. decode also converts the entities & code points, like KXMLReader does.
+template<typename CharT>
+static Counts pullParse(const CharT* document, size_t length, bool decode)
+{
+	KXMLPullParser<CharT> parser(document, length);
+	KXMLSlice<CharT> attributeName, attributeValue;
+	Counts counts;
+	KXMLToken token;
+
+	while ((token = parser.next()) != KXMLToken::EndOfDocument)
+	{
+		if (token == KXMLToken::Error)
+		{
+			BENCHMARK_CHECK(token != KXMLToken::Error);
+			break;
+		}
+
+		if (token == KXMLToken::StartElement)
+		{
+			++counts.elementCount;
+			while (parser.nextAttribute(&attributeName, &attributeValue))
+			{
+				++counts.attributeCount;
+				counts.textLength += decode ? decodedLength(attributeValue) : attributeValue.length;
+			}
+		}
+		else if (token == KXMLToken::Text)
+		{
+			counts.textLength += decode ? decodedLength(parser.getText()) : parser.getText().length;
+		}
+	}
+
+	return counts;
+}
+
+#ifdef _WIN32
+
+// the path KXMLReader::loadFromString took before: copy into a memory stream and read it through IXmlReader.
+static Counts xmlLiteParse(const char* document, size_t length)
+{
+	Counts counts;
+	IStream* stream = ::SHCreateMemStream((const BYTE*)document, (UINT)length);
+	IXmlReader* reader = nullptr;
+
+	if ((stream == nullptr) || FAILED(::CreateXmlReader(__uuidof(IXmlReader), (void**)&reader, nullptr)))
+	{
+		BENCHMARK_CHECK(false);
+		if (stream)
+			stream->Release();
+		return counts;
+	}
+
+	reader->SetProperty(XmlReaderProperty_DtdProcessing, DtdProcessing_Prohibit);
+	reader->SetInput(stream);
+
+	XmlNodeType nodeType;
+	const WCHAR* value;
+	UINT valueLength;
+
+	while (reader->Read(&nodeType) == S_OK)
+	{
+		if (nodeType == XmlNodeType_Element)
+		{
+			++counts.elementCount;
+			HRESULT result = reader->MoveToFirstAttribute();
+			while (result == S_OK)
+			{
+				++counts.attributeCount;
+				reader->GetValue(&value, &valueLength);
+				counts.textLength += valueLength;
+				result = reader->MoveToNextAttribute();
+			}
+		}
+		else if ((nodeType == XmlNodeType_Text) || (nodeType == XmlNodeType_CDATA))
+		{
+			reader->GetValue(&value, &valueLength);
+			counts.textLength += valueLength;
+		}
+	}
+
+	reader->Release();
+	stream->Release();
+	return counts;
+}
+
+#endif
+
+int main()
+{
+	size_t length = 0;
+	char* document = generateDocument(&length);
+
+	size_t utf16Length = 0;
+	char16_t* utf16Document = toUTF16(document, length, &utf16Length);
+
+	const size_t expectedElements = 1 + (size_t)ItemCount * 4;
+	const size_t expectedAttributes = (size_t)ItemCount * 5;
+
+	::printf("%.1f MB document, %zu elements, %zu attributes:\n", (double)length / (1024.0 * 1024.0), expectedElements, expectedAttributes);
+
+	// 3 runs. the first one also pages in the buffers.
+	for (int run = 0; run < 3; run++)
+	{
+		double start = getMilliseconds();
+		const Counts utf8Counts = pullParse(document, length, false);
+		printBenchmark("KXMLPullParser<char>", getMilliseconds() - start, length);
+
+		start = getMilliseconds();
+		const Counts decodedCounts = pullParse(document, length, true);
+		printBenchmark("KXMLPullParser<char>, decoded", getMilliseconds() - start, length);
+
+		start = getMilliseconds();
+		const Counts utf16Counts = pullParse(utf16Document, utf16Length, false);
+		printBenchmark("KXMLPullParser<char16_t>", getMilliseconds() - start, utf16Length * sizeof(char16_t));
+
+		BENCHMARK_CHECK((utf8Counts.elementCount == expectedElements) && (utf8Counts.attributeCount == expectedAttributes));
+		BENCHMARK_CHECK((decodedCounts.elementCount == expectedElements) && (decodedCounts.attributeCount == expectedAttributes));
+		BENCHMARK_CHECK((utf16Counts.elementCount == expectedElements) && (utf16Counts.attributeCount == expectedAttributes));
+		BENCHMARK_CHECK(decodedCounts.textLength < utf8Counts.textLength); // entities & the 2 byte character got shorter
+		BENCHMARK_CHECK(decodedCounts.textLength < utf16Counts.textLength); // only the entities
+
+	#ifdef _WIN32
+		start = getMilliseconds();
+		const Counts xmlLiteCounts = xmlLiteParse(document, length);
+		printBenchmark("XmlLite IXmlReader", getMilliseconds() - start, length);
+
+		BENCHMARK_CHECK((xmlLiteCounts.elementCount == expectedElements) && (xmlLiteCounts.attributeCount == expectedAttributes));
+		BENCHMARK_CHECK(xmlLiteCounts.textLength == decodedCounts.textLength); // all BMP, so UTF-16 units == code points
+	#endif
+	}
+
+	::free(utf16Document);
+	::free(document);
+
+	if (failCount == 0)
+		::printf("XMLPullParserBenchmark: passed\n");
+	else
+		::printf("XMLPullParserBenchmark: %d checks failed\n", failCount);
+
+	return (failCount == 0) ? 0 : 1;
+}
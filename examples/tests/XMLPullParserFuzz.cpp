@@ -0,0 +1,224 @@
+/*
+	Fuzz target for KXMLPullParser. Only needs the parser header, so it builds on any platform.
+	Each input is parsed as UTF-8, UTF-16 and UTF-32, as a document and as a fragment. Every returned slice must lie
+	inside the input and the parser must finish within a bounded number of tokens.
+
+	libFuzzer:	clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -DRFC_LIBFUZZER XMLPullParserFuzz.cpp
+	standalone:	g++ -std=c++17 -g -O1 -fsanitize=address,undefined XMLPullParserFuzz.cpp && ./a.out [iterations]
+				(mutates built-in seed documents. cl /O2 /std:c++17 XMLPullParserFuzz.cpp also works)
+*/
+
+#include "../../rfc/xml/KXMLPullParser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// fuzzers need a crash to report a failure.
+#define FUZZ_CHECK(condition) \
+	do { if (!(condition)) { ::printf("FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); ::abort(); } } while (0)
+
+template<typename CharT>
+static void checkSlice(const KXMLSlice<CharT>& slice, const CharT* buffer, size_t length)
+{
+	FUZZ_CHECK((slice.text >= buffer) && (slice.length <= length) && ((size_t)(slice.text - buffer) <= (length - slice.length)));
+}
+
+// walks the text like KXMLReader does when it converts names & values.
+template<typename CharT>
+static void decodeText(const KXMLSlice<CharT>& slice)
+{
+	size_t index = 0;
+	while (index < slice.length)
+	{
+		unsigned int codePoint = 0;
+		size_t used = 0;
+
+		if (slice.text[index] == '&')
+			used = KXMLPullParser<CharT>::readEntity(slice.text + index, slice.length - index, &codePoint);
+
+		if (used == 0)
+			used = KXMLPullParser<CharT>::readCodePoint(slice.text + index, slice.length - index, &codePoint);
+
+		FUZZ_CHECK((used >= 1) && (used <= (slice.length - index)) && (codePoint <= 0x10FFFF));
+		index += used;
+	}
+}
+
+// control selects between reading the attributes and skipping the element, so both paths are covered.
+template<typename CharT>
+static void parse(const CharT* buffer, size_t length, bool fragment, unsigned int control)
+{
+	KXMLPullParser<CharT> parser(buffer, length, fragment);
+	KXMLSlice<CharT> attributeName, attributeValue;
+	KXMLToken token;
+	size_t tokenCount = 0;
+
+	while (((token = parser.next()) != KXMLToken::EndOfDocument) && (token != KXMLToken::Error))
+	{
+		FUZZ_CHECK(++tokenCount <= (length + 1)); // every token consumes input
+		FUZZ_CHECK(parser.getPosition(buffer) <= length);
+		FUZZ_CHECK(parser.getDepth() >= 0);
+
+		if (token == KXMLToken::StartElement)
+		{
+			checkSlice(parser.getName(), buffer, length);
+			checkSlice(KXMLPullParser<CharT>::getLocalName(parser.getName()), buffer, length);
+			FUZZ_CHECK(parser.getTokenStart(buffer) < length);
+
+			control = (control >> 1) | (control << 31);
+			if (control & 1)
+			{
+				parser.skipElement();
+				continue;
+			}
+
+			while (parser.nextAttribute(&attributeName, &attributeValue))
+			{
+				checkSlice(attributeName, buffer, length);
+				checkSlice(attributeValue, buffer, length);
+				decodeText(attributeValue);
+			}
+		}
+		else if (token == KXMLToken::EndElement)
+		{
+			checkSlice(parser.getName(), buffer, length);
+		}
+		else if (token == KXMLToken::Text)
+		{
+			checkSlice(parser.getText(), buffer, length);
+			decodeText(parser.getText());
+		}
+	}
+
+	FUZZ_CHECK(parser.next() == token); // stays at the end
+}
+
+// copies into an exact size heap buffer, so the sanitizer catches any read past the end.
+template<typename CharT>
+static void parseAs(const uint8_t* data, size_t size)
+{
+	const size_t length = size / sizeof(CharT);
+	CharT* buffer = (CharT*)::calloc(length ? length : 1, sizeof(CharT));
+	if (length)
+		::memcpy(buffer, data, length * sizeof(CharT));
+
+	const unsigned int control = (size > 0) ? (0x9E3779B9u * data[0]) : 0;
+	parse<CharT>(buffer, length, false, control);
+	parse<CharT>(buffer, length, true, ~control);
+
+	::free(buffer);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	parseAs<char>(data, size);
+	parseAs<char16_t>(data, size);
+	parseAs<char32_t>(data, size);
+	return 0;
+}
+
+#ifndef RFC_LIBFUZZER
+
+static const char* seeds[] = {
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<root a=\"1\" b='2'><item id=\"x\">text &amp; &#x263A; &#65;</item><empty/></root>",
+	"<!DOCTYPE root [<!ELEMENT root ANY><!ENTITY e \"<x>\">]><root><!-- comment --><?pi data?><![CDATA[<not a tag>]]></root>",
+	"<ns:root xmlns:ns=\"urn:x\"><ns:child ns:attr=\"&lt;&gt;&quot;&apos;\">\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80</ns:child></ns:root>",
+	"<a><b><c><d><e attr = \" spaced \"/></d></c></b></a>",
+	"text before <first/> middle <second x='y'>inner</second> after",
+	"<root>\r\n\t<line>one\r\ntwo</line>\r\n</root>",
+};
+
+static uint32_t randomState = 12345;
+
+static uint32_t nextRandom()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+// applies a few random edits. interesting characters are inserted more often than random bytes.
+static size_t mutate(uint8_t* data, size_t size, size_t capacity)
+{
+	static const char special[] = "<>/=\"'&;#x![]?- \n:";
+	const int editCount = 1 + (int)(nextRandom() % 8);
+
+	for (int edit = 0; edit < editCount; edit++)
+	{
+		const size_t position = size ? (nextRandom() % size) : 0;
+
+		switch (nextRandom() % 6)
+		{
+		case 0: // flip a bit
+			if (size)
+				data[position] ^= (uint8_t)(1 << (nextRandom() % 8));
+			break;
+		case 1: // insert a special or random byte
+		case 2:
+			if (size < capacity)
+			{
+				::memmove(data + position + 1, data + position, size - position);
+				data[position] = (nextRandom() & 1) ? (uint8_t)special[nextRandom() % (sizeof(special) - 1)] : (uint8_t)nextRandom();
+				++size;
+			}
+			break;
+		case 3: // delete a range
+			if (size)
+			{
+				const size_t count = 1 + (nextRandom() % ((size - position) < 8 ? (size - position) : 8));
+				::memmove(data + position, data + position + count, size - position - count);
+				size -= count;
+			}
+			break;
+		case 4: // duplicate a range
+			if (size)
+			{
+				const size_t count = 1 + (nextRandom() % ((size - position) < 32 ? (size - position) : 32));
+				if ((size + count) <= capacity)
+				{
+					::memmove(data + position + count, data + position, size - position);
+					size += count;
+				}
+			}
+			break;
+		default: // truncate
+			size = position;
+			break;
+		}
+	}
+
+	return size;
+}
+
+int main(int argc, char** argv)
+{
+	const long iterations = (argc > 1) ? ::atol(argv[1]) : 300000;
+	const size_t seedCount = sizeof(seeds) / sizeof(seeds[0]);
+	const size_t capacity = 4096;
+	uint8_t* data = (uint8_t*)::malloc(capacity);
+
+	for (size_t i = 0; i < seedCount; i++)
+		LLVMFuzzerTestOneInput((const uint8_t*)seeds[i], ::strlen(seeds[i]));
+
+	for (long i = 0; i < iterations; i++)
+	{
+		const char* seed = seeds[nextRandom() % seedCount];
+		size_t size = ::strlen(seed);
+		::memcpy(data, seed, size);
+
+		// some inputs get more edits on top of the previous ones
+		do
+		{
+			size = mutate(data, size, capacity);
+		} while ((nextRandom() % 4) == 0);
+
+		LLVMFuzzerTestOneInput(data, size);
+	}
+
+	::free(data);
+	::printf("XMLPullParserFuzz: %ld inputs, passed\n", iterations + (long)seedCount);
+	return 0;
+}
+
+#endif
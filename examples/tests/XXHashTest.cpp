@@ -0,0 +1,142 @@
+// Checks KXXHash64 & KXXHash3 against the vectors of the reference xxhash 0.8 library, and measures their throughput.
+
+#include "TestHelpers.h"
+
+struct XXHashVector
+{
+	size_t length;
+	uint64_t seed;
+	uint64_t xxh64;
+	uint64_t xxh3;
+	uint64_t xxh3Low; // 128 bit
+	uint64_t xxh3High;
+};
+
+class XXHashTest : public KApplication
+{
+	enum { InputSize = 5000 };
+	unsigned char input[InputSize];
+
+	// lengths cover the 0, 1-3, 4-8, 9-16, 17-128, 129-240 & long (stripe) code paths.
+	void testVectors() noexcept
+	{
+		static const XXHashVector vectors[] = {
+		{ 0, 0x0000000000000000ULL, 0xEF46DB3751D8E999ULL, 0x2D06800538D394C2ULL, 0x6001C324468D497FULL, 0x99AA06D3014798D8ULL },
+		{ 1, 0x0000000000000000ULL, 0xA96C7F0CE858BBB7ULL, 0x4C5CCA45D0F4811FULL, 0x4C5CCA45D0F4811FULL, 0x495B62073EF70CA4ULL },
+		{ 3, 0x0000000000000000ULL, 0xBED43740EE6332BBULL, 0x6E3E2670E61106ACULL, 0x6E3E2670E61106ACULL, 0x390CDC5B4A895DD7ULL },
+		{ 4, 0x0000000000000000ULL, 0xFA212AE44B3BB23DULL, 0x5C4C63133443D03FULL, 0x3D668AF6F2A44D77ULL, 0xAA6E2F274640A3F4ULL },
+		{ 8, 0x0000000000000000ULL, 0x994B676B71CE94DDULL, 0xF9FD4DD0B04D78F5ULL, 0x61DDBE7F31A6100DULL, 0x6A86A3BDA6AF4E3DULL },
+		{ 9, 0x0000000000000000ULL, 0x572B84C18B983AF8ULL, 0x7C20DF9712C26EDFULL, 0x8C7B67FD458A936BULL, 0x664C7CA18AFD6255ULL },
+		{ 16, 0x0000000000000000ULL, 0x94AD0095E72B24D5ULL, 0x86ABF6BACCEA0858ULL, 0xE2CE54A7C19C730DULL, 0x7F9A218B0425449AULL },
+		{ 17, 0x0000000000000000ULL, 0x1464F2EFF23B5FE1ULL, 0xB58BF5DC5022D071ULL, 0x8D96EF110FCDEBB4ULL, 0x66FC23F6439DBD77ULL },
+		{ 128, 0x0000000000000000ULL, 0x0430E433B792E757ULL, 0x10D17F72C0CCBA41ULL, 0xFF361DEC1385710AULL, 0xAEC730751478556CULL },
+		{ 129, 0x0000000000000000ULL, 0x1F9708E5A00618FAULL, 0x1648BDC3DB49D1A2ULL, 0x4545B3A09738E31AULL, 0x98CD36CCBB557926ULL },
+		{ 240, 0x0000000000000000ULL, 0xCA0B65CC61295CA7ULL, 0xB6CFAF343FAB81E6ULL, 0x3F2C53E72293711FULL, 0x5293E17BF553903DULL },
+		{ 241, 0x0000000000000000ULL, 0x0FFEFE0DFC875CF4ULL, 0x956CAE592C67279EULL, 0x956CAE592C67279EULL, 0xB53840FE3FEDF161ULL },
+		{ 1024, 0x0000000000000000ULL, 0x5960AF0C625ACFB7ULL, 0x70BD377D9574F4BBULL, 0x70BD377D9574F4BBULL, 0xF69630613F24324DULL },
+		{ 4999, 0x0000000000000000ULL, 0x679472BDCAB7FF53ULL, 0xC3AF6109DAA0965BULL, 0xC3AF6109DAA0965BULL, 0x87E70B4EA9C61EDBULL },
+		{ 0, 0x9E3779B97F4A7C15ULL, 0xC4349FC93C010000ULL, 0x602B0E2CD6662C8BULL, 0x4CA5176998171787ULL, 0xD142977A2CCA554BULL },
+		{ 1, 0x9E3779B97F4A7C15ULL, 0x585882422A6165E7ULL, 0x2F3ACD3805F81DE3ULL, 0x2F3ACD3805F81DE3ULL, 0x00A711EB5A736B26ULL },
+		{ 3, 0x9E3779B97F4A7C15ULL, 0x45FA1406538FA168ULL, 0xBC74611D87F659E0ULL, 0xBC74611D87F659E0ULL, 0x3F5FD00FF400BA58ULL },
+		{ 4, 0x9E3779B97F4A7C15ULL, 0xA65107F22943365AULL, 0x6C3753177C607DE4ULL, 0xC63AF37DA30D5D08ULL, 0x7E5D191BD8D354E6ULL },
+		{ 8, 0x9E3779B97F4A7C15ULL, 0xCE592D5F53E192ECULL, 0xBC72D0531396303FULL, 0x8A88691D5CECB7B6ULL, 0x9B51BCD70BE038F6ULL },
+		{ 9, 0x9E3779B97F4A7C15ULL, 0x5495AA796DE8AB73ULL, 0x93C5AA006102DAF5ULL, 0xA1E691E73AAF9CA5ULL, 0xC0DD1F12F479931BULL },
+		{ 16, 0x9E3779B97F4A7C15ULL, 0x3F8FEA7C86A04013ULL, 0x69D001B16ECF450AULL, 0x1097F793402C818AULL, 0xD5F6FDBF62CDC681ULL },
+		{ 17, 0x9E3779B97F4A7C15ULL, 0xE5044D205F3D2F74ULL, 0xB7C99D19BE27EB69ULL, 0x553306F0D043114CULL, 0xFDB93EA9BD7C5A87ULL },
+		{ 128, 0x9E3779B97F4A7C15ULL, 0xA17EF243CE1FF792ULL, 0x49B81C6E0ABB9305ULL, 0x18528564127001A4ULL, 0x98B7168A26969C36ULL },
+		{ 129, 0x9E3779B97F4A7C15ULL, 0xB5D711B6226E05B6ULL, 0x5E3831B221810B00ULL, 0x54E9357C883CEC48ULL, 0x03159DBF8591C495ULL },
+		{ 240, 0x9E3779B97F4A7C15ULL, 0x85E504429B241D4FULL, 0x76A73EC26433F82CULL, 0xFCAC543705C8C541ULL, 0xDE30C63EE85A3579ULL },
+		{ 241, 0x9E3779B97F4A7C15ULL, 0x537B9610B2F8022DULL, 0x2BE236BA3BACF75CULL, 0x2BE236BA3BACF75CULL, 0x7BE6397A1DFD48CCULL },
+		{ 1024, 0x9E3779B97F4A7C15ULL, 0xFE426926C35C85AAULL, 0xD8CF6B464541F232ULL, 0xD8CF6B464541F232ULL, 0xA888BFDF08883F70ULL },
+		{ 4999, 0x9E3779B97F4A7C15ULL, 0x5E1A01995625EFDEULL, 0x6DF2995FA7BD1D25ULL, 0x6DF2995FA7BD1D25ULL, 0xCC51EBEADAE08B5AULL },
+		};
+
+		for (size_t i = 0; i < (sizeof(vectors) / sizeof(vectors[0])); i++)
+		{
+			const XXHashVector& vector = vectors[i];
+
+			RFC_TEST_CHECK(KXXHash64::hash(input, vector.length, vector.seed) == vector.xxh64);
+			RFC_TEST_CHECK(KHash::hash64(input, vector.length, vector.seed) == vector.xxh64);
+
+			// streaming with uneven chunks.
+			KXXHash64 hasher(vector.seed);
+			for (size_t offset = 0; offset < vector.length; offset += 7)
+				hasher.add(input + offset, ((vector.length - offset) < 7) ? (vector.length - offset) : 7);
+			RFC_TEST_CHECK(hasher.hash() == vector.xxh64);
+
+			RFC_TEST_CHECK(KXXHash3::hash64(input, vector.length, vector.seed) == vector.xxh3);
+
+			const KHash128 hash128 = KXXHash3::hash128(input, vector.length, vector.seed);
+			RFC_TEST_CHECK((hash128.low == vector.xxh3Low) && (hash128.high == vector.xxh3High));
+		}
+
+		// batch with the same seed.
+		const void* inputs[14];
+		size_t lengths[14];
+		uint64_t results[14];
+		for (int i = 0; i < 14; i++)
+		{
+			inputs[i] = input;
+			lengths[i] = vectors[i].length;
+		}
+
+		KXXHash3::hash64Batch(inputs, lengths, results, 14, vectors[0].seed);
+		for (int i = 0; i < 14; i++)
+			RFC_TEST_CHECK(results[i] == vectors[i].xxh3);
+	}
+
+	static void printThroughput(const char* name, double milliseconds, double totalBytes) noexcept
+	{
+		::printf("  %-40s %10.3f ms %8.2f GB/s\n", name, milliseconds, totalBytes / (milliseconds * 1000000.0));
+	}
+
+public:
+	int main(wchar_t** argv, int argc)
+	{
+		for (int i = 0; i < InputSize; i++)
+			input[i] = (unsigned char)(i * 131 + 7);
+
+		testVectors();
+
+		const KSIMDLevel level = KStringKernels::getSIMDLevel();
+		::printf("simd level: %s\n", (level == KSIMDLevel::AVX2) ? "AVX2" : (level == KSIMDLevel::SSE2) ? "SSE2" : "scalar");
+
+		// 64 KB stays in the cache. so the numbers show the hashing speed, not the memory speed.
+		const size_t bufferSize = 64 * 1024;
+		const int passCount = 20000;
+		const double totalBytes = (double)bufferSize * passCount;
+		unsigned char* buffer = (unsigned char*)::malloc(bufferSize);
+		for (size_t i = 0; i < bufferSize; i++)
+			buffer[i] = (unsigned char)(i * 7);
+
+		KPerformanceCounter counter;
+		volatile uint64_t sink = 0;
+
+		::printf("64 KB buffer, %d passes:\n", passCount);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = KXXHash32::hash(buffer, bufferSize, pass);
+		printThroughput("KXXHash32", counter.endCounter(), totalBytes);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = KXXHash64::hash(buffer, bufferSize, pass);
+		printThroughput("KXXHash64", counter.endCounter(), totalBytes);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = KXXHash3::hash64(buffer, bufferSize, pass);
+		printThroughput("KXXHash3::hash64", counter.endCounter(), totalBytes);
+
+		counter.startCounter();
+		for (int pass = 0; pass < passCount; pass++)
+			sink = KXXHash3::hash128(buffer, bufferSize, pass).low;
+		printThroughput("KXXHash3::hash128", counter.endCounter(), totalBytes);
+
+		::free(buffer);
+		return finishTest("XXHashTest");
+	}
+};
+
+START_RFC_CONSOLE_APP_NO_CMD_ARGS(XXHashTest)
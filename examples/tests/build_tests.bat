@@ -0,0 +1,28 @@
+@echo off
+rem builds and runs the test programs. run from a Visual Studio developer command prompt.
+
+..\..\rfc\Generator-CLI.exe -r ..\..\rfc -m containers,thread,file,xml,security,utils -o . || exit /b 1
+cl.exe /nologo /c /O2 /D "UNICODE" /D "_UNICODE" /std:c++17 rfc.cpp || exit /b 1
+
+call :run ContainerGrowthTest || exit /b 1
+call :run ContainerIterationTest || exit /b 1
+call :run ContentionTest || exit /b 1
+call :run PointerQueueTest || exit /b 1
+call :run ThreadPoolTest || exit /b 1
+call :run StringKernelsTest || exit /b 1
+call :run HashMapTest || exit /b 1
+call :run BufferStreamTest || exit /b 1
+call :run BufferedStreamTest || exit /b 1
+call :run AsyncFileTest || exit /b 1
+call :run PropertyStorageTest || exit /b 1
+call :run XMLParallelTest || exit /b 1
+call :run ModelQueryTest || exit /b 1
+call :run XXHashTest || exit /b 1
+
+echo all tests passed
+exit /b 0
+
+:run
+cl.exe /nologo /O2 /D "UNICODE" /D "_UNICODE" /std:c++17 %1.cpp rfc.obj /Fe:%1.exe || exit /b 1
+%1.exe
+exit /b %errorlevel%
@@ -23,6 +23,7 @@
 
 #include "KPointerList.h"
 #include "KVector.h"
+#include "KHashMap.h"
 #include "KPointerQueue.h"
 #include "KScopedClassPointer.h"
 #include "KScopedComPointer.h"
@@ -32,7 +33,9 @@
 #include "KScopedMemory.h"
 #include "KScopedStructPointer.h"
 #include "KStaticAllocator.h"
+#include "KArena.h"
 #include "KFixedStack.h"
 #include "KProperty.h"
 #include "KFixedQueue.h"
+#include "KLockFreeQueue.h"
 #include "KReleaseTypes.h"
\ No newline at end of file
@@ -0,0 +1,220 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KArena.h"
+
+// heap chunks double in size each time up to this limit.
+#define RFC_ARENA_MAX_GROWTH_SIZE (16 * 1024 * 1024)
+
+KArena::KArena(size_t chunkSize, void* initialBuffer, size_t initialBufferSize) noexcept
+{
+	defaultChunkSize = (chunkSize < 256) ? 256 : chunkSize;
+	destructorList = nullptr;
+
+	if (initialBuffer && initialBufferSize)
+	{
+		initialChunk.next = nullptr;
+		initialChunk.data = (char*)initialBuffer;
+		initialChunk.size = initialBufferSize;
+		initialChunk.used = 0;
+		initialChunk.ownedByArena = false;
+
+		firstChunk = &initialChunk;
+		currentChunk = &initialChunk;
+	}
+	else
+	{
+		firstChunk = nullptr;
+		currentChunk = nullptr;
+	}
+}
+
+void* KArena::allocateSlow(size_t size, size_t alignment) noexcept
+{
+	// try the chunks kept from before rewind/reset.
+	while (currentChunk && currentChunk->next)
+	{
+		currentChunk = currentChunk->next;
+		currentChunk->used = 0;
+
+		void* memory = allocateFromChunk(currentChunk, size, alignment);
+		if (memory)
+			return memory;
+	}
+
+	size_t chunkSize = defaultChunkSize;
+	if (currentChunk && currentChunk->ownedByArena)
+	{
+		chunkSize = currentChunk->size * 2;
+		if (chunkSize > RFC_ARENA_MAX_GROWTH_SIZE)
+			chunkSize = (currentChunk->size > RFC_ARENA_MAX_GROWTH_SIZE) ? currentChunk->size : RFC_ARENA_MAX_GROWTH_SIZE;
+	}
+
+	if (chunkSize < (size + alignment))
+		chunkSize = size + alignment;
+
+	// header and data in one block. header size is rounded so the data starts max_align_t aligned.
+	const size_t headerSize = (sizeof(Chunk) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+	if (chunkSize > ((size_t)-1 - headerSize))
+		return nullptr;
+
+	char* block = (char*)::malloc(headerSize + chunkSize);
+	if (block == nullptr)
+		return nullptr;
+
+	Chunk* chunk = (Chunk*)block;
+	chunk->next = nullptr;
+	chunk->data = block + headerSize;
+	chunk->size = chunkSize;
+	chunk->used = 0;
+	chunk->ownedByArena = true;
+
+	if (currentChunk)
+		currentChunk->next = chunk; // currentChunk is the last one here.
+	else
+		firstChunk = chunk;
+
+	currentChunk = chunk;
+
+	return allocateFromChunk(chunk, size, alignment);
+}
+
+void KArena::registerDestructor(void(*destroy)(void*), void* object) noexcept
+{
+	DestructorNode* node = (DestructorNode*)allocate(sizeof(DestructorNode), alignof(DestructorNode));
+	if (node == nullptr)
+	{
+		K_ASSERT(false, "KArena cannot track destructor!");
+		return;
+	}
+
+	node->destroy = destroy;
+	node->object = object;
+	node->next = destructorList;
+	destructorList = node;
+}
+
+void KArena::runDestructorsUntil(DestructorNode* stopNode) noexcept
+{
+	while (destructorList && (destructorList != stopNode))
+	{
+		DestructorNode* node = destructorList;
+		destructorList = node->next;
+		node->destroy(node->object);
+	}
+}
+
+wchar_t* KArena::copyString(const wchar_t* text, int length) noexcept
+{
+	if ((text == nullptr) || (length < 0))
+		return nullptr;
+
+	wchar_t* buffer = allocateArray<wchar_t>((size_t)length + 1);
+	if (buffer == nullptr)
+		return nullptr;
+
+	::memcpy(buffer, text, length * sizeof(wchar_t));
+	buffer[length] = 0;
+	return buffer;
+}
+
+KArena::Marker KArena::getMarker() const noexcept
+{
+	Marker marker;
+	marker.chunk = currentChunk;
+	marker.used = currentChunk ? currentChunk->used : 0;
+	marker.destructorList = destructorList;
+	return marker;
+}
+
+void KArena::rewind(const Marker& marker) noexcept
+{
+	runDestructorsUntil(marker.destructorList);
+
+	if (marker.chunk)
+	{
+		currentChunk = marker.chunk;
+		currentChunk->used = marker.used;
+	}
+	else // marker was taken before the first allocation.
+	{
+		currentChunk = firstChunk;
+		if (currentChunk)
+			currentChunk->used = 0;
+	}
+}
+
+void KArena::reset() noexcept
+{
+	runDestructorsUntil(nullptr);
+
+	currentChunk = firstChunk;
+	if (currentChunk)
+		currentChunk->used = 0;
+}
+
+void KArena::release() noexcept
+{
+	runDestructorsUntil(nullptr);
+
+	Chunk* chunk = firstChunk;
+	firstChunk = nullptr;
+
+	while (chunk)
+	{
+		Chunk* next = chunk->next;
+
+		if (chunk->ownedByArena)
+		{
+			::free(chunk);
+		}
+		else // initial buffer stays.
+		{
+			chunk->next = nullptr;
+			chunk->used = 0;
+			firstChunk = chunk;
+		}
+
+		chunk = next;
+	}
+
+	currentChunk = firstChunk;
+}
+
+size_t KArena::getReservedSize() const noexcept
+{
+	size_t total = 0;
+	for (Chunk* chunk = firstChunk; chunk; chunk = chunk->next)
+		total += chunk->size;
+
+	return total;
+}
+
+KArena& KArena::getThreadArena() noexcept
+{
+	static thread_local KArena threadArena;
+	return threadArena;
+}
+
+KArena::~KArena() noexcept
+{
+	release();
+}
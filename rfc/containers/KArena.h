@@ -0,0 +1,228 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include "KStaticAllocator.h"
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+/**
+	Bump pointer allocator which grows by chaining memory chunks.
+	Individual allocations are never freed. Memory is reclaimed all at once by rewind(), reset() or the destructor.
+	Objects created by create<T>() get their destructors called in reverse creation order on rewind/reset/destruction.
+
+	A KArena instance is not thread safe. Use getThreadArena() to get an arena owned by the calling thread.
+
+	e.g. @code
+	KArena arena;
+	{
+		KArenaScope scope(arena); // everything allocated inside this block is released at the end of the block
+		KString* str = arena.create<KString>(L"temp");
+		int* values = arena.allocateArray<int>(1024);
+	}
+	@endcode
+*/
+class KArena
+{
+protected:
+	struct Chunk
+	{
+		Chunk* next;
+		char* data;
+		size_t size;
+		size_t used;
+		bool ownedByArena; // false for the initial buffer provided by the user.
+	};
+
+	struct DestructorNode
+	{
+		DestructorNode* next;
+		void(*destroy)(void* object);
+		void* object;
+	};
+
+	Chunk* firstChunk;
+	Chunk* currentChunk;
+	DestructorNode* destructorList; // newest first
+	size_t defaultChunkSize;
+	Chunk initialChunk;
+
+	// @returns nullptr if the chunk does not have enough space.
+	static inline void* allocateFromChunk(Chunk* chunk, size_t size, size_t alignment) noexcept
+	{
+		const size_t address = (size_t)(chunk->data + chunk->used);
+		const size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+		const size_t available = chunk->size - chunk->used;
+
+		if ((padding > available) || (size > (available - padding)))
+			return nullptr;
+
+		chunk->used += padding + size;
+		return (void*)(address + padding);
+	}
+
+	void* allocateSlow(size_t size, size_t alignment) noexcept;
+	void runDestructorsUntil(DestructorNode* stopNode) noexcept;
+	void registerDestructor(void(*destroy)(void*), void* object) noexcept;
+
+	template<typename T>
+	static void destroyObject(void* object) noexcept
+	{
+		static_cast<T*>(object)->~T();
+	}
+
+public:
+	// saved allocation position. see getMarker/rewind.
+	struct Marker
+	{
+		Chunk* chunk;
+		size_t used;
+		DestructorNode* destructorList;
+	};
+
+	/**
+		@param chunkSize minimum size of the heap chunks. later chunks grow up to 16MB.
+		@param initialBuffer optional memory used before any heap chunk. (e.g. a stack buffer or a block from KStaticAllocator)
+		@param initialBufferSize size of the initialBuffer in bytes.
+	*/
+	KArena(size_t chunkSize = 64 * 1024, void* initialBuffer = nullptr, size_t initialBufferSize = 0) noexcept;
+
+	/**
+		@returns aligned memory. grows the arena if the current chunk is not enough. returns nullptr only if malloc fails.
+		alignment must be a power of two.
+	*/
+	inline void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) noexcept
+	{
+		if (currentChunk)
+		{
+			void* memory = allocateFromChunk(currentChunk, size, alignment);
+			if (memory)
+				return memory;
+		}
+
+		return allocateSlow(size, alignment);
+	}
+
+	/**
+		Allocates uninitialized storage for count items of T. No destructors are registered.
+	*/
+	template<typename T>
+	T* allocateArray(size_t count) noexcept
+	{
+		if (count > (((size_t)-1) / sizeof(T)))
+			return nullptr;
+
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/**
+		Constructs T inside the arena. Destructor is called on rewind/reset/arena destruction
+		unless T is trivially destructible. Do not delete the returned object.
+	*/
+	template<typename T, typename... Args>
+	T* create(Args&&... args) noexcept
+	{
+		void* memory = allocate(sizeof(T), alignof(T));
+		if (memory == nullptr)
+			return nullptr;
+
+		T* object = ::new (memory) T(std::forward<Args>(args)...);
+
+		if constexpr (!std::is_trivially_destructible<T>::value)
+			registerDestructor(&KArena::destroyObject<T>, object);
+
+		return object;
+	}
+
+	/**
+		Copies given string into the arena with null terminator.
+	*/
+	wchar_t* copyString(const wchar_t* text, int length) noexcept;
+
+	/**
+		@returns current position which can be restored later using rewind.
+	*/
+	Marker getMarker() const noexcept;
+
+	/**
+		Releases everything allocated after the marker was taken and calls destructors of the objects created after it.
+		Chunks are kept for reuse.
+	*/
+	void rewind(const Marker& marker) noexcept;
+
+	/**
+		Releases all the allocations. Chunks are kept for reuse.
+	*/
+	void reset() noexcept;
+
+	/**
+		Releases all the allocations and frees all the heap chunks.
+	*/
+	void release() noexcept;
+
+	/**
+		@returns total bytes of all the chunks. (including initial buffer)
+	*/
+	size_t getReservedSize() const noexcept;
+
+	/**
+		@returns arena owned by the calling thread. it is released when the thread exits.
+		No locking or atomic operations are involved.
+	*/
+	static KArena& getThreadArena() noexcept;
+
+	~KArena() noexcept;
+
+	// no copy/movable
+	KArena(const KArena&) = delete;
+	KArena& operator=(const KArena&) = delete;
+	KArena(KArena&&) = delete;
+	KArena& operator=(KArena&&) = delete;
+
+private:
+	RFC_LEAK_DETECTOR(KArena)
+};
+
+/**
+	Takes a marker at construction and rewinds the arena to it at destruction.
+	Use it for frame or function local temporaries.
+*/
+class KArenaScope
+{
+protected:
+	KArena& arena;
+	KArena::Marker marker;
+
+public:
+	explicit KArenaScope(KArena& arena) noexcept : arena(arena), marker(arena.getMarker()) {}
+
+	~KArenaScope() noexcept
+	{
+		arena.rewind(marker);
+	}
+
+	KArenaScope(const KArenaScope&) = delete;
+	KArenaScope& operator=(const KArenaScope&) = delete;
+};
@@ -26,7 +26,7 @@
 
 // automatically overwrites oldest messages when full.
 // circular buffer implementation (efficient, no dynamic allocation)
-template <typename T, size_t QueueSize, bool IsThreadSafe>
+template <typename T, size_t QueueSize, int IsThreadSafe>
 class KFixedQueue : private KThreadSafetyBase<IsThreadSafe>
 {
 protected:
@@ -42,7 +42,7 @@ protected:
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::EnterCriticalSection(&this->criticalSection);
+			this->lockExclusive();
 		}
 	}
 
@@ -50,7 +50,24 @@ protected:
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::LeaveCriticalSection(&this->criticalSection);
+			this->unlockExclusive();
+		}
+	}
+
+	// read-only operations. shared lock on ReaderWriter mode, same as above on Exclusive mode.
+	inline void enterReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->lockShared();
+		}
+	}
+
+	inline void leaveReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->unlockShared();
 		}
 	}
 
@@ -108,23 +125,23 @@ public:
 	// Queue state
 	bool isEmpty() noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 		bool empty = (iQueueHead == iQueueTail);
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 		return empty;
 	}
 
 	bool isFull() noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 		bool full = ((iQueueHead + 1) % QueueSize == iQueueTail);
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 		return full;
 	}
 
 	int getCount() noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 
 		int count;
 		if (iQueueHead >= iQueueTail)
@@ -136,7 +153,7 @@ public:
 			count = QueueSize - iQueueTail + iQueueHead;
 		}
 
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 		return count;
 	}
 
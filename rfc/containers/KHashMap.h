@@ -0,0 +1,611 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include "KPointerList.h"
+#include <utility>
+#include <type_traits>
+#include <stdint.h>
+
+/**
+	Hash and equality used by KHashMap and KHashSet.
+	Integers, enums and pointers are mixed with KHash::hashInteger. Other types must provide
+	"size_t hashCode() const" and operator==. (KString does)
+	Specialize this struct to use other types as keys.
+*/
+template<class K>
+struct KHashTraits
+{
+	static inline size_t hash(const K& key) noexcept
+	{
+		if constexpr (std::is_integral_v<K> || std::is_enum_v<K>)
+			return KHash::hashInteger((uint64_t)key);
+		else if constexpr (std::is_pointer_v<K>)
+			return KHash::hashInteger((uint64_t)(uintptr_t)key);
+		else
+			return key.hashCode();
+	}
+
+	static inline bool equals(const K& key1, const K& key2) noexcept
+	{
+		return key1 == key2;
+	}
+};
+
+/**
+	Unordered key/value container using open addressing with Robin Hood probing.
+	Entries are stored inline in a single array. On collision, the entry which is farther from its home slot
+	keeps the slot, so probe lengths stay short even when the table is 7/8 full.
+	Removal shifts the following entries back instead of leaving tombstones.
+	Thread safety is determined at compile time via template parameter.
+
+	@param K Key type. see KHashTraits. K and V must be default constructible and movable.
+	@param V Value type.
+	@param SmallSize Number of slots inside the object before allocating heap memory. must be power of two.
+	@param IsThreadSafe Compile-time thread safety mode. false/true or one of KThreadSafety values
+
+	e.g. @code
+	KHashMap<KString, int, 16, false> map;
+	map.put(L"width", 100);
+
+	int width;
+	if (map.get(L"width", width)) {...}
+	@endcode
+*/
+template<class K, class V, int SmallSize, int IsThreadSafe>
+class KHashMap : private KThreadSafetyBase<IsThreadSafe>
+{
+	static_assert((SmallSize > 0) && ((SmallSize & (SmallSize - 1)) == 0), "SmallSize must be power of two");
+
+protected:
+	struct Slot
+	{
+		K key;
+		V value;
+		size_t hash;
+		int distance; // distance from the home slot. -1 if the slot is empty.
+
+		Slot() noexcept : hash(0), distance(-1) {}
+	};
+
+	Slot* slots;
+	int capacity; // always power of two
+	int itemCount;
+	Slot smallSlots[SmallSize];
+
+	inline void enterCriticalSectionIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->lockExclusive();
+		}
+	}
+
+	inline void leaveCriticalSectionIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->unlockExclusive();
+		}
+	}
+
+	// read-only operations. shared lock on ReaderWriter mode, same as above on Exclusive mode.
+	inline void enterReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->lockShared();
+		}
+	}
+
+	inline void leaveReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->unlockShared();
+		}
+	}
+
+	// keep load factor at or below 7/8
+	static inline bool isOverloaded(const int count, const int slotCount) noexcept
+	{
+		return ((int64_t)count * 8) > ((int64_t)slotCount * 7);
+	}
+
+	void resetToSmallSlots() noexcept
+	{
+		slots = smallSlots;
+		capacity = SmallSize;
+		itemCount = 0;
+	}
+
+	// must be called within the lock. @returns slot index or -1.
+	int findIndexUnlocked(const K& key, const size_t hash) const noexcept
+	{
+		const int mask = capacity - 1;
+		int index = (int)(hash & (size_t)mask);
+
+		for (int distance = 0; ; ++distance)
+		{
+			const Slot& slot = slots[index];
+
+			// an entry this close to its home could not be displaced by our key. so the key is not here.
+			if (slot.distance < distance)
+				return -1;
+
+			if ((slot.hash == hash) && KHashTraits<K>::equals(slot.key, key))
+				return index;
+
+			index = (index + 1) & mask;
+		}
+	}
+
+	// must be called within the critical section. key must not exist and there must be a free slot.
+	int insertUnlocked(K&& key, V&& value, size_t hash) noexcept
+	{
+		const int mask = capacity - 1;
+		int index = (int)(hash & (size_t)mask);
+		int distance = 0;
+		int insertedIndex = -1;
+
+		Slot entry;
+		entry.key = std::move(key);
+		entry.value = std::move(value);
+		entry.hash = hash;
+
+		while (true)
+		{
+			Slot& slot = slots[index];
+
+			if (slot.distance == -1)
+			{
+				slot.key = std::move(entry.key);
+				slot.value = std::move(entry.value);
+				slot.hash = entry.hash;
+				slot.distance = distance;
+
+				++itemCount;
+				return (insertedIndex == -1) ? index : insertedIndex;
+			}
+
+			if (slot.distance < distance) // take the slot from the richer entry and carry it forward.
+			{
+				std::swap(slot.key, entry.key);
+				std::swap(slot.value, entry.value);
+				std::swap(slot.hash, entry.hash);
+				std::swap(slot.distance, distance);
+
+				if (insertedIndex == -1)
+					insertedIndex = index;
+			}
+
+			index = (index + 1) & mask;
+			++distance;
+		}
+	}
+
+	// must be called within the critical section.
+	void rehash(const int newCapacity) noexcept
+	{
+		Slot* oldSlots = slots;
+		const int oldCapacity = capacity;
+
+		if (newCapacity <= SmallSize)
+		{
+			if (slots == smallSlots)
+				return;
+
+			slots = smallSlots;
+			capacity = SmallSize;
+		}
+		else
+		{
+			slots = new Slot[newCapacity];
+			capacity = newCapacity;
+		}
+
+		itemCount = 0;
+
+		for (int i = 0; i < oldCapacity; ++i)
+		{
+			Slot& slot = oldSlots[i];
+			if (slot.distance != -1)
+			{
+				insertUnlocked(std::move(slot.key), std::move(slot.value), slot.hash);
+				slot.distance = -1;
+			}
+		}
+
+		if (oldSlots != smallSlots)
+			delete[] oldSlots;
+	}
+
+	// must be called within the critical section.
+	void ensureRoom(const int requiredCount) noexcept
+	{
+		if (!isOverloaded(requiredCount, capacity))
+			return;
+
+		int newCapacity = capacity * 2;
+		while (isOverloaded(requiredCount, newCapacity))
+			newCapacity *= 2;
+
+		rehash(newCapacity);
+	}
+
+	// must be called within the critical section.
+	void removeAtUnlocked(int index) noexcept
+	{
+		const int mask = capacity - 1;
+		int next = (index + 1) & mask;
+
+		// backward shift. entries after the removed one move one step closer to their home slot.
+		while (slots[next].distance > 0)
+		{
+			slots[index].key = std::move(slots[next].key);
+			slots[index].value = std::move(slots[next].value);
+			slots[index].hash = slots[next].hash;
+			slots[index].distance = slots[next].distance - 1;
+
+			index = next;
+			next = (next + 1) & mask;
+		}
+
+		// release the resources of the last moved/removed entry.
+		slots[index].key = K();
+		slots[index].value = V();
+		slots[index].distance = -1;
+		--itemCount;
+	}
+
+	// must be called within the critical section. does not modify the capacity.
+	void clearSlotsUnlocked() noexcept
+	{
+		for (int i = 0; i < capacity; ++i)
+		{
+			if (slots[i].distance != -1)
+			{
+				slots[i].key = K();
+				slots[i].value = V();
+				slots[i].distance = -1;
+			}
+		}
+		itemCount = 0;
+	}
+
+public:
+	KHashMap() noexcept
+	{
+		resetToSmallSlots();
+	}
+
+	KHashMap(const KHashMap&) = delete;
+	KHashMap& operator=(const KHashMap&) = delete;
+
+	/**
+		Adds the key or replaces the value of an existing key.
+	*/
+	void put(const K& key, const V& value) noexcept
+	{
+		const size_t hash = KHashTraits<K>::hash(key);
+
+		enterCriticalSectionIfNeeded();
+
+		const int index = findIndexUnlocked(key, hash);
+		if (index != -1)
+		{
+			slots[index].value = value;
+		}
+		else
+		{
+			ensureRoom(itemCount + 1);
+			insertUnlocked(K(key), V(value), hash);
+		}
+
+		leaveCriticalSectionIfNeeded();
+	}
+
+	/**
+		Adds the key only if it does not exist.
+		@returns false if the key already exists.
+	*/
+	bool add(const K& key, const V& value) noexcept
+	{
+		const size_t hash = KHashTraits<K>::hash(key);
+
+		enterCriticalSectionIfNeeded();
+
+		bool added = false;
+		if (findIndexUnlocked(key, hash) == -1)
+		{
+			ensureRoom(itemCount + 1);
+			insertUnlocked(K(key), V(value), hash);
+			added = true;
+		}
+
+		leaveCriticalSectionIfNeeded();
+		return added;
+	}
+
+	/**
+		Copies the value of the key into outValue.
+		@returns false if the key does not exist!
+	*/
+	bool get(const K& key, V& outValue) noexcept
+	{
+		const size_t hash = KHashTraits<K>::hash(key);
+
+		enterReadLockIfNeeded();
+
+		const int index = findIndexUnlocked(key, hash);
+		if (index != -1)
+			outValue = slots[index].value;
+
+		leaveReadLockIfNeeded();
+		return (index != -1);
+	}
+
+	/**
+		@returns pointer to the value inside the map, or nullptr if the key does not exist.
+		The pointer is valid until the map is modified. Only available on non thread-safe maps.
+	*/
+	V* find(const K& key) noexcept
+	{
+		static_assert(!IsThreadSafe, "find() is not available on thread-safe maps. use get()");
+
+		const int index = findIndexUnlocked(key, KHashTraits<K>::hash(key));
+		return (index != -1) ? &slots[index].value : nullptr;
+	}
+
+	/**
+		@returns reference to the value of the key. a default constructed value is added if the key does not exist.
+		The reference is valid until the map is modified. Only available on non thread-safe maps.
+	*/
+	V& getOrAdd(const K& key) noexcept
+	{
+		static_assert(!IsThreadSafe, "getOrAdd() is not available on thread-safe maps. use get() and add()");
+
+		const size_t hash = KHashTraits<K>::hash(key);
+		int index = findIndexUnlocked(key, hash);
+		if (index == -1)
+		{
+			ensureRoom(itemCount + 1);
+			index = insertUnlocked(K(key), V(), hash);
+		}
+
+		return slots[index].value;
+	}
+
+	bool contains(const K& key) noexcept
+	{
+		const size_t hash = KHashTraits<K>::hash(key);
+
+		enterReadLockIfNeeded();
+		const int index = findIndexUnlocked(key, hash);
+		leaveReadLockIfNeeded();
+
+		return (index != -1);
+	}
+
+	/**
+		@returns false if the key does not exist!
+	*/
+	bool remove(const K& key) noexcept
+	{
+		const size_t hash = KHashTraits<K>::hash(key);
+
+		enterCriticalSectionIfNeeded();
+
+		const int index = findIndexUnlocked(key, hash);
+		if (index != -1)
+			removeAtUnlocked(index);
+
+		leaveCriticalSectionIfNeeded();
+		return (index != -1);
+	}
+
+	/**
+		Removes all entries. Falls back to small buffer.
+	*/
+	void removeAll() noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		if (slots == smallSlots)
+			clearSlotsUnlocked();
+		else
+			delete[] slots;
+
+		resetToSmallSlots();
+
+		leaveCriticalSectionIfNeeded();
+	}
+
+	/**
+		Preallocates slots for given number of entries.
+	*/
+	void reserve(const int count) noexcept
+	{
+		enterCriticalSectionIfNeeded();
+		ensureRoom(count);
+		leaveCriticalSectionIfNeeded();
+	}
+
+	/**
+		@returns entry count in the map
+	*/
+	int size() noexcept
+	{
+		enterReadLockIfNeeded();
+		const int count = itemCount;
+		leaveReadLockIfNeeded();
+		return count;
+	}
+
+	bool isEmpty() noexcept
+	{
+		return (size() == 0);
+	}
+
+	/**
+		@returns slot count. entry count can reach 7/8 of it before the map grows.
+	*/
+	int getCapacity() noexcept
+	{
+		enterReadLockIfNeeded();
+		const int slotCount = capacity;
+		leaveReadLockIfNeeded();
+		return slotCount;
+	}
+
+	/**
+	 * Iterate through all entries in unspecified order. Do not add/remove entries inside func.
+	 * Takes the exclusive lock even in ReaderWriter mode since func receives mutable value references.
+	 * @param func Function/lambda that takes (const K& key, V& value) as parameters
+	*/
+	template<typename Func>
+	void forEach(Func&& func) noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		for (int i = 0; i < capacity; ++i)
+		{
+			if (slots[i].distance != -1)
+				func((const K&)slots[i].key, slots[i].value);
+		}
+
+		leaveCriticalSectionIfNeeded();
+	}
+
+	/**
+	 * Iterate with early termination support.
+	 * @param func Function/lambda that takes (const K& key, V& value) and returns bool (true = continue, false = stop)
+	 * @returns true if iteration completed, false if stopped early
+	*/
+	template<typename Func>
+	bool forEachUntil(Func&& func) noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		bool completed = true;
+		for (int i = 0; i < capacity; ++i)
+		{
+			if ((slots[i].distance != -1) && !func((const K&)slots[i].key, slots[i].value))
+			{
+				completed = false;
+				break;
+			}
+		}
+
+		leaveCriticalSectionIfNeeded();
+		return completed;
+	}
+
+	bool isUsingSmallBuffer() const noexcept
+	{
+		return (slots == smallSlots);
+	}
+
+	~KHashMap() noexcept
+	{
+		if (slots != smallSlots)
+			delete[] slots;
+	}
+
+private:
+	RFC_LEAK_DETECTOR(KHashMap)
+};
+
+/**
+	Unordered set of unique keys. Same storage and probing as KHashMap.
+
+	e.g. @code
+	KHashSet<KString, 16, false> names;
+	names.add(L"width");
+	if (names.contains(L"width")) {...}
+	@endcode
+*/
+template<class K, int SmallSize, int IsThreadSafe>
+class KHashSet
+{
+protected:
+	KHashMap<K, bool, SmallSize, IsThreadSafe> map;
+
+public:
+	KHashSet() noexcept {}
+
+	KHashSet(const KHashSet&) = delete;
+	KHashSet& operator=(const KHashSet&) = delete;
+
+	/**
+		@returns false if the key already exists.
+	*/
+	bool add(const K& key) noexcept
+	{
+		return map.add(key, true);
+	}
+
+	bool contains(const K& key) noexcept
+	{
+		return map.contains(key);
+	}
+
+	/**
+		@returns false if the key does not exist!
+	*/
+	bool remove(const K& key) noexcept
+	{
+		return map.remove(key);
+	}
+
+	void removeAll() noexcept
+	{
+		map.removeAll();
+	}
+
+	void reserve(const int count) noexcept
+	{
+		map.reserve(count);
+	}
+
+	int size() noexcept
+	{
+		return map.size();
+	}
+
+	bool isEmpty() noexcept
+	{
+		return map.isEmpty();
+	}
+
+	/**
+	 * @param func Function/lambda that takes (const K& key) as parameter
+	*/
+	template<typename Func>
+	void forEach(Func&& func) noexcept
+	{
+		map.forEach([&func](const K& key, bool&) { func(key); });
+	}
+
+	~KHashSet() noexcept {}
+};
@@ -0,0 +1,219 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include <atomic>
+#include <utility>
+
+/**
+	Lock-free single-producer/single-consumer ring buffer.
+	Exactly one thread may call enqueue and exactly one (other) thread may call dequeue.
+	Unlike KFixedQueue, enqueue fails instead of overwriting the oldest item when full.
+
+	@param T The item type. T should be default constructible and copy/move assignable.
+	@param QueueSize Number of slots. Must be a power of two. All slots are usable.
+*/
+template <typename T, size_t QueueSize>
+class KSPSCQueue
+{
+	static_assert((QueueSize >= 2) && ((QueueSize & (QueueSize - 1)) == 0), "KSPSCQueue requires power of two QueueSize");
+
+protected:
+	static constexpr size_t indexMask = QueueSize - 1;
+
+	T queue[QueueSize];
+
+	// head and tail only increase. they live on separate cache lines to avoid false sharing between producer and consumer.
+	alignas(64) std::atomic<size_t> head; // next slot to write. (owned by producer)
+	alignas(64) std::atomic<size_t> tail; // next slot to read. (owned by consumer)
+
+public:
+	KSPSCQueue() noexcept : head(0), tail(0) {}
+
+	KSPSCQueue(const KSPSCQueue&) = delete;
+	KSPSCQueue& operator=(const KSPSCQueue&) = delete;
+
+	// producer thread only. @returns false if the queue is full.
+	bool enqueue(const T& data) noexcept
+	{
+		const size_t currentHead = head.load(std::memory_order_relaxed);
+		if ((currentHead - tail.load(std::memory_order_acquire)) == QueueSize)
+			return false;
+
+		queue[currentHead & indexMask] = data;
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer thread only. @returns false if the queue is empty.
+	bool dequeue(T& data) noexcept
+	{
+		const size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail == head.load(std::memory_order_acquire))
+			return false;
+
+		data = std::move(queue[currentTail & indexMask]);
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// the result can be outdated by the time it returns if the other side is active.
+	bool isEmpty() const noexcept
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+	// approximate when called while the other side is active.
+	int getCount() const noexcept
+	{
+		const size_t currentTail = tail.load(std::memory_order_acquire);
+		return static_cast<int>(head.load(std::memory_order_acquire) - currentTail);
+	}
+
+	static constexpr size_t capacity() noexcept
+	{
+		return QueueSize;
+	}
+};
+
+/**
+	Lock-free bounded multi-producer/multi-consumer ring buffer. (Dmitry Vyukov's sequence based design)
+	Any number of threads may enqueue and dequeue concurrently without taking a lock.
+	enqueue fails instead of overwriting the oldest item when full.
+
+	@param T The item type. T should be default constructible and copy/move assignable.
+	@param QueueSize Number of slots. Must be a power of two. All slots are usable.
+*/
+template <typename T, size_t QueueSize>
+class KMPMCQueue
+{
+	static_assert((QueueSize >= 2) && ((QueueSize & (QueueSize - 1)) == 0), "KMPMCQueue requires power of two QueueSize");
+
+protected:
+	static constexpr size_t indexMask = QueueSize - 1;
+
+	struct Cell
+	{
+		// equals slot position when free for writing, position + 1 when holding data.
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	Cell cells[QueueSize];
+
+	alignas(64) std::atomic<size_t> enqueuePos;
+	alignas(64) std::atomic<size_t> dequeuePos;
+
+public:
+	KMPMCQueue() noexcept : enqueuePos(0), dequeuePos(0)
+	{
+		for (size_t i = 0; i < QueueSize; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	KMPMCQueue(const KMPMCQueue&) = delete;
+	KMPMCQueue& operator=(const KMPMCQueue&) = delete;
+
+	// @returns false if the queue is full.
+	bool enqueue(const T& data) noexcept
+	{
+		Cell* cell;
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			cell = &cells[pos & indexMask];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+
+			if (diff == 0) // slot is free. try to claim it.
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0) // slot still holds an item from the previous lap. queue is full.
+			{
+				return false;
+			}
+			else // another producer claimed it.
+			{
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->data = data;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// @returns false if the queue is empty.
+	bool dequeue(T& data) noexcept
+	{
+		Cell* cell;
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			cell = &cells[pos & indexMask];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+
+			if (diff == 0) // slot holds data. try to claim it.
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0) // slot not written yet. queue is empty.
+			{
+				return false;
+			}
+			else // another consumer claimed it.
+			{
+				pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		data = std::move(cell->data);
+		cell->sequence.store(pos + indexMask + 1, std::memory_order_release); // free for the next lap
+		return true;
+	}
+
+	// approximate when other threads are active.
+	bool isEmpty() const noexcept
+	{
+		return getCount() == 0;
+	}
+
+	// approximate when other threads are active.
+	int getCount() const noexcept
+	{
+		const size_t deqPos = dequeuePos.load(std::memory_order_acquire);
+		const size_t enqPos = enqueuePos.load(std::memory_order_acquire);
+		return (enqPos > deqPos) ? static_cast<int>(enqPos - deqPos) : 0;
+	}
+
+	static constexpr size_t capacity() noexcept
+	{
+		return QueueSize;
+	}
+};
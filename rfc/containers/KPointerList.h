@@ -26,16 +26,34 @@
 #include <functional>
 
 /**
-	Helper base class for thread safety - only contains critical section when needed
+	Values for the IsThreadSafe template parameter of the containers.
+	Plain false/true are still accepted and mean None/Exclusive.
 */
-template<bool IsThreadSafe>
+struct KThreadSafety
+{
+	static constexpr int None = 0; // no locking
+	static constexpr int Exclusive = 1; // every operation takes a CRITICAL_SECTION (recursive)
+	static constexpr int ReaderWriter = 2; // read-only operations take a shared SRW lock, modifications take it exclusively. (not recursive)
+};
+
+/**
+	Helper base class for thread safety - only contains a lock when needed
+*/
+template<int IsThreadSafe>
 struct KThreadSafetyBase
 {
 	// Empty base class when thread safety is not needed. ("empty base optimization")
+	// other values would pass "if constexpr (IsThreadSafe)" checks without taking any lock.
+	static_assert((IsThreadSafe >= KThreadSafety::None) && (IsThreadSafe <= KThreadSafety::ReaderWriter), "IsThreadSafe must be one of the KThreadSafety values");
+
+	inline void lockExclusive() noexcept {}
+	inline void unlockExclusive() noexcept {}
+	inline void lockShared() noexcept {}
+	inline void unlockShared() noexcept {}
 };
 
 template<>
-struct KThreadSafetyBase<true>
+struct KThreadSafetyBase<KThreadSafety::Exclusive>
 {
 	CRITICAL_SECTION criticalSection;
 
@@ -44,12 +62,86 @@ struct KThreadSafetyBase<true>
 		::InitializeCriticalSection(&criticalSection);
 	}
 
+	inline void lockExclusive() noexcept { ::EnterCriticalSection(&criticalSection); }
+	inline void unlockExclusive() noexcept { ::LeaveCriticalSection(&criticalSection); }
+	inline void lockShared() noexcept { ::EnterCriticalSection(&criticalSection); }
+	inline void unlockShared() noexcept { ::LeaveCriticalSection(&criticalSection); }
+
 	~KThreadSafetyBase() noexcept
 	{
 		::DeleteCriticalSection(&criticalSection);
 	}
 };
 
+/**
+	SRW lock based reader/writer mode. Readers run concurrently.
+	SRW locks cannot be acquired recursively, so a container callback (forEach etc.)
+	must not call back into the same container.
+	SRW locks need Vista. When targeting XP (_WIN32_WINNT < 0x0600), this mode uses a CRITICAL_SECTION
+	like Exclusive mode, so readers are serialized.
+*/
+#if !defined(_WIN32_WINNT) || (_WIN32_WINNT >= 0x0600)
+template<>
+struct KThreadSafetyBase<KThreadSafety::ReaderWriter>
+{
+	SRWLOCK srwLock;
+
+	KThreadSafetyBase() noexcept
+	{
+		::InitializeSRWLock(&srwLock); // no destroy function needed for SRW locks.
+	}
+
+	inline void lockExclusive() noexcept { ::AcquireSRWLockExclusive(&srwLock); }
+	inline void unlockExclusive() noexcept { ::ReleaseSRWLockExclusive(&srwLock); }
+	inline void lockShared() noexcept { ::AcquireSRWLockShared(&srwLock); }
+	inline void unlockShared() noexcept { ::ReleaseSRWLockShared(&srwLock); }
+};
+#else
+template<>
+struct KThreadSafetyBase<KThreadSafety::ReaderWriter> : public KThreadSafetyBase<KThreadSafety::Exclusive>
+{
+};
+#endif
+
+/**
+	Controls how KVector and KPointerList enlarge their heap buffer when the current room is not enough.
+*/
+enum class KGrowthPolicy
+{
+	Linear, // grows by SmallBufferSize items each time. (old behavior, minimal memory overhead)
+	Geometric // grows by 1.5x each time. amortized O(1) add. (default)
+};
+
+/**
+	Calculates the next room count for the given growth policy.
+	Returned value is always >= requiredCount (or -1 on int overflow).
+*/
+template<KGrowthPolicy GrowthPolicy, int SmallBufferSize>
+struct KContainerGrowth
+{
+	static constexpr int maxRoomCount = 0x7FFFFFFF;
+
+	static int calculateRoomCount(const int roomCount, const int requiredCount) noexcept
+	{
+		if (requiredCount < 0) // overflow in caller
+			return -1;
+
+		int growBy = SmallBufferSize;
+
+		if constexpr (GrowthPolicy == KGrowthPolicy::Geometric)
+		{
+			if ((roomCount / 2) > growBy)
+				growBy = roomCount / 2;
+		}
+
+		int newRoomCount = ((maxRoomCount - roomCount) < growBy) ? maxRoomCount : (roomCount + growBy);
+		if (newRoomCount < requiredCount)
+			newRoomCount = requiredCount;
+
+		return newRoomCount;
+	}
+};
+
 /**
 	Holds a resizable list of pointers with small buffer optimization.
 	Thread safety is determined at compile time via template parameter.
@@ -58,7 +150,8 @@ struct KThreadSafetyBase<true>
 
 	@param T The pointer type to store
 	@param SmallBufferSize Number of items to store in stack buffer before allocating heap memory
-	@param IsThreadSafe Compile-time flag for thread safety
+	@param IsThreadSafe Compile-time thread safety mode. false/true or one of KThreadSafety values
+	@param GrowthPolicy How the heap buffer grows when full. Geometric by default.
 
 	e.g. @code
 	KButton btn1;
@@ -68,7 +161,7 @@ struct KThreadSafetyBase<true>
 	btnList.addPointer(&btn1);
 	@endcode
 */
-template<class T, int SmallBufferSize, bool IsThreadSafe>
+template<class T, int SmallBufferSize, int IsThreadSafe, KGrowthPolicy GrowthPolicy = KGrowthPolicy::Geometric>
 class KPointerList : private KThreadSafetyBase<IsThreadSafe>
 {
 protected:
@@ -91,7 +184,7 @@ protected:
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::EnterCriticalSection(&this->criticalSection);
+			this->lockExclusive();
 		}
 	}
 
@@ -99,10 +192,109 @@ protected:
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::LeaveCriticalSection(&this->criticalSection);
+			this->unlockExclusive();
 		}
 	}
 
+	// read-only operations. shared lock on ReaderWriter mode, same as above on Exclusive mode.
+	inline void enterReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->lockShared();
+		}
+	}
+
+	inline void leaveReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->unlockShared();
+		}
+	}
+
+	// must be called within the critical section. newRoomCount must be >= itemCount.
+	bool reallocate(const int newRoomCount) noexcept
+	{
+		if (newRoomCount <= SmallBufferSize) // fits into small buffer
+		{
+			if (!usingSmallBuffer)
+			{
+				::memcpy(smallBuffer, list, itemCount * sizeof(T));
+				::free((void*)list);
+
+				list = smallBuffer;
+				roomCount = SmallBufferSize;
+				usingSmallBuffer = true;
+			}
+			return true;
+		}
+
+		if (usingSmallBuffer)
+		{
+			// Switch from small buffer to heap buffer
+			T* newList = (T*)::malloc(newRoomCount * sizeof(T));
+			if (newList == nullptr) // memory allocation failed!
+				return false;
+
+			::memcpy(newList, smallBuffer, itemCount * sizeof(T));
+			list = newList;
+			usingSmallBuffer = false;
+		}
+		else
+		{
+			// Already using heap buffer, just reallocate
+			void* retVal = ::realloc((void*)list, newRoomCount * sizeof(T));
+			if (retVal == nullptr) // memory allocation failed!
+				return false;
+
+			list = (T*)retVal;
+		}
+
+		roomCount = newRoomCount;
+		return true;
+	}
+
+	// must be called within the critical section.
+	bool ensureRoom(const int requiredCount) noexcept
+	{
+		if (roomCount >= requiredCount) // no need reallocation. room count is enough!
+			return true;
+
+		const int newRoomCount = KContainerGrowth<GrowthPolicy, SmallBufferSize>::calculateRoomCount(roomCount, requiredCount);
+		if (newRoomCount < 0)
+			return false;
+
+		return reallocate(newRoomCount);
+	}
+
+	// must be called within the lock. (ReaderWriter locks are not recursive)
+	int getIndexUnlocked(T pointer) const noexcept
+	{
+		for (int i = 0; i < itemCount; i++)
+		{
+			if (list[i] == pointer)
+				return i;
+		}
+		return -1;
+	}
+
+	// must be called within the critical section.
+	bool removeUnlocked(const int index) noexcept
+	{
+		if ((index < 0) || (index >= itemCount)) // out of range!
+			return false;
+
+		// Shift all elements after 'index' one position to the left
+		for (int i = index; i < itemCount - 1; i++)
+		{
+			list[i] = list[i + 1];
+		}
+		itemCount--;
+
+		return true;
+	}
+
 public:
 	/**
 		Constructs PointerList object.
@@ -122,65 +314,85 @@ public:
 	{
 		enterCriticalSectionIfNeeded();
 
-		if (roomCount >= (itemCount + 1)) // no need reallocation. room count is enough!
+		if (!ensureRoom(itemCount + 1)) // memory allocation failed!
 		{
-			list[itemCount] = pointer;
-			itemCount++;
-
 			leaveCriticalSectionIfNeeded();
-			return true;
+			return false;
 		}
-		else // require reallocation!
+
+		list[itemCount] = pointer;
+		itemCount++;
+
+		leaveCriticalSectionIfNeeded();
+		return true;
+	}
+
+	/**
+		Adds given number of pointers to the end of the list with a single reallocation.
+		@returns false if memory allocation failed! (list is not modified)
+	*/
+	bool addRange(const T* pointers, const int count) noexcept
+	{
+		if ((pointers == nullptr) || (count <= 0))
+			return (count == 0);
+
+		enterCriticalSectionIfNeeded();
+
+		// pointers may point into our own buffer, which can be moved by the reallocation.
+		const bool isSelfRange = (pointers >= list) && (pointers < (list + itemCount));
+		const int selfOffset = isSelfRange ? (int)(pointers - list) : 0;
+
+		if (((0x7FFFFFFF - itemCount) < count) || !ensureRoom(itemCount + count))
 		{
-			if (usingSmallBuffer)
-			{
-				// Switch from small buffer to heap buffer
-				roomCount += SmallBufferSize;
-				T* newList = (T*)::malloc(roomCount * sizeof(T));
-
-				if (newList)
-				{
-					// Copy from small buffer to heap buffer
-					::memcpy(newList, smallBuffer, SmallBufferSize * sizeof(T));
-
-					list = newList;
-					usingSmallBuffer = false;
-
-					list[itemCount] = pointer;
-					itemCount++;
-
-					leaveCriticalSectionIfNeeded();
-					return true;
-				}
-				else // memory allocation failed!
-				{
-					roomCount -= SmallBufferSize;
-					leaveCriticalSectionIfNeeded();
-					return false;
-				}
-			}
-			else
-			{
-				// Already using heap buffer, just reallocate
-				roomCount += SmallBufferSize;
-				void* retVal = ::realloc((void*)list, roomCount * sizeof(T));
-				if (retVal)
-				{
-					list = (T*)retVal;
-					list[itemCount] = pointer;
-					itemCount++;
-
-					leaveCriticalSectionIfNeeded();
-					return true;
-				}
-				else // memory allocation failed!
-				{
-					roomCount -= SmallBufferSize;
-					leaveCriticalSectionIfNeeded();
-					return false;
-				}
-			}
+			leaveCriticalSectionIfNeeded();
+			return false;
 		}
+
+		::memmove(&list[itemCount], isSelfRange ? (list + selfOffset) : pointers, count * sizeof(T));
+		itemCount += count;
+
+		leaveCriticalSectionIfNeeded();
+		return true;
+	}
+
+	/**
+		Preallocates room for at least given number of items. Never shrinks the buffer.
+		@returns false if memory allocation failed!
+	*/
+	bool reserve(const int capacity) noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		bool retVal = true;
+		if (capacity > roomCount)
+			retVal = reallocate(capacity);
+
+		leaveCriticalSectionIfNeeded();
+		return retVal;
+	}
+
+	/**
+		Releases unused heap room. Falls back to small buffer if items fit into it.
+	*/
+	void shrinkToFit() noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		if (!usingSmallBuffer && (roomCount > itemCount))
+			reallocate(itemCount); // realloc shrink failure keeps the old buffer, which is still valid.
+
+		leaveCriticalSectionIfNeeded();
+	}
+
+	/**
+		@returns number of items which can be stored without reallocation.
+	*/
+	int getCapacity() noexcept
+	{
+		enterReadLockIfNeeded();
+		const int capacity = roomCount;
+		leaveReadLockIfNeeded();
+		return capacity;
 	}
 
 	/**
@@ -189,17 +401,17 @@ public:
 	*/
 	T get(const int index) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 
 		if ((0 <= index) && (index < itemCount)) // checks for valid range!
 		{
 			T object = list[index];
-			leaveCriticalSectionIfNeeded();
+			leaveReadLockIfNeeded();
 			return object;
 		}
 		else // out of range!
 		{
-			leaveCriticalSectionIfNeeded();
+			leaveReadLockIfNeeded();
 			return nullptr;
 		}
 	}
@@ -241,24 +453,10 @@ public:
 	bool remove(const int index) noexcept
 	{
 		enterCriticalSectionIfNeeded();
+		const bool retVal = removeUnlocked(index);
+		leaveCriticalSectionIfNeeded();
 
-		if ((0 <= index) && (index < itemCount))
-		{
-			// Shift all elements after 'index' one position to the left
-			for (int i = index; i < itemCount - 1; i++)
-			{
-				list[i] = list[i + 1];
-			}
-			itemCount--;
-
-			leaveCriticalSectionIfNeeded();
-			return true;
-		}
-		else // out of range!
-		{
-			leaveCriticalSectionIfNeeded();
-			return false;
-		}
+		return retVal;
 	}
 
 	bool remove(T pointer) noexcept
@@ -266,9 +464,9 @@ public:
 		enterCriticalSectionIfNeeded();
 
 		bool retVal = false;
-		const int index = getIndex(pointer);
+		const int index = getIndexUnlocked(pointer);
 		if (index != -1)
-			retVal = remove(index);
+			retVal = removeUnlocked(index);
 
 		leaveCriticalSectionIfNeeded();
 		return retVal;
@@ -314,32 +512,36 @@ public:
 	/**
 	 * Safely iterate through all pointers in the list with thread synchronization.
 	 * The entire iteration is protected by critical section if thread safety is enabled.
+	 * func is a template parameter, so the call is inlined. (no std::function overhead)
+	 * Takes the shared lock in ReaderWriter mode, so func must not modify this list.
 	 * @param func Function/lambda to call for each pointer in the list
 	*/
-	void forEach(std::function<void(T)> func) noexcept
+	template<typename Func>
+	void forEach(Func&& func) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 		for (int i = 0; i < itemCount; i++) 
 		{
 			func(list[i]);
 		}
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 	}
 
 	/**
 	 * Safely iterate with index access. Useful when you need the index as well.
 	 * @param func Function/lambda that takes (pointer, index) as parameters
 	*/
-	void forEachWithIndex(std::function<void(T, int)> func) noexcept
+	template<typename Func>
+	void forEachWithIndex(Func&& func) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 
 		for (int i = 0; i < itemCount; i++)
 		{
 			func(list[i], i);
 		}
 
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 	}
 
 	/**
@@ -356,9 +558,10 @@ public:
 			return true; // Continue
 		});
 	*/
-	bool forEachUntil(std::function<bool(T)> func) noexcept
+	template<typename Func>
+	bool forEachUntil(Func&& func) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 
 		bool completed = true;
 		for (int i = 0; i < itemCount; i++)
@@ -370,13 +573,14 @@ public:
 			}
 		}
 
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 		return completed;
 	}
 
-	bool forEachUntilWithIndex(std::function<bool(T,int)> func) noexcept
+	template<typename Func>
+	bool forEachUntilWithIndex(Func&& func) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 
 		bool completed = true;
 		for (int i = 0; i < itemCount; i++)
@@ -388,29 +592,38 @@ public:
 			}
 		}
 
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 		return completed;
 	}
 
+	/**
+	 * Safely iterate backwards through all pointers in the list with thread synchronization.
+	 * func can remove items since indices aren't affected by removals.
+	 * Takes the shared lock in ReaderWriter mode, so func must not modify this list in that mode.
+	 * @param func Function/lambda to call for each pointer in the list (from last to first)
+	*/
+	template<typename Func>
+	void forEachReverse(Func&& func) noexcept
+	{
+		enterReadLockIfNeeded();
+		for (int i = itemCount - 1; i >= 0; i--)
+		{
+			func(list[i]);
+		}
+		leaveReadLockIfNeeded();
+	}
+
 	/**
 		Finds the index of the first pointer which matches the pointer passed in.
 		@returns -1 if not found!
 	*/
 	int getIndex(T pointer) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
+		const int index = getIndexUnlocked(pointer);
+		leaveReadLockIfNeeded();
 
-		for (int i = 0; i < itemCount; i++)
-		{
-			if (list[i] == pointer)
-			{
-				leaveCriticalSectionIfNeeded();
-				return i;
-			}
-		}
-
-		leaveCriticalSectionIfNeeded();
-		return -1;
+		return index;
 	}
 
 	/**
@@ -421,6 +634,67 @@ public:
 		return itemCount;
 	}
 
+	/**
+		Raw pointer iterators for range-based for loops. Only available on non thread-safe lists,
+		use lockedView() for thread-safe ones. Do not add/remove items while iterating.
+
+		e.g. @code
+		for (auto& item : list) { ... }
+		@endcode
+	*/
+	T* begin() noexcept
+	{
+		static_assert(!IsThreadSafe, "begin()/end() are not available on thread-safe lists. use lockedView()");
+		return list;
+	}
+
+	T* end() noexcept
+	{
+		static_assert(!IsThreadSafe, "begin()/end() are not available on thread-safe lists. use lockedView()");
+		return list + itemCount;
+	}
+
+	/**
+		Holds the list's lock for its lifetime and exposes raw iteration over the items.
+		Keep the view short-lived; writers are blocked while it exists. (takes the shared lock in ReaderWriter mode)
+	*/
+	class LockedView
+	{
+	private:
+		KPointerList& owner;
+
+	public:
+		explicit LockedView(KPointerList& owner) noexcept : owner(owner)
+		{
+			owner.enterReadLockIfNeeded();
+		}
+
+		LockedView(const LockedView&) = delete;
+		LockedView& operator=(const LockedView&) = delete;
+
+		T* begin() const noexcept { return owner.list; }
+		T* end() const noexcept { return owner.list + owner.itemCount; }
+		int size() const noexcept { return owner.itemCount; }
+		T operator[](const int index) const noexcept { return owner.list[index]; }
+
+		~LockedView() noexcept
+		{
+			owner.leaveReadLockIfNeeded();
+		}
+	};
+
+	/**
+		Locks the list (if thread-safe) until the returned view goes out of scope.
+
+		e.g. @code
+		for (auto& item : list.lockedView()) { ... }
+		@endcode
+	*/
+	LockedView lockedView() noexcept
+	{
+		return LockedView(*this);
+	}
+
 	/**
 		@returns whether the list is currently using the small buffer optimization
 	*/
@@ -442,7 +716,7 @@ public:
 	*/
 	static constexpr bool isThreadSafeInstance() noexcept
 	{
-		return IsThreadSafe;
+		return (IsThreadSafe != KThreadSafety::None);
 	}
 
 	/** Destructs PointerList object.*/
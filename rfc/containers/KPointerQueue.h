@@ -32,7 +32,8 @@ public:
 };
 
 // Queue implemented using a linked list. Can hold unlimited number of items. (assumes T is a pointer type which is allocated using new)
-template<class T, bool IsThreadSafe>
+// Popped nodes are kept in a per-queue free list and reused by later pushes, up to maxPooledNodes.
+template<class T, int IsThreadSafe>
 class KPointerQueue : private KThreadSafetyBase<IsThreadSafe>
 {
 protected:
@@ -40,12 +41,16 @@ protected:
 	KQueueNode<T>* lastNode;
 	size_t itemCount;
 
+	KQueueNode<T>* freeNodes; // recycled nodes. linked through next.
+	size_t freeNodeCount;
+	size_t maxPooledNodes;
+
 	// Thread safety helper methods
 	inline void enterCriticalSectionIfNeeded() noexcept
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::EnterCriticalSection(&this->criticalSection);
+			this->lockExclusive();
 		}
 	}
 
@@ -53,16 +58,91 @@ protected:
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::LeaveCriticalSection(&this->criticalSection);
+			this->unlockExclusive();
+		}
+	}
+
+	// read-only operations. shared lock on ReaderWriter mode, same as above on Exclusive mode.
+	inline void enterReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->lockShared();
+		}
+	}
+
+	inline void leaveReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->unlockShared();
+		}
+	}
+
+	// must be called within the critical section.
+	inline KQueueNode<T>* acquireNode() noexcept
+	{
+		KQueueNode<T>* node = freeNodes;
+		if (node)
+		{
+			freeNodes = node->next;
+			--freeNodeCount;
+		}
+		else
+		{
+			node = new KQueueNode<T>();
+		}
+		return node;
+	}
+
+	// must be called within the critical section.
+	inline void releaseNode(KQueueNode<T>* node) noexcept
+	{
+		if (freeNodeCount < maxPooledNodes)
+		{
+			node->next = freeNodes;
+			freeNodes = node;
+			++freeNodeCount;
+		}
+		else
+		{
+			delete node;
+		}
+	}
+
+	// must be called within the critical section. firstInChain..lastInChain are linked through next.
+	inline void releaseNodeChain(KQueueNode<T>* firstInChain, KQueueNode<T>* lastInChain, size_t chainLength) noexcept
+	{
+		if ((freeNodeCount + chainLength) <= maxPooledNodes) // whole chain fits. splice in one step.
+		{
+			lastInChain->next = freeNodes;
+			freeNodes = firstInChain;
+			freeNodeCount += chainLength;
+			return;
+		}
+
+		KQueueNode<T>* nextNode = firstInChain;
+		while (chainLength--)
+		{
+			KQueueNode<T>* tmp = nextNode;
+			nextNode = nextNode->next;
+			releaseNode(tmp);
 		}
 	}
 
 public:
-	KPointerQueue() noexcept
+	/**
+		@param maxPooledNodes maximum number of popped nodes kept for reuse. use zero to disable node pooling.
+	*/
+	KPointerQueue(size_t maxPooledNodes = 256) noexcept
 	{
 		firstNode = nullptr;
 		lastNode = nullptr;
 		itemCount = 0;
+
+		freeNodes = nullptr;
+		freeNodeCount = 0;
+		this->maxPooledNodes = maxPooledNodes;
 	}
 
 	// Linked-list nodes are owned via raw pointers with no refcounting, so copying/moving
@@ -74,28 +154,28 @@ public:
 
 	bool isEmpty() noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 		bool empty = (itemCount == 0);
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 		return empty;
 	}
 
 	size_t size() noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 		size_t count = itemCount;
-		leaveCriticalSectionIfNeeded();
+		leaveReadLockIfNeeded();
 		return count;
 	}
 
 	void push(T value) noexcept
 	{
-		KQueueNode<T>* newNode = new KQueueNode<T>();
+		enterCriticalSectionIfNeeded();
+
+		KQueueNode<T>* newNode = acquireNode();
 		newNode->data = value;
 		newNode->next = nullptr;
 
-		enterCriticalSectionIfNeeded();
-
 		if (firstNode == nullptr)
 		{
 			firstNode = newNode;
@@ -112,6 +192,39 @@ public:
 		leaveCriticalSectionIfNeeded();
 	}
 
+	// pushes all the values in order while holding the lock only once.
+	void pushBatch(const T* values, size_t count) noexcept
+	{
+		if ((values == nullptr) || (count == 0))
+			return;
+
+		enterCriticalSectionIfNeeded();
+
+		// build the chain first, then link it to the queue.
+		KQueueNode<T>* chainFirst = acquireNode();
+		KQueueNode<T>* chainLast = chainFirst;
+		chainFirst->data = values[0];
+
+		for (size_t i = 1; i < count; i++)
+		{
+			KQueueNode<T>* newNode = acquireNode();
+			newNode->data = values[i];
+			chainLast->next = newNode;
+			chainLast = newNode;
+		}
+		chainLast->next = nullptr;
+
+		if (firstNode == nullptr)
+			firstNode = chainFirst;
+		else
+			lastNode->next = chainFirst;
+
+		lastNode = chainLast;
+		itemCount += count;
+
+		leaveCriticalSectionIfNeeded();
+	}
+
 	T pop() noexcept
 	{
 		enterCriticalSectionIfNeeded();
@@ -132,12 +245,95 @@ public:
 
 		--itemCount;
 
-		delete tmp;
+		releaseNode(tmp);
 
 		leaveCriticalSectionIfNeeded();
 		return value;
 	}
 
+	/**
+		Pops up to maxCount items into outValues while holding the lock only once.
+		@returns number of items written to outValues.
+	*/
+	size_t popBatch(T* outValues, size_t maxCount) noexcept
+	{
+		if ((outValues == nullptr) || (maxCount == 0))
+			return 0;
+
+		enterCriticalSectionIfNeeded();
+
+		size_t count = 0;
+		KQueueNode<T>* chainFirst = firstNode;
+		KQueueNode<T>* chainLast = nullptr;
+
+		while (firstNode && (count < maxCount))
+		{
+			outValues[count++] = firstNode->data;
+			chainLast = firstNode;
+			firstNode = firstNode->next;
+		}
+
+		if (firstNode == nullptr)
+			lastNode = nullptr;
+
+		itemCount -= count;
+
+		if (count)
+			releaseNodeChain(chainFirst, chainLast, count);
+
+		leaveCriticalSectionIfNeeded();
+		return count;
+	}
+
+	/**
+		Detaches all the items in one step and calls func(T) for each of them in queue order.
+		func is called without holding the lock, so it may push to this queue.
+		@returns number of items drained.
+	*/
+	template<typename Func>
+	size_t popAll(Func&& func) noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		KQueueNode<T>* chainFirst = firstNode;
+		KQueueNode<T>* chainLast = lastNode;
+		const size_t count = itemCount;
+
+		firstNode = nullptr;
+		lastNode = nullptr;
+		itemCount = 0;
+
+		leaveCriticalSectionIfNeeded();
+
+		if (count == 0)
+			return 0;
+
+		for (KQueueNode<T>* node = chainFirst; node; node = node->next)
+			func(node->data);
+
+		enterCriticalSectionIfNeeded();
+		releaseNodeChain(chainFirst, chainLast, count);
+		leaveCriticalSectionIfNeeded();
+
+		return count;
+	}
+
+	// frees all the recycled nodes kept for reuse.
+	void releasePooledNodes() noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		while (freeNodes)
+		{
+			KQueueNode<T>* tmp = freeNodes;
+			freeNodes = freeNodes->next;
+			delete tmp;
+		}
+		freeNodeCount = 0;
+
+		leaveCriticalSectionIfNeeded();
+	}
+
 	// calls destructor of all the T objects in the queue. also clear the queue.
 	void deleteAllObjects() noexcept
 	{
@@ -156,7 +352,7 @@ public:
 			nextNode = nextNode->next;
 
 			delete tmp->data;
-			delete tmp;
+			releaseNode(tmp);
 		}
 
 		firstNode = nullptr;
@@ -170,9 +366,6 @@ public:
 	{
 		// delete all nodes
 
-		if (firstNode == nullptr)
-			return;
-
 		KQueueNode<T>* nextNode = firstNode;
 		while (nextNode)
 		{
@@ -180,6 +373,14 @@ public:
 			nextNode = nextNode->next;
 			delete tmp;
 		}
+
+		nextNode = freeNodes;
+		while (nextNode)
+		{
+			KQueueNode<T>* tmp = nextNode;
+			nextNode = nextNode->next;
+			delete tmp;
+		}
 	}
 };
 
@@ -35,7 +35,8 @@
 
 	@param T The class type to store. T should implement copy/move constructor, (move)assign & compare operators.
 	@param SmallBufferSize Number of items to store in stack buffer before allocating heap memory
-	@param IsThreadSafe Compile-time flag for thread safety
+	@param IsThreadSafe Compile-time thread safety mode. false/true or one of KThreadSafety values
+	@param GrowthPolicy How the heap buffer grows when full. Geometric by default.
 
 	e.g. @code
 	KString str1, str2;
@@ -44,7 +45,7 @@
 	strList.add(str2);
 	@endcode
 */
-template<class T, int SmallBufferSize, bool IsThreadSafe>
+template<class T, int SmallBufferSize, int IsThreadSafe, KGrowthPolicy GrowthPolicy = KGrowthPolicy::Geometric>
 class KVector : private KThreadSafetyBase<IsThreadSafe>
 {
 protected:
@@ -67,7 +68,7 @@ protected:
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::EnterCriticalSection(&this->criticalSection);
+			this->lockExclusive();
 		}
 	}
 
@@ -75,10 +76,113 @@ protected:
 	{
 		if constexpr (IsThreadSafe)
 		{
-			::LeaveCriticalSection(&this->criticalSection);
+			this->unlockExclusive();
 		}
 	}
 
+	// read-only operations. shared lock on ReaderWriter mode, same as above on Exclusive mode.
+	inline void enterReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->lockShared();
+		}
+	}
+
+	inline void leaveReadLockIfNeeded() noexcept
+	{
+		if constexpr (IsThreadSafe)
+		{
+			this->unlockShared();
+		}
+	}
+
+	// must be called within the critical section. newRoomCount must be >= itemCount.
+	bool reallocate(const int newRoomCount) noexcept
+	{
+		if (newRoomCount <= SmallBufferSize) // fits into small buffer
+		{
+			if (!usingSmallBuffer)
+			{
+				for (int i = 0; i < itemCount; i++)
+				{
+					smallBuffer[i] = std::move(list[i]);
+				}
+
+				delete[] list;
+
+				list = smallBuffer;
+				roomCount = SmallBufferSize;
+				usingSmallBuffer = true;
+			}
+			return true;
+		}
+
+		T* newList = new T[newRoomCount];
+
+		// Move existing items to new buffer
+		for (int i = 0; i < itemCount; i++)
+		{
+			newList[i] = std::move(list[i]);
+		}
+
+		// Free old buffer if it was heap allocated
+		if (!usingSmallBuffer)
+			delete[] list;
+
+		list = newList;
+		roomCount = newRoomCount;
+		usingSmallBuffer = false;
+
+		return true;
+	}
+
+	// must be called within the critical section.
+	bool ensureRoom(const int requiredCount) noexcept
+	{
+		if (roomCount >= requiredCount) // no need reallocation. room count is enough!
+			return true;
+
+		const int newRoomCount = KContainerGrowth<GrowthPolicy, SmallBufferSize>::calculateRoomCount(roomCount, requiredCount);
+		if (newRoomCount < 0)
+			return false;
+
+		return reallocate(newRoomCount);
+	}
+
+	// must be called within the critical section. @returns index of the item if it lives inside our buffer, otherwise -1.
+	int getOwnIndex(const T* item) const noexcept
+	{
+		return ((item >= list) && (item < (list + itemCount))) ? (int)(item - list) : -1;
+	}
+
+	// must be called within the lock. (ReaderWriter locks are not recursive)
+	int getIndexUnlocked(const T& item) const noexcept
+	{
+		for (int i = 0; i < itemCount; i++)
+		{
+			if (list[i] == item)
+				return i;
+		}
+		return -1;
+	}
+
+	// must be called within the critical section.
+	bool removeUnlocked(const int index) noexcept
+	{
+		if ((index < 0) || (index >= itemCount)) // out of range!
+			return false;
+
+		// Shift all elements after 'index' one position to the left
+		for (int i = index; i < itemCount - 1; i++)
+		{
+			list[i] = std::move(list[i + 1]);
+		}
+		itemCount--;
+
+		return true;
+	}
+
 public:
 	/**
 		Constructs KVector object.
@@ -99,7 +203,7 @@ public:
 
 		// other may be concurrently mutated by another thread, so its own lock must be held while we read it.
 		KVector& src = const_cast<KVector&>(other);
-		src.enterCriticalSectionIfNeeded();
+		src.enterReadLockIfNeeded();
 
 		// If other has more items than our small buffer can hold
 		if (other.itemCount > SmallBufferSize)
@@ -116,7 +220,7 @@ public:
 			list[i] = other.list[i];
 		}
 
-		src.leaveCriticalSectionIfNeeded();
+		src.leaveReadLockIfNeeded();
 	}
 
 	/**
@@ -133,11 +237,11 @@ public:
 		if (this < &src)
 		{
 			enterCriticalSectionIfNeeded();
-			src.enterCriticalSectionIfNeeded();
+			src.enterReadLockIfNeeded();
 		}
 		else
 		{
-			src.enterCriticalSectionIfNeeded();
+			src.enterReadLockIfNeeded();
 			enterCriticalSectionIfNeeded();
 		}
 
@@ -165,7 +269,7 @@ public:
 		}
 
 		leaveCriticalSectionIfNeeded();
-		src.leaveCriticalSectionIfNeeded();
+		src.leaveReadLockIfNeeded();
 		return *this;
 	}
 
@@ -185,33 +289,92 @@ public:
 			leaveCriticalSectionIfNeeded();
 			return true;
 		}
-		else // require reallocation!
+
+		// item may be one of our own elements, which will be moved by the reallocation.
+		const int ownIndex = getOwnIndex(&item);
+
+		if (!ensureRoom(itemCount + 1))
 		{
-			int newRoomCount = roomCount + SmallBufferSize;
-			T* newList = new T[newRoomCount];
+			leaveCriticalSectionIfNeeded();
+			return false;
+		}
 
-			// Copy existing items to new buffer
-			for (int i = 0; i < itemCount; i++)
-			{
-				newList[i] = std::move(list[i]);
-			}
+		list[itemCount] = (ownIndex == -1) ? item : T(list[ownIndex]); // copy
+		itemCount++;
 
-			// Add the new item
-			newList[itemCount] = item;
-			itemCount++;
+		leaveCriticalSectionIfNeeded();
+		return true;
+	}
 
-			// Free old buffer if it was heap allocated
-			if (!usingSmallBuffer)
-				delete[] list;
+	/**
+		Adds given number of items to the end of the list with a single reallocation.
+		@returns false if memory allocation failed! (list is not modified)
+	*/
+	bool addRange(const T* items, const int count) noexcept
+	{
+		if ((items == nullptr) || (count <= 0))
+			return (count == 0);
 
-			// Update to use new buffer
-			list = newList;
-			roomCount = newRoomCount;
-			usingSmallBuffer = false;
+		enterCriticalSectionIfNeeded();
 
+		// items may point into our own buffer, which can be moved by the reallocation.
+		const int ownIndex = getOwnIndex(items);
+
+		if (((0x7FFFFFFF - itemCount) < count) || !ensureRoom(itemCount + count))
+		{
 			leaveCriticalSectionIfNeeded();
-			return true;
+			return false;
+		}
+
+		const T* src = (ownIndex == -1) ? items : (list + ownIndex);
+		for (int i = 0; i < count; i++)
+		{
+			list[itemCount + i] = src[i]; // copy
 		}
+		itemCount += count;
+
+		leaveCriticalSectionIfNeeded();
+		return true;
+	}
+
+	/**
+		Preallocates room for at least given number of items. Never shrinks the buffer.
+		@returns false if memory allocation failed!
+	*/
+	bool reserve(const int capacity) noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		bool retVal = true;
+		if (capacity > roomCount)
+			retVal = reallocate(capacity);
+
+		leaveCriticalSectionIfNeeded();
+		return retVal;
+	}
+
+	/**
+		Releases unused heap room. Falls back to small buffer if items fit into it.
+	*/
+	void shrinkToFit() noexcept
+	{
+		enterCriticalSectionIfNeeded();
+
+		if (!usingSmallBuffer && (roomCount > itemCount))
+			reallocate(itemCount);
+
+		leaveCriticalSectionIfNeeded();
+	}
+
+	/**
+		@returns number of items which can be stored without reallocation.
+	*/
+	int getCapacity() noexcept
+	{
+		enterReadLockIfNeeded();
+		const int capacity = roomCount;
+		leaveReadLockIfNeeded();
+		return capacity;
 	}
 
 	T get(const int index) noexcept
@@ -219,17 +382,17 @@ public:
 		if constexpr (IsThreadSafe)
 		{
 			// Thread-safe path: need to copy under lock
-			enterCriticalSectionIfNeeded();
+			enterReadLockIfNeeded();
 
 			if ((0 <= index) && (index < itemCount))
 			{
 				T object(list[index]); // make a copy under lock
-				leaveCriticalSectionIfNeeded();
+				leaveReadLockIfNeeded();
 				return object;
 			}
 			else
 			{
-				leaveCriticalSectionIfNeeded();
+				leaveReadLockIfNeeded();
 				return T();
 			}
 		}
@@ -250,17 +413,17 @@ public:
 	// avoids extra copy
 	bool get(const int index, T& outItem) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
 
 		if ((0 <= index) && (index < itemCount)) // checks for valid range!
 		{
 			outItem = list[index];
-			leaveCriticalSectionIfNeeded();
+			leaveReadLockIfNeeded();
 			return true;
 		}
 		else // out of range!
 		{
-			leaveCriticalSectionIfNeeded();
+			leaveReadLockIfNeeded();
 			outItem = T();
 			return false;
 		}
@@ -298,24 +461,10 @@ public:
 	bool remove(const int index) noexcept
 	{
 		enterCriticalSectionIfNeeded();
+		const bool retVal = removeUnlocked(index);
+		leaveCriticalSectionIfNeeded();
 
-		if ((0 <= index) && (index < itemCount))
-		{
-			// Shift all elements after 'index' one position to the left
-			for (int i = index; i < itemCount - 1; i++)
-			{
-				list[i] = std::move(list[i + 1]);
-			}
-			itemCount--;
-
-			leaveCriticalSectionIfNeeded();
-			return true;
-		}
-		else // out of range!
-		{
-			leaveCriticalSectionIfNeeded();
-			return false;
-		}
+		return retVal;
 	}
 
 	bool removeItem(const T& item) noexcept
@@ -323,9 +472,9 @@ public:
 		enterCriticalSectionIfNeeded();
 
 		bool retVal = false;
-		const int index = getIndex(item);
+		const int index = getIndexUnlocked(item);
 		if (index != -1)
-			retVal = remove(index);
+			retVal = removeUnlocked(index);
 
 		leaveCriticalSectionIfNeeded();
 		return retVal;
@@ -356,20 +505,13 @@ public:
 	*/
 	int getIndex(const T& item) noexcept
 	{
-		enterCriticalSectionIfNeeded();
+		enterReadLockIfNeeded();
+		const int index = getIndexUnlocked(item);
+		leaveReadLockIfNeeded();
 
-		for (int i = 0; i < itemCount; i++)
-		{
-			if (list[i] == item)
-			{
-				leaveCriticalSectionIfNeeded();
-				return i;
-			}
-		}
-
-		leaveCriticalSectionIfNeeded();
-		return -1;
+		return index;
 	}
+
 	/**
 		@returns item count in the list
 	*/
@@ -378,12 +520,77 @@ public:
 		return itemCount;
 	}
 
+	/**
+		Raw pointer iterators for range-based for loops. Only available on non thread-safe lists,
+		use lockedView() for thread-safe ones. Do not add/remove items while iterating.
+
+		e.g. @code
+		for (auto& item : list) { ... }
+		@endcode
+	*/
+	T* begin() noexcept
+	{
+		static_assert(!IsThreadSafe, "begin()/end() are not available on thread-safe lists. use lockedView()");
+		return list;
+	}
+
+	T* end() noexcept
+	{
+		static_assert(!IsThreadSafe, "begin()/end() are not available on thread-safe lists. use lockedView()");
+		return list + itemCount;
+	}
+
+	/**
+		Holds the list's lock for its lifetime and exposes raw iteration over the items.
+		Keep the view short-lived; other threads are blocked while it exists.
+		Items are handed out by reference, so the exclusive lock is taken even in ReaderWriter mode.
+	*/
+	class LockedView
+	{
+	private:
+		KVector& owner;
+
+	public:
+		explicit LockedView(KVector& owner) noexcept : owner(owner)
+		{
+			owner.enterCriticalSectionIfNeeded();
+		}
+
+		LockedView(const LockedView&) = delete;
+		LockedView& operator=(const LockedView&) = delete;
+
+		T* begin() const noexcept { return owner.list; }
+		T* end() const noexcept { return owner.list + owner.itemCount; }
+		int size() const noexcept { return owner.itemCount; }
+		T& operator[](const int index) const noexcept { return owner.list[index]; }
+
+		~LockedView() noexcept
+		{
+			owner.leaveCriticalSectionIfNeeded();
+		}
+	};
+
+	/**
+		Locks the list (if thread-safe) until the returned view goes out of scope.
+
+		e.g. @code
+		for (auto& item : list.lockedView()) { ... }
+		@endcode
+	*/
+	LockedView lockedView() noexcept
+	{
+		return LockedView(*this);
+	}
+
 	/**
 	 * Safely iterate through all items in the list with thread synchronization.
 	 * The entire iteration is protected by critical section if thread safety is enabled.
+	 * func is a template parameter, so the call is inlined. (no std::function overhead)
+	 * Takes the exclusive lock even in ReaderWriter mode since func receives mutable references.
 	 * @param func Function/lambda to call for each item in the list
 	*/
-	void forEach(std::function<void(T&)> func) noexcept
+	template<typename Func>
+	void forEach(Func&& func) noexcept
 	{
 		enterCriticalSectionIfNeeded();
 		for (int i = 0; i < itemCount; i++)
@@ -397,7 +604,8 @@ public:
 	 * Safely iterate with index access. Useful when you need the index as well.
 	 * @param func Function/lambda that takes (item, index) as parameters
 	*/
-	void forEachWithIndex(std::function<void(T&, int)> func) noexcept
+	template<typename Func>
+	void forEachWithIndex(Func&& func) noexcept
 	{
 		enterCriticalSectionIfNeeded();
 
@@ -414,7 +622,8 @@ public:
 	 * @param func Function/lambda that returns bool (true = continue, false = stop)
 	 * @returns true if iteration completed, false if stopped early
 	*/
-	bool forEachUntilWithIndex(std::function<bool(T&, int)> func) noexcept
+	template<typename Func>
+	bool forEachUntilWithIndex(Func&& func) noexcept
 	{
 		enterCriticalSectionIfNeeded();
 
@@ -437,7 +646,8 @@ public:
 	 * @param func Function/lambda that returns bool (true = continue, false = stop)
 	 * @returns true if iteration completed, false if stopped early
 	*/
-	bool forEachUntil(std::function<bool(T&)> func) noexcept
+	template<typename Func>
+	bool forEachUntil(Func&& func) noexcept
 	{
 		enterCriticalSectionIfNeeded();
 
@@ -457,10 +667,12 @@ public:
 
 	/**
 	 * Safely iterate backwards through all items in the list with thread synchronization.
-	 * Safe for removing items during iteration since indices aren't affected by removals.
+	 * func can remove items since indices aren't affected by removals.
+	 * In ReaderWriter mode func must not modify this list. (SRW locks are not recursive, so it deadlocks)
 	 * @param func Function/lambda to call for each item in the list (from last to first)
 	*/
-	void forEachReverse(std::function<void(T&)> func) noexcept
+	template<typename Func>
+	void forEachReverse(Func&& func) noexcept
 	{
 		enterCriticalSectionIfNeeded();
 		for (int i = itemCount - 1; i >= 0; i--)
@@ -472,10 +684,12 @@ public:
 
 	/**
 	 * Safely iterate backwards with index access.
-	 * Safe for removing items during iteration.
+	 * func can remove items.
+	 * In ReaderWriter mode func must not modify this list. (SRW locks are not recursive, so it deadlocks)
 	 * @param func Function/lambda that takes (item, index) as parameters
 	*/
-	void forEachReverseWithIndex(std::function<void(T&, int)> func) noexcept
+	template<typename Func>
+	void forEachReverseWithIndex(Func&& func) noexcept
 	{
 		enterCriticalSectionIfNeeded();
 		for (int i = itemCount - 1; i >= 0; i--)
@@ -487,11 +701,13 @@ public:
 
 	/**
 	 * Safely iterate backwards with early termination support and index.
-	 * Safe for removing items during iteration.
+	 * func can remove items.
+	 * In ReaderWriter mode func must not modify this list. (SRW locks are not recursive, so it deadlocks)
 	 * @param func Function/lambda that returns bool (true = continue, false = stop)
 	 * @returns true if iteration completed, false if stopped early
 	*/
-	bool forEachReverseUntilWithIndex(std::function<bool(T&, int)> func) noexcept
+	template<typename Func>
+	bool forEachReverseUntilWithIndex(Func&& func) noexcept
 	{
 		enterCriticalSectionIfNeeded();
 
@@ -530,7 +746,7 @@ public:
 	*/
 	static constexpr bool isThreadSafeInstance() noexcept
 	{
-		return IsThreadSafe;
+		return (IsThreadSafe != KThreadSafety::None);
 	}
 
 	/** Destructs KVector object.*/
@@ -31,3 +31,7 @@
 	#define RFC_NATIVE_INT int
 #endif
 
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define RFC_X86
+#endif
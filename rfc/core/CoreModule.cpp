@@ -47,11 +47,15 @@ public:
 		if (CoreModuleInitParams::initCOMAsSTA)
 			::CoInitialize(NULL); //Initializes COM as STA.
 
+		KStringInterner::createGlobal();
+
 		return true;
 	}
 
 	static void rfcModuleFree() noexcept
 	{
+		KStringInterner::destroyGlobal();
+
 		if (CoreModuleInitParams::initCOMAsSTA)
 			::CoUninitialize();
 	}
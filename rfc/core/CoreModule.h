@@ -32,6 +32,10 @@
 #include "KAssert.h"
 #include "KRefCountedMemory.h"
 #include "KString.h"
+#include "KStringBuilder.h"
+#include "KStringKernels.h"
+#include "KStringInterner.h"
+#include "KHash.h"
 
 // link default libs here so we don't need to link them from commandline(Clang).
 
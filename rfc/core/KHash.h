@@ -0,0 +1,168 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "Architecture.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+	Fast non-cryptographic hashing used by KString and the hash containers.
+	hash64 is the XXH64 algorithm. Results are same as the reference implementation on little-endian cpus.
+*/
+class KHash
+{
+private:
+	static const uint64_t Prime1 = 11400714785074694791ULL;
+	static const uint64_t Prime2 = 14029467366897019727ULL;
+	static const uint64_t Prime3 = 1609587929392839161ULL;
+	static const uint64_t Prime4 = 9650029242287828579ULL;
+	static const uint64_t Prime5 = 2870177450012600261ULL;
+
+	static inline uint64_t rotateLeft(uint64_t x, int bits) noexcept
+	{
+		return (x << bits) | (x >> (64 - bits));
+	}
+
+	static inline uint64_t read64(const unsigned char* data) noexcept
+	{
+		uint64_t value;
+		::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static inline uint32_t read32(const unsigned char* data) noexcept
+	{
+		uint32_t value;
+		::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static inline uint64_t round(uint64_t acc, uint64_t input) noexcept
+	{
+		acc += input * Prime2;
+		acc = rotateLeft(acc, 31);
+		return acc * Prime1;
+	}
+
+	static inline uint64_t mergeRound(uint64_t acc, uint64_t value) noexcept
+	{
+		acc ^= round(0, value);
+		return acc * Prime1 + Prime4;
+	}
+
+public:
+	static uint64_t hash64(const void* input, size_t length, uint64_t seed = 0) noexcept
+	{
+		const unsigned char* data = (const unsigned char*)input;
+		const unsigned char* const end = data + length;
+		uint64_t result;
+
+		if (length >= 32)
+		{
+			const unsigned char* const limit = end - 32;
+			uint64_t v1 = seed + Prime1 + Prime2;
+			uint64_t v2 = seed + Prime2;
+			uint64_t v3 = seed;
+			uint64_t v4 = seed - Prime1;
+
+			do
+			{
+				v1 = round(v1, read64(data));
+				v2 = round(v2, read64(data + 8));
+				v3 = round(v3, read64(data + 16));
+				v4 = round(v4, read64(data + 24));
+				data += 32;
+			} while (data <= limit);
+
+			result = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+			result = mergeRound(result, v1);
+			result = mergeRound(result, v2);
+			result = mergeRound(result, v3);
+			result = mergeRound(result, v4);
+		}
+		else
+		{
+			result = seed + Prime5;
+		}
+
+		result += (uint64_t)length;
+
+		for (; data + 8 <= end; data += 8)
+		{
+			result ^= round(0, read64(data));
+			result = rotateLeft(result, 27) * Prime1 + Prime4;
+		}
+
+		if (data + 4 <= end)
+		{
+			result ^= (uint64_t)read32(data) * Prime1;
+			result = rotateLeft(result, 23) * Prime2 + Prime3;
+			data += 4;
+		}
+
+		while (data < end)
+		{
+			result ^= (*data++) * Prime5;
+			result = rotateLeft(result, 11) * Prime1;
+		}
+
+		result ^= result >> 33;
+		result *= Prime2;
+		result ^= result >> 29;
+		result *= Prime3;
+		result ^= result >> 32;
+		return result;
+	}
+
+	/**
+		hash64 folded to size_t.
+	*/
+	static inline size_t hash(const void* input, size_t length) noexcept
+	{
+		const uint64_t value = hash64(input, length);
+
+	#ifdef RFC64
+		return (size_t)value;
+	#else
+		return (size_t)(value ^ (value >> 32));
+	#endif
+	}
+
+	/**
+		Mixes bits of an integer key. (finalizer of murmur3)
+	*/
+	static inline size_t hashInteger(uint64_t key) noexcept
+	{
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdULL;
+		key ^= key >> 33;
+		key *= 0xc4ceb9fe1a85ec53ULL;
+		key ^= key >> 33;
+
+	#ifdef RFC64
+		return (size_t)key;
+	#else
+		return (size_t)(key ^ (key >> 32));
+	#endif
+	}
+};
@@ -40,7 +40,10 @@ protected:
 public:
 	T buffer;
 
-	KRefCountedMemory(T buffer) noexcept : refCount(1), buffer(buffer) {}
+	// cached hash of the buffer content. zero until calculated. (used by KString)
+	volatile size_t hash;
+
+	KRefCountedMemory(T buffer) noexcept : refCount(1), buffer(buffer), hash(0) {}
 	
 	/**
 		Make sure to call this method if you construct new KRefCountedMemory or keep reference to another KRefCountedMemory object.
@@ -19,9 +19,12 @@
 */
 
 #include "KString.h"
+#include "KStringBuilder.h"
+#include "KStringKernels.h"
+#include "KStringInterner.h"
+#include "KHash.h"
 #include <stdio.h>
 #include <stdarg.h>
-#include <string_view>
 
 const KString operator+ (const char* const string1, const KString& string2) noexcept
 {
@@ -496,25 +499,29 @@ KString KString::replace(const KString& textToFind, const KString& replacementTe
 	if ((characterCount == 0) || (textToFind.characterCount == 0))
 		return *this;
 
-	KString result;
-	int searchStart = 0;
+	const wchar_t* str = getStringPtr();
+	const wchar_t* pattern = textToFind.getStringPtr();
+	int found = KStringKernels::findString(str, characterCount, pattern, textToFind.characterCount);
 
-	while (searchStart < characterCount)
-	{
-		KString remaining = subString(searchStart, characterCount - 1);
-		int foundAt = remaining.indexOf(textToFind);
+	if (found == -1) // nothing to replace. share the buffer.
+		return *this;
 
-		if (foundAt == -1)
-		{
-			result = result.append(remaining);
-			break;
-		}
+	KStringBuilder builder(characterCount);
+	int segmentStart = 0;
+
+	while (found != -1)
+	{
+		builder.append(str + segmentStart, found);
+		builder.append(replacementText);
 
-		result = result.append(remaining.subString(0, foundAt - 1)).append(replacementText);
-		searchStart += foundAt + textToFind.characterCount;
+		segmentStart += found + textToFind.characterCount;
+		found = KStringKernels::findString(str + segmentStart, characterCount - segmentStart,
+			pattern, textToFind.characterCount);
 	}
 
-	return result;
+	builder.append(str + segmentStart, characterCount - segmentStart);
+
+	return builder.toString();
 }
 
 bool KString::compareIgnoreCase(const KString& otherString)const noexcept
@@ -522,21 +529,27 @@ bool KString::compareIgnoreCase(const KString& otherString)const noexcept
 	if (characterCount == 0 && otherString.characterCount == 0)
 		return true;
 
-	if ((otherString.characterCount != 0) && (characterCount != 0))
-		return (::_wcsicmp(getStringPtr(), otherString.getStringPtr()) == 0);
+	if (characterCount != otherString.characterCount)
+		return false;
 
-	return false;
+	return KStringKernels::equalsIgnoreCase(getStringPtr(), otherString.getStringPtr(), characterCount);
 }
 
 bool KString::compare(const KString& otherString)const noexcept
 {
-	if (characterCount == 0 && otherString.characterCount == 0)
+	if (characterCount != otherString.characterCount)
+		return false;
+
+	if (characterCount == 0)
 		return true;
 
-	if ((otherString.characterCount != 0) && (characterCount != 0))
-		return (::wcscmp(getStringPtr(), otherString.getStringPtr()) == 0);
+	const wchar_t* str = getStringPtr();
+	const wchar_t* otherStr = otherString.getStringPtr();
 
-	return false;
+	if (str == otherStr) // shared buffer
+		return true;
+
+	return (::memcmp(str, otherStr, characterCount * sizeof(wchar_t)) == 0);
 }
 
 bool KString::compareWithStaticText(const wchar_t* const text)const noexcept
@@ -589,9 +602,8 @@ int KString::indexOfChar(wchar_t character, int startIndex)const noexcept
 	if ((characterCount == 0) || (startIndex < 0) || (startIndex >= characterCount))
 		return -1;
 
-	const wchar_t* str = getStringPtr();
-	const wchar_t* found = ::wcschr(str + startIndex, character);
-	return found ? (int)(found - str) : -1;
+	const int found = KStringKernels::findChar(getStringPtr() + startIndex, characterCount - startIndex, character);
+	return (found == -1) ? -1 : (startIndex + found);
 }
 
 int KString::lastIndexOfChar(wchar_t character)const noexcept
@@ -599,9 +611,7 @@ int KString::lastIndexOfChar(wchar_t character)const noexcept
 	if (characterCount == 0)
 		return -1;
 
-	const wchar_t* str = getStringPtr();
-	const wchar_t* found = ::wcsrchr(str, character);
-	return found ? (int)(found - str) : -1;
+	return KStringKernels::findLastChar(getStringPtr(), characterCount, character);
 }
 
 int KString::indexOf(const KString& textToFind)const noexcept
@@ -609,9 +619,7 @@ int KString::indexOf(const KString& textToFind)const noexcept
 	if ((characterCount == 0) || (textToFind.characterCount == 0))
 		return -1;
 
-	const wchar_t* str = getStringPtr();
-	const wchar_t* found = ::wcsstr(str, textToFind.getStringPtr());
-	return found ? (int)(found - str) : -1;
+	return KStringKernels::findString(getStringPtr(), characterCount, textToFind.getStringPtr(), textToFind.characterCount);
 }
 
 bool KString::contains(const KString& textToFind)const noexcept
@@ -669,7 +677,7 @@ KString KString::toUpperCase()const noexcept
 		return KString();
 
 	KString result(getStringPtr(), KStringBehaviour::MAKE_A_COPY, characterCount);
-	::CharUpperBuffW((wchar_t*)result.getStringPtr(), result.characterCount);
+	KStringKernels::toUpperCase((wchar_t*)result.getStringPtr(), result.characterCount);
 
 	return result;
 }
@@ -680,7 +688,7 @@ KString KString::toLowerCase()const noexcept
 		return KString();
 
 	KString result(getStringPtr(), KStringBehaviour::MAKE_A_COPY, characterCount);
-	::CharLowerBuffW((wchar_t*)result.getStringPtr(), result.characterCount);
+	KStringKernels::toLowerCase((wchar_t*)result.getStringPtr(), result.characterCount);
 
 	return result;
 }
@@ -721,29 +729,30 @@ void KString::splitLines(bool ignoreEmptyLines, std::function<void(int, const KS
 
 	const wchar_t* str = getStringPtr();
 	int lineIndex = 0;
-	const wchar_t* lineStart = str;
+	int lineStart = 0;
 
-	for (const wchar_t* p = str; *p != L'\0'; ++p)
+	while (true)
 	{
-		if (*p == L'\r' || *p == L'\n')
-		{
-			int lineLength = (int)(p - lineStart);
+		const int lineLength = KStringKernels::findLineBreak(str + lineStart, characterCount - lineStart);
+		if (lineLength == -1)
+			break;
 
-			if (!(ignoreEmptyLines && lineLength == 0))
-				func(lineIndex++, KString(lineStart, KStringBehaviour::MAKE_A_COPY, lineLength));
+		if (!(ignoreEmptyLines && lineLength == 0))
+			func(lineIndex++, KString(str + lineStart, KStringBehaviour::MAKE_A_COPY, lineLength));
 
-			// skip \r\n as a single newline
-			if (*p == L'\r' && *(p + 1) == L'\n')
-				++p;
+		const int lineEnd = lineStart + lineLength;
 
-			lineStart = p + 1;
-		}
+		// skip \r\n as a single newline
+		if (str[lineEnd] == L'\r' && (lineEnd + 1) < characterCount && str[lineEnd + 1] == L'\n')
+			lineStart = lineEnd + 2;
+		else
+			lineStart = lineEnd + 1;
 	}
 
 	// last line
-	int lastLineLength = (int)((str + characterCount) - lineStart);
+	const int lastLineLength = characterCount - lineStart;
 	if (!(ignoreEmptyLines && lastLineLength == 0))
-		func(lineIndex, KString(lineStart, KStringBehaviour::MAKE_A_COPY, lastLineLength));
+		func(lineIndex, KString(str + lineStart, KStringBehaviour::MAKE_A_COPY, lastLineLength));
 }
 
 void KString::split(wchar_t delimiter, bool ignoreEmptyParts, std::function<void(int, const KString&)> func) const noexcept
@@ -753,25 +762,24 @@ void KString::split(wchar_t delimiter, bool ignoreEmptyParts, std::function<void
 
 	const wchar_t* str = getStringPtr();
 	int partIndex = 0;
-	const wchar_t* partStart = str;
+	int partStart = 0;
 
-	for (const wchar_t* p = str; *p != L'\0'; ++p)
+	while (true)
 	{
-		if (*p == delimiter)
-		{
-			int partLength = (int)(p - partStart);
+		const int partLength = KStringKernels::findChar(str + partStart, characterCount - partStart, delimiter);
+		if (partLength == -1)
+			break;
 
-			if (!(ignoreEmptyParts && partLength == 0))
-				func(partIndex++, KString(partStart, KStringBehaviour::MAKE_A_COPY, partLength));
+		if (!(ignoreEmptyParts && partLength == 0))
+			func(partIndex++, KString(str + partStart, KStringBehaviour::MAKE_A_COPY, partLength));
 
-			partStart = p + 1;
-		}
+		partStart += partLength + 1;
 	}
 
 	// last part
-	int lastPartLength = (int)((str + characterCount) - partStart);
+	const int lastPartLength = characterCount - partStart;
 	if (!(ignoreEmptyParts && lastPartLength == 0))
-		func(partIndex, KString(partStart, KStringBehaviour::MAKE_A_COPY, lastPartLength));
+		func(partIndex, KString(str + partStart, KStringBehaviour::MAKE_A_COPY, lastPartLength));
 }
 
 size_t KString::hashCode()const noexcept
@@ -779,35 +787,57 @@ size_t KString::hashCode()const noexcept
 	if (characterCount == 0)
 		return 0;
 
-	return std::hash<std::wstring_view>{}(std::wstring_view(getStringPtr(), (size_t)characterCount));
+	if (bufferType == KStringBufferType::HeapText)
+	{
+		// other threads may calculate it at the same time. they all store the same value.
+		size_t hash = data.refCountedMem->hash;
+		if (hash == 0)
+		{
+			hash = calculateHash(data.refCountedMem->buffer, characterCount);
+			data.refCountedMem->hash = hash;
+		}
+		return hash;
+	}
+
+	return calculateHash(getStringPtr(), characterCount);
 }
 
-KString KString::format(const wchar_t* const fmt, ...) noexcept
+size_t KString::calculateHash(const wchar_t* text, int length) noexcept
 {
-	wchar_t stackBuffer[256];
+	return KHash::hash(text, length * sizeof(wchar_t));
+}
 
-	va_list args;
-	va_start(args, fmt);
-	int required = ::_vsnwprintf_s(stackBuffer, 256, _TRUNCATE, fmt, args);
-	va_end(args);
+bool KString::sharesBufferWith(const KString& other)const noexcept
+{
+	if (characterCount != other.characterCount)
+		return false;
 
-	if (required >= 0) // fit in stack buffer, no truncation
-		return KString(stackBuffer, KStringBehaviour::MAKE_A_COPY, required);
+	if (characterCount == 0)
+		return true;
 
-	va_start(args, fmt);
-	required = ::_vscwprintf(fmt, args);
-	va_end(args);
+	if ((bufferType == KStringBufferType::SSOText) || (other.bufferType == KStringBufferType::SSOText))
+		return false;
 
-	if (required <= 0)
-		return KString();
+	return getStringPtr() == other.getStringPtr();
+}
 
-	wchar_t* buffer = (wchar_t*)::malloc((required + 1) * sizeof(wchar_t));
+KString KString::intern(const KString& text) noexcept
+{
+	KStringInterner* interner = KStringInterner::getGlobal();
+	return interner ? interner->intern(text) : text;
+}
 
+KString KString::format(const wchar_t* const fmt, ...) noexcept
+{
+	// short results are formatted into the builder's internal buffer. long ones grow it once and hand it over without a copy.
+	KStringBuilder builder;
+
+	va_list args;
 	va_start(args, fmt);
-	::_vsnwprintf_s(buffer, required + 1, _TRUNCATE, fmt, args);
+	builder.appendFormatV(fmt, args);
 	va_end(args);
 
-	return KString(buffer, KStringBehaviour::FREE_ON_DESTROY, required);
+	return builder.toString();
 }
 
 char* KString::toUTF8String(const wchar_t* text) noexcept
@@ -354,9 +354,24 @@ public:
 	// separate a string by given delimiter character with index. remaining content will be also passed at the end.
 	void split(wchar_t delimiter, bool ignoreEmptyParts, std::function<void(int, const KString&)> func) const noexcept;
 
-	// hash code for this string. useful for hashing/lookup structures.
+	// hash code for this string. useful for hashing/lookup structures. heap strings calculate it once and cache it in the shared buffer.
 	size_t hashCode()const noexcept;
 
+	// same hash as hashCode for the given text.
+	static size_t calculateHash(const wchar_t* text, int length) noexcept;
+
+	/**
+		Checks whether both strings point to the same text buffer. O(1).
+		Interned strings are equal only if they share the buffer.
+	*/
+	bool sharesBufferWith(const KString& other)const noexcept;
+
+	/**
+		Returns canonical copy of the text from the global KStringInterner.
+		Returns the text itself if the core module is not initialized.
+	*/
+	static KString intern(const KString& text) noexcept;
+
 	// printf-style formatted construction. e.g. KString::format(L"count: %d", n);
 	static KString format(const wchar_t* const fmt, ...) noexcept;
 
@@ -0,0 +1,231 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KStringBuilder.h"
+#include <stdio.h>
+
+KStringBuilder::KStringBuilder() noexcept
+{
+	resetToStackBuffer();
+}
+
+KStringBuilder::KStringBuilder(int initialCapacity) noexcept
+{
+	resetToStackBuffer();
+	reserve(initialCapacity);
+}
+
+void KStringBuilder::resetToStackBuffer() noexcept
+{
+	buffer = stackBuffer;
+	capacity = RFC_STRING_BUILDER_STACK_SIZE;
+	characterCount = 0;
+	stackBuffer[0] = 0;
+}
+
+bool KStringBuilder::ensureCapacity(int requiredCapacity) noexcept
+{
+	if (requiredCapacity <= capacity)
+		return true;
+
+	if (requiredCapacity < 0) // overflow in caller
+		return false;
+
+	// grow by 1.5x so a sequence of appends costs amortized O(1) per character.
+	int newCapacity = (capacity > (0x7FFFFFFE - (capacity / 2))) ? 0x7FFFFFFE : (capacity + (capacity / 2));
+	if (newCapacity < requiredCapacity)
+		newCapacity = requiredCapacity;
+
+	wchar_t* newBuffer;
+	if (buffer == stackBuffer)
+	{
+		newBuffer = (wchar_t*)::malloc(((size_t)newCapacity + 1) * sizeof(wchar_t));
+		if (newBuffer == nullptr)
+			return false;
+
+		::memcpy(newBuffer, stackBuffer, ((size_t)characterCount + 1) * sizeof(wchar_t));
+	}
+	else
+	{
+		newBuffer = (wchar_t*)::realloc(buffer, ((size_t)newCapacity + 1) * sizeof(wchar_t));
+		if (newBuffer == nullptr)
+			return false;
+	}
+
+	buffer = newBuffer;
+	capacity = newCapacity;
+	return true;
+}
+
+bool KStringBuilder::reserve(int capacity) noexcept
+{
+	return ensureCapacity(capacity);
+}
+
+KStringBuilder& KStringBuilder::append(const KString& text) noexcept
+{
+	return append((const wchar_t*)text, text.length());
+}
+
+KStringBuilder& KStringBuilder::append(const wchar_t* text, int length) noexcept
+{
+	if (text == nullptr)
+		return *this;
+
+	if (length == -1)
+		length = (int)::wcslen(text);
+
+	if (length <= 0)
+		return *this;
+
+	if (!ensureCapacity(characterCount + length))
+		return *this;
+
+	::memcpy(&buffer[characterCount], text, (size_t)length * sizeof(wchar_t));
+	characterCount += length;
+	buffer[characterCount] = 0;
+
+	return *this;
+}
+
+KStringBuilder& KStringBuilder::appendChar(wchar_t character) noexcept
+{
+	if (!ensureCapacity(characterCount + 1))
+		return *this;
+
+	buffer[characterCount++] = character;
+	buffer[characterCount] = 0;
+
+	return *this;
+}
+
+KStringBuilder& KStringBuilder::appendInt(int value, int radix) noexcept
+{
+	wchar_t digits[34]; // max 33 digits
+	::_itow_s(value, digits, 34, radix);
+
+	return append(digits, (int)::wcslen(digits));
+}
+
+KStringBuilder& KStringBuilder::appendFormat(const wchar_t* const fmt, ...) noexcept
+{
+	va_list args;
+	va_start(args, fmt);
+	appendFormatV(fmt, args);
+	va_end(args);
+
+	return *this;
+}
+
+KStringBuilder& KStringBuilder::appendFormatV(const wchar_t* const fmt, va_list args) noexcept
+{
+	if (fmt == nullptr)
+		return *this;
+
+	// try to format directly into the free space first.
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	const int freeSpace = capacity - characterCount;
+	int written = ::_vsnwprintf_s(&buffer[characterCount], (size_t)freeSpace + 1, _TRUNCATE, fmt, argsCopy);
+	va_end(argsCopy);
+
+	if (written >= 0) // fit, no truncation
+	{
+		characterCount += written;
+		return *this;
+	}
+
+	va_copy(argsCopy, args);
+	const int required = ::_vscwprintf(fmt, argsCopy);
+	va_end(argsCopy);
+
+	if ((required <= 0) || !ensureCapacity(characterCount + required))
+	{
+		buffer[characterCount] = 0; // drop the truncated output
+		return *this;
+	}
+
+	va_copy(argsCopy, args);
+	written = ::_vsnwprintf_s(&buffer[characterCount], (size_t)required + 1, _TRUNCATE, fmt, argsCopy);
+	va_end(argsCopy);
+
+	if (written > 0)
+		characterCount += written;
+	else
+		buffer[characterCount] = 0;
+
+	return *this;
+}
+
+int KStringBuilder::length() const noexcept
+{
+	return characterCount;
+}
+
+bool KStringBuilder::isEmpty() const noexcept
+{
+	return (characterCount == 0);
+}
+
+const wchar_t* KStringBuilder::getBuffer() const noexcept
+{
+	return buffer;
+}
+
+void KStringBuilder::clear() noexcept
+{
+	characterCount = 0;
+	buffer[0] = 0;
+}
+
+KString KStringBuilder::toString() noexcept
+{
+	if (characterCount == 0)
+		return KString();
+
+	// short text goes to the SSO buffer of the KString. keep our heap buffer for the next use.
+	if ((characterCount < KString::SSO_BUFFER_SIZE) || (buffer == stackBuffer))
+	{
+		KString result(buffer, KStringBehaviour::MAKE_A_COPY, characterCount);
+		clear();
+		return result;
+	}
+
+	// give away the heap buffer. trim it if more than a quarter is unused.
+	wchar_t* text = buffer;
+	const int textLength = characterCount;
+
+	if ((capacity - textLength) > (capacity / 4))
+	{
+		wchar_t* trimmed = (wchar_t*)::realloc(text, ((size_t)textLength + 1) * sizeof(wchar_t));
+		if (trimmed)
+			text = trimmed;
+	}
+
+	resetToStackBuffer();
+	return KString(text, KStringBehaviour::FREE_ON_DESTROY, textLength);
+}
+
+KStringBuilder::~KStringBuilder() noexcept
+{
+	if (buffer != stackBuffer)
+		::free(buffer);
+}
@@ -0,0 +1,121 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "KString.h"
+#include "KLeakDetector.h"
+#include <stdarg.h>
+
+// number of characters kept inside the builder before switching to heap memory.
+#ifndef RFC_STRING_BUILDER_STACK_SIZE
+	#define RFC_STRING_BUILDER_STACK_SIZE 128
+#endif
+
+/**
+	Mutable string buffer for building a KString piece by piece.
+	Heap buffer grows geometrically, so appending n characters costs O(n) in total.
+	toString() hands the heap buffer to the returned KString without copying.
+
+	e.g. @code
+	KStringBuilder sb;
+	sb.append(L"count: ");
+	sb.appendInt(count);
+	sb.appendFormat(L" (%.2f%%)", percent);
+	KString result = sb.toString(); // sb is empty after this call
+	@endcode
+*/
+class KStringBuilder
+{
+protected:
+	wchar_t* buffer; // points to stackBuffer or heap memory. always null terminated.
+	int characterCount;
+	int capacity; // max characters without the null terminator.
+	wchar_t stackBuffer[RFC_STRING_BUILDER_STACK_SIZE + 1];
+
+	bool ensureCapacity(int requiredCapacity) noexcept;
+	void resetToStackBuffer() noexcept;
+
+public:
+	KStringBuilder() noexcept;
+
+	/**
+		@param initialCapacity number of characters to preallocate.
+	*/
+	explicit KStringBuilder(int initialCapacity) noexcept;
+
+	/**
+		Preallocates room for at least given number of characters.
+		@returns false if memory allocation failed!
+	*/
+	bool reserve(int capacity) noexcept;
+
+	KStringBuilder& append(const KString& text) noexcept;
+
+	/**
+		@param length number of characters. use -1 for null terminated text.
+	*/
+	KStringBuilder& append(const wchar_t* text, int length = -1) noexcept;
+
+	KStringBuilder& appendChar(wchar_t character) noexcept;
+
+	KStringBuilder& appendInt(int value, int radix = 10) noexcept;
+
+	// printf-style formatted append. e.g. sb.appendFormat(L"%d items", n);
+	KStringBuilder& appendFormat(const wchar_t* const fmt, ...) noexcept;
+
+	KStringBuilder& appendFormatV(const wchar_t* const fmt, va_list args) noexcept;
+
+	/**
+		@returns number of characters in the builder.
+	*/
+	int length() const noexcept;
+
+	bool isEmpty() const noexcept;
+
+	/**
+		@returns null terminated content. valid until next modification.
+	*/
+	const wchar_t* getBuffer() const noexcept;
+
+	/**
+		Removes the content. Heap buffer is kept for reuse.
+	*/
+	void clear() noexcept;
+
+	/**
+		Moves the content out to a KString and clears the builder.
+		Heap buffer is transferred to the KString without copying.
+		Short content is copied into the SSO buffer of the KString and the heap buffer is kept for reuse.
+	*/
+	KString toString() noexcept;
+
+	~KStringBuilder() noexcept;
+
+	// no copy/movable
+	KStringBuilder(const KStringBuilder&) = delete;
+	KStringBuilder& operator=(const KStringBuilder&) = delete;
+	KStringBuilder(KStringBuilder&&) = delete;
+	KStringBuilder& operator=(KStringBuilder&&) = delete;
+
+private:
+	RFC_LEAK_DETECTOR(KStringBuilder)
+};
@@ -0,0 +1,184 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KStringInterner.h"
+#include <utility>
+
+#define RFC_INTERNER_INITIAL_CAPACITY 64
+
+KStringInterner* KStringInterner::globalInterner = nullptr;
+
+KStringInterner::KStringInterner() noexcept
+{
+	entries = nullptr;
+	capacity = 0;
+	count = 0;
+	::InitializeCriticalSection(&criticalSection);
+}
+
+// returns slot of the text or the empty slot where it should be inserted. capacity must not be zero.
+int KStringInterner::findSlot(const wchar_t* text, int length, size_t hash) const noexcept
+{
+	const int mask = capacity - 1;
+	int slot = (int)(hash & (size_t)mask);
+
+	while (true)
+	{
+		const Entry& entry = entries[slot];
+
+		if (entry.text.isEmpty())
+			return slot;
+
+		if ((entry.hash == hash) && (entry.text.length() == length) &&
+			(::memcmp((const wchar_t*)entry.text, text, length * sizeof(wchar_t)) == 0))
+			return slot;
+
+		slot = (slot + 1) & mask; // linear probing
+	}
+}
+
+void KStringInterner::grow() noexcept
+{
+	const int newCapacity = (capacity == 0) ? RFC_INTERNER_INITIAL_CAPACITY : (capacity * 2);
+	Entry* newEntries = new Entry[newCapacity];
+	Entry* oldEntries = entries;
+	const int oldCapacity = capacity;
+
+	entries = newEntries;
+	capacity = newCapacity;
+
+	for (int i = 0; i < oldCapacity; ++i)
+	{
+		if (oldEntries[i].text.isNotEmpty())
+		{
+			Entry& entry = entries[findSlot(oldEntries[i].text, oldEntries[i].text.length(), oldEntries[i].hash)];
+			entry.hash = oldEntries[i].hash;
+			entry.text = std::move(oldEntries[i].text);
+		}
+	}
+
+	delete[] oldEntries;
+}
+
+KString KStringInterner::intern(const wchar_t* text, int length) noexcept
+{
+	if ((text == nullptr) || (length <= 0))
+		return KString();
+
+	const size_t hash = KString::calculateHash(text, length);
+
+	::EnterCriticalSection(&criticalSection);
+
+	// keep load factor below 75%
+	if ((count + 1) * 4 > capacity * 3)
+		grow();
+
+	Entry& entry = entries[findSlot(text, length, hash)];
+
+	if (entry.text.isEmpty())
+	{
+		// always use heap memory. copies of sso strings would not share the buffer.
+		wchar_t* buffer = (wchar_t*)::malloc((length + 1) * sizeof(wchar_t));
+		::memcpy(buffer, text, length * sizeof(wchar_t));
+		buffer[length] = 0;
+
+		entry.hash = hash;
+		entry.text = KString(buffer, KStringBehaviour::FREE_ON_DESTROY, length);
+		entry.text.hashCode(); // cache the hash inside the shared buffer.
+		++count;
+	}
+
+	KString result(entry.text);
+
+	::LeaveCriticalSection(&criticalSection);
+
+	return result;
+}
+
+KString KStringInterner::intern(const KString& text) noexcept
+{
+	return intern((const wchar_t*)text, text.length());
+}
+
+KString KStringInterner::find(const KString& text) noexcept
+{
+	if (text.isEmpty())
+		return KString();
+
+	const size_t hash = text.hashCode();
+
+	::EnterCriticalSection(&criticalSection);
+
+	KString result;
+	if (capacity != 0)
+		result = entries[findSlot(text, text.length(), hash)].text;
+
+	::LeaveCriticalSection(&criticalSection);
+
+	return result;
+}
+
+int KStringInterner::getCount() noexcept
+{
+	::EnterCriticalSection(&criticalSection);
+	const int result = count;
+	::LeaveCriticalSection(&criticalSection);
+
+	return result;
+}
+
+void KStringInterner::clear() noexcept
+{
+	::EnterCriticalSection(&criticalSection);
+
+	delete[] entries;
+	entries = nullptr;
+	capacity = 0;
+	count = 0;
+
+	::LeaveCriticalSection(&criticalSection);
+}
+
+KStringInterner* KStringInterner::getGlobal() noexcept
+{
+	return globalInterner;
+}
+
+void KStringInterner::createGlobal() noexcept
+{
+	if (globalInterner == nullptr)
+		globalInterner = new KStringInterner();
+}
+
+void KStringInterner::destroyGlobal() noexcept
+{
+	if (globalInterner)
+	{
+		delete globalInterner;
+		globalInterner = nullptr;
+	}
+}
+
+KStringInterner::~KStringInterner() noexcept
+{
+	delete[] entries;
+	::DeleteCriticalSection(&criticalSection);
+}
@@ -0,0 +1,99 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "KString.h"
+#include "KLeakDetector.h"
+#include <windows.h>
+
+/**
+	Keeps a single canonical copy of each distinct text.
+	Returned strings are heap strings that share the buffer of the canonical copy, and their hash is already cached.
+	So two interned strings are equal only if they share the same buffer. Use KString::sharesBufferWith to compare them in O(1).
+	Canonical copies live until the interner is cleared or destroyed. Returned strings remain valid after that.
+	This class is thread-safe.
+
+	e.g. @code
+	KString name1 = KString::intern(L"width");
+	KString name2 = KString::intern(textFromFile);
+	if (name1.sharesBufferWith(name2)) {...}
+	@endcode
+*/
+class KStringInterner
+{
+protected:
+	struct Entry
+	{
+		size_t hash;
+		KString text; // empty if the slot is unused
+	};
+
+	Entry* entries;
+	int capacity; // always power of two
+	int count;
+	CRITICAL_SECTION criticalSection;
+
+	static KStringInterner* globalInterner;
+
+	int findSlot(const wchar_t* text, int length, size_t hash) const noexcept;
+	void grow() noexcept;
+
+public:
+	KStringInterner() noexcept;
+
+	/**
+		@returns canonical copy of the given text. empty string for empty text.
+	*/
+	KString intern(const KString& text) noexcept;
+
+	KString intern(const wchar_t* text, int length) noexcept;
+
+	/**
+		@returns canonical copy if the text was interned before. otherwise empty string.
+	*/
+	KString find(const KString& text) noexcept;
+
+	int getCount() noexcept;
+
+	// releases all canonical copies.
+	void clear() noexcept;
+
+	/**
+		Interner used by KString::intern. available between core module init and free.
+	*/
+	static KStringInterner* getGlobal() noexcept;
+
+	// called by the core module.
+	static void createGlobal() noexcept;
+	static void destroyGlobal() noexcept;
+
+	~KStringInterner() noexcept;
+
+	// no copy/movable
+	KStringInterner(const KStringInterner&) = delete;
+	KStringInterner& operator=(const KStringInterner&) = delete;
+	KStringInterner(KStringInterner&&) = delete;
+	KStringInterner& operator=(KStringInterner&&) = delete;
+
+private:
+	RFC_LEAK_DETECTOR(KStringInterner)
+};
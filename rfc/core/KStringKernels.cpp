@@ -0,0 +1,544 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KStringKernels.h"
+#include <string.h>
+
+#ifdef RFC_STRING_SIMD
+	#include <emmintrin.h>
+	#include <immintrin.h>
+
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+
+	static_assert(sizeof(wchar_t) == 2, "string kernels expect 16 bit wchar_t");
+
+	// msvc accepts avx2 intrinsics in any function. gcc and clang need them to be marked.
+	#if defined(__GNUC__) || defined(__clang__)
+		#define RFC_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define RFC_TARGET_AVX2
+	#endif
+#endif
+
+// ---------------- scalar kernels ----------------
+
+static int scalarFindChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+	for (int i = 0; i < length; ++i)
+	{
+		if (text[i] == character)
+			return i;
+	}
+	return -1;
+}
+
+static int scalarFindLastChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+	for (int i = length - 1; i >= 0; --i)
+	{
+		if (text[i] == character)
+			return i;
+	}
+	return -1;
+}
+
+static int scalarFindString(const wchar_t* text, int length, const wchar_t* pattern, int patternLength, int start) noexcept
+{
+	const wchar_t first = pattern[0];
+	const int lastStart = length - patternLength;
+
+	for (int i = start; i <= lastStart; ++i)
+	{
+		if ((text[i] == first) && (::memcmp(text + i + 1, pattern + 1, (patternLength - 1) * sizeof(wchar_t)) == 0))
+			return i;
+	}
+	return -1;
+}
+
+static int scalarFindLineBreak(const wchar_t* text, int length) noexcept
+{
+	for (int i = 0; i < length; ++i)
+	{
+		if ((text[i] == L'\r') || (text[i] == L'\n'))
+			return i;
+	}
+	return -1;
+}
+
+// handles only ascii. returns false at first non-ascii character, with its index in "stopIndex".
+static bool scalarEqualsIgnoreCaseASCII(const wchar_t* text1, const wchar_t* text2, int length, int start, int* stopIndex) noexcept
+{
+	for (int i = start; i < length; ++i)
+	{
+		wchar_t c1 = text1[i];
+		wchar_t c2 = text2[i];
+
+		if ((c1 | c2) >= 0x80)
+		{
+			*stopIndex = i;
+			return false;
+		}
+
+		if ((c1 >= L'A') && (c1 <= L'Z'))
+			c1 += 0x20;
+		if ((c2 >= L'A') && (c2 <= L'Z'))
+			c2 += 0x20;
+
+		if (c1 != c2)
+		{
+			*stopIndex = -1; // mismatch
+			return false;
+		}
+	}
+
+	*stopIndex = length;
+	return true;
+}
+
+// returns index of first non-ascii character, or length.
+static int scalarChangeCaseASCII(wchar_t* text, int length, int start, wchar_t rangeBegin, wchar_t rangeEnd, wchar_t delta) noexcept
+{
+	for (int i = start; i < length; ++i)
+	{
+		const wchar_t c = text[i];
+		if (c >= 0x80)
+			return i;
+
+		if ((c >= rangeBegin) && (c <= rangeEnd))
+			text[i] = c ^ delta;
+	}
+	return length;
+}
+
+#ifdef RFC_STRING_SIMD
+
+static inline int lowestBitIndex(unsigned int value) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	::_BitScanForward(&index, value);
+	return (int)index;
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+static inline int highestBitIndex(unsigned int value) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	::_BitScanReverse(&index, value);
+	return (int)index;
+#else
+	return 31 - __builtin_clz(value);
+#endif
+}
+
+/*
+	Each 16 bit lane produces two bits in the byte mask of movemask. So character index = bit index / 2.
+	All loads are unaligned and never read past text + length.
+*/
+
+// ---------------- SSE2 kernels ----------------
+
+static int sse2FindChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+	const __m128i needle = _mm_set1_epi16((short)character);
+	int i = 0;
+
+	for (; i + 8 <= length; i += 8)
+	{
+		const __m128i block = _mm_loadu_si128((const __m128i*)(text + i));
+		const int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, needle));
+		if (mask)
+			return i + (lowestBitIndex(mask) >> 1);
+	}
+
+	const int found = scalarFindChar(text + i, length - i, character);
+	return (found == -1) ? -1 : (i + found);
+}
+
+static int sse2FindLastChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+	const __m128i needle = _mm_set1_epi16((short)character);
+	int i = length;
+
+	for (; i >= 8; i -= 8)
+	{
+		const __m128i block = _mm_loadu_si128((const __m128i*)(text + i - 8));
+		const int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, needle));
+		if (mask)
+			return i - 8 + (highestBitIndex(mask) >> 1);
+	}
+
+	return scalarFindLastChar(text, i, character);
+}
+
+// compares first and last characters of the pattern for 8 positions at once. full compare only runs on candidates.
+static int sse2FindString(const wchar_t* text, int length, const wchar_t* pattern, int patternLength) noexcept
+{
+	const __m128i first = _mm_set1_epi16((short)pattern[0]);
+	const __m128i last = _mm_set1_epi16((short)pattern[patternLength - 1]);
+	const size_t middleSize = (patternLength - 2) * sizeof(wchar_t);
+	int i = 0;
+
+	for (; i + patternLength - 1 + 8 <= length; i += 8)
+	{
+		const __m128i blockFirst = _mm_loadu_si128((const __m128i*)(text + i));
+		const __m128i blockLast = _mm_loadu_si128((const __m128i*)(text + i + patternLength - 1));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(blockFirst, first),
+			_mm_cmpeq_epi16(blockLast, last)));
+
+		while (mask)
+		{
+			const int bit = lowestBitIndex(mask);
+			const int pos = i + (bit >> 1);
+			if (::memcmp(text + pos + 1, pattern + 1, middleSize) == 0)
+				return pos;
+
+			mask &= ~(3u << bit);
+		}
+	}
+
+	return scalarFindString(text, length, pattern, patternLength, i);
+}
+
+static int sse2FindLineBreak(const wchar_t* text, int length) noexcept
+{
+	const __m128i cr = _mm_set1_epi16(L'\r');
+	const __m128i lf = _mm_set1_epi16(L'\n');
+	int i = 0;
+
+	for (; i + 8 <= length; i += 8)
+	{
+		const __m128i block = _mm_loadu_si128((const __m128i*)(text + i));
+		const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(block, cr), _mm_cmpeq_epi16(block, lf)));
+		if (mask)
+			return i + (lowestBitIndex(mask) >> 1);
+	}
+
+	const int found = scalarFindLineBreak(text + i, length - i);
+	return (found == -1) ? -1 : (i + found);
+}
+
+// all lanes below 0x80?
+static inline bool sse2IsASCII(__m128i block) noexcept
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(block, _mm_set1_epi16((short)0xFF80)),
+		_mm_setzero_si128())) == 0xFFFF;
+}
+
+// flips 0x20 bit of the lanes in [rangeBegin, rangeEnd]. lanes must be ascii.
+static inline __m128i sse2FlipCase(__m128i block, __m128i rangeBegin, __m128i rangeEnd) noexcept
+{
+	const __m128i inRange = _mm_and_si128(_mm_cmpgt_epi16(block, rangeBegin), _mm_cmplt_epi16(block, rangeEnd));
+	return _mm_xor_si128(block, _mm_and_si128(inRange, _mm_set1_epi16(0x20)));
+}
+
+static bool sse2EqualsIgnoreCaseASCII(const wchar_t* text1, const wchar_t* text2, int length, int* stopIndex) noexcept
+{
+	const __m128i upperBegin = _mm_set1_epi16(L'A' - 1);
+	const __m128i upperEnd = _mm_set1_epi16(L'Z' + 1);
+	int i = 0;
+
+	for (; i + 8 <= length; i += 8)
+	{
+		const __m128i block1 = _mm_loadu_si128((const __m128i*)(text1 + i));
+		const __m128i block2 = _mm_loadu_si128((const __m128i*)(text2 + i));
+
+		if (!sse2IsASCII(_mm_or_si128(block1, block2)))
+			break; // let the scalar loop find the exact position.
+
+		const __m128i lower1 = sse2FlipCase(block1, upperBegin, upperEnd);
+		const __m128i lower2 = sse2FlipCase(block2, upperBegin, upperEnd);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(lower1, lower2)) != 0xFFFF)
+		{
+			*stopIndex = -1;
+			return false;
+		}
+	}
+
+	return scalarEqualsIgnoreCaseASCII(text1, text2, length, i, stopIndex);
+}
+
+static int sse2ChangeCaseASCII(wchar_t* text, int length, wchar_t rangeBegin, wchar_t rangeEnd) noexcept
+{
+	const __m128i begin = _mm_set1_epi16((short)(rangeBegin - 1));
+	const __m128i end = _mm_set1_epi16((short)(rangeEnd + 1));
+	int i = 0;
+
+	for (; i + 8 <= length; i += 8)
+	{
+		const __m128i block = _mm_loadu_si128((const __m128i*)(text + i));
+		if (!sse2IsASCII(block))
+			break;
+
+		_mm_storeu_si128((__m128i*)(text + i), sse2FlipCase(block, begin, end));
+	}
+
+	return scalarChangeCaseASCII(text, length, i, rangeBegin, rangeEnd, 0x20);
+}
+
+// ---------------- AVX2 kernels ----------------
+
+RFC_TARGET_AVX2 static int avx2FindChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+	const __m256i needle = _mm256_set1_epi16((short)character);
+	int i = 0;
+
+	for (; i + 16 <= length; i += 16)
+	{
+		const __m256i block = _mm256_loadu_si256((const __m256i*)(text + i));
+		const unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, needle));
+		if (mask)
+			return i + (lowestBitIndex(mask) >> 1);
+	}
+
+	const int found = sse2FindChar(text + i, length - i, character);
+	return (found == -1) ? -1 : (i + found);
+}
+
+RFC_TARGET_AVX2 static int avx2FindLastChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+	const __m256i needle = _mm256_set1_epi16((short)character);
+	int i = length;
+
+	for (; i >= 16; i -= 16)
+	{
+		const __m256i block = _mm256_loadu_si256((const __m256i*)(text + i - 16));
+		const unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, needle));
+		if (mask)
+			return i - 16 + (highestBitIndex(mask) >> 1);
+	}
+
+	return sse2FindLastChar(text, i, character);
+}
+
+RFC_TARGET_AVX2 static int avx2FindString(const wchar_t* text, int length, const wchar_t* pattern, int patternLength) noexcept
+{
+	const __m256i first = _mm256_set1_epi16((short)pattern[0]);
+	const __m256i last = _mm256_set1_epi16((short)pattern[patternLength - 1]);
+	const size_t middleSize = (patternLength - 2) * sizeof(wchar_t);
+	int i = 0;
+
+	for (; i + patternLength - 1 + 16 <= length; i += 16)
+	{
+		const __m256i blockFirst = _mm256_loadu_si256((const __m256i*)(text + i));
+		const __m256i blockLast = _mm256_loadu_si256((const __m256i*)(text + i + patternLength - 1));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(blockFirst, first),
+			_mm256_cmpeq_epi16(blockLast, last)));
+
+		while (mask)
+		{
+			const int bit = lowestBitIndex(mask);
+			const int pos = i + (bit >> 1);
+			if (::memcmp(text + pos + 1, pattern + 1, middleSize) == 0)
+				return pos;
+
+			mask &= ~(3u << bit);
+		}
+	}
+
+	return scalarFindString(text, length, pattern, patternLength, i);
+}
+
+RFC_TARGET_AVX2 static int avx2FindLineBreak(const wchar_t* text, int length) noexcept
+{
+	const __m256i cr = _mm256_set1_epi16(L'\r');
+	const __m256i lf = _mm256_set1_epi16(L'\n');
+	int i = 0;
+
+	for (; i + 16 <= length; i += 16)
+	{
+		const __m256i block = _mm256_loadu_si256((const __m256i*)(text + i));
+		const unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi16(block, cr),
+			_mm256_cmpeq_epi16(block, lf)));
+		if (mask)
+			return i + (lowestBitIndex(mask) >> 1);
+	}
+
+	const int found = sse2FindLineBreak(text + i, length - i);
+	return (found == -1) ? -1 : (i + found);
+}
+
+// detects avx2 support of both cpu and os(saving of ymm registers).
+static KSIMDLevel detectSIMDLevel() noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	::__cpuid(info, 0);
+	if (info[0] < 7)
+		return KSIMDLevel::SSE2;
+
+	::__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!(osxsave && avx) || ((::_xgetbv(0) & 0x6) != 0x6))
+		return KSIMDLevel::SSE2;
+
+	::__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) ? KSIMDLevel::AVX2 : KSIMDLevel::SSE2;
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return KSIMDLevel::SSE2;
+
+	const bool osxsave = (ecx & (1 << 27)) != 0;
+	const bool avx = (ecx & (1 << 28)) != 0;
+	if (!(osxsave && avx))
+		return KSIMDLevel::SSE2;
+
+	unsigned int xcr0Low, xcr0High;
+	__asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+	if ((xcr0Low & 0x6) != 0x6)
+		return KSIMDLevel::SSE2;
+
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return KSIMDLevel::SSE2;
+
+	return (ebx & (1 << 5)) ? KSIMDLevel::AVX2 : KSIMDLevel::SSE2;
+#endif
+}
+
+#endif // RFC_STRING_SIMD
+
+KSIMDLevel KStringKernels::getSIMDLevel() noexcept
+{
+#ifdef RFC_STRING_SIMD
+	static const KSIMDLevel level = detectSIMDLevel();
+	return level;
+#else
+	return KSIMDLevel::Scalar;
+#endif
+}
+
+int KStringKernels::findChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+#ifdef RFC_STRING_SIMD
+	if (length >= 16)
+	{
+		if (getSIMDLevel() == KSIMDLevel::AVX2)
+			return avx2FindChar(text, length, character);
+
+		return sse2FindChar(text, length, character);
+	}
+#endif
+
+	return scalarFindChar(text, length, character);
+}
+
+int KStringKernels::findLastChar(const wchar_t* text, int length, wchar_t character) noexcept
+{
+#ifdef RFC_STRING_SIMD
+	if (length >= 16)
+	{
+		if (getSIMDLevel() == KSIMDLevel::AVX2)
+			return avx2FindLastChar(text, length, character);
+
+		return sse2FindLastChar(text, length, character);
+	}
+#endif
+
+	return scalarFindLastChar(text, length, character);
+}
+
+int KStringKernels::findString(const wchar_t* text, int length, const wchar_t* pattern, int patternLength) noexcept
+{
+	if ((patternLength <= 0) || (patternLength > length))
+		return -1;
+
+	if (patternLength == 1)
+		return findChar(text, length, pattern[0]);
+
+#ifdef RFC_STRING_SIMD
+	if ((length - patternLength) >= 16)
+	{
+		if (getSIMDLevel() == KSIMDLevel::AVX2)
+			return avx2FindString(text, length, pattern, patternLength);
+
+		return sse2FindString(text, length, pattern, patternLength);
+	}
+#endif
+
+	return scalarFindString(text, length, pattern, patternLength, 0);
+}
+
+int KStringKernels::findLineBreak(const wchar_t* text, int length) noexcept
+{
+#ifdef RFC_STRING_SIMD
+	if (length >= 16)
+	{
+		if (getSIMDLevel() == KSIMDLevel::AVX2)
+			return avx2FindLineBreak(text, length);
+
+		return sse2FindLineBreak(text, length);
+	}
+#endif
+
+	return scalarFindLineBreak(text, length);
+}
+
+bool KStringKernels::equalsIgnoreCase(const wchar_t* text1, const wchar_t* text2, int length) noexcept
+{
+	int stopIndex;
+
+#ifdef RFC_STRING_SIMD
+	if (sse2EqualsIgnoreCaseASCII(text1, text2, length, &stopIndex))
+		return true;
+#else
+	if (scalarEqualsIgnoreCaseASCII(text1, text2, length, 0, &stopIndex))
+		return true;
+#endif
+
+	if (stopIndex == -1) // ascii mismatch
+		return false;
+
+	// non-ascii character found. system compares the rest according to the locale.
+	return (::_wcsnicmp(text1 + stopIndex, text2 + stopIndex, length - stopIndex) == 0);
+}
+
+void KStringKernels::toUpperCase(wchar_t* text, int length) noexcept
+{
+#ifdef RFC_STRING_SIMD
+	const int stopIndex = sse2ChangeCaseASCII(text, length, L'a', L'z');
+#else
+	const int stopIndex = scalarChangeCaseASCII(text, length, 0, L'a', L'z', 0x20);
+#endif
+
+	if (stopIndex < length)
+		::CharUpperBuffW(text + stopIndex, (DWORD)(length - stopIndex));
+}
+
+void KStringKernels::toLowerCase(wchar_t* text, int length) noexcept
+{
+#ifdef RFC_STRING_SIMD
+	const int stopIndex = sse2ChangeCaseASCII(text, length, L'A', L'Z');
+#else
+	const int stopIndex = scalarChangeCaseASCII(text, length, 0, L'A', L'Z', 0x20);
+#endif
+
+	if (stopIndex < length)
+		::CharLowerBuffW(text + stopIndex, (DWORD)(length - stopIndex));
+}
@@ -0,0 +1,81 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "Architecture.h"
+#include <windows.h>
+
+// define RFC_NO_STRING_SIMD to use only the portable scalar kernels.
+#if defined(RFC_X86) && !defined(RFC_NO_STRING_SIMD)
+	#define RFC_STRING_SIMD
+#endif
+
+enum class KSIMDLevel { Scalar, SSE2, AVX2 };
+
+/**
+	Search, compare and case conversion routines on UTF-16 buffers used by KString.
+	SSE2/AVX2 versions are selected at runtime according to the cpu. Others use scalar loops.
+	All functions work on explicit lengths, so the buffers do not need to be null terminated.
+
+	Case conversions handle ASCII text with vector instructions. When a non-ASCII character is
+	found, remaining text is passed to the system functions. So results are same as CharUpperBuffW,
+	CharLowerBuffW and _wcsnicmp.
+*/
+class KStringKernels
+{
+public:
+	/**
+		@returns index of first occurrence, or -1 if not found
+	*/
+	static int findChar(const wchar_t* text, int length, wchar_t character) noexcept;
+
+	/**
+		@returns index of last occurrence, or -1 if not found
+	*/
+	static int findLastChar(const wchar_t* text, int length, wchar_t character) noexcept;
+
+	/**
+		@returns index of first occurrence, or -1 if not found or pattern is empty
+	*/
+	static int findString(const wchar_t* text, int length, const wchar_t* pattern, int patternLength) noexcept;
+
+	/**
+		@returns index of first '\r' or '\n', or -1 if not found
+	*/
+	static int findLineBreak(const wchar_t* text, int length) noexcept;
+
+	/**
+		Case-insensitive comparison of two buffers with same length.
+	*/
+	static bool equalsIgnoreCase(const wchar_t* text1, const wchar_t* text2, int length) noexcept;
+
+	// converts in place.
+	static void toUpperCase(wchar_t* text, int length) noexcept;
+
+	// converts in place.
+	static void toLowerCase(wchar_t* text, int length) noexcept;
+
+	/**
+		@returns instruction set used by the kernels. detected once on first call.
+	*/
+	static KSIMDLevel getSIMDLevel() noexcept;
+};
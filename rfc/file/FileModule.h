@@ -29,6 +29,9 @@
 #include "KSettingsReader.h"
 #include "KSettingsWriter.h"
 #include "KBufferStream.h"
+#include "KBufferedStream.h"
+#include "KMappedFile.h"
+#include "KAsyncFile.h"
 
 #pragma comment(lib,"Shlwapi.lib")
 
@@ -0,0 +1,438 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KAsyncFile.h"
+
+// one overlapped operation. a request has one operation per buffer.
+struct KAsyncFileOperation
+{
+	OVERLAPPED overlapped; // must be the first member
+	KAsyncFileRequest* request;
+	void* buffer;
+	DWORD size;
+	DWORD errorCode; // set when the operation could not be issued
+};
+
+// internal use.
+class KAsyncFileRequest
+{
+public:
+	bool isWrite;
+	uint64_t offset;
+
+	KAsyncFileOperation* operations;
+	int operationCount;
+	KAsyncFileOperation singleOperation; // avoids an allocation for single buffer requests
+
+	int remainingCount; // operations not completed yet. only the completion thread changes it after the issue.
+	DWORD bytesTransferred;
+	DWORD errorCode;
+
+	KAsyncFileCallback callback;
+	HWND hwndReceiver;
+	WPARAM signalID;
+	LPARAM param;
+
+	KAsyncFileRequest* next; // waiting queue link
+
+	KAsyncFileRequest(bool isWrite, uint64_t offset, int operationCount) noexcept
+	{
+		this->isWrite = isWrite;
+		this->offset = offset;
+		this->operationCount = operationCount;
+		operations = (operationCount == 1) ? &singleOperation : new KAsyncFileOperation[operationCount];
+
+		for (int i = 0; i < operationCount; i++)
+			operations[i].request = this;
+
+		remainingCount = operationCount;
+		bytesTransferred = 0;
+		errorCode = ERROR_SUCCESS;
+		hwndReceiver = NULL;
+		signalID = 0;
+		param = 0;
+		next = nullptr;
+	}
+
+	~KAsyncFileRequest() noexcept
+	{
+		if (operations != &singleOperation)
+			delete[] operations;
+	}
+};
+
+KAsyncFile::KAsyncFile() noexcept : pendingCount(0)
+{
+	fileHandle = INVALID_HANDLE_VALUE;
+	completionPort = NULL;
+	firstWaiting = nullptr;
+	lastWaiting = nullptr;
+	inFlightCount = 0;
+	queueDepth = KAsyncFile::DEFAULT_QUEUE_DEPTH;
+
+	::InitializeCriticalSection(&queueLock);
+	hIdleEvent = ::CreateEventW(NULL, TRUE, TRUE, NULL); // manual reset, initially signaled
+}
+
+bool KAsyncFile::openFile(const wchar_t* fileName, DWORD desiredAccess, DWORD creationDisposition) noexcept
+{
+	closeFile();
+
+	if (completionPort == NULL) // the port & thread are reused when another file is opened.
+	{
+		completionPort = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+		if (completionPort == NULL)
+			return false;
+
+		completionThread.onRun = [this](KThread* thread) {
+			this->completionLoop();
+		};
+
+		if (!completionThread.start())
+		{
+			::CloseHandle(completionPort);
+			completionPort = NULL;
+			return false;
+		}
+	}
+
+	fileHandle = ::CreateFileW(fileName, desiredAccess, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		NULL, creationDisposition, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL);
+
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	if (::CreateIoCompletionPort(fileHandle, completionPort, 0, 0) == NULL)
+	{
+		::CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+		return false;
+	}
+
+	return true;
+}
+
+void KAsyncFile::closeFile() noexcept
+{
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	waitForIdle();
+
+	::CloseHandle(fileHandle);
+	fileHandle = INVALID_HANDLE_VALUE;
+}
+
+bool KAsyncFile::isOpen() const noexcept
+{
+	return fileHandle != INVALID_HANDLE_VALUE;
+}
+
+HANDLE KAsyncFile::getFileHandle() const noexcept
+{
+	return fileHandle;
+}
+
+uint64_t KAsyncFile::getFileSize() const noexcept
+{
+	LARGE_INTEGER fileSize;
+	if (::GetFileSizeEx(fileHandle, &fileSize) == 0)
+		return 0;
+
+	return (uint64_t)fileSize.QuadPart;
+}
+
+void KAsyncFile::setQueueDepth(int queueDepth) noexcept
+{
+	::EnterCriticalSection(&queueLock);
+	this->queueDepth = (queueDepth < 1) ? 1 : queueDepth;
+	::LeaveCriticalSection(&queueLock);
+}
+
+int KAsyncFile::getQueueDepth() const noexcept
+{
+	return queueDepth;
+}
+
+bool KAsyncFile::read(uint64_t offset, void* buffer, DWORD size, KAsyncFileCallback callback,
+	HWND hwndReceiver, WPARAM signalID, LPARAM param) noexcept
+{
+	KAsyncFileBuffer fileBuffer = { buffer, size };
+	return readScatter(offset, &fileBuffer, 1, std::move(callback), hwndReceiver, signalID, param);
+}
+
+bool KAsyncFile::write(uint64_t offset, const void* buffer, DWORD size, KAsyncFileCallback callback,
+	HWND hwndReceiver, WPARAM signalID, LPARAM param) noexcept
+{
+	KAsyncFileBuffer fileBuffer = { (void*)buffer, size };
+	return writeGather(offset, &fileBuffer, 1, std::move(callback), hwndReceiver, signalID, param);
+}
+
+bool KAsyncFile::readScatter(uint64_t offset, const KAsyncFileBuffer* buffers, int bufferCount, KAsyncFileCallback callback,
+	HWND hwndReceiver, WPARAM signalID, LPARAM param) noexcept
+{
+	if ((buffers == nullptr) || (bufferCount < 1) || (fileHandle == INVALID_HANDLE_VALUE))
+		return false;
+
+	KAsyncFileRequest* request = new KAsyncFileRequest(false, offset, bufferCount);
+	for (int i = 0; i < bufferCount; i++)
+	{
+		request->operations[i].buffer = buffers[i].buffer;
+		request->operations[i].size = buffers[i].size;
+	}
+
+	request->callback = std::move(callback);
+	request->hwndReceiver = hwndReceiver;
+	request->signalID = signalID;
+	request->param = param;
+
+	return submitRequest(request);
+}
+
+bool KAsyncFile::writeGather(uint64_t offset, const KAsyncFileBuffer* buffers, int bufferCount, KAsyncFileCallback callback,
+	HWND hwndReceiver, WPARAM signalID, LPARAM param) noexcept
+{
+	if ((buffers == nullptr) || (bufferCount < 1) || (fileHandle == INVALID_HANDLE_VALUE))
+		return false;
+
+	KAsyncFileRequest* request = new KAsyncFileRequest(true, offset, bufferCount);
+	for (int i = 0; i < bufferCount; i++)
+	{
+		request->operations[i].buffer = buffers[i].buffer;
+		request->operations[i].size = buffers[i].size;
+	}
+
+	request->callback = std::move(callback);
+	request->hwndReceiver = hwndReceiver;
+	request->signalID = signalID;
+	request->param = param;
+
+	return submitRequest(request);
+}
+
+bool KAsyncFile::canIssue(int operationCount) const noexcept
+{
+	// a request with more buffers than the queue depth is issued alone.
+	return (inFlightCount == 0) || ((inFlightCount + operationCount) <= queueDepth);
+}
+
+bool KAsyncFile::submitRequest(KAsyncFileRequest* request) noexcept
+{
+	bool issueNow = false;
+
+	::EnterCriticalSection(&queueLock);
+
+	// the counter & the event are changed together, so waitForIdle never sees a stale state.
+	if (pendingCount.fetch_add(1, std::memory_order_acq_rel) == 0)
+		::ResetEvent(hIdleEvent);
+
+	if ((firstWaiting == nullptr) && canIssue(request->operationCount))
+	{
+		inFlightCount += request->operationCount;
+		issueNow = true;
+	}
+	else
+	{
+		if (lastWaiting)
+			lastWaiting->next = request;
+		else
+			firstWaiting = request;
+
+		lastWaiting = request;
+	}
+
+	::LeaveCriticalSection(&queueLock);
+
+	if (issueNow)
+		issueRequest(request);
+
+	return true;
+}
+
+void KAsyncFile::issueRequest(KAsyncFileRequest* request) noexcept
+{
+	// the completion thread deletes the request when its last operation completes.
+	// so nothing is read from the request after the last operation is issued.
+	KAsyncFileOperation* operations = request->operations;
+	const int operationCount = request->operationCount;
+	const bool isWrite = request->isWrite;
+	uint64_t offset = request->offset;
+
+	for (int i = 0; i < operationCount; i++)
+	{
+		KAsyncFileOperation* operation = &operations[i];
+		const DWORD size = operation->size;
+
+		::ZeroMemory(&operation->overlapped, sizeof(OVERLAPPED));
+		operation->overlapped.Offset = (DWORD)offset;
+		operation->overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		operation->errorCode = ERROR_SUCCESS;
+		offset += size;
+
+		const BOOL result = isWrite ? ::WriteFile(fileHandle, operation->buffer, size, NULL, &operation->overlapped) :
+			::ReadFile(fileHandle, operation->buffer, size, NULL, &operation->overlapped);
+
+		if (result == FALSE)
+		{
+			const DWORD error = ::GetLastError();
+			if (error != ERROR_IO_PENDING) // no packet will be queued. complete it through the port ourselves.
+			{
+				operation->errorCode = error;
+				::PostQueuedCompletionStatus(completionPort, 0, 0, &operation->overlapped);
+			}
+		}
+	}
+}
+
+void KAsyncFile::completionLoop() noexcept
+{
+	while (true)
+	{
+		DWORD bytesTransferred = 0;
+		ULONG_PTR completionKey = 0;
+		LPOVERLAPPED overlapped = NULL;
+
+		const BOOL result = ::GetQueuedCompletionStatus(completionPort, &bytesTransferred, &completionKey, &overlapped, INFINITE);
+
+		if (overlapped == NULL) // stop packet or the port is closed
+			break;
+
+		KAsyncFileOperation* operation = (KAsyncFileOperation*)overlapped;
+		KAsyncFileRequest* request = operation->request;
+
+		DWORD errorCode = operation->errorCode;
+		if ((result == FALSE) && (errorCode == ERROR_SUCCESS))
+			errorCode = ::GetLastError();
+
+		request->bytesTransferred += bytesTransferred;
+		if (request->errorCode == ERROR_SUCCESS)
+			request->errorCode = errorCode;
+
+		const bool requestCompleted = (--request->remainingCount == 0);
+		if (requestCompleted)
+			completeRequest(request);
+
+		releaseOperation(requestCompleted);
+	}
+}
+
+void KAsyncFile::completeRequest(KAsyncFileRequest* request) noexcept
+{
+	if (request->callback)
+		request->callback(request->bytesTransferred, request->errorCode);
+
+	if (request->hwndReceiver)
+		::PostMessageW(request->hwndReceiver, RFC_SIGNAL_MESSAGE, request->signalID, request->param);
+
+	delete request;
+}
+
+void KAsyncFile::releaseOperation(bool requestCompleted) noexcept
+{
+	// fill the free slot with the waiting requests.
+	KAsyncFileRequest* readyList = nullptr;
+
+	::EnterCriticalSection(&queueLock);
+
+	--inFlightCount;
+
+	KAsyncFileRequest* lastReady = nullptr;
+	while (firstWaiting && canIssue(firstWaiting->operationCount))
+	{
+		KAsyncFileRequest* waitingRequest = firstWaiting;
+		firstWaiting = waitingRequest->next;
+		waitingRequest->next = nullptr;
+
+		if (lastReady)
+			lastReady->next = waitingRequest;
+		else
+			readyList = waitingRequest;
+
+		lastReady = waitingRequest;
+		inFlightCount += waitingRequest->operationCount;
+	}
+
+	if (firstWaiting == nullptr)
+		lastWaiting = nullptr;
+
+	// the callback has already returned. readyList is empty when this was the last request.
+	if (requestCompleted && (pendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1))
+		::SetEvent(hIdleEvent);
+
+	::LeaveCriticalSection(&queueLock);
+
+	while (readyList)
+	{
+		KAsyncFileRequest* readyRequest = readyList;
+		readyList = readyRequest->next;
+		issueRequest(readyRequest);
+	}
+}
+
+int KAsyncFile::getPendingCount() const noexcept
+{
+	return pendingCount.load(std::memory_order_acquire);
+}
+
+void KAsyncFile::waitForIdle(bool pumpMessages) noexcept
+{
+	if (!pumpMessages)
+	{
+		::WaitForSingleObject(hIdleEvent, INFINITE);
+		return;
+	}
+
+	while (true)
+	{
+		MSG msg;
+		while (::PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
+		{
+			::TranslateMessage(&msg);
+			::DispatchMessageW(&msg);
+		}
+
+		// timeout handles the messages which arrive between PeekMessage & MsgWaitForMultipleObjects.
+		const DWORD dwRet = ::MsgWaitForMultipleObjects(1, &hIdleEvent, FALSE, 200, QS_ALLINPUT);
+
+		if (dwRet == WAIT_OBJECT_0) // all requests completed
+			return;
+		else if ((dwRet == (WAIT_OBJECT_0 + 1)) || (dwRet == WAIT_TIMEOUT)) // window message or timeout
+			continue;
+		else // failed
+			return;
+	}
+}
+
+KAsyncFile::~KAsyncFile() noexcept
+{
+	closeFile();
+
+	if (completionPort)
+	{
+		waitForIdle(); // the stop packet must not overtake the pending completions.
+		::PostQueuedCompletionStatus(completionPort, 0, 0, NULL); // stop packet
+		completionThread.waitUntilThreadFinish();
+		::CloseHandle(completionPort);
+	}
+
+	::DeleteCriticalSection(&queueLock);
+	::CloseHandle(hIdleEvent);
+}
@@ -0,0 +1,171 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include "../thread/ThreadModule.h"
+#include "KFile.h"
+#include <functional>
+#include <atomic>
+
+// one buffer of a scatter read or gather write.
+struct KAsyncFileBuffer
+{
+	void* buffer;
+	DWORD size;
+};
+
+class KAsyncFileRequest;
+
+/**
+	Called on the completion thread after all the buffers of a request are transferred.
+	errorCode is ERROR_SUCCESS or the first win32 error of the request. (ERROR_HANDLE_EOF when reading beyond the end)
+*/
+typedef std::function<void(DWORD bytesTransferred, DWORD errorCode)> KAsyncFileCallback;
+
+/**
+	Reads & writes a file without blocking the caller. Requests are issued as overlapped I/O and
+	their completions are collected from an I/O completion port by a completion thread.
+	Every request has an explicit file offset. Up to queueDepth operations are in flight at the same time,
+	the rest wait in a queue and are issued as the earlier ones complete. (a request has one operation per buffer)
+
+	Completion is delivered to the callback (runs on the completion thread) and/or to a window
+	through RFC_SIGNAL_MESSAGE(signalID, param) (see KSignal and KSignalHandler), so the gui thread can handle it.
+	Buffers must stay valid until the request completes.
+
+	e.g. @code
+	KAsyncFile file;
+	file.openFile(L"project.dat", KFile::KWRITE, CREATE_ALWAYS);
+	file.write(0, data, dataSize, [](DWORD bytesTransferred, DWORD errorCode) {
+		// runs on the completion thread
+	}, myWindow.getHWND(), PROJECT_SAVED_SIGNAL, 0);
+	@endcode
+
+	To copy a file without blocking, submit KFile::copyFile to a KThreadPool.
+*/
+class KAsyncFile
+{
+protected:
+	HANDLE fileHandle;
+	HANDLE completionPort;
+	KThread completionThread;
+
+	CRITICAL_SECTION queueLock;
+	KAsyncFileRequest* firstWaiting; // requests not issued yet. (fifo)
+	KAsyncFileRequest* lastWaiting;
+	int inFlightCount; // issued operations
+	int queueDepth;
+
+	HANDLE hIdleEvent; // signaled when there are no waiting or in flight requests
+	std::atomic<int> pendingCount; // waiting + in flight requests. changed only inside queueLock, together with hIdleEvent.
+
+	bool canIssue(int operationCount) const noexcept;
+	bool submitRequest(KAsyncFileRequest* request) noexcept;
+	void issueRequest(KAsyncFileRequest* request) noexcept;
+	void completionLoop() noexcept;
+	void completeRequest(KAsyncFileRequest* request) noexcept;
+	void releaseOperation(bool requestCompleted) noexcept;
+
+public:
+	enum { DEFAULT_QUEUE_DEPTH = 8 };
+
+	KAsyncFile() noexcept;
+
+	/**
+		Opens the file for overlapped I/O. The previously opened file will be closed.
+		@param creationDisposition CreateFile constant. OPEN_EXISTING, OPEN_ALWAYS, CREATE_ALWAYS etc.
+	*/
+	bool openFile(const wchar_t* fileName, DWORD desiredAccess = KFile::KREAD, DWORD creationDisposition = OPEN_EXISTING) noexcept;
+
+	/**
+		Waits for the pending requests and closes the file.
+	*/
+	void closeFile() noexcept;
+
+	bool isOpen() const noexcept;
+
+	HANDLE getFileHandle() const noexcept;
+
+	/**
+		returns zero on error
+	*/
+	uint64_t getFileSize() const noexcept;
+
+	/**
+		Maximum number of operations in flight. A scatter/gather request takes one per buffer.
+		A request with more buffers than the depth is issued alone. Does not affect the requests already issued.
+	*/
+	void setQueueDepth(int queueDepth) noexcept;
+
+	int getQueueDepth() const noexcept;
+
+	/**
+		Queues a read of size bytes at the given file offset.
+		@returns false if the file is not open.
+	*/
+	bool read(uint64_t offset, void* buffer, DWORD size, KAsyncFileCallback callback = nullptr,
+		HWND hwndReceiver = NULL, WPARAM signalID = 0, LPARAM param = 0) noexcept;
+
+	/**
+		Queues a write of size bytes at the given file offset.
+		@returns false if the file is not open.
+	*/
+	bool write(uint64_t offset, const void* buffer, DWORD size, KAsyncFileCallback callback = nullptr,
+		HWND hwndReceiver = NULL, WPARAM signalID = 0, LPARAM param = 0) noexcept;
+
+	/**
+		Reads consecutive file bytes starting at offset into multiple buffers, as one request.
+		The buffer list is copied. the buffers themselves must stay valid until the completion.
+	*/
+	bool readScatter(uint64_t offset, const KAsyncFileBuffer* buffers, int bufferCount, KAsyncFileCallback callback = nullptr,
+		HWND hwndReceiver = NULL, WPARAM signalID = 0, LPARAM param = 0) noexcept;
+
+	/**
+		Writes multiple buffers to consecutive file bytes starting at offset, as one request.
+		The buffer list is copied. the buffers themselves must stay valid until the completion.
+	*/
+	bool writeGather(uint64_t offset, const KAsyncFileBuffer* buffers, int bufferCount, KAsyncFileCallback callback = nullptr,
+		HWND hwndReceiver = NULL, WPARAM signalID = 0, LPARAM param = 0) noexcept;
+
+	/**
+		returns number of requests which are not completed yet.
+	*/
+	int getPendingCount() const noexcept;
+
+	/**
+		Blocks until all the requests completed. Do not call from a completion callback.
+		Set pumpMessages to true to enable message processing for caller. (gui thread)
+	*/
+	void waitForIdle(bool pumpMessages = false) noexcept;
+
+	virtual ~KAsyncFile() noexcept;
+
+	// no copy/movable
+	KAsyncFile(const KAsyncFile&) = delete;
+	KAsyncFile& operator=(const KAsyncFile&) = delete;
+	KAsyncFile(KAsyncFile&&) = delete;
+	KAsyncFile& operator=(KAsyncFile&&) = delete;
+
+private:
+	RFC_LEAK_DETECTOR(KAsyncFile)
+};
+
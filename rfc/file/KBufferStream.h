@@ -61,22 +61,216 @@ public:
 	{
 		return false;
 	}
+
+	DWORD readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept override
+	{
+		const DWORD remaining = bufferSize - bufferPos;
+		const DWORD bytesToRead = (maxBytesToRead < remaining) ? maxBytesToRead : remaining;
+
+		if (bytesToRead)
+		{
+			::memcpy(buffer, bufferPtr + bufferPos, bytesToRead);
+			bufferPos += bytesToRead;
+		}
+
+		return bytesToRead;
+	}
+};
+
+// a block of the chunked KBufferWriteStream. data follows the header.
+struct KBufferWriteStreamChunk
+{
+	KBufferWriteStreamChunk* next;
+	DWORD used;
+	DWORD capacity;
+
+	inline BYTE* data() noexcept { return (BYTE*)(this + 1); }
 };
 
+/**
+	Growable memory stream. Capacity is doubled when it is full. So n small writes are amortized O(n).
+	In chunked mode, data is kept in fixed size blocks instead of a single buffer.
+	So a very large output never needs a giant contiguous reallocation. Use writeTo to move it into another stream.
+*/
 class KBufferWriteStream : public KStream
 {
 protected:
 	BYTE* bufferPtr;
-	DWORD bufferSize;
+	DWORD bufferSize; // written bytes
+	DWORD bufferCapacity;
+
+	// chunked mode
+	KBufferWriteStreamChunk* firstChunk;
+	KBufferWriteStreamChunk* lastChunk;
+	DWORD chunkSize;
+
+	bool growBuffer(DWORD requiredCapacity) noexcept
+	{
+		DWORD newCapacity = (bufferCapacity < 64) ? 64 : bufferCapacity;
+		while (newCapacity < requiredCapacity)
+			newCapacity = (newCapacity > 0x7FFFFFFF) ? 0xFFFFFFFF : (newCapacity * 2);
+
+		BYTE* newBuffer = (BYTE*)::realloc(bufferPtr, newCapacity);
+		if (newBuffer == nullptr)
+			return false;
+
+		bufferPtr = newBuffer;
+		bufferCapacity = newCapacity;
+		return true;
+	}
+
+	bool addChunk() noexcept
+	{
+		KBufferWriteStreamChunk* chunk = (KBufferWriteStreamChunk*)::malloc(sizeof(KBufferWriteStreamChunk) + chunkSize);
+		if (chunk == nullptr)
+			return false;
+
+		chunk->next = nullptr;
+		chunk->used = 0;
+		chunk->capacity = chunkSize;
+
+		if (lastChunk)
+			lastChunk->next = chunk;
+		else
+			firstChunk = chunk;
+
+		lastChunk = chunk;
+		return true;
+	}
+
+	void freeChunks() noexcept
+	{
+		KBufferWriteStreamChunk* chunk = firstChunk;
+		while (chunk)
+		{
+			KBufferWriteStreamChunk* next = chunk->next;
+			::free(chunk);
+			chunk = next;
+		}
+
+		firstChunk = nullptr;
+		lastChunk = nullptr;
+	}
+
 public:
-	KBufferWriteStream() noexcept : bufferPtr(nullptr), bufferSize(0) {}
+	enum { DEFAULT_CHUNK_SIZE = 64 * 1024 };
+
+	KBufferWriteStream() noexcept : bufferPtr(nullptr), bufferSize(0), bufferCapacity(0), 
+		firstChunk(nullptr), lastChunk(nullptr), chunkSize(0) {}
+
+	/**
+		@param chunked if true, data is stored in blocks of chunkSize. data() is available after flatten().
+	*/
+	KBufferWriteStream(bool chunked, DWORD chunkSize = DEFAULT_CHUNK_SIZE) noexcept : bufferPtr(nullptr), bufferSize(0),
+		bufferCapacity(0), firstChunk(nullptr), lastChunk(nullptr), chunkSize(chunked ? (chunkSize ? chunkSize : DEFAULT_CHUNK_SIZE) : 0) {}
 
 	virtual ~KBufferWriteStream() noexcept
 	{
 		if (bufferPtr)
 			::free(bufferPtr);
+
+		freeChunks();
+	}
+
+	bool isChunked() const noexcept
+	{
+		return chunkSize != 0;
 	}
 
+	/**
+		Makes room for totalSize bytes, so the following writes do not reallocate. Ignored in chunked mode.
+	*/
+	bool reserve(DWORD totalSize) noexcept
+	{
+		if (isChunked() || (totalSize <= bufferCapacity))
+			return true;
+
+		BYTE* newBuffer = (BYTE*)::realloc(bufferPtr, totalSize);
+		if (newBuffer == nullptr)
+			return false;
+
+		bufferPtr = newBuffer;
+		bufferCapacity = totalSize;
+		return true;
+	}
+
+	DWORD capacity() const noexcept
+	{
+		return bufferCapacity;
+	}
+
+	/**
+		Copies the chunks into a single buffer which has the exact size & leaves chunked mode.
+		Does nothing if the stream is not chunked.
+	*/
+	bool flatten() noexcept
+	{
+		if (!isChunked())
+			return true;
+
+		if (bufferSize)
+		{
+			BYTE* newBuffer = (BYTE*)::malloc(bufferSize);
+			if (newBuffer == nullptr)
+				return false;
+
+			DWORD position = 0;
+			for (KBufferWriteStreamChunk* chunk = firstChunk; chunk; chunk = chunk->next)
+			{
+				::memcpy(newBuffer + position, chunk->data(), chunk->used);
+				position += chunk->used;
+			}
+
+			bufferPtr = newBuffer;
+			bufferCapacity = bufferSize;
+		}
+
+		freeChunks();
+		chunkSize = 0;
+		return true;
+	}
+
+	/**
+		Writes all data into given stream. In chunked mode, chunks are written one by one without joining them.
+	*/
+	bool writeTo(KStream* stream) const noexcept
+	{
+		if (!isChunked())
+			return (bufferSize == 0) || stream->writeStream(bufferPtr, bufferSize);
+
+		for (KBufferWriteStreamChunk* chunk = firstChunk; chunk; chunk = chunk->next)
+		{
+			if (chunk->used && !stream->writeStream(chunk->data(), chunk->used))
+				return false;
+		}
+		return true;
+	}
+
+	/**
+		Transfers the ownership of the buffer to the caller without copying. (chunked stream is flattened first)
+		Free the returned buffer using ::free. The stream becomes empty.
+		@param size receives the data size. can be null.
+		@returns null if there is no data.
+	*/
+	BYTE* detach(DWORD* size = nullptr) noexcept
+	{
+		if (!flatten())
+			return nullptr;
+
+		BYTE* buffer = bufferPtr;
+		if (size)
+			*size = bufferSize;
+
+		bufferPtr = nullptr;
+		bufferSize = 0;
+		bufferCapacity = 0;
+
+		return buffer;
+	}
+
+	/**
+		In chunked mode, returns null until flatten is called.
+	*/
 	const BYTE* data() const noexcept
 	{
 		return bufferPtr;
@@ -104,20 +298,45 @@ public:
 		if (!buffer || bytesToWrite == 0)
 			return false;
 
-		if (bufferPtr)
+		if (bytesToWrite > (0xFFFFFFFF - bufferSize))
+			return false; // DWORD overflow
+
+		if (isChunked())
 		{
-			const DWORD newBufferSize = bufferSize + bytesToWrite;
-			bufferPtr = (BYTE*)realloc(bufferPtr, newBufferSize);
-			::memcpy(bufferPtr + bufferSize, buffer, bytesToWrite);
-			bufferSize = newBufferSize;
+			DWORD remaining = bytesToWrite;
+			while (remaining)
+			{
+				if ((lastChunk == nullptr) || (lastChunk->used == lastChunk->capacity))
+				{
+					if (!addChunk())
+						return false;
+				}
+
+				const DWORD space = lastChunk->capacity - lastChunk->used;
+				const DWORD copySize = (remaining < space) ? remaining : space;
+
+				::memcpy(lastChunk->data() + lastChunk->used, buffer, copySize);
+				lastChunk->used += copySize;
+				buffer += copySize;
+				remaining -= copySize;
+			}
 		}
 		else
 		{
-			bufferSize = bytesToWrite;
-			bufferPtr = (BYTE*)malloc(bufferSize);
-			::memcpy(bufferPtr, buffer, bufferSize);
+			const DWORD newBufferSize = bufferSize + bytesToWrite;
+			if ((newBufferSize > bufferCapacity) && !growBuffer(newBufferSize))
+				return false;
+
+			::memcpy(bufferPtr + bufferSize, buffer, bytesToWrite);
 		}
 
+		bufferSize += bytesToWrite;
 		return true;
 	}
+
+	// no copy/movable
+	KBufferWriteStream(const KBufferWriteStream&) = delete;
+	KBufferWriteStream& operator=(const KBufferWriteStream&) = delete;
+	KBufferWriteStream(KBufferWriteStream&&) = delete;
+	KBufferWriteStream& operator=(KBufferWriteStream&&) = delete;
 };
@@ -0,0 +1,200 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KBufferedStream.h"
+
+KBufferedStream::KBufferedStream(KStream* stream, DWORD blockSize) noexcept : stream(stream), buffer(nullptr),
+	blockSize(blockSize ? blockSize : DEFAULT_BLOCK_SIZE), readPosition(0), readSize(0), writeSize(0) {}
+
+bool KBufferedStream::allocateBuffer() noexcept
+{
+	if (buffer == nullptr) // allocated on first use
+		buffer = (BYTE*)::malloc(blockSize);
+
+	return buffer != nullptr;
+}
+
+bool KBufferedStream::setStream(KStream* stream) noexcept
+{
+	const bool result = flush();
+
+	writeSize = 0; // pending bytes of a failed flush belong to the previous stream.
+	readPosition = 0;
+	readSize = 0;
+	this->stream = stream;
+
+	return result;
+}
+
+KStream* KBufferedStream::getStream() const noexcept
+{
+	return stream;
+}
+
+DWORD KBufferedStream::getBlockSize() const noexcept
+{
+	return blockSize;
+}
+
+bool KBufferedStream::flush() noexcept
+{
+	if (writeSize == 0)
+		return true;
+
+	if (!stream || !stream->writeStream(buffer, writeSize))
+		return false; // pending bytes are kept. caller can retry.
+
+	writeSize = 0;
+	return true;
+}
+
+bool KBufferedStream::fillBuffer() noexcept
+{
+	readPosition = 0;
+	readSize = stream->readStreamUpTo(buffer, blockSize);
+
+	return readSize != 0;
+}
+
+DWORD KBufferedStream::readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept
+{
+	if (!stream || !buffer || (maxBytesToRead == 0) || !flush() || !allocateBuffer())
+		return 0;
+
+	DWORD totalRead = 0;
+	while (totalRead < maxBytesToRead)
+	{
+		const DWORD available = readSize - readPosition;
+		if (available)
+		{
+			const DWORD copySize = ((maxBytesToRead - totalRead) < available) ? (maxBytesToRead - totalRead) : available;
+			::memcpy(buffer + totalRead, this->buffer + readPosition, copySize);
+
+			readPosition += copySize;
+			totalRead += copySize;
+			continue;
+		}
+
+		const DWORD remaining = maxBytesToRead - totalRead;
+		if (remaining >= blockSize) // large read. no need to copy through the buffer.
+		{
+			const DWORD bytesRead = stream->readStreamUpTo(buffer + totalRead, remaining);
+			totalRead += bytesRead;
+			break;
+		}
+
+		if (!fillBuffer())
+			break;
+	}
+
+	return totalRead;
+}
+
+bool KBufferedStream::readStream(BYTE* buffer, DWORD bytesToRead) noexcept
+{
+	if (!stream || !buffer || (bytesToRead == 0))
+		return false;
+
+	// fast path: whole data is already in the buffer.
+	if ((readSize - readPosition) >= bytesToRead)
+	{
+		::memcpy(buffer, this->buffer + readPosition, bytesToRead);
+		readPosition += bytesToRead;
+		return true;
+	}
+
+	const DWORD available = readSize - readPosition;
+	const DWORD bytesRead = readStreamUpTo(buffer, bytesToRead);
+	if (bytesRead == bytesToRead)
+		return true;
+
+	// underlying stream may not support partial reads. (default readStreamUpTo)
+	if ((bytesRead == available) && (readSize == readPosition))
+		return stream->readStream(buffer + bytesRead, bytesToRead - bytesRead);
+
+	return false;
+}
+
+bool KBufferedStream::skip(DWORD bytesToSkip) noexcept
+{
+	if (!stream || !flush() || !allocateBuffer())
+		return false;
+
+	while (bytesToSkip)
+	{
+		const DWORD available = readSize - readPosition;
+		if (available == 0)
+		{
+			if (!fillBuffer())
+				return false;
+			continue;
+		}
+
+		const DWORD skipSize = (bytesToSkip < available) ? bytesToSkip : available;
+		readPosition += skipSize;
+		bytesToSkip -= skipSize;
+	}
+
+	return true;
+}
+
+bool KBufferedStream::writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept
+{
+	if (!stream || !buffer || (bytesToWrite == 0))
+		return false;
+
+	if (readPosition != readSize) // unread data. underlying stream position is not ours.
+		return false;
+
+	readPosition = 0;
+	readSize = 0;
+
+	if ((blockSize - writeSize) >= bytesToWrite) // fits into the buffer
+	{
+		if (!allocateBuffer())
+			return false;
+
+		::memcpy(this->buffer + writeSize, buffer, bytesToWrite);
+		writeSize += bytesToWrite;
+		return true;
+	}
+
+	if (!flush())
+		return false;
+
+	if (bytesToWrite >= blockSize) // large write. no need to copy through the buffer.
+		return stream->writeStream(buffer, bytesToWrite);
+
+	if (!allocateBuffer())
+		return false;
+
+	::memcpy(this->buffer, buffer, bytesToWrite);
+	writeSize = bytesToWrite;
+	return true;
+}
+
+KBufferedStream::~KBufferedStream() noexcept
+{
+	flush();
+
+	if (buffer)
+		::free(buffer);
+}
@@ -0,0 +1,99 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include "KStream.h"
+
+/**
+	Adds a memory block in front of any KStream. Small reads are served from a block which is filled
+	with a single read of the underlying stream (read-ahead). Small writes are collected & written as a single block.
+	Reads or writes larger than the block size go directly to the underlying stream.
+
+	Use it either for reading or for writing. Writing is refused while there are unread buffered bytes,
+	because the underlying stream is already ahead of the reader.
+	Pending writes are written by flush, setStream or destructor.
+*/
+class KBufferedStream : public KStream
+{
+protected:
+	KStream* stream;
+	BYTE* buffer;
+	DWORD blockSize;
+
+	DWORD readPosition; // next unread byte in buffer
+	DWORD readSize; // valid bytes in buffer
+	DWORD writeSize; // pending bytes in buffer
+
+	bool allocateBuffer() noexcept;
+
+	// refills the buffer. @returns false at the end of the stream.
+	bool fillBuffer() noexcept;
+
+public:
+	enum { DEFAULT_BLOCK_SIZE = 64 * 1024 };
+
+	/**
+		@param stream can be null. use setStream later.
+	*/
+	KBufferedStream(KStream* stream = nullptr, DWORD blockSize = DEFAULT_BLOCK_SIZE) noexcept;
+
+	/**
+		Flushes pending writes & drops unread data of the previous stream.
+		@returns false if the pending writes could not be written. they are dropped.
+	*/
+	bool setStream(KStream* stream) noexcept;
+
+	KStream* getStream() const noexcept;
+
+	/**
+		Writes the pending bytes into the underlying stream.
+		@returns false if the write fails. pending bytes are kept, so flush can be called again.
+	*/
+	bool flush() noexcept;
+
+	/**
+		Moves forward without returning the data. KStream does not have seek, so skipped bytes beyond the buffer are read & dropped.
+	*/
+	bool skip(DWORD bytesToSkip) noexcept;
+
+	DWORD getBlockSize() const noexcept;
+
+	~KBufferedStream() noexcept;
+
+	// ============= KStream ===============
+
+	bool readStream(BYTE* buffer, DWORD bytesToRead) noexcept override;
+
+	bool writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept override;
+
+	DWORD readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept override;
+
+	// no copy/movable
+	KBufferedStream(const KBufferedStream&) = delete;
+	KBufferedStream& operator=(const KBufferedStream&) = delete;
+	KBufferedStream(KBufferedStream&&) = delete;
+	KBufferedStream& operator=(KBufferedStream&&) = delete;
+
+private:
+	RFC_LEAK_DETECTOR(KBufferedStream)
+};
@@ -253,4 +253,12 @@ bool KFile::writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept
 	::WriteFile(fileHandle, buffer, bytesToWrite, &numberOfBytesWritten, NULL);
 
 	return numberOfBytesWritten == bytesToWrite;
+}
+
+DWORD KFile::readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept
+{
+	DWORD numberOfBytesRead = 0;
+	::ReadFile(fileHandle, buffer, maxBytesToRead, &numberOfBytesRead, NULL);
+
+	return numberOfBytesRead;
 }
\ No newline at end of file
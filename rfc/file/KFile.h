@@ -126,6 +126,7 @@ public:
 	// ============= KStream ===============
 	bool readStream(BYTE* buffer, DWORD bytesToRead) noexcept override;
 	bool writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept override;
+	DWORD readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept override;
 
 private:
 	RFC_LEAK_DETECTOR(KFile)
@@ -22,90 +22,242 @@
 #include "KLogger.h"
 #include "KFile.h"
 
-KLogger::KLogger(DWORD bufferSize) noexcept
+// size of the write buffer used while moving events into the file.
+#define RFC_LOGGER_WRITE_BUFFER_SIZE (64 * 1024)
+
+// placed in front of each event inside the thread buffers. not written to the file.
+struct KLoggerRecordHeader
 {
-	buffer = (char*)malloc(bufferSize);
-	this->bufferSize = bufferSize;
-	bufferIndex = 0;
-	totalEvents = 0;
-	totalMills = 0;
-	bufferFull = false;
-	isFirstCall = true;
-}
+	DWORD size; // header + event data
+	__int64 time; // qpc time of writeNewEvent
+};
 
-bool KLogger::writeNewEvent(unsigned char eventType) noexcept
+/*
+	Ring buffer of a single thread. Only the owner thread writes events & writePosition.
+	Only the flusher moves readPosition. So no lock is needed.
+	Positions always increase. offset inside the buffer = position % size.
+*/
+class KLoggerThreadBuffer
 {
-	if (!bufferFull)
+public:
+	KLoggerThreadBuffer* next;
+	DWORD threadID;
+	char* data;
+	DWORD size;
+	std::atomic<unsigned __int64> writePosition;
+	std::atomic<unsigned __int64> readPosition;
+
+	// event which is being built by the owner thread. starts with KLoggerRecordHeader.
+	char event[RFC_LOGGER_MAX_EVENT_SIZE];
+	DWORD eventSize;
+	bool eventStarted;
+
+	KLoggerThreadBuffer(DWORD threadID, DWORD size) noexcept : next(nullptr), threadID(threadID), 
+		size(size), writePosition(0), readPosition(0), eventSize(0), eventStarted(false)
 	{
-		if ((bufferIndex + 300) >= bufferSize) // assume each event data is not greater than 300 bytes
+		data = (char*)::malloc(size);
+		if (data == nullptr)
+			this->size = 0;
+	}
+
+	// @returns false if there is no room for given bytes inside the current event.
+	inline bool reserveEventBytes(DWORD bytes) noexcept
+	{
+		if (!eventStarted)
+			return false;
+
+		if ((eventSize + bytes) > RFC_LOGGER_MAX_EVENT_SIZE)
 		{
-			bufferFull = true;
+			eventStarted = false; // too large. drop it.
 			return false;
 		}
+		return true;
+	}
+
+	void copyIn(unsigned __int64 position, const char* source, DWORD length) noexcept
+	{
+		const DWORD offset = (DWORD)(position % size);
+		const DWORD firstPart = ((size - offset) < length) ? (size - offset) : length;
+
+		::memcpy(data + offset, source, firstPart);
+		::memcpy(data, source + firstPart, length - firstPart);
+	}
+
+	void copyOut(unsigned __int64 position, char* destination, DWORD length) const noexcept
+	{
+		const DWORD offset = (DWORD)(position % size);
+		const DWORD firstPart = ((size - offset) < length) ? (size - offset) : length;
+
+		::memcpy(destination, data + offset, firstPart);
+		::memcpy(destination + firstPart, data, length - firstPart);
+	}
+
+	~KLoggerThreadBuffer() noexcept
+	{
+		if (data)
+			::free(data);
+	}
+};
 
-		unsigned short secs = 0;
-		unsigned short mills = 0;
+struct KLoggerThreadCache
+{
+	unsigned int loggerID;
+	KLoggerThreadBuffer* buffer;
+};
+
+static thread_local KLoggerThreadCache rfc_loggerThreadCache = { 0, nullptr };
+static std::atomic<unsigned int> rfc_loggerIDCounter(0);
+static std::atomic<KLoggerFormat*> rfc_loggerFormats(nullptr);
+
+KLoggerFormat::KLoggerFormat(const char* text) noexcept : text(text)
+{
+	const size_t textLength = ::strlen(text);
+	length = (textLength > 0xFFFF) ? 0xFFFF : (unsigned short)textLength;
+
+	// id is taken from the previous head. so ids are unique & dense.
+	next = rfc_loggerFormats.load(std::memory_order_relaxed);
+	do
+	{
+		id = next ? (next->id + 1) : 0;
+	} while (!rfc_loggerFormats.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+KLoggerFormat* KLoggerFormat::getLastFormat() noexcept
+{
+	return rfc_loggerFormats.load(std::memory_order_acquire);
+}
+
+KLogger::KLogger(DWORD bufferSize) noexcept : threadBuffers(nullptr), startTime(0), bufferFull(false)
+{
+	// an event must always fit into an empty buffer.
+	this->bufferSize = (bufferSize < (RFC_LOGGER_MAX_EVENT_SIZE * 2)) ? (RFC_LOGGER_MAX_EVENT_SIZE * 2) : bufferSize;
+	loggerID = ++rfc_loggerIDCounter;
+
+	LARGE_INTEGER frequency;
+	::QueryPerformanceFrequency(&frequency);
+	ticksPerSecond = frequency.QuadPart;
+
+	fileFormat = FORMAT_V2;
+
+	streamFile = nullptr;
+	flushEvent = ::CreateEventW(NULL, FALSE, FALSE, NULL); // auto-reset
+	flushInterval = 100;
+	streamedEvents = 0;
+	streamedFormats = 0;
+
+	flusherThread.onRun = [this](KThread* thread) { flusherProc(thread); };
+}
 
-		if (isFirstCall)
+KLoggerThreadBuffer* KLogger::getThreadBuffer() noexcept
+{
+	KLoggerThreadCache& cache = rfc_loggerThreadCache;
+	if (cache.loggerID == loggerID)
+		return cache.buffer;
+
+	const DWORD threadID = ::GetCurrentThreadId();
+
+	KLoggerThreadBuffer* buffer = threadBuffers.load(std::memory_order_acquire);
+	while (buffer && (buffer->threadID != threadID))
+		buffer = buffer->next;
+
+	if (buffer == nullptr) // first event of this thread. (buffers of exited threads are reused by the threads which get the same id)
+	{
+		buffer = new KLoggerThreadBuffer(threadID, bufferSize);
+		buffer->next = threadBuffers.load(std::memory_order_relaxed);
+		while (!threadBuffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed))
 		{
-			pCounter.startCounter();
-			isFirstCall = false;
-			totalMills = 0;
 		}
-		else{
-			const double deltaMills = pCounter.endCounter();
-			totalMills += (unsigned int)deltaMills;
+	}
 
-			secs = (unsigned short)(totalMills/1000);
-			mills = (unsigned short)(totalMills % 1000);
+	cache.loggerID = loggerID;
+	cache.buffer = buffer;
+	return buffer;
+}
 
-			pCounter.startCounter();
-		}
+void KLogger::registerCurrentThread() noexcept
+{
+	getThreadBuffer();
+}
 
-		buffer[bufferIndex] = eventType; // write event type
-		bufferIndex += sizeof(unsigned char);
+char* KLogger::beginEvent(unsigned char eventType, unsigned char category, DWORD paramsSize) noexcept
+{
+	KLoggerThreadBuffer* buffer = getThreadBuffer();
 
-		*((unsigned short*)&buffer[bufferIndex]) = secs; // write secs
-		bufferIndex += sizeof(unsigned short);
+	if ((sizeof(KLoggerRecordHeader) + 2 + paramsSize) > RFC_LOGGER_MAX_EVENT_SIZE)
+	{
+		buffer->eventStarted = false;
+		bufferFull.store(true, std::memory_order_relaxed);
+		return nullptr;
+	}
 
-		*((unsigned short*)&buffer[bufferIndex]) = mills; // write mills
-		bufferIndex += sizeof(unsigned short);
+	LARGE_INTEGER now;
+	::QueryPerformanceCounter(&now);
 
-		totalEvents++;
+	__int64 expected = 0;
+	startTime.compare_exchange_strong(expected, now.QuadPart, std::memory_order_relaxed); // first event is the time zero.
 
-		return true;
-	}
-	return false;
+	KLoggerRecordHeader* header = (KLoggerRecordHeader*)buffer->event;
+	header->time = now.QuadPart;
+
+	buffer->event[sizeof(KLoggerRecordHeader)] = (char)eventType; // write event type
+	buffer->event[sizeof(KLoggerRecordHeader) + 1] = (char)category; // write category
+	buffer->eventSize = sizeof(KLoggerRecordHeader) + 2 + paramsSize;
+	buffer->eventStarted = true;
+
+	return &buffer->event[sizeof(KLoggerRecordHeader) + 2];
+}
+
+bool KLogger::writeNewEvent(unsigned char eventType, unsigned char category) noexcept
+{
+	return beginEvent(eventType, category, 0) != nullptr;
 }
 
 bool KLogger::endEvent() noexcept
 {
-	if (!bufferFull)
+	KLoggerThreadBuffer* buffer = getThreadBuffer();
+	if (!buffer->eventStarted)
 	{
-		buffer[bufferIndex] = EVT_END; // write event end
-		bufferIndex += sizeof(unsigned char);
+		bufferFull.store(true, std::memory_order_relaxed);
+		return false;
+	}
 
-		return true;
+	buffer->eventStarted = false;
+
+	const DWORD recordSize = buffer->eventSize;
+	((KLoggerRecordHeader*)buffer->event)->size = recordSize;
+
+	const unsigned __int64 writePosition = buffer->writePosition.load(std::memory_order_relaxed);
+	const unsigned __int64 usedBytes = writePosition - buffer->readPosition.load(std::memory_order_acquire);
+
+	if ((usedBytes + recordSize) > buffer->size)
+	{
+		bufferFull.store(true, std::memory_order_relaxed);
+		return false;
 	}
-	return false;
+
+	buffer->copyIn(writePosition, buffer->event, recordSize);
+	buffer->writePosition.store(writePosition + recordSize, std::memory_order_release);
+
+	// wake up the flusher once when the buffer becomes half full.
+	const unsigned __int64 halfSize = buffer->size / 2;
+	if ((usedBytes < halfSize) && ((usedBytes + recordSize) >= halfSize))
+		::SetEvent(flushEvent);
+
+	return true;
 }
 
 bool KLogger::addTextParam(const char *text, unsigned char textLength) noexcept
 {
-	if( (textLength < 255) && (!bufferFull) )
-	{
-		buffer[bufferIndex] = PARAM_STRING; // write param type
-		bufferIndex += sizeof(unsigned char);
-
-		buffer[bufferIndex] = textLength; // write data size
-		bufferIndex += sizeof(unsigned char);
+	KLoggerThreadBuffer* buffer = getThreadBuffer();
 
-		for (int i = 0; i < textLength; i++) // write data
-		{
-			buffer[bufferIndex] = text[i];
-			bufferIndex += sizeof(unsigned char);
-		}
+	if ((textLength < 255) && buffer->reserveEventBytes(2 + textLength))
+	{
+		char* destination = &buffer->event[buffer->eventSize];
+		destination[0] = PARAM_STRING; // write param type
+		destination[1] = textLength; // write data size
+		::memcpy(&destination[2], text, textLength); // write data
 
+		buffer->eventSize += 2 + textLength;
 		return true;
 	}
 	return false;
@@ -113,14 +265,14 @@ bool KLogger::addTextParam(const char *text, unsigned char textLength) noexcept
 
 bool KLogger::addIntParam(int value) noexcept
 {
-	if(!bufferFull)
-	{
-		buffer[bufferIndex] = PARAM_INT32; // write param type
-		bufferIndex += sizeof(unsigned char);
+	KLoggerThreadBuffer* buffer = getThreadBuffer();
 
-		*((int*)&buffer[bufferIndex]) = value; // write data
-		bufferIndex += sizeof(int);
+	if (buffer->reserveEventBytes(1 + sizeof(int)))
+	{
+		buffer->event[buffer->eventSize] = PARAM_INT32; // write param type
+		::memcpy(&buffer->event[buffer->eventSize + 1], &value, sizeof(int)); // write data
 
+		buffer->eventSize += 1 + sizeof(int);
 		return true;
 	}
 	return false;
@@ -128,14 +280,14 @@ bool KLogger::addIntParam(int value) noexcept
 
 bool KLogger::addShortParam(unsigned short value) noexcept
 {
-	if(!bufferFull)
-	{
-		buffer[bufferIndex] = PARAM_SHORT16; // write param type
-		bufferIndex += sizeof(unsigned char);
+	KLoggerThreadBuffer* buffer = getThreadBuffer();
 
-		*((unsigned short*)&buffer[bufferIndex]) = value; // write data
-		bufferIndex += sizeof(unsigned short);
+	if (buffer->reserveEventBytes(1 + sizeof(unsigned short)))
+	{
+		buffer->event[buffer->eventSize] = PARAM_SHORT16; // write param type
+		::memcpy(&buffer->event[buffer->eventSize + 1], &value, sizeof(unsigned short)); // write data
 
+		buffer->eventSize += 1 + sizeof(unsigned short);
 		return true;
 	}
 	return false;
@@ -143,14 +295,14 @@ bool KLogger::addShortParam(unsigned short value) noexcept
 
 bool KLogger::addFloatParam(float value) noexcept
 {
-	if(!bufferFull)
-	{
-		buffer[bufferIndex] = PARAM_FLOAT; // write param type
-		bufferIndex += sizeof(unsigned char);
+	KLoggerThreadBuffer* buffer = getThreadBuffer();
 
-		*((float*)&buffer[bufferIndex]) = value; // write data
-		bufferIndex += sizeof(float);
+	if (buffer->reserveEventBytes(1 + sizeof(float)))
+	{
+		buffer->event[buffer->eventSize] = PARAM_FLOAT; // write param type
+		::memcpy(&buffer->event[buffer->eventSize + 1], &value, sizeof(float)); // write data
 
+		buffer->eventSize += 1 + sizeof(float);
 		return true;
 	}
 	return false;
@@ -158,14 +310,14 @@ bool KLogger::addFloatParam(float value) noexcept
 	
 bool KLogger::addDoubleParam(double value) noexcept
 {
-	if(!bufferFull)
-	{
-		buffer[bufferIndex] = PARAM_DOUBLE; // write param type
-		bufferIndex += sizeof(unsigned char);
+	KLoggerThreadBuffer* buffer = getThreadBuffer();
 
-		*((double*)&buffer[bufferIndex]) = value; // write data
-		bufferIndex += sizeof(double);
+	if (buffer->reserveEventBytes(1 + sizeof(double)))
+	{
+		buffer->event[buffer->eventSize] = PARAM_DOUBLE; // write param type
+		::memcpy(&buffer->event[buffer->eventSize + 1], &value, sizeof(double)); // write data
 
+		buffer->eventSize += 1 + sizeof(double);
 		return true;
 	}
 	return false;
@@ -173,11 +325,189 @@ bool KLogger::addDoubleParam(double value) noexcept
 
 bool KLogger::isBufferFull() noexcept
 {
-	return bufferFull;
+	return bufferFull.load(std::memory_order_relaxed);
+}
+
+void KLogger::setFileFormat(int format) noexcept
+{
+	fileFormat = format;
+}
+
+unsigned __int64 KLogger::toNanoseconds(__int64 time, __int64 timeZero) noexcept
+{
+	// an event of another thread may get an earlier time than the first published one.
+	const __int64 elapsed = (time > timeZero) ? (time - timeZero) : 0;
+
+	// split to avoid overflow of elapsed * 1e9
+	return (unsigned __int64)((elapsed / ticksPerSecond) * 1000000000LL +
+		((elapsed % ticksPerSecond) * 1000000000LL) / ticksPerSecond);
+}
+
+void KLogger::writeFormats(KFile* file, unsigned int* formatCount) noexcept
+{
+	KLoggerFormat* lastFormat = KLoggerFormat::getLastFormat();
+	if ((lastFormat == nullptr) || (lastFormat->id < *formatCount))
+		return;
+
+	// list is newest first. the parser does not need them in id order.
+	for (KLoggerFormat* format = lastFormat; format && (format->id >= *formatCount); format = format->next)
+	{
+		char packet[7];
+		packet[0] = (char)EVT_FORMAT_DEFINITION;
+		::memcpy(&packet[1], &format->id, sizeof(unsigned int));
+		::memcpy(&packet[5], &format->length, sizeof(unsigned short));
+
+		file->writeFile(packet, sizeof(packet));
+		file->writeFile((void*)format->text, format->length);
+	}
+
+	*formatCount = lastFormat->id + 1;
+}
+
+unsigned int KLogger::writeEvents(KFile* file, bool consume, unsigned int* formatCount) noexcept
+{
+	struct Cursor
+	{
+		KLoggerThreadBuffer* buffer;
+		unsigned __int64 position;
+		unsigned __int64 end;
+		KLoggerRecordHeader header; // header of the event at position
+	};
+
+	int bufferCount = 0;
+	for (KLoggerThreadBuffer* buffer = threadBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->next)
+		++bufferCount;
+
+	if (bufferCount == 0)
+		return 0;
+
+	Cursor* cursors = (Cursor*)::malloc(bufferCount * sizeof(Cursor));
+	char* writeBuffer = (char*)::malloc(RFC_LOGGER_WRITE_BUFFER_SIZE);
+
+	// take a snapshot of each buffer. events published after this point are written next time.
+	int activeCount = 0;
+	KLoggerThreadBuffer* buffer = threadBuffers.load(std::memory_order_acquire);
+	for (int i = 0; i < bufferCount; ++i, buffer = buffer->next)
+	{
+		Cursor& cursor = cursors[activeCount];
+		cursor.buffer = buffer;
+		cursor.position = buffer->readPosition.load(std::memory_order_relaxed);
+		cursor.end = buffer->writePosition.load(std::memory_order_acquire);
+
+		if (cursor.position != cursor.end)
+		{
+			buffer->copyOut(cursor.position, (char*)&cursor.header, sizeof(KLoggerRecordHeader));
+			++activeCount;
+		}
+	}
+
+	// formats of the snapshot events are registered before the events are published.
+	if (fileFormat != FORMAT_V1)
+		writeFormats(file, formatCount);
+
+	const __int64 timeZero = startTime.load(std::memory_order_relaxed);
+	unsigned int eventCount = 0;
+	DWORD writeIndex = 0;
+
+	// merge: always take the oldest event among the threads. each buffer is already in time order.
+	while (activeCount > 0)
+	{
+		int oldest = 0;
+		for (int i = 1; i < activeCount; ++i)
+		{
+			if (cursors[i].header.time < cursors[oldest].header.time)
+				oldest = i;
+		}
+
+		Cursor& cursor = cursors[oldest];
+		const unsigned __int64 dataPosition = cursor.position + sizeof(KLoggerRecordHeader);
+		const DWORD paramsSize = cursor.header.size - sizeof(KLoggerRecordHeader) - 2; // without event type & category
+
+		// largest packet is v2: type|category|thread id|time|params|end
+		if ((writeIndex + paramsSize + 15) > RFC_LOGGER_WRITE_BUFFER_SIZE)
+		{
+			file->writeFile(writeBuffer, writeIndex);
+			writeIndex = 0;
+		}
+
+		char* destination = &writeBuffer[writeIndex];
+		const unsigned __int64 nanoseconds = toNanoseconds(cursor.header.time, timeZero);
+
+		bool skipEvent = false;
+		if ((fileFormat == FORMAT_V1) && (paramsSize != 0))
+		{
+			char paramType;
+			cursor.buffer->copyOut(dataPosition + 2, &paramType, 1);
+			skipEvent = (paramType == PARAM_FORMAT); // v1 cannot hold KLOG events
+		}
+
+		if (!skipEvent)
+		{
+			if (fileFormat == FORMAT_V1)
+			{
+				const unsigned __int64 totalMills = nanoseconds / 1000000;
+				const unsigned short secs = (unsigned short)(totalMills / 1000);
+				const unsigned short mills = (unsigned short)(totalMills % 1000);
+
+				cursor.buffer->copyOut(dataPosition, destination, 1); // event type
+				::memcpy(destination + 1, &secs, sizeof(unsigned short));
+				::memcpy(destination + 3, &mills, sizeof(unsigned short));
+				destination += 5;
+			}
+			else
+			{
+				const DWORD threadID = cursor.buffer->threadID;
+
+				cursor.buffer->copyOut(dataPosition, destination, 2); // event type & category
+				::memcpy(destination + 2, &threadID, sizeof(DWORD));
+				::memcpy(destination + 6, &nanoseconds, sizeof(unsigned __int64));
+				destination += 14;
+			}
+
+			cursor.buffer->copyOut(dataPosition + 2, destination, paramsSize);
+			destination[paramsSize] = EVT_END;
+
+			writeIndex = (DWORD)((destination + paramsSize + 1) - writeBuffer);
+			++eventCount;
+		}
+
+		cursor.position += cursor.header.size;
+		if (cursor.position == cursor.end)
+		{
+			if (consume)
+				cursor.buffer->readPosition.store(cursor.position, std::memory_order_release);
+
+			cursors[oldest] = cursors[--activeCount];
+		}
+		else
+		{
+			cursor.buffer->copyOut(cursor.position, (char*)&cursor.header, sizeof(KLoggerRecordHeader));
+		}
+	}
+
+	if (writeIndex)
+		file->writeFile(writeBuffer, writeIndex);
+
+	::free(writeBuffer);
+	::free(cursors);
+
+	return eventCount;
+}
+
+bool KLogger::writeHeader(KFile* file, unsigned int eventCount) noexcept
+{
+	if (!file->setFilePointerToStart())
+		return false;
+
+	const char* magic = (fileFormat == FORMAT_V1) ? "RLOG" : "RLG2";
+	return (file->writeFile((void*)magic, 4) == 4) && (file->writeFile(&eventCount, 4) == 4);
 }
 
 bool KLogger::writeToFile(const KString &filePath) noexcept
 {
+	if (streamFile) // the file is being written by the flusher.
+		return false;
+
 	KFile file;
 
 	if (KFile::isFileExists(filePath))
@@ -185,17 +515,90 @@ bool KLogger::writeToFile(const KString &filePath) noexcept
 
 	if (file.openFile(filePath, KFile::KWRITE))
 	{
-		file.writeFile((void*)"RLOG", 4);
-		file.writeFile(&totalEvents, 4);
-		file.writeFile(buffer, bufferIndex);
+		writeHeader(&file, 0);
 
-		return true;
+		unsigned int formatCount = 0;
+		const unsigned int eventCount = writeEvents(&file, false, &formatCount);
+
+		return writeHeader(&file, eventCount);
 	}
 
 	return false;
 }
 
+void KLogger::flusherProc(KThread* thread) noexcept
+{
+	while (thread->isRunningAllowed())
+	{
+		::WaitForSingleObject(flushEvent, flushInterval);
+		streamedEvents += writeEvents(streamFile, true, &streamedFormats);
+	}
+}
+
+bool KLogger::startStreaming(const KString& filePath, DWORD flushInterval) noexcept
+{
+	if (streamFile)
+		return false;
+
+	if (KFile::isFileExists(filePath))
+		KFile::deleteFile(filePath);
+
+	streamFile = new KFile();
+	if (!streamFile->openFile(filePath, KFile::KWRITE) || !writeHeader(streamFile, 0))
+	{
+		delete streamFile;
+		streamFile = nullptr;
+		return false;
+	}
+
+	this->flushInterval = flushInterval;
+	streamedEvents = 0;
+	streamedFormats = 0;
+
+	if (!flusherThread.start())
+	{
+		delete streamFile;
+		streamFile = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+void KLogger::stopStreaming() noexcept
+{
+	if (streamFile == nullptr)
+		return;
+
+	flusherThread.shouldStop();
+	::SetEvent(flushEvent);
+	flusherThread.waitUntilThreadFinish();
+
+	streamedEvents += writeEvents(streamFile, true, &streamedFormats); // remaining events
+
+	writeHeader(streamFile, streamedEvents);
+	streamFile->closeFile();
+
+	delete streamFile;
+	streamFile = nullptr;
+}
+
+bool KLogger::isStreaming() noexcept
+{
+	return (streamFile != nullptr);
+}
+
 KLogger::~KLogger() noexcept
 {
-	free(buffer);
-}
\ No newline at end of file
+	stopStreaming();
+
+	KLoggerThreadBuffer* buffer = threadBuffers.load(std::memory_order_acquire);
+	while (buffer)
+	{
+		KLoggerThreadBuffer* next = buffer->next;
+		delete buffer;
+		buffer = next;
+	}
+
+	::CloseHandle(flushEvent);
+}
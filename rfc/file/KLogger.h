@@ -23,32 +23,225 @@
 
 #include "../core/CoreModule.h"
 #include "../utils/UtilsModule.h"
+#include "../thread/ThreadModule.h"
+#include <atomic>
+#include <type_traits>
 
+// max size of a single event with its params. larger events are dropped.
+#ifndef RFC_LOGGER_MAX_EVENT_SIZE
+	#define RFC_LOGGER_MAX_EVENT_SIZE 1024
+#endif
+
+// KLOG calls with a lower event type are compiled out. (1 = information, 2 = warning, 3 = error, 4 = none)
+#ifndef RFC_LOGGER_MIN_LEVEL
+	#define RFC_LOGGER_MIN_LEVEL 1
+#endif
+
+class KLoggerThreadBuffer;
+class KFile;
+
+/**
+	Format string of a KLOG call site. Lives as a function local static.
+	Gets a process wide unique id on construction and stays in a global lock-free list,
+	so the logger can write the text into the file once instead of with each event.
+	"{}" inside the text is replaced by the next argument when the file is viewed.
+*/
+class KLoggerFormat
+{
+public:
+	const char* text;
+	unsigned short length;
+	unsigned int id;
+	KLoggerFormat* next;
+
+	KLoggerFormat(const char* text) noexcept;
+
+	// @returns the last registered format. ids of the list are in descending order.
+	static KLoggerFormat* getLastFormat() noexcept;
+
+	// no copy/movable
+	KLoggerFormat(const KLoggerFormat&) = delete;
+	KLoggerFormat& operator=(const KLoggerFormat&) = delete;
+	KLoggerFormat(KLoggerFormat&&) = delete;
+	KLoggerFormat& operator=(KLoggerFormat&&) = delete;
+};
 
 /**
-	Super fast logging class for logging within a (audio)loop. (not thread safe)
-	Writes logging data into ram & dumps data into file when needed.
+	Packing of a single KLOG argument. Supported types: integers, enums, float, double and char strings.
+	size is the fixed part. Strings add their length at runtime.
+*/
+template<typename T, typename Enable = void>
+struct KLoggerArg
+{
+	static_assert(sizeof(T) == 0, "unsupported KLOG argument type");
+};
+
+template<typename T>
+struct KLoggerArg<T, std::enable_if_t<(std::is_integral_v<T> || std::is_enum_v<T>) && (sizeof(T) <= 4)>>
+{
+	static constexpr unsigned char type = 2; // KLogger::PARAM_INT32
+	static constexpr DWORD size = sizeof(int);
+
+	static inline DWORD getExtraSize(T) noexcept { return 0; }
+
+	static inline char* write(char* destination, T value) noexcept
+	{
+		const int data = (int)value;
+		::memcpy(destination, &data, sizeof(int));
+		return destination + sizeof(int);
+	}
+};
+
+template<typename T>
+struct KLoggerArg<T, std::enable_if_t<(std::is_integral_v<T> || std::is_enum_v<T>) && (sizeof(T) == 8)>>
+{
+	static constexpr unsigned char type = 7; // KLogger::PARAM_INT64
+	static constexpr DWORD size = sizeof(__int64);
+
+	static inline DWORD getExtraSize(T) noexcept { return 0; }
+
+	static inline char* write(char* destination, T value) noexcept
+	{
+		const __int64 data = (__int64)value;
+		::memcpy(destination, &data, sizeof(__int64));
+		return destination + sizeof(__int64);
+	}
+};
+
+template<typename T>
+struct KLoggerArg<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+	static constexpr unsigned char type = std::is_same_v<T, float> ? 4 : 5; // KLogger::PARAM_FLOAT, KLogger::PARAM_DOUBLE
+	static constexpr DWORD size = std::is_same_v<T, float> ? sizeof(float) : sizeof(double);
+
+	static inline DWORD getExtraSize(T) noexcept { return 0; }
+
+	static inline char* write(char* destination, T value) noexcept
+	{
+		if constexpr (std::is_same_v<T, float>)
+		{
+			::memcpy(destination, &value, sizeof(float));
+		}
+		else
+		{
+			const double data = (double)value;
+			::memcpy(destination, &data, sizeof(double));
+		}
+		return destination + size;
+	}
+};
+
+template<typename T>
+struct KLoggerArg<T, std::enable_if_t<std::is_same_v<T, const char*> || std::is_same_v<T, char*>>>
+{
+	static constexpr unsigned char type = 1; // KLogger::PARAM_STRING
+	static constexpr DWORD size = 1; // length byte
+
+	// max 254 chars. longer texts are truncated.
+	static inline DWORD getLength(const char* text) noexcept
+	{
+		if (text == nullptr)
+			return 0;
+
+		DWORD length = 0;
+		while ((length < 254) && text[length])
+			++length;
+		return length;
+	}
+
+	static inline DWORD getExtraSize(const char* text) noexcept { return getLength(text); }
+
+	static inline char* write(char* destination, const char* text) noexcept
+	{
+		const DWORD length = getLength(text);
+		destination[0] = (char)length;
+		if (length)
+			::memcpy(destination + 1, text, length);
+		return destination + 1 + length;
+	}
+};
+
+/**
+	Super fast logging class for logging within a (audio)loop. Thread safe and lock-free.
+	Each thread writes its events into its own ring buffer. Events are merged by their timestamps when written to the file.
+	Buffer of a thread is allocated on its first log call or by registerCurrentThread.
 	You can use this class instead of OutputDebugString API.(OutputDebugString is too slow & ETW is too complex?)
 	Use Log Viewer tool to view generated log file.
 
-	Log File Format:
-		file header:				'R' 'L' 'O' 'G'
+	Two ways to get the events into a file:
+	- writeToFile: keeps everything in ram & dumps data into file when needed. events are dropped when a thread's buffer is full.
+	- startStreaming: a background thread moves the events to the file periodically. so the buffers never get full 
+	  unless a thread logs faster than the disk can take it.
+
+	Calls of writeNewEvent, add...Param and endEvent of an event must be made from the same thread.
+	Each thread can build only one event at a time.
+
+	Log File Format (v2, default):
+		file header:				'R' 'L' 'G' '2'
 		event count:				int32					; (event count)
-		event start packet format:	byte|short16|short16	; (event type|secs|mills)
+		event start packet format:	byte|byte|int32|int64	; (event type|category|thread id|nanoseconds since first event)
 		event param number format:	byte|data				; (param type|data)
-		event param string format:	byte|byte|data			; (param type|data size[max 255]|data)
+		event param string format:	byte|byte|data			; (param type|data size[max 254]|data)
 		event end packet format:	byte					; (EVT_END)
+
+	Log File Format (v1, see setFileFormat):
+		file header:				'R' 'L' 'O' 'G'
+		event count:				int32					; (event count)
+		event start packet format:	byte|short16|short16	; (event type|secs|mills)
+		params and event end are same as v2. category and thread id are not written.
+		secs wraps after about 18 hours. KLOG events are not written.
+
+	KLOG packets (v2):
+		format definition:			byte|int32|short16|data	; (EVT_FORMAT_DEFINITION|format id|text length|text) written before its first use
+		format param:				byte|int32|byte|bytes|data	; (PARAM_FORMAT|format id|arg count|arg param types|packed args)
+		string args are byte|data (length|text), others are raw values.
 */
 class KLogger
 {
 protected:
-	DWORD bufferSize;
-	DWORD bufferIndex;
-	unsigned int totalMills;
-	unsigned int totalEvents;
-	char *buffer;
-	bool bufferFull, isFirstCall;
-	KPerformanceCounter pCounter;
+	DWORD bufferSize; // size of each thread buffer
+	unsigned int loggerID; // unique id. used to find the buffer of the calling thread.
+	std::atomic<KLoggerThreadBuffer*> threadBuffers; // lock-free linked list of thread buffers
+	std::atomic<__int64> startTime; // qpc time of the first event
+	std::atomic<bool> bufferFull;
+	__int64 ticksPerSecond;
+	int fileFormat;
+
+	// streaming
+	KThread flusherThread;
+	KFile* streamFile;
+	HANDLE flushEvent;
+	DWORD flushInterval;
+	unsigned int streamedEvents;
+	unsigned int streamedFormats;
+
+	KLoggerThreadBuffer* getThreadBuffer() noexcept;
+
+	/**
+		Starts a new event and reserves space for its params.
+		@returns pointer to the params area or null if the event is too large.
+	*/
+	char* beginEvent(unsigned char eventType, unsigned char category, DWORD paramsSize) noexcept;
+
+	/**
+		Writes the events of all threads in time order.
+		@param consume if false, events are kept in the buffers.
+		@returns number of events written
+	*/
+	unsigned int writeEvents(KFile* file, bool consume, unsigned int* formatCount) noexcept;
+
+	/**
+		Writes the definitions of the formats which are registered after the previous call. (v2 only)
+		@param formatCount number of formats already in the file. updated by this method.
+	*/
+	void writeFormats(KFile* file, unsigned int* formatCount) noexcept;
+
+	bool writeHeader(KFile* file, unsigned int eventCount) noexcept;
+
+	// time since the first event.
+	unsigned __int64 toNanoseconds(__int64 time, __int64 timeZero) noexcept;
+
+	void flusherProc(KThread* thread) noexcept;
 
 public:
 
@@ -64,6 +257,13 @@ public:
 		EVT_INFORMATION = 1,
 		EVT_WARNING = 2,
 		EVT_ERROR = 3,
+		EVT_FORMAT_DEFINITION = 255, // not an event. defines the text of a KLOG format. (v2 only)
+	};
+
+	enum FileFormats
+	{
+		FORMAT_V1 = 1,
+		FORMAT_V2 = 2,
 	};
 
 	enum ParamTypes
@@ -74,16 +274,34 @@ public:
 		PARAM_SHORT16 = 3,
 		PARAM_FLOAT = 4,
 		PARAM_DOUBLE = 5,
+		PARAM_FORMAT = 6, // written by KLOG. (v2 only)
+		PARAM_INT64 = 7, // only inside PARAM_FORMAT
 	};
 
-	KLogger(DWORD bufferSize = (SZ_MEGABYTE * 10)) noexcept;
+	/**
+		@param bufferSize size of the ring buffer of each logging thread. total memory grows with the number of threads.
+	*/
+	KLogger(DWORD bufferSize = SZ_MEGABYTE) noexcept;
 
-	bool writeNewEvent(unsigned char eventType = EVT_INFORMATION) noexcept;
+	/**
+		Allocates the buffer of the calling thread. Call this at the start of a real-time (audio) thread,
+		so its first log call does not allocate memory. Otherwise the buffer is allocated on the first log call.
+	*/
+	void registerCurrentThread() noexcept;
 
+	/**
+		@param category user defined value to group the events. (e.g. subsystem id) not stored in v1 files.
+	*/
+	bool writeNewEvent(unsigned char eventType = EVT_INFORMATION, unsigned char category = 0) noexcept;
+
+	/**
+		Publishes the event.
+		@returns false if the event was dropped because the thread buffer is full or the event is too large.
+	*/
 	bool endEvent() noexcept;
 
 	/**
-		textLength is number of chars. max value is 255.
+		textLength is number of chars. max value is 254.
 	*/
 	bool addTextParam(const char *text, unsigned char textLength) noexcept;
 
@@ -95,13 +313,88 @@ public:
 	
 	bool addDoubleParam(double value) noexcept;
 
+	/**
+		Writes a complete event with a single reservation. Use KLOG macro instead of calling this directly.
+		Argument types are packed into a compile-time signature.
+	*/
+	template<typename... Args>
+	bool logFormatted(unsigned char eventType, unsigned char category, const KLoggerFormat& format, const Args&... args) noexcept
+	{
+		static_assert(sizeof...(Args) < 256, "too many KLOG arguments");
+		static constexpr unsigned char signature[sizeof...(Args) + 1] = { KLoggerArg<std::decay_t<Args>>::type..., 0 };
+		constexpr DWORD fixedSize = 6 + sizeof...(Args) + (KLoggerArg<std::decay_t<Args>>::size + ... + 0);
+
+		const DWORD paramsSize = fixedSize + (KLoggerArg<std::decay_t<Args>>::getExtraSize(args) + ... + 0);
+		char* destination = beginEvent(eventType, category, paramsSize);
+		if (destination == nullptr)
+			return false;
+
+		destination[0] = PARAM_FORMAT;
+		::memcpy(destination + 1, &format.id, sizeof(unsigned int));
+		destination[5] = (char)sizeof...(Args);
+		::memcpy(destination + 6, signature, sizeof...(Args));
+		destination += 6 + sizeof...(Args);
+
+		((destination = KLoggerArg<std::decay_t<Args>>::write(destination, args)), ...);
+
+		return endEvent();
+	}
+
+	/**
+		@returns true if any event was dropped.
+	*/
 	bool isBufferFull() noexcept;
 
+	/**
+		Selects the format of the files written after this call. FORMAT_V2 is the default.
+		Use FORMAT_V1 for the tools which cannot read v2 files.
+	*/
+	void setFileFormat(int format) noexcept;
+
+	/**
+		Writes all buffered events into the file. Events stay in the buffers.
+		Not available while streaming.
+	*/
 	bool writeToFile(const KString &filePath) noexcept;
 
+	/**
+		Creates the file and starts a background thread which moves the events from the thread buffers into the file.
+		@param flushInterval max time between two writes in milliseconds. 
+		Buffers which become half full are written immediately.
+	*/
+	bool startStreaming(const KString& filePath, DWORD flushInterval = 100) noexcept;
+
+	/**
+		Writes the remaining events and closes the file.
+	*/
+	void stopStreaming() noexcept;
+
+	bool isStreaming() noexcept;
+
 	~KLogger() noexcept;
 
+	// no copy/movable
+	KLogger(const KLogger&) = delete;
+	KLogger& operator=(const KLogger&) = delete;
+	KLogger(KLogger&&) = delete;
+	KLogger& operator=(KLogger&&) = delete;
+
 private:
 	RFC_LEAK_DETECTOR(KLogger)
 };
 
+/**
+	Structured logging with a compile-time format. Calls below RFC_LOGGER_MIN_LEVEL are compiled out.
+	e.g. KLOG(logger, EVT_WARNING, "buffer underrun {} at {} ms", count, time);
+*/
+#define KLOG(logger, eventType, format, ...) KLOG_CATEGORY(logger, eventType, 0, format, ##__VA_ARGS__)
+
+#define KLOG_CATEGORY(logger, eventType, category, format, ...) \
+	do { \
+		if constexpr (KLogger::eventType >= RFC_LOGGER_MIN_LEVEL) \
+		{ \
+			static const KLoggerFormat rfc_logFormat(format); \
+			(logger).logFormatted(KLogger::eventType, category, rfc_logFormat, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
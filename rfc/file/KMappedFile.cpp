@@ -0,0 +1,270 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KMappedFile.h"
+
+#ifndef _WIN32
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <stdlib.h>
+#endif
+
+KMappedFile::KMappedFile() noexcept
+{
+	view = nullptr;
+	viewSize = 0;
+	position = 0;
+	opened = false;
+}
+
+KMappedFile::KMappedFile(const wchar_t* fileName) noexcept
+{
+	view = nullptr;
+	viewSize = 0;
+	position = 0;
+	opened = false;
+
+	openFile(fileName);
+}
+
+#ifdef _WIN32
+
+bool KMappedFile::openFile(const wchar_t* fileName) noexcept
+{
+	closeFile();
+
+	HANDLE fileHandle = ::CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if ((::GetFileSizeEx(fileHandle, &fileSize) == 0) || ((ULONGLONG)fileSize.QuadPart > (SIZE_T)-1))
+	{
+		::CloseHandle(fileHandle);
+		return false;
+	}
+
+	if (fileSize.QuadPart == 0) // empty file cannot be mapped
+	{
+		::CloseHandle(fileHandle);
+		opened = true;
+		return true;
+	}
+
+	HANDLE mappingHandle = ::CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	::CloseHandle(fileHandle); // mapping keeps the file open
+
+	if (mappingHandle == NULL)
+		return false;
+
+	view = (const BYTE*)::MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	::CloseHandle(mappingHandle); // view keeps the mapping alive
+
+	if (view == nullptr)
+		return false;
+
+	viewSize = (size_t)fileSize.QuadPart;
+	opened = true;
+	return true;
+}
+
+void KMappedFile::closeFile() noexcept
+{
+	if (view)
+		::UnmapViewOfFile(view);
+
+	view = nullptr;
+	viewSize = 0;
+	position = 0;
+	opened = false;
+}
+
+#else
+
+bool KMappedFile::openFile(const wchar_t* fileName) noexcept
+{
+	closeFile();
+
+	const size_t pathLength = ::wcstombs(nullptr, fileName, 0);
+	if (pathLength == (size_t)-1)
+		return false;
+
+	char* path = (char*)::malloc(pathLength + 1);
+	::wcstombs(path, fileName, pathLength + 1);
+
+	const int fileDescriptor = ::open(path, O_RDONLY);
+	::free(path);
+
+	if (fileDescriptor == -1)
+		return false;
+
+	struct stat fileStat;
+	if ((::fstat(fileDescriptor, &fileStat) != 0) || !S_ISREG(fileStat.st_mode))
+	{
+		::close(fileDescriptor);
+		return false;
+	}
+
+	if (fileStat.st_size == 0) // empty file cannot be mapped
+	{
+		::close(fileDescriptor);
+		opened = true;
+		return true;
+	}
+
+	void* mappedView = ::mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	::close(fileDescriptor); // mapping keeps the file open
+
+	if (mappedView == MAP_FAILED)
+		return false;
+
+	view = (const BYTE*)mappedView;
+	viewSize = (size_t)fileStat.st_size;
+	opened = true;
+	return true;
+}
+
+void KMappedFile::closeFile() noexcept
+{
+	if (view)
+		::munmap((void*)view, viewSize);
+
+	view = nullptr;
+	viewSize = 0;
+	position = 0;
+	opened = false;
+}
+
+#endif
+
+bool KMappedFile::isOpen() const noexcept
+{
+	return opened;
+}
+
+const BYTE* KMappedFile::getData() const noexcept
+{
+	return view;
+}
+
+size_t KMappedFile::getSize() const noexcept
+{
+	return viewSize;
+}
+
+#ifdef _WIN32
+
+KString KMappedFile::readAsString(bool isUnicode) const noexcept
+{
+	if ((viewSize == 0) || (viewSize > INT_MAX))
+		return KString();
+
+	if (isUnicode)
+	{
+		const int length = (int)(viewSize / sizeof(wchar_t));
+		if (length == 0)
+			return KString();
+
+		wchar_t* buffer = (wchar_t*)::malloc((length + 1) * sizeof(wchar_t));
+		::memcpy(buffer, view, length * sizeof(wchar_t));
+		buffer[length] = 0;
+
+		return KString(buffer, KStringBehaviour::FREE_ON_DESTROY, length);
+	}
+
+	// converts straight from the view. no intermediate null terminated copy.
+	const int length = ::MultiByteToWideChar(CP_UTF8, 0, (const char*)view, (int)viewSize, NULL, 0);
+	if (length <= 0)
+		return KString();
+
+	wchar_t* buffer = (wchar_t*)::malloc((length + 1) * sizeof(wchar_t));
+	::MultiByteToWideChar(CP_UTF8, 0, (const char*)view, (int)viewSize, buffer, length);
+	buffer[length] = 0;
+
+	return KString(buffer, KStringBehaviour::FREE_ON_DESTROY, length);
+}
+
+#endif
+
+bool KMappedFile::setPosition(size_t newPosition) noexcept
+{
+	if (newPosition > viewSize)
+		return false;
+
+	position = newPosition;
+	return true;
+}
+
+size_t KMappedFile::getPosition() const noexcept
+{
+	return position;
+}
+
+bool KMappedFile::skip(size_t bytesToSkip) noexcept
+{
+	if (bytesToSkip > (viewSize - position))
+		return false;
+
+	position += bytesToSkip;
+	return true;
+}
+
+KMappedFile::~KMappedFile() noexcept
+{
+	closeFile();
+}
+
+bool KMappedFile::readStream(BYTE* buffer, DWORD bytesToRead) noexcept
+{
+	if (bytesToRead > (viewSize - position))
+		return false;
+
+	if (bytesToRead)
+	{
+		::memcpy(buffer, view + position, bytesToRead);
+		position += bytesToRead;
+	}
+
+	return true;
+}
+
+bool KMappedFile::writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept
+{
+	return false;
+}
+
+DWORD KMappedFile::readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept
+{
+	const size_t available = viewSize - position;
+	const DWORD bytesToRead = (maxBytesToRead < available) ? maxBytesToRead : (DWORD)available;
+
+	if (bytesToRead)
+	{
+		::memcpy(buffer, view + position, bytesToRead);
+		position += bytesToRead;
+	}
+
+	return bytesToRead;
+}
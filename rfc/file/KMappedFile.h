@@ -0,0 +1,105 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include "KStream.h"
+#include <limits.h>
+
+/**
+	Maps a whole file into memory for reading. The content can be accessed directly through getData
+	without copying it into a heap buffer, or read sequentially as a KStream.
+	Opening is instant even for large files. pages are loaded by the OS when they are accessed.
+
+	Uses CreateFileMapping/MapViewOfFile on Windows and mmap on other platforms.
+	The view becomes invalid after closeFile or destructor.
+*/
+class KMappedFile : public KStream
+{
+protected:
+	const BYTE* view;
+	size_t viewSize;
+	size_t position; // stream position
+	bool opened;
+
+public:
+	KMappedFile() noexcept;
+
+	/**
+		The file must exist. opening an empty file succeeds with a null view.
+	*/
+	KMappedFile(const wchar_t* fileName) noexcept;
+
+	/**
+		The file must exist. opening an empty file succeeds with a null view.
+		The previously opened file will be closed.
+	*/
+	bool openFile(const wchar_t* fileName) noexcept;
+
+	void closeFile() noexcept;
+
+	bool isOpen() const noexcept;
+
+	/**
+		returns the mapped content. null if the file is not open or empty.
+	*/
+	const BYTE* getData() const noexcept;
+
+	size_t getSize() const noexcept;
+
+#ifdef _WIN32
+	// the utf-8 conversion uses MultiByteToWideChar. so it is only available on Windows.
+	KString readAsString(bool isUnicode = true) const noexcept;
+#endif
+
+	/**
+		moves the stream position. returns false if the position is beyond the end of the file.
+	*/
+	bool setPosition(size_t newPosition) noexcept;
+
+	size_t getPosition() const noexcept;
+
+	bool skip(size_t bytesToSkip) noexcept;
+
+	~KMappedFile() noexcept;
+
+	// ============= KStream ===============
+
+	bool readStream(BYTE* buffer, DWORD bytesToRead) noexcept override;
+
+	/**
+		always returns false. the view is read only.
+	*/
+	bool writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept override;
+
+	DWORD readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept override;
+
+	// no copy/movable
+	KMappedFile(const KMappedFile&) = delete;
+	KMappedFile& operator=(const KMappedFile&) = delete;
+	KMappedFile(KMappedFile&&) = delete;
+	KMappedFile& operator=(KMappedFile&&) = delete;
+
+private:
+	RFC_LEAK_DETECTOR(KMappedFile)
+};
+
@@ -21,15 +21,20 @@
 
 // Readonly data storage model. Use Property Storage - Editor tool to write.
 // Can be used when there is no order of storing data objects.
+// PS02 files are indexed for random access. Use KPSIndexedWriter to write or convert them.
 
 #pragma once
 
 #include <windows.h>
 #include "../containers/ContainersModule.h"
+#include "KMappedFile.h"
+#include "KFile.h"
+#include "KBufferedStream.h"
 
 #pragma comment(lib, "Rpcrt4.lib")
 
 #define PS_V1_HEADER    { 'P','S','0','1'}
+#define PS_V2_HEADER    { 'P','S','0','2'}
 
 namespace KPSPropertyTypes
 {
@@ -296,9 +301,41 @@ public:
     }
 };
 
+// object of an arena load. the name & the properties belong to the arena.
+class KPSArenaObject : public KPSObject
+{
+public:
+    ~KPSArenaObject() noexcept
+    {
+        name = NULL;
+        propertyList.removeAll();
+    }
+};
+
 class KPSReader
 {
 protected:
+    KArena* arena; // not null if the last file was loaded into an arena
+
+    void clear() noexcept
+    {
+        if (psObjectList)
+        {
+            if (arena)
+                psObjectList->removeAll(); // arena destroys the objects
+            else
+                psObjectList->deleteAll();
+
+            delete psObjectList;
+            psObjectList = NULL;
+        }
+
+        if (arena)
+        {
+            delete arena;
+            arena = NULL;
+        }
+    }
 
 public:
     KPointerList<KPSObject*,16, false>* psObjectList;
@@ -306,6 +343,7 @@ public:
     KPSReader() noexcept
     {
         psObjectList = NULL;
+        arena = NULL;
     }
 
     // do not free returned object.
@@ -321,155 +359,151 @@ public:
         return NULL;
     }
 
-    bool loadFromFile(const wchar_t* path, bool readNames = true) noexcept
+    /**
+        If useArena is true, all the objects, properties, strings, arrays and file data are placed into a single arena
+        instead of a heap block per item. Unloading frees the arena chunks at once.
+        Objects & properties of an arena load must not be deleted or modified to point to the heap memory.
+    */
+    bool loadFromFile(const wchar_t* path, bool readNames = true, bool useArena = false) noexcept
     {
-        if (psObjectList)
-        {
-            psObjectList->deleteAll();
-            delete psObjectList;
-            psObjectList = NULL;
-        }
+        clear();
 
-        HANDLE fileHandle = ::CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
-            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-
-        if (fileHandle == INVALID_HANDLE_VALUE)
+        // fields are small. so they are read from the mapped view instead of a syscall per field.
+        KMappedFile stream;
+        if (!stream.openFile(path))
             return false;
 
-        DWORD fileSize = ::GetFileSize(fileHandle, NULL);
-        fileSize = (fileSize == INVALID_FILE_SIZE) ? 0 : fileSize;
-
-        if (fileSize == 0)
-        {
-            ::CloseHandle(fileHandle);
+        if (stream.getSize() == 0)
             return false;
-        }
 
-        char fileHeader[4];
-        DWORD bytesRead;
-        ::ReadFile(fileHandle, fileHeader, 4, &bytesRead, NULL);
+        char fileHeader[4] = {};
+        stream.readStream((BYTE*)fileHeader, 4);
 
         char psFileHeader[4] = PS_V1_HEADER;
 
         for (int i = 0; i < 4; ++i)
         {
             if (psFileHeader[i] != fileHeader[i])
-            {
-                ::CloseHandle(fileHandle);
                 return false;
-            }
         }
 
         unsigned int objectCount = 0;
-        ::ReadFile(fileHandle, &objectCount, sizeof(unsigned int), &bytesRead, NULL);
+        stream.readStream((BYTE*)&objectCount, sizeof(unsigned int));
 
         if (objectCount == 0)
-        {
-            ::CloseHandle(fileHandle);
             return false;
+
+        if (useArena)
+        {
+            // the loaded data is about the size of the file. the first chunk is capped, the arena chains more chunks for huge files.
+            const size_t maxFirstChunkSize = 16 * 1024 * 1024;
+            const size_t firstChunkSize = stream.getSize() + (64 * 1024);
+            arena = new KArena((firstChunkSize < maxFirstChunkSize) ? firstChunkSize : maxFirstChunkSize);
         }
 
+        auto allocate = [this](size_t size) -> void* {
+            return arena ? arena->allocate(size, sizeof(int)) : ::malloc(size);
+        };
+
+        // reads length prefixed text with null terminator
+        auto readString = [&](int* length, wchar_t** text) {
+            stream.readStream((BYTE*)length, sizeof(int));
+            *text = (wchar_t*)allocate(sizeof(wchar_t) * (*length + 1));
+            stream.readStream((BYTE*)*text, sizeof(wchar_t) * *length);
+            (*text)[*length] = 0;
+        };
+
         psObjectList = new KPointerList<KPSObject*, 16, false>();
 
         for (unsigned int objectIndex = 0; objectIndex < objectCount; ++objectIndex)
         {
             GUID objectID;
-            ::ReadFile(fileHandle, &objectID, sizeof(GUID), &bytesRead, NULL);
+            stream.readStream((BYTE*)&objectID, sizeof(GUID));
 
             int nameLength;
-            ::ReadFile(fileHandle, &nameLength, sizeof(int), &bytesRead, NULL);
-
             wchar_t* objectName = NULL;
+
             if (readNames)
             {
-                objectName = (wchar_t*)::malloc(sizeof(wchar_t) * (nameLength + 1));
-                ::ReadFile(fileHandle, objectName, sizeof(wchar_t) * nameLength, &bytesRead, NULL);
-                objectName[nameLength] = 0;
+                readString(&nameLength, &objectName);
             }
             else // ignore name
             {
-                ::SetFilePointer(fileHandle, nameLength * sizeof(wchar_t), 0, FILE_CURRENT); 
+                stream.readStream((BYTE*)&nameLength, sizeof(int));
+                stream.skip(nameLength * sizeof(wchar_t));
             }
 
             unsigned int propertyCount;
-            ::ReadFile(fileHandle, &propertyCount, sizeof(unsigned int), &bytesRead, NULL);
+            stream.readStream((BYTE*)&propertyCount, sizeof(unsigned int));
 
 
             if (propertyCount == 0) // ignore the objects which doesn't have properties.
             {
-                if (objectName)
+                if (objectName && !arena)
                     ::free(objectName);
 
                 continue;
             }
 
-            KPSObject* psObject = new KPSObject();
+            KPSObject* psObject = arena ? arena->create<KPSArenaObject>() : new KPSObject();
             psObject->objectID = objectID;
             psObject->nameLength = nameLength;
             psObject->name = objectName;
 
             for (unsigned int propertyIndex = 0; propertyIndex < propertyCount; ++propertyIndex)
             {
-                KPSProperty* psProperty = new KPSProperty();
-
-                ::ReadFile(fileHandle, &psProperty->nameLength, sizeof(int), &bytesRead, NULL);
+                // destructor of an arena property has nothing to free. so it is not registered to the arena.
+                KPSProperty* psProperty = arena ? new (arena->allocate(sizeof(KPSProperty), alignof(KPSProperty))) KPSProperty() : new KPSProperty();
 
                 if (readNames)
                 {
-                    psProperty->name = (wchar_t*)::malloc(sizeof(wchar_t) * (psProperty->nameLength + 1));
-                    ::ReadFile(fileHandle, psProperty->name, sizeof(wchar_t) * psProperty->nameLength, &bytesRead, NULL);
-                    psProperty->name[psProperty->nameLength] = 0;
+                    readString(&psProperty->nameLength, &psProperty->name);
                 }
                 else // ignore name
                 {
-                    ::SetFilePointer(fileHandle, psProperty->nameLength * sizeof(wchar_t), 0, FILE_CURRENT);
+                    stream.readStream((BYTE*)&psProperty->nameLength, sizeof(int));
+                    stream.skip(psProperty->nameLength * sizeof(wchar_t));
                 }
 
-                ::ReadFile(fileHandle, &psProperty->type, sizeof(int), &bytesRead, NULL);
+                stream.readStream((BYTE*)&psProperty->type, sizeof(int));
 
                 if (psProperty->type == KPSPropertyTypes::STRING) // string
                 {
-                    ::ReadFile(fileHandle, &psProperty->strValueLength, sizeof(int), &bytesRead, NULL);
-                    psProperty->strValue = (wchar_t*)::malloc(sizeof(wchar_t) * (psProperty->strValueLength + 1));
-                    ::ReadFile(fileHandle, psProperty->strValue, sizeof(wchar_t) * psProperty->strValueLength, &bytesRead, NULL);
-                    psProperty->strValue[psProperty->strValueLength] = 0;
+                    readString(&psProperty->strValueLength, &psProperty->strValue);
                 }
                 else if (psProperty->type == KPSPropertyTypes::INTEGER) // int
                 {
-                    ::ReadFile(fileHandle, &psProperty->intValue, sizeof(int), &bytesRead, NULL);
+                    stream.readStream((BYTE*)&psProperty->intValue, sizeof(int));
                 }
                 else if (psProperty->type == KPSPropertyTypes::DWORD) // DWORD
                 {
-                    ::ReadFile(fileHandle, &psProperty->dwordValue, sizeof(DWORD), &bytesRead, NULL);
+                    stream.readStream((BYTE*)&psProperty->dwordValue, sizeof(DWORD));
                 }
                 else if (psProperty->type == KPSPropertyTypes::FLOAT) // float
                 {
-                    ::ReadFile(fileHandle, &psProperty->floatValue, sizeof(float), &bytesRead, NULL);
+                    stream.readStream((BYTE*)&psProperty->floatValue, sizeof(float));
                 }
                 else if (psProperty->type == KPSPropertyTypes::INT_ARRAY) // int array
                 {
-                    ::ReadFile(fileHandle, &psProperty->intArraySize, sizeof(int), &bytesRead, NULL);
+                    stream.readStream((BYTE*)&psProperty->intArraySize, sizeof(int));
                     if (psProperty->intArraySize)
                     {
-                        psProperty->intArray = (int*)::malloc(sizeof(int) * psProperty->intArraySize);
-                        ::ReadFile(fileHandle, psProperty->intArray, sizeof(int) * psProperty->intArraySize, &bytesRead, NULL);
+                        psProperty->intArray = (int*)allocate(sizeof(int) * psProperty->intArraySize);
+                        stream.readStream((BYTE*)psProperty->intArray, sizeof(int) * psProperty->intArraySize);
                     }
                 }
                 else if (psProperty->type == KPSPropertyTypes::GUID) // guid
                 {
-                    ::ReadFile(fileHandle, &psProperty->guidValue, sizeof(GUID), &bytesRead, NULL);
+                    stream.readStream((BYTE*)&psProperty->guidValue, sizeof(GUID));
                 }
                 else // file
                 {
-                    ::ReadFile(fileHandle, &psProperty->fileNameLength, sizeof(int), &bytesRead, NULL);
-                    psProperty->fileName = (wchar_t*)::malloc(sizeof(wchar_t) * (psProperty->fileNameLength + 1));
-                    ::ReadFile(fileHandle, psProperty->fileName, sizeof(wchar_t) * psProperty->fileNameLength, &bytesRead, NULL);
-                    psProperty->fileName[psProperty->fileNameLength] = 0;
-                    ::ReadFile(fileHandle, &psProperty->fileDataSize, sizeof(DWORD), &bytesRead, NULL);
+                    readString(&psProperty->fileNameLength, &psProperty->fileName);
+                    stream.readStream((BYTE*)&psProperty->fileDataSize, sizeof(DWORD));
                     if (psProperty->fileDataSize)
                     {
-                        psProperty->fileData = (unsigned char*)::malloc(psProperty->fileDataSize);
-                        ::ReadFile(fileHandle, psProperty->fileData, psProperty->fileDataSize, &bytesRead, NULL);
+                        psProperty->fileData = (unsigned char*)allocate(psProperty->fileDataSize);
+                        stream.readStream((BYTE*)psProperty->fileData, psProperty->fileDataSize);
                     }
                 }
 
@@ -479,17 +513,478 @@ public:
             psObjectList->add(psObject);
         }
 
-        ::CloseHandle(fileHandle);
         return true;
     }
 
     virtual ~KPSReader() noexcept
     {
-        if (psObjectList)
+        clear();
+    }
+};
+
+// PS02 layout. (little endian)
+// header : char[4] "PS02" | unsigned int objectCount | unsigned int reserved[2]
+// table  : objectCount x KPSTableEntry, sorted by the bytes of objectID. (binary searchable)
+// object : int nameLength | wchar_t name[nameLength] | properties
+//          properties are same as PS01, except FILE stores uint64_t fileDataOffset instead of the data.
+// blobs  : data of the FILE properties.
+
+struct KPSTableEntry
+{
+    GUID objectID;
+    unsigned int propertyCount;
+    unsigned int objectSize; // bytes of the object record
+    uint64_t objectOffset; // from the start of the file
+};
+
+/**
+    Random access reader for PS02 files.
+    Opening maps the file and touches only the header & the table. An object is parsed when it is requested
+    for the first time. FILE property data is not copied. fileData points into the mapped file, so it is read
+    from the disk only when it is accessed. (read only. valid until the reader is closed)
+*/
+class KPSIndexedReader
+{
+protected:
+    // fileData belongs to the mapped file.
+    class KPSMappedProperty : public KPSProperty
+    {
+    public:
+        ~KPSMappedProperty() noexcept
         {
-            psObjectList->deleteAll();
-            delete psObjectList;
+            fileData = NULL;
+        }
+    };
+
+    KMappedFile mappedFile;
+    const KPSTableEntry* table;
+    unsigned int objectCount;
+    KPSObject** loadedObjects; // parsed objects by table index
+
+    KPSObject* loadObject(unsigned int index) noexcept
+    {
+        const KPSTableEntry* entry = &table[index];
+        const BYTE* fileData = mappedFile.getData();
+        const size_t fileSize = mappedFile.getSize();
+
+        if ((entry->objectOffset > fileSize) || (entry->objectSize > (fileSize - entry->objectOffset)))
+            return NULL;
+
+        const BYTE* position = fileData + entry->objectOffset;
+        const BYTE* end = position + entry->objectSize;
+
+        auto read = [&](void* buffer, size_t size) -> bool {
+            if (size > (size_t)(end - position))
+                return false;
+
+            ::memcpy(buffer, position, size);
+            position += size;
+            return true;
+        };
+
+        auto readString = [&](int* length, wchar_t** text) -> bool {
+            if (!read(length, sizeof(int)) || (*length < 0) || (((size_t)*length * sizeof(wchar_t)) > (size_t)(end - position)))
+                return false;
+
+            *text = (wchar_t*)::malloc(sizeof(wchar_t) * (*length + 1));
+            read(*text, sizeof(wchar_t) * *length);
+            (*text)[*length] = 0;
+            return true;
+        };
+
+        KPSObject* psObject = new KPSObject();
+        psObject->objectID = entry->objectID;
+
+        bool success = readString(&psObject->nameLength, &psObject->name);
+
+        for (unsigned int propertyIndex = 0; success && (propertyIndex < entry->propertyCount); ++propertyIndex)
+        {
+            KPSProperty* psProperty = new KPSMappedProperty();
+            psObject->propertyList.add(psProperty);
+
+            success = readString(&psProperty->nameLength, &psProperty->name) &&
+                read(&psProperty->type, sizeof(int));
+
+            if (!success)
+                break;
+
+            if (psProperty->type == KPSPropertyTypes::STRING)
+            {
+                success = readString(&psProperty->strValueLength, &psProperty->strValue);
+            }
+            else if (psProperty->type == KPSPropertyTypes::INTEGER)
+            {
+                success = read(&psProperty->intValue, sizeof(int));
+            }
+            else if (psProperty->type == KPSPropertyTypes::DWORD)
+            {
+                success = read(&psProperty->dwordValue, sizeof(DWORD));
+            }
+            else if (psProperty->type == KPSPropertyTypes::FLOAT)
+            {
+                success = read(&psProperty->floatValue, sizeof(float));
+            }
+            else if (psProperty->type == KPSPropertyTypes::INT_ARRAY)
+            {
+                success = read(&psProperty->intArraySize, sizeof(int)) && (psProperty->intArraySize >= 0) &&
+                    (((size_t)psProperty->intArraySize * sizeof(int)) <= (size_t)(end - position));
+
+                if (success && psProperty->intArraySize)
+                {
+                    psProperty->intArray = (int*)::malloc(sizeof(int) * psProperty->intArraySize);
+                    success = read(psProperty->intArray, sizeof(int) * psProperty->intArraySize);
+                }
+            }
+            else if (psProperty->type == KPSPropertyTypes::GUID)
+            {
+                success = read(&psProperty->guidValue, sizeof(GUID));
+            }
+            else // file
+            {
+                uint64_t fileDataOffset = 0;
+                success = readString(&psProperty->fileNameLength, &psProperty->fileName) &&
+                    read(&psProperty->fileDataSize, sizeof(DWORD)) && read(&fileDataOffset, sizeof(uint64_t)) &&
+                    (fileDataOffset <= fileSize) && (psProperty->fileDataSize <= (fileSize - fileDataOffset));
+
+                if (success && psProperty->fileDataSize)
+                    psProperty->fileData = (unsigned char*)(fileData + fileDataOffset);
+            }
+        }
+
+        if (!success) // corrupted file
+        {
+            delete psObject;
+            return NULL;
+        }
+
+        return psObject;
+    }
+
+public:
+    KPSIndexedReader() noexcept
+    {
+        table = NULL;
+        objectCount = 0;
+        loadedObjects = NULL;
+    }
+
+    bool openFile(const wchar_t* path) noexcept
+    {
+        closeFile();
+
+        if (!mappedFile.openFile(path))
+            return false;
+
+        const BYTE* fileData = mappedFile.getData();
+        const size_t fileSize = mappedFile.getSize();
+
+        const char psFileHeader[4] = PS_V2_HEADER;
+        unsigned int count = 0;
+
+        if ((fileSize < 16) || (::memcmp(fileData, psFileHeader, 4) != 0))
+        {
+            mappedFile.closeFile();
+            return false;
+        }
+
+        ::memcpy(&count, fileData + 4, sizeof(unsigned int));
+
+        if ((count == 0) || (count > ((fileSize - 16) / sizeof(KPSTableEntry))))
+        {
+            mappedFile.closeFile();
+            return false;
+        }
+
+        table = (const KPSTableEntry*)(fileData + 16);
+        objectCount = count;
+        loadedObjects = (KPSObject**)::calloc(objectCount, sizeof(KPSObject*));
+
+        return true;
+    }
+
+    void closeFile() noexcept
+    {
+        if (loadedObjects)
+        {
+            for (unsigned int i = 0; i < objectCount; i++)
+            {
+                if (loadedObjects[i])
+                    delete loadedObjects[i];
+            }
+
+            ::free(loadedObjects);
+            loadedObjects = NULL;
         }
+
+        table = NULL;
+        objectCount = 0;
+        mappedFile.closeFile();
+    }
+
+    unsigned int getObjectCount() noexcept
+    {
+        return objectCount;
+    }
+
+    // returns NULL if the index is out of range.
+    const GUID* getObjectID(unsigned int index) noexcept
+    {
+        return (index < objectCount) ? &table[index].objectID : NULL;
     }
+
+    // binary search on the table. returns -1 if not found.
+    int findObject(const GUID& objectID) noexcept
+    {
+        int low = 0;
+        int high = (int)objectCount - 1;
+
+        while (low <= high)
+        {
+            const int middle = low + ((high - low) / 2);
+            const int result = ::memcmp(&table[middle].objectID, &objectID, sizeof(GUID));
+
+            if (result == 0)
+                return middle;
+            else if (result < 0)
+                low = middle + 1;
+            else
+                high = middle - 1;
+        }
+
+        return -1;
+    }
+
+    // do not free returned object. returns NULL if the index is out of range or the object is corrupted.
+    KPSObject* getPSObjectAt(unsigned int index) noexcept
+    {
+        if (index >= objectCount)
+            return NULL;
+
+        if (loadedObjects[index] == NULL)
+            loadedObjects[index] = loadObject(index);
+
+        return loadedObjects[index];
+    }
+
+    // do not free returned object.
+    KPSObject* getPSObject(const GUID& objectID) noexcept
+    {
+        const int index = findObject(objectID);
+        return (index == -1) ? NULL : getPSObjectAt((unsigned int)index);
+    }
+
+    virtual ~KPSIndexedReader() noexcept
+    {
+        closeFile();
+    }
+
+    // no copy/movable
+    KPSIndexedReader(const KPSIndexedReader&) = delete;
+    KPSIndexedReader& operator=(const KPSIndexedReader&) = delete;
+    KPSIndexedReader(KPSIndexedReader&&) = delete;
+    KPSIndexedReader& operator=(KPSIndexedReader&&) = delete;
 };
 
+// Writes PS02 files.
+class KPSIndexedWriter
+{
+protected:
+    // PS01 reader reads unknown types as FILE.
+    static bool isFileProperty(KPSProperty* psProperty) noexcept
+    {
+        return (psProperty->type < KPSPropertyTypes::STRING) || (psProperty->type > KPSPropertyTypes::GUID);
+    }
+
+    static uint64_t getObjectSize(KPSObject* psObject) noexcept
+    {
+        uint64_t size = sizeof(int) + (psObject->name ? (sizeof(wchar_t) * psObject->nameLength) : 0);
+
+        for (int i = 0; i < psObject->propertyList.size(); i++)
+        {
+            KPSProperty* psProperty = psObject->propertyList.get(i);
+            size += sizeof(int) + (psProperty->name ? (sizeof(wchar_t) * psProperty->nameLength) : 0) + sizeof(int);
+
+            if (psProperty->type == KPSPropertyTypes::STRING)
+                size += sizeof(int) + (psProperty->strValue ? (sizeof(wchar_t) * psProperty->strValueLength) : 0);
+            else if (psProperty->type == KPSPropertyTypes::INTEGER)
+                size += sizeof(int);
+            else if (psProperty->type == KPSPropertyTypes::DWORD)
+                size += sizeof(DWORD);
+            else if (psProperty->type == KPSPropertyTypes::FLOAT)
+                size += sizeof(float);
+            else if (psProperty->type == KPSPropertyTypes::INT_ARRAY)
+                size += sizeof(int) + (psProperty->intArray ? (sizeof(int) * psProperty->intArraySize) : 0);
+            else if (psProperty->type == KPSPropertyTypes::GUID)
+                size += sizeof(GUID);
+            else // file
+                size += sizeof(int) + (psProperty->fileName ? (sizeof(wchar_t) * psProperty->fileNameLength) : 0) + sizeof(DWORD) + sizeof(uint64_t);
+        }
+
+        return size;
+    }
+
+public:
+    /**
+        Objects without properties are not written. (PS01 reader ignores them too)
+        Names which are not loaded are written as empty.
+    */
+    static bool saveToFile(const wchar_t* path, KPointerList<KPSObject*, 16, false>* psObjectList) noexcept
+    {
+        if ((psObjectList == NULL) || (psObjectList->size() == 0))
+            return false;
+
+        KPSObject** objects = (KPSObject**)::malloc(sizeof(KPSObject*) * psObjectList->size());
+        unsigned int objectCount = 0;
+
+        for (int i = 0; i < psObjectList->size(); i++)
+        {
+            KPSObject* psObject = psObjectList->get(i);
+            if (psObject->propertyList.size())
+                objects[objectCount++] = psObject;
+        }
+
+        if (objectCount == 0)
+        {
+            ::free(objects);
+            return false;
+        }
+
+        ::qsort(objects, objectCount, sizeof(KPSObject*), [](const void* a, const void* b) -> int {
+            return ::memcmp(&(*(KPSObject**)a)->objectID, &(*(KPSObject**)b)->objectID, sizeof(GUID));
+        });
+
+        uint64_t blobOffset = 16 + ((uint64_t)sizeof(KPSTableEntry) * objectCount);
+        for (unsigned int i = 0; i < objectCount; i++)
+        {
+            const uint64_t objectSize = getObjectSize(objects[i]);
+            if (objectSize > 0xFFFFFFFF)
+            {
+                ::free(objects);
+                return false;
+            }
+
+            blobOffset += objectSize;
+        }
+
+        KFile::deleteFile(path); // openFile does not truncate
+        KFile file;
+        if (!file.openFile(path, KFile::KWRITE))
+        {
+            ::free(objects);
+            return false;
+        }
+
+        bool success = true;
+        KBufferedStream stream(&file);
+
+        auto write = [&](const void* buffer, DWORD size) {
+            if (success && size)
+                success = stream.writeStream((const BYTE*)buffer, size);
+        };
+
+        auto writeString = [&](const wchar_t* text, int length) {
+            if (text == NULL)
+                length = 0;
+
+            write(&length, sizeof(int));
+            write(text, sizeof(wchar_t) * length);
+        };
+
+        const char psFileHeader[4] = PS_V2_HEADER;
+        const unsigned int reserved[2] = { 0, 0 };
+        write(psFileHeader, 4);
+        write(&objectCount, sizeof(unsigned int));
+        write(reserved, sizeof(reserved));
+
+        uint64_t objectOffset = 16 + ((uint64_t)sizeof(KPSTableEntry) * objectCount);
+        for (unsigned int i = 0; i < objectCount; i++)
+        {
+            KPSTableEntry entry;
+            entry.objectID = objects[i]->objectID;
+            entry.propertyCount = (unsigned int)objects[i]->propertyList.size();
+            entry.objectSize = (unsigned int)getObjectSize(objects[i]);
+            entry.objectOffset = objectOffset;
+            write(&entry, sizeof(KPSTableEntry));
+
+            objectOffset += entry.objectSize;
+        }
+
+        for (unsigned int i = 0; i < objectCount; i++)
+        {
+            KPSObject* psObject = objects[i];
+            writeString(psObject->name, psObject->nameLength);
+
+            for (int j = 0; j < psObject->propertyList.size(); j++)
+            {
+                KPSProperty* psProperty = psObject->propertyList.get(j);
+                writeString(psProperty->name, psProperty->nameLength);
+                write(&psProperty->type, sizeof(int));
+
+                if (psProperty->type == KPSPropertyTypes::STRING)
+                {
+                    writeString(psProperty->strValue, psProperty->strValueLength);
+                }
+                else if (psProperty->type == KPSPropertyTypes::INTEGER)
+                {
+                    write(&psProperty->intValue, sizeof(int));
+                }
+                else if (psProperty->type == KPSPropertyTypes::DWORD)
+                {
+                    write(&psProperty->dwordValue, sizeof(DWORD));
+                }
+                else if (psProperty->type == KPSPropertyTypes::FLOAT)
+                {
+                    write(&psProperty->floatValue, sizeof(float));
+                }
+                else if (psProperty->type == KPSPropertyTypes::INT_ARRAY)
+                {
+                    const int intArraySize = psProperty->intArray ? psProperty->intArraySize : 0;
+                    write(&intArraySize, sizeof(int));
+                    write(psProperty->intArray, sizeof(int) * intArraySize);
+                }
+                else if (psProperty->type == KPSPropertyTypes::GUID)
+                {
+                    write(&psProperty->guidValue, sizeof(GUID));
+                }
+                else // file
+                {
+                    const DWORD fileDataSize = psProperty->fileData ? psProperty->fileDataSize : 0;
+                    writeString(psProperty->fileName, psProperty->fileNameLength);
+                    write(&fileDataSize, sizeof(DWORD));
+                    write(&blobOffset, sizeof(uint64_t));
+
+                    blobOffset += fileDataSize;
+                }
+            }
+        }
+
+        // blobs. same order as the FILE properties above.
+        for (unsigned int i = 0; i < objectCount; i++)
+        {
+            KPSObject* psObject = objects[i];
+            for (int j = 0; j < psObject->propertyList.size(); j++)
+            {
+                KPSProperty* psProperty = psObject->propertyList.get(j);
+                if (isFileProperty(psProperty) && psProperty->fileData)
+                    write(psProperty->fileData, psProperty->fileDataSize);
+            }
+        }
+
+        ::free(objects);
+
+        if (!stream.flush())
+            success = false;
+
+        return success;
+    }
+
+    // loads a PS01 file and writes it as PS02.
+    static bool convertFromPS01(const wchar_t* ps01Path, const wchar_t* ps02Path) noexcept
+    {
+        KPSReader reader;
+        if (!reader.loadFromFile(ps01Path, true, true)) // only read. so the arena mode is enough
+            return false;
+
+        return saveToFile(ps02Path, reader.psObjectList);
+    }
+};
@@ -27,10 +27,7 @@ KSettingsReader::KSettingsReader(KStream* stream) noexcept : streamPtr(stream) {
 
 bool KSettingsReader::openFile(const wchar_t* fileName, int formatID) noexcept
 {
-	if (!KFile::isFileExists(fileName))
-		return false;
-
-	if (!settingsFile.openFile(fileName, KFile::KREAD))
+	if (!settingsFile.openFile(fileName))
 		return false;
 
 	streamPtr = &settingsFile;
@@ -24,6 +24,7 @@
 #include "../core/CoreModule.h"
 #include "KStream.h"
 #include "KFile.h"
+#include "KMappedFile.h"
 
 /**
 	High performance configuration reading class.
@@ -31,7 +32,7 @@
 class KSettingsReader
 {
 protected:
-	KFile settingsFile;
+	KMappedFile settingsFile; // fields are read straight from the mapped view
 	KStream* streamPtr;
 public:
 	KSettingsReader() noexcept;
@@ -27,13 +27,16 @@ KSettingsWriter::KSettingsWriter(KStream* stream) noexcept : streamPtr(stream){}
 
 bool KSettingsWriter::openFile(const wchar_t* fileName, int formatID) noexcept
 {
+	bufferedStream.setStream(nullptr); // writes the remaining data of the previous file
+
 	if (KFile::isFileExists(fileName))
 		KFile::deleteFile(fileName);
 
 	if (!settingsFile.openFile(fileName, KFile::KWRITE))
 		return false;
 
-	streamPtr = &settingsFile;
+	bufferedStream.setStream(&settingsFile);
+	streamPtr = &bufferedStream;
 	return streamPtr->writeStream((BYTE*)&formatID, sizeof(int));
 }
 
@@ -91,6 +94,11 @@ void KSettingsWriter::writeBool(bool value) noexcept
 		streamPtr->writeStream((BYTE*)&value, sizeof(bool));
 }
 
+bool KSettingsWriter::flush() noexcept
+{
+	return (streamPtr == &bufferedStream) ? bufferedStream.flush() : true;
+}
+
 KSettingsWriter::~KSettingsWriter() noexcept
 {
 
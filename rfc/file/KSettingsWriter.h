@@ -24,6 +24,7 @@
 #include "../core/CoreModule.h"
 #include "KStream.h"
 #include "KFile.h"
+#include "KBufferedStream.h"
 
 /**
 	High performance configuration writing class.
@@ -32,6 +33,7 @@ class KSettingsWriter
 {
 protected:
 	KFile settingsFile;
+	KBufferedStream bufferedStream; // collects small writes. declared after the file, so it is flushed before the file is closed.
 	KStream* streamPtr;
 public:
 	KSettingsWriter() noexcept;
@@ -69,6 +71,11 @@ public:
 
 	void writeBool(bool value) noexcept;
 
+	/**
+		Writes the buffered data into the file. Also done by the destructor.
+	*/
+	bool flush() noexcept;
+
 	~KSettingsWriter() noexcept;
 
 private:
@@ -29,6 +29,16 @@ public:
 	virtual bool readStream(BYTE* buffer, DWORD bytesToRead) noexcept = 0;
 	virtual bool writeStream(const BYTE* buffer, DWORD bytesToWrite) noexcept = 0;
 
+	/**
+		Reads at most maxBytesToRead bytes. Used by buffering streams to read ahead.
+		Default implementation can only read the exact size. Override it if the stream can read less.
+		@returns number of bytes read. zero at the end of the stream or on error.
+	*/
+	virtual DWORD readStreamUpTo(BYTE* buffer, DWORD maxBytesToRead) noexcept
+	{
+		return readStream(buffer, maxBytesToRead) ? maxBytesToRead : 0;
+	}
+
 	KStream() noexcept = default;
 	virtual ~KStream() noexcept = default;
 };
@@ -21,6 +21,5 @@
 
 #include "KFont.h"
 
-KFontCache::Entry KFontCache::entries[KFontCache::MAX_ENTRIES];
-int KFontCache::count = 0;
+KHashMap<KFontCache::Key, KFontHandle*, 32, false> KFontCache::entries;
 
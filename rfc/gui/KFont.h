@@ -22,6 +22,7 @@
 #pragma once
 
 #include "../core/CoreModule.h"
+#include "../containers/ContainersModule.h"
 
 // copy supported font definition.
 class KFontType
@@ -100,15 +101,26 @@ public:
 class KFontCache
 {
 private:
-	struct Entry {
+	struct Key {
 		KFontType type;
 		int dpi;
-		KFontHandle* handle;
+
+		bool operator==(const Key& other) const noexcept
+		{
+			return (dpi == other.dpi) && type.compare(other.type);
+		}
+
+		size_t hashCode() const noexcept
+		{
+			const uint64_t flags = (type.isBold ? 1 : 0) | (type.isItalic ? 2 : 0) | (type.isUnderline ? 4 : 0) |
+				(type.isAntiAliased ? 8 : 0) | (type.isVertical ? 16 : 0);
+
+			return type.fontFace.hashCode() ^
+				KHash::hashInteger(((uint64_t)(uint32_t)type.fontSize << 32) | ((uint64_t)(uint16_t)dpi << 8) | flags);
+		}
 	};
 
-	static constexpr int MAX_ENTRIES = 20;
-	static Entry entries[MAX_ENTRIES];
-	static int count;
+	static KHashMap<Key, KFontHandle*, 32, false> entries;
 
 	static KFontHandle* createFontHandle(const KFontType& type, int dpi) noexcept
 	{
@@ -137,27 +149,19 @@ public:
 
 	static KFontHandle* getFontHandle(const KFontType& type, int dpi) noexcept
 	{
-		// search
-		for (int i = 0; i < count; ++i)
+		const Key key = { type, dpi };
+
+		KFontHandle** cachedHandle = entries.find(key);
+		if (cachedHandle)
 		{
-			if (entries[i].dpi == dpi && entries[i].type.compare(type))
-			{
-				entries[i].handle->addRef();
-				return entries[i].handle;
-			}
+			(*cachedHandle)->addRef();
+			return *cachedHandle;
 		}
 
 		// not found, let's create!
 		KFontHandle* handle = createFontHandle(type, dpi);
 
-		// cache is full. we don't store
-		if (count >= MAX_ENTRIES)
-		{
-			DEBUG_PRINT("KFontCache is full!");
-			return handle;
-		}
-
-		entries[count++] = { type, dpi, handle };
+		entries.put(key, handle);
 		handle->addRef();
 		return handle;
 	}
@@ -165,11 +169,10 @@ public:
 	// call to remove unused fonts or at framework shutdown.
 	static void cleanup() noexcept
 	{
-		for (int i = 0; i < count; ++i)
-		{
-			entries[i].handle->release();
-		}
-		count = 0;
+		entries.forEach([](const Key&, KFontHandle*& handle) {
+			handle->release();
+		});
+		entries.removeAll();
 	}
 };
 
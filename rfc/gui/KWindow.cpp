@@ -127,9 +127,9 @@ bool KWindow::create(bool requireInitialMessages) noexcept
 				const int dpi_2 = KDPIUtility::getWindowDPI(compHWND);
 				if (dpi_2 != USER_DEFAULT_SCREEN_DPI)
 				{
-					for (int i = 0; i < componentList.size(); i++)
+					for (KComponent* component : componentList)
 					{
-						componentList[i]->setDPI(dpi_2);
+						component->setDPI(dpi_2);
 					}
 				}
 			}
@@ -611,9 +611,9 @@ LRESULT KWindow::windowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) n
 				this->updateWindowIconForNewDPI();
 				::InvalidateRect(compHWND, NULL, TRUE);
 
-				for (int i = 0; i < componentList.size(); i++)
+				for (KComponent* component : componentList)
 				{
-					componentList[i]->setDPI(newDPI);
+					component->setDPI(newDPI);
 				}
 
 				if (onDPIChange)
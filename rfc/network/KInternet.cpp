@@ -25,6 +25,8 @@
 #include "KInternet.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
 
 KInternet::KInternet() noexcept {}
 
@@ -83,41 +85,29 @@ KString KInternet::urlEncodeString(const KString &text) noexcept
 	if (text.length() == 0)
 		return KString();
 
-	KString new_str;
-	char c;
-	int ic;
+	KStringBuilder builder;
 	char* chars = KString::toUTF8String(text);
-	char bufHex[10];
-	int len = text.length();
+	const int len = (int)::strlen(chars);
 
 	for (int i = 0; i < len; i++)
 	{
-		c = chars[i];
-		ic = c;
+		const unsigned char c = (unsigned char)chars[i];
 
 		if (c == ' ')
 		{
-			new_str = new_str.appendStaticText(L"+", 1, true);
+			builder.appendChar(L'+');
 		}
 		else if (::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
-		{		
-			char tmp[] = { c, 0 };
-			new_str = new_str.append(KString(tmp));
+		{
+			builder.appendChar((wchar_t)c);
 		}
 		else
 		{
-			::sprintf_s(bufHex, 10, "%X", c);
-
-			if (ic < 16)
-				new_str = new_str.appendStaticText(L"%0", 2, true);
-			else
-				new_str = new_str.appendStaticText(L"%", 1, true);
-
-			new_str = new_str.append(KString(bufHex));
+			builder.appendFormat(L"%%%02X", c);
 		}
 	}
 	::free(chars);
-	return new_str;
+	return builder.toString();
 }
 
 KString KInternet::urlDecodeString(const KString &text) noexcept
@@ -125,40 +115,35 @@ KString KInternet::urlDecodeString(const KString &text) noexcept
 	if (text.length() == 0)
 		return KString();
 
-	KString ret;
 	char* str = KString::toUTF8String(text);
+	const int len = (int)::strlen(str);
 
-	char ch;
-	int i, ii, len = text.length();
+	// decode into bytes first. escaped sequences can form multi-byte utf-8 characters.
+	char* decoded = (char*)::malloc((size_t)len + 1);
+	int decodedLength = 0;
 
-	for (i = 0; i < len; i++)
+	for (int i = 0; i < len; i++)
 	{
-		if (str[i] != '%')
+		if (str[i] == '+')
 		{
-			if (str[i] == '+')
-			{
-				ret = ret.appendStaticText(L" ", 1, true);
-			}
-			else
-			{
-				char tmp[] = { str[i], 0 };
-				ret = ret.append(KString(tmp));
-			}
+			decoded[decodedLength++] = ' ';
 		}
-		else
+		else if ((str[i] == '%') && ((i + 2) < len) && ::isxdigit((unsigned char)str[i + 1]) && ::isxdigit((unsigned char)str[i + 2]))
 		{
-			char* sub = KString::toUTF8String(text.subString(i + 1, i + 2));
-			::sscanf_s(sub, "%x", &ii);
-			ch = static_cast<char>(ii);
-
-			char tmp[] = { ch, 0 };
-			ret = ret.append(KString(tmp));
-
-			::free(sub);
-
+			const char hex[3] = { str[i + 1], str[i + 2], 0 };
+			decoded[decodedLength++] = (char)::strtol(hex, nullptr, 16);
 			i = i + 2;
 		}
+		else
+		{
+			decoded[decodedLength++] = str[i];
+		}
 	}
+	decoded[decodedLength] = 0;
+
+	KString ret(decoded);
+
+	::free(decoded);
 	::free(str);
 	return ret;
 }
@@ -206,26 +191,47 @@ KString KInternet::sendRequest(const wchar_t* url,
 
 	if (resultOK)
 	{
+		// collect raw bytes and convert once at the end. chunk boundaries can split utf-8 sequences,
+		// and converting + concatenating per chunk is quadratic on large responses.
+		char* responseData = nullptr;
+		size_t responseSize = 0;
+		size_t responseCapacity = 0;
+
 		DWORD dwSize = 0;
 		DWORD dwDownloaded = 0;
 
 		do
 		{
 			dwSize = 0;
-			if (::WinHttpQueryDataAvailable(hRequest, &dwSize))
+			if (::WinHttpQueryDataAvailable(hRequest, &dwSize) && (dwSize > 0))
 			{
-				char* outBuffer = new char[dwSize + 1];
-				::ZeroMemory(outBuffer, dwSize + 1);
-
-				if (::WinHttpReadData(hRequest, (LPVOID)outBuffer, dwSize, &dwDownloaded))
+				if ((responseSize + dwSize + 1) > responseCapacity) // grow geometrically
 				{
-					receivedText = receivedText + KString(outBuffer);
+					size_t newCapacity = responseCapacity ? (responseCapacity * 2) : 8192;
+					if (newCapacity < (responseSize + dwSize + 1))
+						newCapacity = responseSize + dwSize + 1;
+
+					char* newData = (char*)::realloc(responseData, newCapacity);
+					if (newData == nullptr)
+						break;
+
+					responseData = newData;
+					responseCapacity = newCapacity;
 				}
 
-				delete[] outBuffer;
+				dwDownloaded = 0;
+				if (::WinHttpReadData(hRequest, (LPVOID)(responseData + responseSize), dwSize, &dwDownloaded))
+					responseSize += dwDownloaded;
 			}
 
 		} while (dwSize > 0);
+
+		if (responseData)
+		{
+			responseData[responseSize] = 0;
+			receivedText = KString(responseData);
+			::free(responseData);
+		}
 	}
 
 	if (hRequest)
@@ -0,0 +1,728 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	#include <intrin.h>
+#endif
+
+#ifdef RFC_STRING_SIMD
+	#include <emmintrin.h>
+	#include <immintrin.h>
+
+	// msvc accepts avx2 intrinsics in any function. gcc and clang need them to be marked.
+	#if defined(__GNUC__) || defined(__clang__)
+		#define RFC_XXH3_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define RFC_XXH3_TARGET_AVX2
+	#endif
+#endif
+
+struct KHash128
+{
+	uint64_t low;
+	uint64_t high;
+
+	bool operator==(const KHash128& other) const noexcept
+	{
+		return (low == other.low) && (high == other.high);
+	}
+
+	bool operator!=(const KHash128& other) const noexcept
+	{
+		return !(*this == other);
+	}
+};
+
+/**
+	XXH3 64 and 128 bit hashes. Results are same as XXH3_64bits_withSeed and XXH3_128bits_withSeed
+	of the reference implementation on little-endian cpus.
+
+	Inputs longer than 240 bytes are processed in 64 byte stripes with SSE2 or AVX2. The instruction set
+	is selected at runtime by KStringKernels::getSIMDLevel, so RFC_NO_STRING_SIMD also disables it here.
+	Shorter inputs use a few 64 bit multiplications and have no vector version.
+
+	hash64Batch hashes many independent keys in one call. Short keys have no loop carried dependency,
+	so the cpu overlaps the multiplications of neighbouring keys.
+
+	e.g. @code
+	const uint64_t result = KXXHash3::hash64(data, length);
+	const KHash128 result2 = KXXHash3::hash128(data, length, seed);
+	@endcode
+*/
+class KXXHash3
+{
+protected:
+	static const uint64_t Prime32_1 = 0x9E3779B1U;
+	static const uint64_t Prime32_2 = 0x85EBCA77U;
+	static const uint64_t Prime32_3 = 0xC2B2AE3DU;
+	static const uint64_t Prime64_1 = 0x9E3779B185EBCA87ULL;
+	static const uint64_t Prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+	static const uint64_t Prime64_3 = 0x165667B19E3779F9ULL;
+	static const uint64_t Prime64_4 = 0x85EBCA77C2B2AE63ULL;
+	static const uint64_t Prime64_5 = 0x27D4EB2F165667C5ULL;
+	static const uint64_t PrimeMx1 = 0x165667919E3779F9ULL;
+	static const uint64_t PrimeMx2 = 0x9FB21C651E98DF25ULL;
+
+	static const size_t SecretSize = 192;
+	static const size_t StripeLength = 64;
+	static const size_t SecretConsumeRate = 8;
+	static const size_t StripesPerBlock = (SecretSize - StripeLength) / SecretConsumeRate;
+	static const size_t BlockLength = StripeLength * StripesPerBlock;
+	static const size_t MidSizeMax = 240;
+
+	static const unsigned char* getDefaultSecret() noexcept
+	{
+		alignas(64) static const unsigned char secret[SecretSize] = {
+			0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+			0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+			0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+			0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+			0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+			0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+			0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+			0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+			0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+			0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+			0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+			0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+		};
+		return secret;
+	}
+
+	static inline uint64_t read64(const unsigned char* data) noexcept
+	{
+		uint64_t value;
+		::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static inline uint32_t read32(const unsigned char* data) noexcept
+	{
+		uint32_t value;
+		::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static inline uint64_t swap64(uint64_t x) noexcept
+	{
+		x = ((x << 8) & 0xFF00FF00FF00FF00ULL) | ((x >> 8) & 0x00FF00FF00FF00FFULL);
+		x = ((x << 16) & 0xFFFF0000FFFF0000ULL) | ((x >> 16) & 0x0000FFFF0000FFFFULL);
+		return (x << 32) | (x >> 32);
+	}
+
+	static inline uint32_t swap32(uint32_t x) noexcept
+	{
+		return ((x << 24) & 0xFF000000U) | ((x << 8) & 0x00FF0000U) | ((x >> 8) & 0x0000FF00U) | ((x >> 24) & 0x000000FFU);
+	}
+
+	static inline uint64_t rotateLeft(uint64_t x, int bits) noexcept
+	{
+		return (x << bits) | (x >> (64 - bits));
+	}
+
+	static inline uint32_t rotateLeft32(uint32_t x, int bits) noexcept
+	{
+		return (x << bits) | (x >> (32 - bits));
+	}
+
+	// full 128 bit product. returns low half.
+	static inline uint64_t multiply128(uint64_t left, uint64_t right, uint64_t* high) noexcept
+	{
+	#if defined(__SIZEOF_INT128__)
+		const unsigned __int128 product = (unsigned __int128)left * right;
+		*high = (uint64_t)(product >> 64);
+		return (uint64_t)product;
+	#elif defined(_MSC_VER) && defined(_M_X64)
+		return ::_umul128(left, right, high);
+	#elif defined(_MSC_VER) && defined(_M_ARM64)
+		*high = ::__umulh(left, right);
+		return left * right;
+	#else
+		const uint64_t lowLow = (left & 0xFFFFFFFF) * (right & 0xFFFFFFFF);
+		const uint64_t highLow = (left >> 32) * (right & 0xFFFFFFFF);
+		const uint64_t lowHigh = (left & 0xFFFFFFFF) * (right >> 32);
+		const uint64_t highHigh = (left >> 32) * (right >> 32);
+		const uint64_t cross = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + lowHigh;
+		*high = (highLow >> 32) + (cross >> 32) + highHigh;
+		return (cross << 32) | (lowLow & 0xFFFFFFFF);
+	#endif
+	}
+
+	static inline uint64_t multiplyFold64(uint64_t left, uint64_t right) noexcept
+	{
+		uint64_t high;
+		const uint64_t low = multiply128(left, right, &high);
+		return low ^ high;
+	}
+
+	static inline uint64_t xxh64Avalanche(uint64_t hash) noexcept
+	{
+		hash ^= hash >> 33;
+		hash *= Prime64_2;
+		hash ^= hash >> 29;
+		hash *= Prime64_3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	static inline uint64_t avalanche(uint64_t hash) noexcept
+	{
+		hash ^= hash >> 37;
+		hash *= PrimeMx1;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	static inline uint64_t rrmxmx(uint64_t hash, uint64_t length) noexcept
+	{
+		hash ^= rotateLeft(hash, 49) ^ rotateLeft(hash, 24);
+		hash *= PrimeMx2;
+		hash ^= (hash >> 35) + length;
+		hash *= PrimeMx2;
+		hash ^= hash >> 28;
+		return hash;
+	}
+
+	static inline uint64_t mix16(const unsigned char* input, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		return multiplyFold64(read64(input) ^ (read64(secret) + seed), read64(input + 8) ^ (read64(secret + 8) - seed));
+	}
+
+	static inline void mix32(uint64_t& low, uint64_t& high, const unsigned char* input1, const unsigned char* input2,
+		const unsigned char* secret, uint64_t seed) noexcept
+	{
+		low += mix16(input1, secret, seed);
+		low ^= read64(input2) + read64(input2 + 8);
+		high += mix16(input2, secret + 16, seed);
+		high ^= read64(input1) + read64(input1 + 8);
+	}
+
+	// ---------------- 64 bit, up to 240 bytes ----------------
+
+	static inline uint64_t hash64Length9To16(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		const uint64_t flip1 = (read64(secret + 24) ^ read64(secret + 32)) + seed;
+		const uint64_t flip2 = (read64(secret + 40) ^ read64(secret + 48)) - seed;
+		const uint64_t low = read64(input) ^ flip1;
+		const uint64_t high = read64(input + length - 8) ^ flip2;
+		return avalanche(length + swap64(low) + high + multiplyFold64(low, high));
+	}
+
+	static inline uint64_t hash64Length4To8(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		seed ^= (uint64_t)swap32((uint32_t)seed) << 32;
+		const uint64_t flip = (read64(secret + 8) ^ read64(secret + 16)) - seed;
+		const uint64_t value = read32(input + length - 4) + ((uint64_t)read32(input) << 32);
+		return rrmxmx(value ^ flip, length);
+	}
+
+	static inline uint64_t hash64Length0To16(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		if (length > 8)
+			return hash64Length9To16(input, length, secret, seed);
+
+		if (length >= 4)
+			return hash64Length4To8(input, length, secret, seed);
+
+		if (length)
+		{
+			const uint32_t combined = ((uint32_t)input[0] << 16) | ((uint32_t)input[length >> 1] << 24) |
+				(uint32_t)input[length - 1] | ((uint32_t)length << 8);
+			const uint64_t flip = (uint64_t)(read32(secret) ^ read32(secret + 4)) + seed;
+			return xxh64Avalanche(combined ^ flip);
+		}
+
+		return xxh64Avalanche(seed ^ read64(secret + 56) ^ read64(secret + 64));
+	}
+
+	static inline uint64_t hash64Length17To128(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		uint64_t acc = length * Prime64_1;
+
+		if (length > 32)
+		{
+			if (length > 64)
+			{
+				if (length > 96)
+				{
+					acc += mix16(input + 48, secret + 96, seed);
+					acc += mix16(input + length - 64, secret + 112, seed);
+				}
+				acc += mix16(input + 32, secret + 64, seed);
+				acc += mix16(input + length - 48, secret + 80, seed);
+			}
+			acc += mix16(input + 16, secret + 32, seed);
+			acc += mix16(input + length - 32, secret + 48, seed);
+		}
+		acc += mix16(input, secret, seed);
+		acc += mix16(input + length - 16, secret + 16, seed);
+
+		return avalanche(acc);
+	}
+
+	static uint64_t hash64Length129To240(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		uint64_t acc = length * Prime64_1;
+		const size_t rounds = length / 16;
+
+		size_t i = 0;
+		for (; i < 8; ++i)
+			acc += mix16(input + 16 * i, secret + 16 * i, seed);
+		acc = avalanche(acc);
+
+		for (; i < rounds; ++i)
+			acc += mix16(input + 16 * i, secret + 16 * (i - 8) + 3, seed);
+
+		acc += mix16(input + length - 16, secret + 136 - 17, seed);
+		return avalanche(acc);
+	}
+
+	// ---------------- 128 bit, up to 240 bytes ----------------
+
+	static inline KHash128 hash128Length0To16(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		KHash128 result;
+
+		if (length > 8)
+		{
+			const uint64_t flipLow = (read64(secret + 32) ^ read64(secret + 40)) - seed;
+			const uint64_t flipHigh = (read64(secret + 48) ^ read64(secret + 56)) + seed;
+			const uint64_t inputLow = read64(input);
+			uint64_t inputHigh = read64(input + length - 8);
+
+			uint64_t mulHigh;
+			uint64_t mulLow = multiply128(inputLow ^ inputHigh ^ flipLow, Prime64_1, &mulHigh);
+			mulLow += (uint64_t)(length - 1) << 54;
+			inputHigh ^= flipHigh;
+			mulHigh += inputHigh + (uint64_t)(uint32_t)inputHigh * (Prime32_2 - 1);
+			mulLow ^= swap64(mulHigh);
+
+			uint64_t high;
+			const uint64_t low = multiply128(mulLow, Prime64_2, &high);
+			high += mulHigh * Prime64_2;
+
+			result.low = avalanche(low);
+			result.high = avalanche(high);
+			return result;
+		}
+
+		if (length >= 4)
+		{
+			seed ^= (uint64_t)swap32((uint32_t)seed) << 32;
+			const uint64_t value = read32(input) + ((uint64_t)read32(input + length - 4) << 32);
+			const uint64_t flip = (read64(secret + 16) ^ read64(secret + 24)) + seed;
+
+			uint64_t high;
+			uint64_t low = multiply128(value ^ flip, Prime64_1 + (length << 2), &high);
+			high += low << 1;
+			low ^= high >> 3;
+
+			low ^= low >> 35;
+			low *= PrimeMx2;
+			low ^= low >> 28;
+
+			result.low = low;
+			result.high = avalanche(high);
+			return result;
+		}
+
+		if (length)
+		{
+			const uint32_t combinedLow = ((uint32_t)input[0] << 16) | ((uint32_t)input[length >> 1] << 24) |
+				(uint32_t)input[length - 1] | ((uint32_t)length << 8);
+			const uint32_t combinedHigh = rotateLeft32(swap32(combinedLow), 13);
+			const uint64_t flipLow = (uint64_t)(read32(secret) ^ read32(secret + 4)) + seed;
+			const uint64_t flipHigh = (uint64_t)(read32(secret + 8) ^ read32(secret + 12)) - seed;
+
+			result.low = xxh64Avalanche(combinedLow ^ flipLow);
+			result.high = xxh64Avalanche(combinedHigh ^ flipHigh);
+			return result;
+		}
+
+		result.low = xxh64Avalanche(seed ^ read64(secret + 64) ^ read64(secret + 72));
+		result.high = xxh64Avalanche(seed ^ read64(secret + 80) ^ read64(secret + 88));
+		return result;
+	}
+
+	static inline KHash128 finish128(uint64_t low, uint64_t high, size_t length, uint64_t seed) noexcept
+	{
+		KHash128 result;
+		result.low = avalanche(low + high);
+		result.high = (uint64_t)0 - avalanche(low * Prime64_1 + high * Prime64_4 + ((uint64_t)length - seed) * Prime64_2);
+		return result;
+	}
+
+	static inline KHash128 hash128Length17To128(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		uint64_t low = length * Prime64_1;
+		uint64_t high = 0;
+
+		if (length > 32)
+		{
+			if (length > 64)
+			{
+				if (length > 96)
+					mix32(low, high, input + 48, input + length - 64, secret + 96, seed);
+				mix32(low, high, input + 32, input + length - 48, secret + 64, seed);
+			}
+			mix32(low, high, input + 16, input + length - 32, secret + 32, seed);
+		}
+		mix32(low, high, input, input + length - 16, secret, seed);
+
+		return finish128(low, high, length, seed);
+	}
+
+	static KHash128 hash128Length129To240(const unsigned char* input, size_t length, const unsigned char* secret, uint64_t seed) noexcept
+	{
+		uint64_t low = length * Prime64_1;
+		uint64_t high = 0;
+		const size_t rounds = length / 32;
+
+		size_t i = 0;
+		for (; i < 4; ++i)
+			mix32(low, high, input + 32 * i, input + 32 * i + 16, secret + 32 * i, seed);
+		low = avalanche(low);
+		high = avalanche(high);
+
+		for (; i < rounds; ++i)
+			mix32(low, high, input + 32 * i, input + 32 * i + 16, secret + 32 * (i - 4) + 3, seed);
+
+		mix32(low, high, input + length - 16, input + length - 32, secret + 136 - 17 - 16, (uint64_t)0 - seed);
+
+		return finish128(low, high, length, seed);
+	}
+
+	// ---------------- long inputs ----------------
+
+	static inline void initAccumulators(uint64_t* acc) noexcept
+	{
+		acc[0] = Prime32_3;
+		acc[1] = Prime64_1;
+		acc[2] = Prime64_2;
+		acc[3] = Prime64_3;
+		acc[4] = Prime64_4;
+		acc[5] = Prime32_2;
+		acc[6] = Prime64_5;
+		acc[7] = Prime32_1;
+	}
+
+	static void deriveSecret(uint64_t seed, unsigned char* secret) noexcept
+	{
+		const unsigned char* defaultSecret = getDefaultSecret();
+
+		for (size_t i = 0; i < SecretSize; i += 16)
+		{
+			const uint64_t low = read64(defaultSecret + i) + seed;
+			const uint64_t high = read64(defaultSecret + i + 8) - seed;
+			::memcpy(secret + i, &low, 8);
+			::memcpy(secret + i + 8, &high, 8);
+		}
+	}
+
+	static inline void accumulateScalar(uint64_t* acc, const unsigned char* input, const unsigned char* secret) noexcept
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			const uint64_t value = read64(input + 8 * i);
+			const uint64_t key = value ^ read64(secret + 8 * i);
+			acc[i ^ 1] += value;
+			acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+		}
+	}
+
+	static inline void scrambleScalar(uint64_t* acc, const unsigned char* secret) noexcept
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			uint64_t value = acc[i];
+			value ^= value >> 47;
+			value ^= read64(secret + 8 * i);
+			acc[i] = value * Prime32_1;
+		}
+	}
+
+	static void hashLongScalar(uint64_t* acc, const unsigned char* input, size_t length, const unsigned char* secret) noexcept
+	{
+		const size_t blocks = (length - 1) / BlockLength;
+
+		for (size_t block = 0; block < blocks; ++block)
+		{
+			const unsigned char* blockInput = input + block * BlockLength;
+			for (size_t stripe = 0; stripe < StripesPerBlock; ++stripe)
+				accumulateScalar(acc, blockInput + stripe * StripeLength, secret + stripe * SecretConsumeRate);
+			scrambleScalar(acc, secret + SecretSize - StripeLength);
+		}
+
+		const size_t stripes = ((length - 1) - blocks * BlockLength) / StripeLength;
+		const unsigned char* lastBlock = input + blocks * BlockLength;
+		for (size_t stripe = 0; stripe < stripes; ++stripe)
+			accumulateScalar(acc, lastBlock + stripe * StripeLength, secret + stripe * SecretConsumeRate);
+
+		accumulateScalar(acc, input + length - StripeLength, secret + SecretSize - StripeLength - 7);
+	}
+
+#ifdef RFC_STRING_SIMD
+	// accumulators are passed as separate variables. compilers keep them in registers, but not an array.
+
+	static inline __m128i accumulateSSE2(__m128i acc, const unsigned char* input, const unsigned char* secret) noexcept
+	{
+		const __m128i data = _mm_loadu_si128((const __m128i*)input);
+		const __m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)secret));
+		const __m128i product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+		const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+		return _mm_add_epi64(acc, _mm_add_epi64(product, swapped));
+	}
+
+	static inline __m128i scrambleSSE2(__m128i acc, const unsigned char* secret) noexcept
+	{
+		const __m128i prime = _mm_set1_epi32((int)Prime32_1);
+		__m128i value = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+		value = _mm_xor_si128(value, _mm_loadu_si128((const __m128i*)secret));
+		const __m128i productLow = _mm_mul_epu32(value, prime);
+		const __m128i productHigh = _mm_mul_epu32(_mm_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		return _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32));
+	}
+
+	static inline void accumulateStripeSSE2(__m128i& acc0, __m128i& acc1, __m128i& acc2, __m128i& acc3,
+		const unsigned char* input, const unsigned char* secret) noexcept
+	{
+		acc0 = accumulateSSE2(acc0, input, secret);
+		acc1 = accumulateSSE2(acc1, input + 16, secret + 16);
+		acc2 = accumulateSSE2(acc2, input + 32, secret + 32);
+		acc3 = accumulateSSE2(acc3, input + 48, secret + 48);
+	}
+
+	static void hashLongSSE2(uint64_t* acc, const unsigned char* input, size_t length, const unsigned char* secret) noexcept
+	{
+		__m128i acc0 = _mm_loadu_si128((const __m128i*)acc);
+		__m128i acc1 = _mm_loadu_si128((const __m128i*)(acc + 2));
+		__m128i acc2 = _mm_loadu_si128((const __m128i*)(acc + 4));
+		__m128i acc3 = _mm_loadu_si128((const __m128i*)(acc + 6));
+
+		const unsigned char* scrambleSecret = secret + SecretSize - StripeLength;
+		const size_t blocks = (length - 1) / BlockLength;
+
+		for (size_t block = 0; block < blocks; ++block)
+		{
+			const unsigned char* blockInput = input + block * BlockLength;
+			for (size_t stripe = 0; stripe < StripesPerBlock; ++stripe)
+				accumulateStripeSSE2(acc0, acc1, acc2, acc3, blockInput + stripe * StripeLength, secret + stripe * SecretConsumeRate);
+
+			acc0 = scrambleSSE2(acc0, scrambleSecret);
+			acc1 = scrambleSSE2(acc1, scrambleSecret + 16);
+			acc2 = scrambleSSE2(acc2, scrambleSecret + 32);
+			acc3 = scrambleSSE2(acc3, scrambleSecret + 48);
+		}
+
+		const size_t stripes = ((length - 1) - blocks * BlockLength) / StripeLength;
+		const unsigned char* lastBlock = input + blocks * BlockLength;
+		for (size_t stripe = 0; stripe < stripes; ++stripe)
+			accumulateStripeSSE2(acc0, acc1, acc2, acc3, lastBlock + stripe * StripeLength, secret + stripe * SecretConsumeRate);
+
+		accumulateStripeSSE2(acc0, acc1, acc2, acc3, input + length - StripeLength, scrambleSecret - 7);
+
+		_mm_storeu_si128((__m128i*)acc, acc0);
+		_mm_storeu_si128((__m128i*)(acc + 2), acc1);
+		_mm_storeu_si128((__m128i*)(acc + 4), acc2);
+		_mm_storeu_si128((__m128i*)(acc + 6), acc3);
+	}
+
+	RFC_XXH3_TARGET_AVX2 static inline __m256i accumulateAVX2(__m256i acc, const unsigned char* input, const unsigned char* secret) noexcept
+	{
+		const __m256i data = _mm256_loadu_si256((const __m256i*)input);
+		const __m256i key = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i*)secret));
+		const __m256i product = _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32));
+		const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+		return _mm256_add_epi64(acc, _mm256_add_epi64(product, swapped));
+	}
+
+	RFC_XXH3_TARGET_AVX2 static inline __m256i scrambleAVX2(__m256i acc, const unsigned char* secret) noexcept
+	{
+		const __m256i prime = _mm256_set1_epi32((int)Prime32_1);
+		__m256i value = _mm256_xor_si256(acc, _mm256_srli_epi64(acc, 47));
+		value = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i*)secret));
+		const __m256i productLow = _mm256_mul_epu32(value, prime);
+		const __m256i productHigh = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+		return _mm256_add_epi64(productLow, _mm256_slli_epi64(productHigh, 32));
+	}
+
+	RFC_XXH3_TARGET_AVX2 static void hashLongAVX2(uint64_t* acc, const unsigned char* input, size_t length, const unsigned char* secret) noexcept
+	{
+		__m256i acc0 = _mm256_loadu_si256((const __m256i*)acc);
+		__m256i acc1 = _mm256_loadu_si256((const __m256i*)(acc + 4));
+
+		const unsigned char* scrambleSecret = secret + SecretSize - StripeLength;
+		const size_t blocks = (length - 1) / BlockLength;
+
+		for (size_t block = 0; block < blocks; ++block)
+		{
+			const unsigned char* blockInput = input + block * BlockLength;
+			for (size_t stripe = 0; stripe < StripesPerBlock; ++stripe)
+			{
+				acc0 = accumulateAVX2(acc0, blockInput + stripe * StripeLength, secret + stripe * SecretConsumeRate);
+				acc1 = accumulateAVX2(acc1, blockInput + stripe * StripeLength + 32, secret + stripe * SecretConsumeRate + 32);
+			}
+
+			acc0 = scrambleAVX2(acc0, scrambleSecret);
+			acc1 = scrambleAVX2(acc1, scrambleSecret + 32);
+		}
+
+		const size_t stripes = ((length - 1) - blocks * BlockLength) / StripeLength;
+		const unsigned char* lastBlock = input + blocks * BlockLength;
+		for (size_t stripe = 0; stripe < stripes; ++stripe)
+		{
+			acc0 = accumulateAVX2(acc0, lastBlock + stripe * StripeLength, secret + stripe * SecretConsumeRate);
+			acc1 = accumulateAVX2(acc1, lastBlock + stripe * StripeLength + 32, secret + stripe * SecretConsumeRate + 32);
+		}
+
+		acc0 = accumulateAVX2(acc0, input + length - StripeLength, scrambleSecret - 7);
+		acc1 = accumulateAVX2(acc1, input + length - StripeLength + 32, scrambleSecret - 7 + 32);
+
+		_mm256_storeu_si256((__m256i*)acc, acc0);
+		_mm256_storeu_si256((__m256i*)(acc + 4), acc1);
+	}
+#endif
+
+	static void hashLong(uint64_t* acc, const unsigned char* input, size_t length, const unsigned char* secret) noexcept
+	{
+		initAccumulators(acc);
+
+	#ifdef RFC_STRING_SIMD
+		if (KStringKernels::getSIMDLevel() == KSIMDLevel::AVX2)
+			hashLongAVX2(acc, input, length, secret);
+		else
+			hashLongSSE2(acc, input, length, secret);
+	#else
+		hashLongScalar(acc, input, length, secret);
+	#endif
+	}
+
+	static inline uint64_t mergeAccumulators(const uint64_t* acc, const unsigned char* secret, uint64_t start) noexcept
+	{
+		uint64_t result = start;
+		for (int i = 0; i < 4; ++i)
+			result += multiplyFold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+		return avalanche(result);
+	}
+
+	static uint64_t hash64Long(const unsigned char* input, size_t length, const unsigned char* secret) noexcept
+	{
+		alignas(32) uint64_t acc[8];
+		hashLong(acc, input, length, secret);
+		return mergeAccumulators(acc, secret + 11, length * Prime64_1);
+	}
+
+	static KHash128 hash128Long(const unsigned char* input, size_t length, const unsigned char* secret) noexcept
+	{
+		alignas(32) uint64_t acc[8];
+		hashLong(acc, input, length, secret);
+
+		KHash128 result;
+		result.low = mergeAccumulators(acc, secret + 11, length * Prime64_1);
+		result.high = mergeAccumulators(acc, secret + SecretSize - 64 - 11, ~(length * Prime64_2));
+		return result;
+	}
+
+	static inline uint64_t hash64WithSecret(const unsigned char* input, size_t length, uint64_t seed,
+		const unsigned char* defaultSecret, const unsigned char* longSecret) noexcept
+	{
+		if (length <= 16)
+			return hash64Length0To16(input, length, defaultSecret, seed);
+
+		if (length <= 128)
+			return hash64Length17To128(input, length, defaultSecret, seed);
+
+		if (length <= MidSizeMax)
+			return hash64Length129To240(input, length, defaultSecret, seed);
+
+		return hash64Long(input, length, longSecret);
+	}
+
+public:
+	static uint64_t hash64(const void* input, size_t length, uint64_t seed = 0) noexcept
+	{
+		const unsigned char* data = (const unsigned char*)input;
+		const unsigned char* secret = getDefaultSecret();
+
+		if ((length > MidSizeMax) && seed)
+		{
+			alignas(64) unsigned char seedSecret[SecretSize];
+			deriveSecret(seed, seedSecret);
+			return hash64Long(data, length, seedSecret);
+		}
+
+		return hash64WithSecret(data, length, seed, secret, secret);
+	}
+
+	static KHash128 hash128(const void* input, size_t length, uint64_t seed = 0) noexcept
+	{
+		const unsigned char* data = (const unsigned char*)input;
+		const unsigned char* secret = getDefaultSecret();
+
+		if (length <= 16)
+			return hash128Length0To16(data, length, secret, seed);
+
+		if (length <= 128)
+			return hash128Length17To128(data, length, secret, seed);
+
+		if (length <= MidSizeMax)
+			return hash128Length129To240(data, length, secret, seed);
+
+		if (seed)
+		{
+			alignas(64) unsigned char seedSecret[SecretSize];
+			deriveSecret(seed, seedSecret);
+			return hash128Long(data, length, seedSecret);
+		}
+
+		return hash128Long(data, length, secret);
+	}
+
+	/**
+		Hashes count independent keys. results[i] is same as hash64(inputs[i], lengths[i], seed).
+		Length dispatch is inlined and the seeded secret for long keys is derived once per call.
+	*/
+	static void hash64Batch(const void* const* inputs, const size_t* lengths, uint64_t* results, size_t count, uint64_t seed = 0) noexcept
+	{
+		const unsigned char* secret = getDefaultSecret();
+		const unsigned char* longSecret = secret;
+		alignas(64) unsigned char seedSecret[SecretSize];
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const size_t length = lengths[i];
+
+			if ((length > MidSizeMax) && seed && (longSecret == secret))
+			{
+				deriveSecret(seed, seedSecret);
+				longSecret = seedSecret;
+			}
+
+			results[i] = hash64WithSecret((const unsigned char*)inputs[i], length, seed, secret, longSecret);
+		}
+	}
+};
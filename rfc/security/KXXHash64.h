@@ -0,0 +1,209 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+	Streaming XXH64. Results are same as the reference implementation and KHash::hash64.
+	Input is read as little-endian words, which is the byte order of all windows targets.
+
+	e.g. @code
+	KXXHash64 hasher(seed);
+	hasher.add(data1, length1);
+	hasher.add(data2, length2);
+	const uint64_t result = hasher.hash();
+
+	// or in one call
+	const uint64_t result2 = KXXHash64::hash(data, length, seed);
+	@endcode
+*/
+class KXXHash64
+{
+protected:
+	static const uint64_t Prime1 = 11400714785074694791ULL;
+	static const uint64_t Prime2 = 14029467366897019727ULL;
+	static const uint64_t Prime3 = 1609587929392839161ULL;
+	static const uint64_t Prime4 = 9650029242287828579ULL;
+	static const uint64_t Prime5 = 2870177450012600261ULL;
+
+	static const unsigned int BlockSize = 32;
+
+	uint64_t state[4];
+	uint64_t seed;
+	uint64_t totalLength;
+	unsigned char buffer[BlockSize];
+	unsigned int bufferSize;
+
+	static inline uint64_t rotateLeft(uint64_t x, int bits) noexcept
+	{
+		return (x << bits) | (x >> (64 - bits));
+	}
+
+	static inline uint64_t read64(const unsigned char* data) noexcept
+	{
+		uint64_t value;
+		::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static inline uint32_t read32(const unsigned char* data) noexcept
+	{
+		uint32_t value;
+		::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static inline uint64_t round(uint64_t acc, uint64_t input) noexcept
+	{
+		acc += input * Prime2;
+		acc = rotateLeft(acc, 31);
+		return acc * Prime1;
+	}
+
+	static inline uint64_t mergeRound(uint64_t acc, uint64_t value) noexcept
+	{
+		acc ^= round(0, value);
+		return acc * Prime1 + Prime4;
+	}
+
+public:
+	KXXHash64(uint64_t seed = 0) noexcept
+	{
+		reset(seed);
+	}
+
+	// starts a new hash.
+	void reset(uint64_t seed = 0) noexcept
+	{
+		this->seed = seed;
+		state[0] = seed + Prime1 + Prime2;
+		state[1] = seed + Prime2;
+		state[2] = seed;
+		state[3] = seed - Prime1;
+		totalLength = 0;
+		bufferSize = 0;
+	}
+
+	void add(const void* input, size_t length) noexcept
+	{
+		if ((input == nullptr) || (length == 0))
+			return;
+
+		const unsigned char* data = (const unsigned char*)input;
+		totalLength += length;
+
+		if (bufferSize + length < BlockSize)
+		{
+			::memcpy(buffer + bufferSize, data, length);
+			bufferSize += (unsigned int)length;
+			return;
+		}
+
+		const unsigned char* const end = data + length;
+		uint64_t v1 = state[0], v2 = state[1], v3 = state[2], v4 = state[3];
+
+		if (bufferSize)
+		{
+			const unsigned int fill = BlockSize - bufferSize;
+			::memcpy(buffer + bufferSize, data, fill);
+			data += fill;
+
+			v1 = round(v1, read64(buffer));
+			v2 = round(v2, read64(buffer + 8));
+			v3 = round(v3, read64(buffer + 16));
+			v4 = round(v4, read64(buffer + 24));
+		}
+
+		while ((size_t)(end - data) >= BlockSize)
+		{
+			v1 = round(v1, read64(data));
+			v2 = round(v2, read64(data + 8));
+			v3 = round(v3, read64(data + 16));
+			v4 = round(v4, read64(data + 24));
+			data += BlockSize;
+		}
+
+		state[0] = v1; state[1] = v2; state[2] = v3; state[3] = v4;
+
+		bufferSize = (unsigned int)(end - data);
+		if (bufferSize)
+			::memcpy(buffer, data, bufferSize);
+	}
+
+	// hash of the data added so far. more data can be added after this call.
+	uint64_t hash() const noexcept
+	{
+		uint64_t result;
+
+		if (totalLength >= BlockSize)
+		{
+			result = rotateLeft(state[0], 1) + rotateLeft(state[1], 7) + rotateLeft(state[2], 12) + rotateLeft(state[3], 18);
+			result = mergeRound(result, state[0]);
+			result = mergeRound(result, state[1]);
+			result = mergeRound(result, state[2]);
+			result = mergeRound(result, state[3]);
+		}
+		else
+		{
+			result = seed + Prime5;
+		}
+
+		result += totalLength;
+
+		const unsigned char* data = buffer;
+		const unsigned char* const end = buffer + bufferSize;
+
+		for (; data + 8 <= end; data += 8)
+		{
+			result ^= round(0, read64(data));
+			result = rotateLeft(result, 27) * Prime1 + Prime4;
+		}
+
+		if (data + 4 <= end)
+		{
+			result ^= (uint64_t)read32(data) * Prime1;
+			result = rotateLeft(result, 23) * Prime2 + Prime3;
+			data += 4;
+		}
+
+		while (data < end)
+		{
+			result ^= (*data++) * Prime5;
+			result = rotateLeft(result, 11) * Prime1;
+		}
+
+		result ^= result >> 33;
+		result *= Prime2;
+		result ^= result >> 29;
+		result *= Prime3;
+		result ^= result >> 32;
+		return result;
+	}
+
+	static inline uint64_t hash(const void* input, size_t length, uint64_t seed = 0) noexcept
+	{
+		return KHash::hash64(input, length, seed);
+	}
+};
@@ -25,6 +25,8 @@
 #include "KSignCheck.h"
 #include "KDPAPI.h"
 #include "KXXHash32.h"
+#include "KXXHash64.h"
+#include "KXXHash3.h"
 #include "KXoredString.h"
 
 #pragma comment(lib,"crypt32.lib")
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../core/CoreModule.h"
+#include "../file/KMappedFile.h"
 #include "plutosvg/plutosvg.h"
 
 // uses modified plutosvg. (removed font support, image element support & image saving)
@@ -35,12 +36,39 @@ protected:
 public:
 	KSVGImage() noexcept {}
 
-	bool loadFromFile(const char* filePath) noexcept
+	// the document is parsed from the mapped file. the mapping lives until the document is destroyed.
+	bool loadFromFile(const wchar_t* filePath) noexcept
 	{
-		document = plutosvg::plutosvg_document_load_from_file(filePath, -1, -1);
+		KMappedFile* mappedFile = new KMappedFile();
+		if (!mappedFile->openFile(filePath) || (mappedFile->getSize() == 0) || (mappedFile->getSize() > INT_MAX))
+		{
+			delete mappedFile;
+			return false;
+		}
+
+		// plutosvg calls destroyMappedFile even if the loading fails.
+		document = plutosvg::plutosvg_document_load_from_data((const char*)mappedFile->getData(),
+			(int)mappedFile->getSize(), -1, -1, &KSVGImage::destroyMappedFile, mappedFile);
+
 		return document != NULL;
 	}
 
+	// filePath is in the ANSI code page.
+	bool loadFromFile(const char* filePath) noexcept
+	{
+		const int length = ::MultiByteToWideChar(CP_ACP, 0, filePath, -1, NULL, 0);
+		if (length <= 0)
+			return false;
+
+		wchar_t* widePath = (wchar_t*)::malloc(length * sizeof(wchar_t));
+		::MultiByteToWideChar(CP_ACP, 0, filePath, -1, widePath, length);
+
+		const bool result = loadFromFile(widePath);
+		::free(widePath);
+
+		return result;
+	}
+
 	bool loadFromData(const char* data, int length) noexcept
 	{
 		document = plutosvg::plutosvg_document_load_from_data(data, length, -1, -1, 0, 0);
@@ -126,5 +154,10 @@ public:
 	}
 
 private:
+	static void destroyMappedFile(void* closure)
+	{
+		delete (KMappedFile*)closure;
+	}
+
 	RFC_LEAK_DETECTOR(KSVGImage)
 };
@@ -0,0 +1,418 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "KThreadPool.h"
+
+// per worker deque capacity. tasks overflow to the shared queue when it is full.
+#define RFC_WORKER_DEQUE_SIZE 256
+
+class KThreadPoolWorker : public KThread
+{
+public:
+	KThreadPool* pool;
+	int workerIndex;
+
+	// owner pushes and pops at the bottom (newest first, cache friendly), thieves take from the top (oldest first).
+	CRITICAL_SECTION dequeLock;
+	KThreadPoolTask* deque[RFC_WORKER_DEQUE_SIZE];
+	int dequeTop; // index of the oldest task
+	int dequeCount;
+
+	KThreadPoolWorker(KThreadPool* pool, int workerIndex) noexcept
+	{
+		this->pool = pool;
+		this->workerIndex = workerIndex;
+		dequeTop = 0;
+		dequeCount = 0;
+		::InitializeCriticalSection(&dequeLock);
+	}
+
+	bool pushBottom(KThreadPoolTask* task) noexcept
+	{
+		::EnterCriticalSection(&dequeLock);
+
+		if (dequeCount == RFC_WORKER_DEQUE_SIZE)
+		{
+			::LeaveCriticalSection(&dequeLock);
+			return false;
+		}
+
+		deque[(dequeTop + dequeCount) % RFC_WORKER_DEQUE_SIZE] = task;
+		++dequeCount;
+
+		::LeaveCriticalSection(&dequeLock);
+		return true;
+	}
+
+	KThreadPoolTask* popBottom() noexcept
+	{
+		KThreadPoolTask* task = nullptr;
+		::EnterCriticalSection(&dequeLock);
+
+		if (dequeCount)
+		{
+			--dequeCount;
+			task = deque[(dequeTop + dequeCount) % RFC_WORKER_DEQUE_SIZE];
+		}
+
+		::LeaveCriticalSection(&dequeLock);
+		return task;
+	}
+
+	KThreadPoolTask* stealTop() noexcept
+	{
+		KThreadPoolTask* task = nullptr;
+		::EnterCriticalSection(&dequeLock);
+
+		if (dequeCount)
+		{
+			task = deque[dequeTop];
+			dequeTop = (dequeTop + 1) % RFC_WORKER_DEQUE_SIZE;
+			--dequeCount;
+		}
+
+		::LeaveCriticalSection(&dequeLock);
+		return task;
+	}
+
+	void run() noexcept override
+	{
+		pool->workerLoop(this);
+	}
+
+	~KThreadPoolWorker() noexcept
+	{
+		::DeleteCriticalSection(&dequeLock);
+	}
+};
+
+// worker object of the calling thread. nullptr if the calling thread is not a pool worker.
+static thread_local KThreadPoolWorker* rfc_currentPoolWorker = nullptr;
+
+KThreadPool::KThreadPool() noexcept : pendingTaskCount(0), stopRequested(false)
+{
+	workers = nullptr;
+	workerCount = 0;
+
+	hTaskSemaphore = ::CreateSemaphoreW(NULL, 0, 0x7FFFFFFF, NULL);
+	hIdleEvent = ::CreateEventW(NULL, TRUE, TRUE, NULL); // manual reset, initially signaled
+}
+
+bool KThreadPool::start(int workerCount) noexcept
+{
+	if (workers)
+		return false;
+
+	if (workerCount <= 0)
+	{
+		SYSTEM_INFO sysInfo;
+		::GetSystemInfo(&sysInfo);
+		workerCount = (int)sysInfo.dwNumberOfProcessors;
+		if (workerCount < 1)
+			workerCount = 1;
+	}
+
+	stopRequested.store(false, std::memory_order_release);
+
+	workers = new KThreadPoolWorker*[workerCount];
+	for (int i = 0; i < workerCount; i++)
+		workers[i] = new KThreadPoolWorker(this, i);
+
+	this->workerCount = workerCount;
+
+	for (int i = 0; i < workerCount; i++)
+	{
+		if (!workers[i]->start())
+		{
+			stop();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool KThreadPool::enqueueTask(KThreadPoolTask* task) noexcept
+{
+	if ((workers == nullptr) || stopRequested.load(std::memory_order_acquire))
+	{
+		delete task;
+		return false;
+	}
+
+	if (pendingTaskCount.fetch_add(1, std::memory_order_acq_rel) == 0)
+		::ResetEvent(hIdleEvent);
+
+	// tasks created by a worker of this pool stay local, so the same worker is likely to run them with a warm cache.
+	KThreadPoolWorker* currentWorker = rfc_currentPoolWorker;
+	if ((currentWorker == nullptr) || (currentWorker->pool != this) || !currentWorker->pushBottom(task))
+		sharedQueue.push(task);
+
+	::ReleaseSemaphore(hTaskSemaphore, 1, NULL);
+	return true;
+}
+
+bool KThreadPool::submit(KRunnable* runnable, HWND hwndReceiver, WPARAM signalID, LPARAM param) noexcept
+{
+	if (runnable == nullptr)
+		return false;
+
+	KThreadPoolTask* task = new KThreadPoolTask();
+	task->runnable = runnable;
+	task->hwndReceiver = hwndReceiver;
+	task->signalID = signalID;
+	task->param = param;
+
+	return enqueueTask(task);
+}
+
+bool KThreadPool::submit(std::function<void()> func, HWND hwndReceiver, WPARAM signalID, LPARAM param) noexcept
+{
+	if (!func)
+		return false;
+
+	KThreadPoolTask* task = new KThreadPoolTask();
+	task->runnable = nullptr;
+	task->func = std::move(func);
+	task->hwndReceiver = hwndReceiver;
+	task->signalID = signalID;
+	task->param = param;
+
+	return enqueueTask(task);
+}
+
+KThreadPoolTask* KThreadPool::findTask(KThreadPoolWorker* worker) noexcept
+{
+	KThreadPoolTask* task = worker->popBottom();
+	if (task)
+		return task;
+
+	task = sharedQueue.pop();
+	if (task)
+		return task;
+
+	// steal from the others, starting next to us so the victims are spread between the workers.
+	for (int i = 1; i < workerCount; i++)
+	{
+		task = workers[(worker->workerIndex + i) % workerCount]->stealTop();
+		if (task)
+			return task;
+	}
+
+	return nullptr;
+}
+
+void KThreadPool::executeTask(KThreadPoolTask* task, KThreadPoolWorker* worker) noexcept
+{
+	if (task->runnable)
+		task->runnable->run(worker);
+	else
+		task->func();
+
+	if (task->hwndReceiver)
+		::PostMessageW(task->hwndReceiver, RFC_SIGNAL_MESSAGE, task->signalID, task->param);
+
+	delete task;
+
+	if (pendingTaskCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		::SetEvent(hIdleEvent);
+}
+
+void KThreadPool::workerLoop(KThreadPoolWorker* worker) noexcept
+{
+	rfc_currentPoolWorker = worker;
+
+	while (true)
+	{
+		::WaitForSingleObject(hTaskSemaphore, INFINITE);
+
+		if (stopRequested.load(std::memory_order_acquire))
+			break;
+
+		// each semaphore count belongs to exactly one queued task, so keep looking until we get it.
+		// (the task can be inside a deque which is temporarily locked by a thief)
+		KThreadPoolTask* task;
+		while ((task = findTask(worker)) == nullptr)
+		{
+			if (stopRequested.load(std::memory_order_acquire))
+				break;
+
+			::SwitchToThread();
+		}
+
+		if (task == nullptr) // stop requested
+			break;
+
+		executeTask(task, worker);
+	}
+
+	rfc_currentPoolWorker = nullptr;
+}
+
+bool KThreadPool::runPendingTask() noexcept
+{
+	KThreadPoolWorker* worker = rfc_currentPoolWorker;
+	if ((worker == nullptr) || (worker->pool != this))
+		return false;
+
+	// take the count of the task before taking the task, to keep the semaphore in sync with the queues.
+	if (::WaitForSingleObject(hTaskSemaphore, 0) != WAIT_OBJECT_0)
+		return false;
+
+	KThreadPoolTask* task;
+	while ((task = findTask(worker)) == nullptr)
+		::SwitchToThread();
+
+	executeTask(task, worker);
+	return true;
+}
+
+void KThreadPool::runParallel(int chunkCount, KParallelChunkProc chunkProc, void* context) noexcept
+{
+	struct State
+	{
+		KParallelChunkProc chunkProc;
+		void* context;
+		int chunkCount;
+		std::atomic<int> nextChunk;
+		std::atomic<int> activeHelpers;
+	};
+
+	State state;
+	state.chunkProc = chunkProc;
+	state.context = context;
+	state.chunkCount = chunkCount;
+	state.nextChunk.store(0, std::memory_order_relaxed);
+	state.activeHelpers.store(0, std::memory_order_relaxed);
+
+	// the caller and the helpers pull chunks from the same counter until all of them are taken.
+	auto runChunks = [](State* s) {
+		int chunkIndex;
+		while ((chunkIndex = s->nextChunk.fetch_add(1, std::memory_order_relaxed)) < s->chunkCount)
+			s->chunkProc(s->context, chunkIndex);
+	};
+
+	int helperCount = (chunkCount - 1) < workerCount ? (chunkCount - 1) : workerCount;
+	for (int i = 0; i < helperCount; i++)
+	{
+		state.activeHelpers.fetch_add(1, std::memory_order_relaxed);
+
+		State* s = &state;
+		if (!submit([s, runChunks]() {
+			runChunks(s);
+			s->activeHelpers.fetch_sub(1, std::memory_order_release);
+		}))
+		{
+			state.activeHelpers.fetch_sub(1, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	runChunks(&state);
+
+	// helpers reference the state on our stack, so wait until all of them returned.
+	// a worker keeps running other tasks meanwhile. otherwise nested parallelFor calls could starve the pool.
+	int spinCount = 0;
+	while (state.activeHelpers.load(std::memory_order_acquire) != 0)
+	{
+		if (runPendingTask())
+			continue;
+
+		if (++spinCount < 64)
+			::SwitchToThread();
+		else
+			::Sleep(1);
+	}
+}
+
+void KThreadPool::waitForIdle() noexcept
+{
+	// counter is the real state. the event only avoids busy waiting.
+	while (pendingTaskCount.load(std::memory_order_acquire) != 0)
+		::WaitForSingleObject(hIdleEvent, 20);
+}
+
+int KThreadPool::getWorkerCount() const noexcept
+{
+	return workerCount;
+}
+
+bool KThreadPool::stop() noexcept
+{
+	// a worker cannot wait for itself to finish.
+	KThreadPoolWorker* currentWorker = rfc_currentPoolWorker;
+	if ((currentWorker != nullptr) && (currentWorker->pool == this))
+		return false;
+
+	if (workers == nullptr)
+		return true;
+
+	stopRequested.store(true, std::memory_order_release);
+	::ReleaseSemaphore(hTaskSemaphore, workerCount, NULL);
+
+	for (int i = 0; i < workerCount; i++)
+	{
+		if (workers[i]->getHandle())
+			workers[i]->waitUntilThreadFinish();
+	}
+
+	// discard the tasks which are not started.
+	int discardedCount = 0;
+	KThreadPoolTask* task;
+
+	for (int i = 0; i < workerCount; i++)
+	{
+		while ((task = workers[i]->popBottom()) != nullptr)
+		{
+			delete task;
+			++discardedCount;
+		}
+
+		delete workers[i];
+	}
+
+	while ((task = sharedQueue.pop()) != nullptr)
+	{
+		delete task;
+		++discardedCount;
+	}
+
+	delete[] workers;
+	workers = nullptr;
+	workerCount = 0;
+
+	if (pendingTaskCount.fetch_sub(discardedCount, std::memory_order_acq_rel) == discardedCount)
+		::SetEvent(hIdleEvent);
+
+	// drop the counts of the discarded tasks and the wake up counts.
+	::CloseHandle(hTaskSemaphore);
+	hTaskSemaphore = ::CreateSemaphoreW(NULL, 0, 0x7FFFFFFF, NULL);
+
+	return true;
+}
+
+KThreadPool::~KThreadPool() noexcept
+{
+	stop();
+
+	::CloseHandle(hTaskSemaphore);
+	::CloseHandle(hIdleEvent);
+}
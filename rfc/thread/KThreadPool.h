@@ -0,0 +1,188 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "../core/CoreModule.h"
+#include "../containers/ContainersModule.h"
+#include "KThread.h"
+#include "KRunnable.h"
+#include <functional>
+#include <atomic>
+
+#ifndef RFC_SIGNAL_MESSAGE
+	#define RFC_SIGNAL_MESSAGE WM_APP + 102 // same as KSignal. (GUI module)
+#endif
+
+class KThreadPoolWorker;
+
+// a unit of work queued to KThreadPool. internal use.
+struct KThreadPoolTask
+{
+	KRunnable* runnable;
+	std::function<void()> func;
+
+	// completion signal. posted as RFC_SIGNAL_MESSAGE after the task finished.
+	HWND hwndReceiver;
+	WPARAM signalID;
+	LPARAM param;
+};
+
+/**
+	Fixed size pool of worker threads.
+	Each worker owns a deque of tasks. tasks submitted from a worker go to its own deque,
+	tasks submitted from other threads go to a shared queue. idle workers steal from the others.
+
+	Completion can be delivered to a window through RFC_SIGNAL_MESSAGE (see KSignal and KSignalHandler),
+	so the onSignal method runs on the gui thread.
+
+	e.g. @code
+	KThreadPool pool;
+	pool.start(); // one worker per logical processor
+
+	pool.submit([]() {
+		// your code goes here...
+	}, myWindow.getHWND(), MY_JOB_FINISHED_SIGNAL, 0);
+
+	pool.parallelFor(0, itemCount, [&](int index) {
+		items[index] = process(index);
+	});
+	@endcode
+*/
+class KThreadPool
+{
+	friend class KThreadPoolWorker;
+
+protected:
+	KThreadPoolWorker** workers;
+	int workerCount;
+
+	KPointerQueue<KThreadPoolTask*, KThreadSafety::Exclusive> sharedQueue;
+	HANDLE hTaskSemaphore; // one count per queued task
+	HANDLE hIdleEvent; // signaled when there are no pending or running tasks
+	std::atomic<int> pendingTaskCount; // queued + running tasks
+	std::atomic<bool> stopRequested;
+
+	// called with a chunk index by parallelFor.
+	typedef void(*KParallelChunkProc)(void* context, int chunkIndex);
+
+	bool enqueueTask(KThreadPoolTask* task) noexcept;
+	KThreadPoolTask* findTask(KThreadPoolWorker* worker) noexcept;
+	void executeTask(KThreadPoolTask* task, KThreadPoolWorker* worker) noexcept;
+	void workerLoop(KThreadPoolWorker* worker) noexcept;
+
+	// takes one pending task if there is any and runs it on the calling thread.
+	bool runPendingTask() noexcept;
+
+	void runParallel(int chunkCount, KParallelChunkProc chunkProc, void* context) noexcept;
+
+public:
+	KThreadPool() noexcept;
+
+	/**
+		Creates worker threads.
+		@param workerCount number of worker threads. zero means number of logical processors.
+		@returns false if the pool is already started or thread creation failed.
+	*/
+	bool start(int workerCount = 0) noexcept;
+
+	/**
+		Queues a runnable. runnable->run() receives the worker thread. pool does not delete the runnable.
+		If hwndReceiver is not null, RFC_SIGNAL_MESSAGE(signalID, param) is posted to it after the run.
+		@returns false if the pool is not started.
+	*/
+	bool submit(KRunnable* runnable, HWND hwndReceiver = NULL, WPARAM signalID = 0, LPARAM param = 0) noexcept;
+
+	/**
+		Queues a lambda. If hwndReceiver is not null, RFC_SIGNAL_MESSAGE(signalID, param) is posted to it after the run.
+		@returns false if the pool is not started.
+	*/
+	bool submit(std::function<void()> func, HWND hwndReceiver = NULL, WPARAM signalID = 0, LPARAM param = 0) noexcept;
+
+	/**
+		Calls func(index) for each index in [beginIndex, endIndex) using the workers and the calling thread.
+		Returns after all the calls finished. The calling thread runs other pending tasks while waiting,
+		so it is safe to call from a task.
+		@param grainSize number of indices per chunk. zero selects a size which gives about 4 chunks per worker.
+	*/
+	template<typename Func>
+	void parallelFor(int beginIndex, int endIndex, Func&& func, int grainSize = 0) noexcept
+	{
+		if (endIndex <= beginIndex)
+			return;
+
+		const int count = endIndex - beginIndex;
+		if (grainSize <= 0)
+		{
+			grainSize = count / ((workerCount > 0 ? workerCount : 1) * 4);
+			if (grainSize < 1)
+				grainSize = 1;
+		}
+
+		struct Context
+		{
+			Func* func;
+			int beginIndex;
+			int endIndex;
+			int grainSize;
+		};
+
+		Context context = { &func, beginIndex, endIndex, grainSize };
+
+		// chunk dispatch goes through a plain function pointer. func itself is called directly. (no per-index type erasure)
+		runParallel((count + grainSize - 1) / grainSize, [](void* ctx, int chunkIndex) {
+			Context* c = (Context*)ctx;
+			const int first = c->beginIndex + (chunkIndex * c->grainSize);
+			const int last = ((c->endIndex - first) > c->grainSize) ? (first + c->grainSize) : c->endIndex;
+
+			for (int i = first; i < last; i++)
+				(*c->func)(i);
+		}, &context);
+	}
+
+	/**
+		Blocks until all the queued and running tasks finished.
+		Do not call from a task of this pool.
+	*/
+	void waitForIdle() noexcept;
+
+	int getWorkerCount() const noexcept;
+
+	/**
+		Stops all the workers after their current task. queued tasks which are not started yet are discarded.
+		@returns false without stopping if called from a task of this pool. (it would wait for its own worker)
+	*/
+	bool stop() noexcept;
+
+	/**
+		Calls stop. The pool must not be destroyed from one of its own tasks.
+	*/
+	virtual ~KThreadPool() noexcept;
+
+	// no copy/movable
+	KThreadPool(const KThreadPool&) = delete;
+	KThreadPool& operator=(const KThreadPool&) = delete;
+	KThreadPool(KThreadPool&&) = delete;
+	KThreadPool& operator=(KThreadPool&&) = delete;
+
+private:
+	RFC_LEAK_DETECTOR(KThreadPool)
+};
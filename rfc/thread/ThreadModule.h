@@ -23,4 +23,5 @@
 
 #include "KRunnable.h"
 #include "KThread.h"
-#include "KInterruptableSleep.h"
\ No newline at end of file
+#include "KInterruptableSleep.h"
+#include "KThreadPool.h"
\ No newline at end of file
@@ -0,0 +1,570 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include "KXMLReader.h"
+
+/**
+	Compiled path query over KModelElement trees. Supports a small subset of XPath.
+
+	/root/item        child steps from the document. first step matches the root element.
+	//item            item elements at any depth.
+	/root//item       item elements at any depth under root.
+	item/name         relative to the context element.
+	*                 any element.
+	item[@id='x']     attribute predicate. more than one is allowed.
+
+	Predicates on the id attribute of the given KModelIndex are resolved by the index. All the other predicates
+	(and id predicates when there is no index) are compared by KModelElement::matchesAttribute, which must be
+	overridden by the model elements. With an index, an id predicate only matches the first element which has that id.
+
+	Element names are compiled into elementType values using the factory. so different names which
+	give the same elementType are not distinguished.
+	Results are in document order. Compile once and run many times.
+
+	e.g. @code
+	KModelQuery query;
+	if (query.compile(L"/Panel//Label[@x='10']", &factory))
+	{
+		query.forEach(rootElement, [](KModelElement* element) {
+			// ...
+		});
+	}
+	@endcode
+*/
+class KModelQuery
+{
+protected:
+	struct Predicate
+	{
+		wchar_t* name;
+		UINT nameLength;
+		wchar_t* value;
+		UINT valueLength;
+	};
+
+	struct Step
+	{
+		bool descendant; // separator before the step is "//"
+		bool anyElement;
+		int elementType;
+		int firstPredicate;
+		int predicateCount;
+	};
+
+	Step* steps;
+	int stepCount;
+	Predicate* predicates;
+	int predicateCount;
+	bool absolute;
+	int firstDescendantStep; // stepCount if there is no "//" step
+
+	bool failCompile() noexcept
+	{
+		clear();
+		return false;
+	}
+
+	static wchar_t* copyText(const wchar_t* text, size_t length) noexcept
+	{
+		wchar_t* copy = (wchar_t*)::malloc((length + 1) * sizeof(wchar_t));
+		if (copy)
+		{
+			::memcpy(copy, text, length * sizeof(wchar_t));
+			copy[length] = 0;
+		}
+
+		return copy;
+	}
+
+	static bool isNameEnd(wchar_t c) noexcept
+	{
+		return (c == 0) || (c == L'/') || (c == L'[') || (c == L']') || (c == L'=') || (c == L' ') || (c == L'\t');
+	}
+
+	static void skipSpaces(const wchar_t** text) noexcept
+	{
+		while ((**text == L' ') || (**text == L'\t'))
+			++(*text);
+	}
+
+	bool addStep(const Step& step) noexcept
+	{
+		Step* newSteps = (Step*)::realloc(steps, (stepCount + 1) * sizeof(Step));
+		if (newSteps == nullptr)
+			return false;
+
+		steps = newSteps;
+		steps[stepCount++] = step;
+		return true;
+	}
+
+	bool addPredicate(const wchar_t* name, size_t nameLength, const wchar_t* value, size_t valueLength) noexcept
+	{
+		Predicate* newPredicates = (Predicate*)::realloc(predicates, (predicateCount + 1) * sizeof(Predicate));
+		if (newPredicates == nullptr)
+			return false;
+
+		predicates = newPredicates;
+
+		Predicate& predicate = predicates[predicateCount];
+		predicate.name = copyText(name, nameLength);
+		predicate.nameLength = (UINT)nameLength;
+		predicate.value = copyText(value, valueLength);
+		predicate.valueLength = (UINT)valueLength;
+
+		++predicateCount; // added before the check. so clear frees the copies.
+		return (predicate.name != nullptr) && (predicate.value != nullptr);
+	}
+
+	static bool isIdPredicate(const Predicate& predicate, KModelIndex* index) noexcept
+	{
+		const KString& idAttributeName = index->getIdAttributeName();
+		return (predicate.nameLength == (UINT)idAttributeName.length()) && (::wcscmp(predicate.name, idAttributeName) == 0);
+	}
+
+	// id predicates are checked with the index when it is given. elements do not keep their attributes by default.
+	bool matchesStep(KModelElement* element, int stepIndex, KModelIndex* index) const noexcept
+	{
+		const Step& step = steps[stepIndex];
+
+		if ((!step.anyElement) && (element->elementType != step.elementType))
+			return false;
+
+		for (int i = step.firstPredicate; i < (step.firstPredicate + step.predicateCount); i++)
+		{
+			const Predicate& predicate = predicates[i];
+			if (index && isIdPredicate(predicate, index))
+			{
+				if (index->findById(predicate.value, (int)predicate.valueLength) != element)
+					return false;
+			}
+			else if (!element->matchesAttribute(predicate.name, predicate.nameLength, predicate.value, predicate.valueLength))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// checks steps[0..stepIndex] from the element towards the context. depth is limited by the step count.
+	bool matchesPath(KModelElement* element, int stepIndex, const KModelElement* context, KModelIndex* index) const noexcept
+	{
+		if (!matchesStep(element, stepIndex, index))
+			return false;
+
+		if (stepIndex == 0)
+		{
+			if (absolute)
+				return steps[0].descendant ? isInside(element, context) : (element == context);
+
+			return steps[0].descendant ? ((element != context) && isInside(element, context)) : (element->parent == context);
+		}
+
+		if (element == context)
+			return false;
+
+		KModelElement* ancestor = element->parent;
+		if (!steps[stepIndex].descendant)
+			return ancestor && matchesPath(ancestor, stepIndex - 1, context, index);
+
+		for (; ancestor; ancestor = ancestor->parent)
+		{
+			if (matchesPath(ancestor, stepIndex - 1, context, index))
+				return true;
+
+			if (ancestor == context)
+				break;
+		}
+
+		return false;
+	}
+
+	static bool isInside(const KModelElement* element, const KModelElement* context) noexcept
+	{
+		for (; element; element = element->parent)
+		{
+			if (element == context)
+				return true;
+		}
+
+		return false;
+	}
+
+	// walks the tree and calls func for each match. returns false if func stopped it.
+	template<typename Func>
+	bool walk(KModelElement* context, KModelIndex* index, Func& func) const noexcept
+	{
+		if (stepCount == 0)
+			return true;
+
+		const int lastStep = stepCount - 1;
+		const int stepOffset = absolute ? 0 : 1; // step index of an element is depth - stepOffset
+
+		KModelElement* element = absolute ? context : context->firstChild;
+		int depth = absolute ? 0 : 1;
+
+		while (element)
+		{
+			const int stepIndex = depth - stepOffset;
+			bool enterChildren = true;
+			bool candidate = true;
+
+			if (stepIndex < firstDescendantStep) // fixed child steps. skip the subtrees which do not match.
+			{
+				if (!matchesStep(element, stepIndex, index))
+				{
+					enterChildren = false;
+					candidate = false;
+				}
+				else if (stepIndex == lastStep)
+				{
+					enterChildren = false;
+				}
+				else
+				{
+					candidate = false;
+				}
+			}
+
+			if (candidate && matchesPath(element, lastStep, context, index))
+			{
+				if (!func(element))
+					return false;
+			}
+
+			if (enterChildren && element->firstChild)
+			{
+				element = element->firstChild;
+				++depth;
+				continue;
+			}
+
+			while ((element != context) && (element->next == nullptr))
+			{
+				element = element->parent;
+				--depth;
+			}
+
+			if (element == context)
+				break;
+
+			element = element->next;
+		}
+
+		return true;
+	}
+
+	// uses the index if the last step can be resolved by it. returns false if the index cannot be used.
+	template<typename Func>
+	bool walkIndex(KModelElement* context, KModelIndex* index, Func& func) const noexcept
+	{
+		const Step& step = steps[stepCount - 1];
+
+		for (int i = step.firstPredicate; i < (step.firstPredicate + step.predicateCount); i++)
+		{
+			const Predicate& predicate = predicates[i];
+			if (isIdPredicate(predicate, index))
+			{
+				KModelElement* element = index->findById(predicate.value, (int)predicate.valueLength);
+				if (element && matchesPath(element, stepCount - 1, context, index))
+					func(element);
+
+				return true;
+			}
+		}
+
+		if (step.anyElement)
+			return false;
+
+		KModelElementList* list = index->getElementsOfType(step.elementType);
+		if (list == nullptr)
+			return true;
+
+		for (KModelElement* element : *list)
+		{
+			if (matchesPath(element, stepCount - 1, context, index))
+			{
+				if (!func(element))
+					break;
+			}
+		}
+
+		return true;
+	}
+
+public:
+	KModelQuery() noexcept
+	{
+		steps = nullptr;
+		stepCount = 0;
+		predicates = nullptr;
+		predicateCount = 0;
+		absolute = false;
+		firstDescendantStep = 0;
+	}
+
+	/**
+		Compiles the path. element names are converted to elementType using factory->getElementType.
+		@returns false on syntax error or if the factory does not know an element name. (use * for any element)
+	*/
+	bool compile(const wchar_t* path, KModelElementFactory* factory) noexcept
+	{
+		clear();
+
+		if ((!path) || (!factory))
+			return false;
+
+		const wchar_t* position = path;
+		skipSpaces(&position);
+
+		absolute = (*position == L'/');
+		bool descendant = false;
+
+		while (true)
+		{
+			if (*position == L'/')
+			{
+				++position;
+				descendant = (*position == L'/');
+				if (descendant)
+					++position;
+			}
+			else if (stepCount != 0)
+			{
+				break;
+			}
+
+			Step step;
+			step.descendant = descendant;
+			step.anyElement = false;
+			step.elementType = (int)KModelElementType::Unknown;
+			step.firstPredicate = predicateCount;
+			step.predicateCount = 0;
+
+			const wchar_t* name = position;
+			while (!isNameEnd(*position))
+				++position;
+
+			if (position == name)
+				return failCompile();
+
+			if (((position - name) == 1) && (*name == L'*'))
+			{
+				step.anyElement = true;
+			}
+			else
+			{
+				const wchar_t* localName = name;
+				for (const wchar_t* c = name; c < position; c++) // namespace prefix is ignored like in KXMLReader
+				{
+					if (*c == L':')
+						localName = c + 1;
+				}
+
+				wchar_t* elementName = copyText(localName, position - localName);
+				if (elementName == nullptr)
+					return failCompile();
+
+				step.elementType = factory->getElementType(elementName, (UINT)(position - localName));
+				::free(elementName);
+
+				// unknown type is shared by all the unregistered elements. it would match every one of them.
+				if (step.elementType == (int)KModelElementType::Unknown)
+					return failCompile();
+			}
+
+			while (*position == L'[') // [@name='value']
+			{
+				++position;
+				skipSpaces(&position);
+
+				if (*position != L'@')
+					return failCompile();
+
+				const wchar_t* attributeName = ++position;
+				while (!isNameEnd(*position))
+					++position;
+
+				const size_t attributeNameLength = position - attributeName;
+				skipSpaces(&position);
+
+				if ((attributeNameLength == 0) || (*position != L'='))
+					return failCompile();
+
+				++position;
+				skipSpaces(&position);
+
+				const wchar_t quote = *position;
+				if ((quote != L'\'') && (quote != L'"'))
+					return failCompile();
+
+				const wchar_t* value = ++position;
+				while (*position && (*position != quote))
+					++position;
+
+				if (*position != quote)
+					return failCompile();
+
+				const size_t valueLength = position - value;
+				++position;
+				skipSpaces(&position);
+
+				if ((*position != L']') || !addPredicate(attributeName, attributeNameLength, value, valueLength))
+					return failCompile();
+
+				++position;
+				++step.predicateCount;
+			}
+
+			if (!addStep(step))
+				return failCompile();
+		}
+
+		skipSpaces(&position);
+		if (*position != 0)
+			return failCompile();
+
+		firstDescendantStep = stepCount;
+		for (int i = 0; i < stepCount; i++)
+		{
+			if (steps[i].descendant)
+			{
+				firstDescendantStep = i;
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	bool isCompiled() const noexcept
+	{
+		return stepCount != 0;
+	}
+
+	/**
+		Calls func(KModelElement*) for each match in document order. func returns false to stop.
+		For absolute paths, context is the root element. Otherwise the path is relative to the context.
+		If the index is given and the last step has an id predicate or an element name, the candidates are taken from
+		the index instead of walking the whole tree. The index also resolves the id predicates of every step.
+		@returns false if the func stopped the search.
+	*/
+	template<typename Func>
+	bool forEachUntil(KModelElement* context, Func&& func, KModelIndex* index = nullptr) const noexcept
+	{
+		if ((!context) || (stepCount == 0))
+			return true;
+
+		bool completed = true;
+		auto callback = [&](KModelElement* element) -> bool {
+			completed = func(element);
+			return completed;
+		};
+
+		if (index && walkIndex(context, index, callback))
+			return completed;
+
+		walk(context, index, callback);
+		return completed;
+	}
+
+	/**
+		Calls func(KModelElement*) for each match in document order.
+	*/
+	template<typename Func>
+	void forEach(KModelElement* context, Func&& func, KModelIndex* index = nullptr) const noexcept
+	{
+		forEachUntil(context, [&](KModelElement* element) -> bool {
+			func(element);
+			return true;
+		}, index);
+	}
+
+	/**
+		returns the first match in document order or null.
+	*/
+	KModelElement* findFirst(KModelElement* context, KModelIndex* index = nullptr) const noexcept
+	{
+		KModelElement* result = nullptr;
+		forEachUntil(context, [&result](KModelElement* element) -> bool {
+			result = element;
+			return false;
+		}, index);
+
+		return result;
+	}
+
+	/**
+		Adds all the matches to the list. returns the number of matches.
+	*/
+	int findAll(KModelElement* context, KModelElementList* results, KModelIndex* index = nullptr) const noexcept
+	{
+		int count = 0;
+		forEach(context, [results, &count](KModelElement* element) {
+			results->add(element);
+			++count;
+		}, index);
+
+		return count;
+	}
+
+	/**
+		returns true if the element is a result of this query for the given context.
+	*/
+	bool matches(KModelElement* element, KModelElement* context, KModelIndex* index = nullptr) const noexcept
+	{
+		return element && context && (stepCount != 0) && matchesPath(element, stepCount - 1, context, index);
+	}
+
+	void clear() noexcept
+	{
+		for (int i = 0; i < predicateCount; i++)
+		{
+			::free(predicates[i].name);
+			::free(predicates[i].value);
+		}
+
+		::free(predicates);
+		::free(steps);
+
+		steps = nullptr;
+		stepCount = 0;
+		predicates = nullptr;
+		predicateCount = 0;
+		absolute = false;
+		firstDescendantStep = 0;
+	}
+
+	~KModelQuery() noexcept
+	{
+		clear();
+	}
+
+	// no copy/movable
+	KModelQuery(const KModelQuery&) = delete;
+	KModelQuery& operator=(const KModelQuery&) = delete;
+	KModelQuery(KModelQuery&&) = delete;
+	KModelQuery& operator=(KModelQuery&&) = delete;
+};
+
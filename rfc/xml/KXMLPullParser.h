@@ -0,0 +1,771 @@
+
+/*
+	Copyright (C) 2013-2026 CrownSoft
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+
+// part of the input buffer. not null terminated.
+template<typename CharT>
+struct KXMLSlice
+{
+	const CharT* text;
+	size_t length;
+};
+
+enum class KXMLToken : int
+{
+	EndOfDocument = 0,
+	StartElement, // name is available. attributes can be read with nextAttribute.
+	EndElement, // not reported for self closing elements.
+	Text, // raw text. entity references are not decoded. (except CDATA, which has none)
+	Error
+};
+
+/**
+	Pull XML tokenizer which works on the input buffer in place. It does not allocate memory or copy the input.
+	Names, attribute values and texts are returned as slices of the input buffer.
+	Comments, processing instructions, DOCTYPE and whitespace only texts are skipped.
+	Not a validating parser. end tag names are not matched against the start tags.
+
+	CharT is the code unit type of the input. char for UTF-8, char16_t or wchar_t for UTF-16.
+	Does not depend on the Windows headers.
+
+	e.g. @code
+	KXMLPullParser<char> parser(data, size);
+	KXMLToken token;
+	while ((token = parser.next()) > KXMLToken::EndOfDocument && token != KXMLToken::Error)
+	{
+		if (token == KXMLToken::StartElement)
+		{
+			KXMLSlice<char> name, value;
+			while (parser.nextAttribute(&name, &value))
+			{
+				// ...
+			}
+		}
+	}
+	@endcode
+*/
+template<typename CharT>
+class KXMLPullParser
+{
+protected:
+	const CharT* position;
+	const CharT* end;
+
+	const CharT* tokenStart; // '<' of the current start or end element
+
+	KXMLSlice<CharT> name;
+	KXMLSlice<CharT> text;
+
+	int depth;
+	bool inStartTag; // attributes of the last start element are not consumed yet
+	bool emptyElement;
+	bool cdata;
+	bool rootFound;
+	bool fragment; // multiple top level elements and text are allowed
+	bool failed;
+
+	static inline bool isWhitespace(CharT c) noexcept
+	{
+		return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+	}
+
+	static inline bool isNameEnd(CharT c) noexcept
+	{
+		return isWhitespace(c) || (c == '>') || (c == '/') || (c == '=');
+	}
+
+	// returns true if the input at position starts with the given ascii text.
+	inline bool startsWith(const char* prefix, size_t length) const noexcept
+	{
+		if ((size_t)(end - position) < length)
+			return false;
+
+		for (size_t i = 0; i < length; i++)
+		{
+			if (position[i] != (CharT)prefix[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	// moves the position after the given ascii terminator. returns start of the terminator or null.
+	const CharT* skipAfter(const char* terminator, size_t length) noexcept
+	{
+		while (position < end)
+		{
+			if ((*position == (CharT)terminator[0]) && startsWith(terminator, length))
+			{
+				const CharT* found = position;
+				position += length;
+				return found;
+			}
+
+			++position;
+		}
+
+		return nullptr;
+	}
+
+	inline void skipWhitespace() noexcept
+	{
+		while ((position < end) && isWhitespace(*position))
+			++position;
+	}
+
+	inline void readName(KXMLSlice<CharT>* slice) noexcept
+	{
+		const CharT* start = position;
+		while ((position < end) && !isNameEnd(*position))
+			++position;
+
+		slice->text = start;
+		slice->length = (size_t)(position - start);
+	}
+
+	KXMLToken fail() noexcept
+	{
+		failed = true;
+		inStartTag = false;
+		return KXMLToken::Error;
+	}
+
+	// moves the position to the next given character or to the end.
+	inline void findChar(CharT value) noexcept
+	{
+		if constexpr (sizeof(CharT) == 1)
+		{
+			const void* found = ::memchr(position, value, (size_t)(end - position));
+			position = found ? (const CharT*)found : end;
+		}
+		else
+		{
+			while ((position < end) && (*position != value))
+				++position;
+		}
+	}
+
+	// moves the position after the '>' of the current tag. quoted attribute values may contain '>'.
+	// returns 1 for an empty element tag, 0 for others and -1 on error.
+	int skipTagEnd() noexcept
+	{
+		while (position < end)
+		{
+			const CharT c = *position++;
+
+			if (c == '>')
+				return (position[-2] == '/') ? 1 : 0;
+
+			if ((c == '"') || (c == '\''))
+			{
+				findChar(c);
+				if (position == end)
+					return -1;
+
+				++position;
+			}
+		}
+
+		return -1;
+	}
+
+	// skips <!DOCTYPE ...> including the internal subset.
+	bool skipDeclaration() noexcept
+	{
+		int bracketDepth = 0;
+		CharT quote = 0;
+
+		while (position < end)
+		{
+			const CharT c = *position++;
+
+			if (quote)
+			{
+				if (c == quote)
+					quote = 0;
+			}
+			else if ((c == '"') || (c == '\''))
+			{
+				quote = c;
+			}
+			else if (c == '[')
+			{
+				++bracketDepth;
+			}
+			else if (c == ']')
+			{
+				--bracketDepth;
+			}
+			else if ((c == '>') && (bracketDepth <= 0))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+public:
+	static inline unsigned int toCodeUnit(CharT c) noexcept
+	{
+		if constexpr (sizeof(CharT) == 1)
+			return (unsigned char)c;
+		else if constexpr (sizeof(CharT) == 2)
+			return (unsigned short)c;
+		else
+			return (unsigned int)c;
+	}
+
+	KXMLPullParser(const CharT* buffer = nullptr, size_t length = 0, bool fragment = false) noexcept
+	{
+		setInput(buffer, length, fragment);
+	}
+
+	/**
+		Starts parsing the given buffer. Buffer must be valid while the parser is used.
+		@param fragment allows a sequence of elements and text instead of a single root element.
+	*/
+	void setInput(const CharT* buffer, size_t length, bool fragment = false) noexcept
+	{
+		position = buffer;
+		end = buffer + length;
+		tokenStart = buffer;
+		name.text = nullptr;
+		name.length = 0;
+		text.text = nullptr;
+		text.length = 0;
+		depth = 0;
+		inStartTag = false;
+		emptyElement = false;
+		cdata = false;
+		rootFound = false;
+		this->fragment = fragment;
+		failed = (buffer == nullptr);
+	}
+
+	KXMLToken next() noexcept
+	{
+		if (failed)
+			return KXMLToken::Error;
+
+		if (inStartTag) // skip the attributes which are not read
+		{
+			KXMLSlice<CharT> attributeName, attributeValue;
+			while (nextAttribute(&attributeName, &attributeValue)) {}
+
+			if (failed)
+				return KXMLToken::Error;
+		}
+
+		while (position < end)
+		{
+			if (*position != '<')
+			{
+				const CharT* start = position;
+				bool whitespaceOnly = true;
+
+				while ((position < end) && (*position != '<'))
+				{
+					if (whitespaceOnly && !isWhitespace(*position))
+						whitespaceOnly = false;
+
+					++position;
+				}
+
+				if (whitespaceOnly)
+					continue;
+
+				if ((depth == 0) && !fragment) // text outside of the root element
+					return fail();
+
+				text.text = start;
+				text.length = (size_t)(position - start);
+				cdata = false;
+				return KXMLToken::Text;
+			}
+
+			if (startsWith("<!--", 4))
+			{
+				position += 4;
+				if (!skipAfter("-->", 3))
+					return fail();
+			}
+			else if (startsWith("<![CDATA[", 9))
+			{
+				position += 9;
+				const CharT* start = position;
+				const CharT* terminator = skipAfter("]]>", 3);
+
+				if ((terminator == nullptr) || ((depth == 0) && !fragment))
+					return fail();
+
+				text.text = start;
+				text.length = (size_t)(terminator - start);
+				cdata = true;
+				return KXMLToken::Text;
+			}
+			else if (startsWith("<!", 2))
+			{
+				position += 2;
+				if (!skipDeclaration())
+					return fail();
+			}
+			else if (startsWith("<?", 2))
+			{
+				position += 2;
+				if (!skipAfter("?>", 2))
+					return fail();
+			}
+			else if (startsWith("</", 2))
+			{
+				tokenStart = position;
+				position += 2;
+				readName(&name);
+				skipWhitespace();
+
+				if ((name.length == 0) || (position == end) || (*position != '>') || (depth == 0))
+					return fail();
+
+				++position;
+				--depth;
+				return KXMLToken::EndElement;
+			}
+			else
+			{
+				tokenStart = position++;
+				readName(&name);
+
+				if ((name.length == 0) || ((depth == 0) && rootFound && !fragment)) // only one root element allowed
+					return fail();
+
+				rootFound = true;
+				++depth;
+				inStartTag = true;
+				emptyElement = false;
+				return KXMLToken::StartElement;
+			}
+		}
+
+		if ((depth != 0) || (!rootFound && !fragment))
+			return fail();
+
+		return KXMLToken::EndOfDocument;
+	}
+
+	/**
+		Skips the current start element with all of its content without reporting the tokens.
+		Call after next returned StartElement. Attributes and names are not checked. only the tag structure is scanned.
+		@returns false on error.
+	*/
+	bool skipElement() noexcept
+	{
+		if (failed || !inStartTag)
+			return false;
+
+		inStartTag = false;
+
+		int result = skipTagEnd();
+		if (result < 0)
+		{
+			fail();
+			return false;
+		}
+
+		int level = (result == 1) ? 0 : 1;
+
+		while (level > 0)
+		{
+			findChar('<');
+
+			if (position == end)
+			{
+				fail();
+				return false;
+			}
+
+			if (startsWith("<!--", 4))
+			{
+				position += 4;
+				result = skipAfter("-->", 3) ? 0 : -1;
+			}
+			else if (startsWith("<![CDATA[", 9))
+			{
+				position += 9;
+				result = skipAfter("]]>", 3) ? 0 : -1;
+			}
+			else if (startsWith("<!", 2))
+			{
+				position += 2;
+				result = skipDeclaration() ? 0 : -1;
+			}
+			else if (startsWith("<?", 2))
+			{
+				position += 2;
+				result = skipAfter("?>", 2) ? 0 : -1;
+			}
+			else if (startsWith("</", 2))
+			{
+				position += 2;
+				result = skipTagEnd();
+				--level;
+			}
+			else
+			{
+				++position;
+				result = skipTagEnd();
+				if (result == 0)
+					++level;
+			}
+
+			if (result < 0)
+			{
+				fail();
+				return false;
+			}
+		}
+
+		--depth;
+		emptyElement = false;
+		return true;
+	}
+
+	/**
+		Reads the next attribute of the current start element.
+		@returns false when there are no more attributes. (or on error)
+	*/
+	bool nextAttribute(KXMLSlice<CharT>* attributeName, KXMLSlice<CharT>* attributeValue) noexcept
+	{
+		if (!inStartTag)
+			return false;
+
+		skipWhitespace();
+
+		if (position == end)
+		{
+			fail();
+			return false;
+		}
+
+		if (*position == '>')
+		{
+			++position;
+			inStartTag = false;
+			return false;
+		}
+
+		if (*position == '/')
+		{
+			if (((end - position) < 2) || (position[1] != '>'))
+			{
+				fail();
+				return false;
+			}
+
+			position += 2;
+			inStartTag = false;
+			emptyElement = true;
+			--depth;
+			return false;
+		}
+
+		readName(attributeName);
+		skipWhitespace();
+
+		if ((attributeName->length == 0) || (position == end) || (*position != '='))
+		{
+			fail();
+			return false;
+		}
+
+		++position;
+		skipWhitespace();
+
+		if ((position == end) || ((*position != '"') && (*position != '\'')))
+		{
+			fail();
+			return false;
+		}
+
+		const CharT quote = *position++;
+		const CharT* start = position;
+
+		while ((position < end) && (*position != quote))
+			++position;
+
+		if (position == end)
+		{
+			fail();
+			return false;
+		}
+
+		attributeValue->text = start;
+		attributeValue->length = (size_t)(position - start);
+		++position;
+
+		return true;
+	}
+
+	/**
+		Valid after nextAttribute returned false.
+	*/
+	bool isEmptyElement() const noexcept
+	{
+		return emptyElement;
+	}
+
+	/**
+		Qualified name of the current start or end element.
+	*/
+	KXMLSlice<CharT> getName() const noexcept
+	{
+		return name;
+	}
+
+	KXMLSlice<CharT> getText() const noexcept
+	{
+		return text;
+	}
+
+	/**
+		returns true if the current text is a CDATA section.
+	*/
+	bool isCDATA() const noexcept
+	{
+		return cdata;
+	}
+
+	int getDepth() const noexcept
+	{
+		return depth;
+	}
+
+	/**
+		returns the offset of the '<' of the last start or end element in code units.
+	*/
+	size_t getTokenStart(const CharT* buffer) const noexcept
+	{
+		return (size_t)(tokenStart - buffer);
+	}
+
+	/**
+		returns the offset of the parser in code units. can be used to locate an error.
+	*/
+	size_t getPosition(const CharT* buffer) const noexcept
+	{
+		return (size_t)(position - buffer);
+	}
+
+	/**
+		returns the part after the namespace prefix.
+	*/
+	static KXMLSlice<CharT> getLocalName(KXMLSlice<CharT> qualifiedName) noexcept
+	{
+		for (size_t i = qualifiedName.length; i > 0; i--)
+		{
+			if (qualifiedName.text[i - 1] == ':')
+			{
+				qualifiedName.text += i;
+				qualifiedName.length -= i;
+				break;
+			}
+		}
+
+		return qualifiedName;
+	}
+
+	/**
+		Reads one code point and returns the number of code units used. Invalid sequences give U+FFFD.
+	*/
+	static size_t readCodePoint(const CharT* text, size_t length, unsigned int* codePoint) noexcept
+	{
+		const unsigned int first = toCodeUnit(text[0]);
+
+		if constexpr (sizeof(CharT) == 1) // UTF-8
+		{
+			if (first < 0x80)
+			{
+				*codePoint = first;
+				return 1;
+			}
+
+			size_t count;
+			unsigned int value, minimum;
+
+			if ((first & 0xE0) == 0xC0)
+			{
+				count = 2; value = first & 0x1F; minimum = 0x80;
+			}
+			else if ((first & 0xF0) == 0xE0)
+			{
+				count = 3; value = first & 0x0F; minimum = 0x800;
+			}
+			else if ((first & 0xF8) == 0xF0)
+			{
+				count = 4; value = first & 0x07; minimum = 0x10000;
+			}
+			else
+			{
+				*codePoint = 0xFFFD;
+				return 1;
+			}
+
+			if (count > length)
+			{
+				*codePoint = 0xFFFD;
+				return 1;
+			}
+
+			for (size_t i = 1; i < count; i++)
+			{
+				const unsigned int next = (unsigned char)text[i];
+				if ((next & 0xC0) != 0x80)
+				{
+					*codePoint = 0xFFFD;
+					return i;
+				}
+
+				value = (value << 6) | (next & 0x3F);
+			}
+
+			*codePoint = ((value < minimum) || (value > 0x10FFFF) || ((value >= 0xD800) && (value <= 0xDFFF))) ? 0xFFFD : value;
+			return count;
+		}
+		else if constexpr (sizeof(CharT) == 2) // UTF-16
+		{
+			if ((first >= 0xD800) && (first <= 0xDBFF))
+			{
+				if (length > 1)
+				{
+					const unsigned int second = toCodeUnit(text[1]);
+					if ((second >= 0xDC00) && (second <= 0xDFFF))
+					{
+						*codePoint = 0x10000 + ((first - 0xD800) << 10) + (second - 0xDC00);
+						return 2;
+					}
+				}
+
+				*codePoint = 0xFFFD;
+				return 1;
+			}
+
+			*codePoint = ((first >= 0xDC00) && (first <= 0xDFFF)) ? 0xFFFD : first;
+			return 1;
+		}
+		else // UTF-32
+		{
+			*codePoint = (first > 0x10FFFF) ? 0xFFFD : first;
+			return 1;
+		}
+	}
+
+	/**
+		Decodes an entity reference which starts with '&'. Supports the predefined and numeric references.
+		@returns the number of code units used. zero if it is not a valid reference.
+	*/
+	static size_t readEntity(const CharT* text, size_t length, unsigned int* codePoint) noexcept
+	{
+		size_t semicolon = 1;
+		while ((semicolon < length) && (semicolon < 12) && (text[semicolon] != ';'))
+			++semicolon;
+
+		if ((semicolon >= length) || (text[semicolon] != ';') || (semicolon < 2))
+			return 0;
+
+		const CharT* entity = text + 1;
+		const size_t entityLength = semicolon - 1;
+
+		auto equals = [&](const char* value, size_t valueLength) -> bool {
+			if (entityLength != valueLength)
+				return false;
+
+			for (size_t i = 0; i < valueLength; i++)
+			{
+				if (entity[i] != (CharT)value[i])
+					return false;
+			}
+
+			return true;
+		};
+
+		if (entity[0] == '#')
+		{
+			unsigned int value = 0;
+			size_t i = 1;
+			const bool hex = (entityLength > 1) && (entity[1] == 'x');
+
+			if (hex)
+				++i;
+
+			if (i == entityLength)
+				return 0;
+
+			for (; i < entityLength; i++)
+			{
+				const CharT c = entity[i];
+				unsigned int digit;
+
+				if ((c >= '0') && (c <= '9'))
+					digit = (unsigned int)(c - '0');
+				else if (hex && (c >= 'a') && (c <= 'f'))
+					digit = (unsigned int)(c - 'a') + 10;
+				else if (hex && (c >= 'A') && (c <= 'F'))
+					digit = (unsigned int)(c - 'A') + 10;
+				else
+					return 0;
+
+				value = (value * (hex ? 16 : 10)) + digit;
+			}
+
+			*codePoint = ((value == 0) || (value > 0x10FFFF) || ((value >= 0xD800) && (value <= 0xDFFF))) ? 0xFFFD : value;
+		}
+		else if (equals("lt", 2))
+		{
+			*codePoint = '<';
+		}
+		else if (equals("gt", 2))
+		{
+			*codePoint = '>';
+		}
+		else if (equals("amp", 3))
+		{
+			*codePoint = '&';
+		}
+		else if (equals("quot", 4))
+		{
+			*codePoint = '"';
+		}
+		else if (equals("apos", 4))
+		{
+			*codePoint = '\'';
+		}
+		else
+		{
+			return 0;
+		}
+
+		return semicolon + 1;
+	}
+};
+
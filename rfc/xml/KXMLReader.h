@@ -21,9 +21,11 @@
 
 #pragma once
 
-#include <windows.h>
-#include <Xmllite.h>
-#include <shlwapi.h>
+#include "../core/CoreModule.h"
+#include "../containers/ContainersModule.h"
+#include "../file/KMappedFile.h"
+#include "../thread/ThreadModule.h"
+#include "KXMLPullParser.h"
 
 enum class KModelElementType : int {
 	Unknown = -1
@@ -33,12 +35,37 @@ enum class KModelElementType : int {
 // each type has unique elementType value which can be used to identify the instance type.
 class KModelElement
 {
+protected:
+	// deletes the given sibling list and all of their children without recursion.
+	static void deleteElements(KModelElement* element) noexcept
+	{
+		while (element)
+		{
+			if (element->firstChild) // move the children in front of the remaining siblings
+			{
+				KModelElement* lastChild = element->firstChild;
+				while (lastChild->next)
+					lastChild = lastChild->next;
+
+				lastChild->next = element->next;
+				element->next = element->firstChild;
+				element->firstChild = nullptr;
+			}
+
+			KModelElement* nextElement = element->next;
+			element->next = nullptr;
+			delete element;
+			element = nextElement;
+		}
+	}
+
 public:
 	int elementType;
 	KModelElement* next;
 	KModelElement* prev;
 	KModelElement* parent;
 	KModelElement* firstChild;
+	bool ownedByArena; // created by KModelElementFactory::createElement into a KModelDocument
 
 	KModelElement() noexcept
 	{
@@ -47,6 +74,7 @@ public:
 		prev = nullptr;
 		parent = nullptr;
 		firstChild = nullptr;
+		ownedByArena = false;
 	}
 
 	// name and value will become invalid after the call.
@@ -58,125 +86,504 @@ public:
 	// make a copy of content if you are using it for later.
 	virtual void setContent(const wchar_t* content, UINT length) noexcept {}
 
-	// deleting root node will recuresively delete all other nodes.
-	virtual ~KModelElement() noexcept
+	// used by the [@name='value'] predicates of KModelQuery.
+	// override it and compare with the stored attribute. (e.g. convert the value if it is stored as a number)
+	virtual bool matchesAttribute(const wchar_t* name, UINT nameLength,
+		const wchar_t* value, UINT valueLength) noexcept
+	{
+		return false;
+	}
+
+	/**
+		returns the next element of the subtree of root in document order. (depth first, pre-order)
+		returns null after the last element. does not use recursion or extra memory.
+
+		e.g. @code
+		for (KModelElement* element = root; element; element = element->getNextElement(root))
+		{
+			// ...
+		}
+		@endcode
+	*/
+	KModelElement* getNextElement(const KModelElement* root) noexcept
 	{
 		if (firstChild)
-			delete firstChild;
+			return firstChild;
 
-		if (next)
-			delete next;
+		return getNextElementSkipChildren(root);
+	}
+
+	/**
+		same as getNextElement but does not enter the children of this element.
+	*/
+	KModelElement* getNextElementSkipChildren(const KModelElement* root) noexcept
+	{
+		KModelElement* element = this;
+		while (element && (element != root))
+		{
+			if (element->next)
+				return element->next;
+
+			element = element->parent;
+		}
+
+		return nullptr;
+	}
+
+	// deleting root node will delete all other nodes. (without recursion)
+	// elements of a KModelDocument are destroyed by the document. do not delete them.
+	virtual ~KModelElement() noexcept
+	{
+		if (ownedByArena)
+			return;
+
+		deleteElements(firstChild);
+		deleteElements(next);
 	}
 };
 
 class KModelElementFactory
 {
+protected:
+	KArena* arena; // arena of the document being parsed. null when parsing into the heap.
+	static inline thread_local KArena* threadArena = nullptr; // overrides the arena on the parallel parsing threads.
+
 public:
+	KModelElementFactory() noexcept
+	{
+		arena = nullptr;
+	}
+
+	/**
+		Creates T in the arena of the document being parsed or in the heap.
+		Use it inside createModelElement so the same factory can be used for both cases.
+		Destructor of T is called when the document is cleared.
+	*/
+	template<typename T>
+	T* createElement() noexcept
+	{
+		KArena* targetArena = threadArena ? threadArena : arena;
+		if (targetArena == nullptr)
+			return new T();
+
+		T* element = targetArena->create<T>();
+		if (element)
+			element->ownedByArena = true;
+
+		return element;
+	}
+
+	void setArena(KArena* arena) noexcept
+	{
+		this->arena = arena;
+	}
+
+	KArena* getArena() const noexcept
+	{
+		return arena;
+	}
+
+	/**
+		Sets the arena used by createElement on the calling thread instead of the factory arena.
+		Used by KXMLReader::parseParallel. pass null to remove.
+	*/
+	static void setThreadArena(KArena* arena) noexcept
+	{
+		threadArena = arena;
+	}
+
 	// create the required element type with default values.
 	// if the elementType is unknown, return an object of KModelElement with id of KModelElementType::Unknown.
 	virtual KModelElement* createModelElement(const wchar_t* elementName, UINT length) noexcept = 0;
+
+	// returns the elementType of the given element name. used by KModelQuery to compile the names.
+	// default implementation creates a temporary element. override it if that is expensive.
+	virtual int getElementType(const wchar_t* elementName, UINT length) noexcept
+	{
+		// the temporary element must come from the heap. so both arenas are removed while creating it.
+		KArena* factoryArena = arena;
+		KArena* callerThreadArena = threadArena;
+		arena = nullptr;
+		threadArena = nullptr;
+		KModelElement* element = createModelElement(elementName, length);
+		arena = factoryArena;
+		threadArena = callerThreadArena;
+
+		if (!element)
+			return (int)KModelElementType::Unknown;
+
+		const int elementType = element->elementType;
+		delete element;
+
+		return elementType;
+	}
+
+	virtual ~KModelElementFactory() noexcept {}
 };
 
-// https://learn.microsoft.com/en-us/archive/msdn-magazine/2007/april/xmllite-a-small-and-fast-xml-parser-for-native-c
-// requires COM initialization
-// builds a custom model when parsing and returns the root element of the model.
-class KXMLReader {
+/**
+	Element tree which is allocated from a single arena.
+	Clearing the document calls the element destructors and releases the arena at once.
+	All the elements must be created using KModelElementFactory::createElement.
+	see KXMLReader::parse(KModelElementFactory*, KModelDocument*)
+*/
+class KModelDocument
+{
 protected:
-	IStream* stream;
+	KArena arena;
+	KModelElement* rootElement;
 
 public:
-	IXmlReader* reader;
+	/**
+		@param chunkSize minimum size of the arena chunks.
+	*/
+	KModelDocument(size_t chunkSize = 256 * 1024) noexcept : arena(chunkSize)
+	{
+		rootElement = nullptr;
+	}
 
-	KXMLReader() noexcept
+	KModelElement* getRootElement() const noexcept
 	{
-		reader = nullptr;
-		stream = nullptr;
-		::CreateXmlReader(__uuidof(IXmlReader), reinterpret_cast<void**>(&reader), 0);
+		return rootElement;
 	}
 
-	bool loadFromFile(const wchar_t* filePath) noexcept
+	void setRootElement(KModelElement* rootElement) noexcept
 	{
-		if (!reader)
-			return false;
+		this->rootElement = rootElement;
+	}
+
+	KArena* getArena() noexcept
+	{
+		return &arena;
+	}
 
-		if (stream)
-			stream->Release();
+	// destroys all the elements. chunks are kept for the next parse.
+	void clear() noexcept
+	{
+		rootElement = nullptr;
+		arena.reset();
+	}
 
-		stream = nullptr;
-		if (::SHCreateStreamOnFileW(filePath, STGM_READ | STGM_SHARE_DENY_WRITE, &stream) != S_OK)
-			return false;
+	~KModelDocument() noexcept
+	{
+		rootElement = nullptr;
+		arena.release();
+	}
 
-		if (reader->SetInput(stream) != S_OK)
-		{
-			stream->Release();
-			stream = nullptr;
-			return false;
-		}
+	// no copy/movable
+	KModelDocument(const KModelDocument&) = delete;
+	KModelDocument& operator=(const KModelDocument&) = delete;
+	KModelDocument(KModelDocument&&) = delete;
+	KModelDocument& operator=(KModelDocument&&) = delete;
+};
 
-		return true;
+typedef KVector<KModelElement*, 16, false> KModelElementList;
+
+/**
+	Id and elementType lookup tables which are filled while parsing. see KXMLReader::setIndex.
+	Elements are kept in document order. The index does not own the elements.
+	Clear it before the tree is destroyed.
+*/
+class KModelIndex
+{
+protected:
+	KString idAttributeName;
+	KHashMap<KString, KModelElement*, 16, false> idMap;
+	KHashMap<int, KModelElementList*, 16, false> typeMap;
+
+public:
+	/**
+		@param idAttributeName elements are indexed by the value of this attribute.
+	*/
+	KModelIndex(const KString& idAttributeName = KString(L"id")) noexcept : idAttributeName(idAttributeName) {}
+
+	const KString& getIdAttributeName() const noexcept
+	{
+		return idAttributeName;
 	}
 
-	bool loadFromString(const wchar_t* text, UINT length = 0) noexcept
+	void addElement(KModelElement* element) noexcept
 	{
-		if (!reader)
-			return false;
+		KModelElementList*& list = typeMap.getOrAdd(element->elementType);
+		if (list == nullptr)
+			list = new KModelElementList();
+
+		list->add(element);
+	}
+
+	void addAttribute(KModelElement* element, const wchar_t* name, UINT nameLength,
+		const wchar_t* value, UINT valueLength) noexcept
+	{
+		if ((nameLength != (UINT)idAttributeName.length()) || (::wcscmp(name, idAttributeName) != 0))
+			return;
+
+		// first element wins for duplicated ids
+		idMap.add(KString(value, KStringBehaviour::MAKE_A_COPY, (int)valueLength), element);
+	}
+
+	/**
+		returns null if there is no element with the given id.
+	*/
+	KModelElement* findById(const wchar_t* id, int length = -1) noexcept
+	{
+		KModelElement** element = idMap.find(KString(id, KStringBehaviour::DO_NOT_FREE, length));
+		return element ? *element : nullptr;
+	}
+
+	/**
+		returns elements of the given type in document order. null if there is none.
+	*/
+	KModelElementList* getElementsOfType(int elementType) noexcept
+	{
+		KModelElementList** list = typeMap.find(elementType);
+		return list ? *list : nullptr;
+	}
+
+	/**
+		appends the entries of the other index. used to join the indexes of the parallel parsing.
+	*/
+	void merge(KModelIndex* other) noexcept
+	{
+		other->typeMap.forEach([this](const int& elementType, KModelElementList*& otherList) {
+			KModelElementList*& list = typeMap.getOrAdd(elementType);
+			if (list == nullptr)
+				list = new KModelElementList();
+
+			for (KModelElement* element : *otherList)
+				list->add(element);
+		});
+
+		other->idMap.forEach([this](const KString& id, KModelElement*& element) {
+			idMap.add(id, element);
+		});
+	}
 
-		if (stream)
+	void clear() noexcept
+	{
+		typeMap.forEach([](const int& elementType, KModelElementList*& list) {
+			delete list;
+		});
+
+		typeMap.removeAll();
+		idMap.removeAll();
+	}
+
+	~KModelIndex() noexcept
+	{
+		clear();
+	}
+
+	// no copy/movable
+	KModelIndex(const KModelIndex&) = delete;
+	KModelIndex& operator=(const KModelIndex&) = delete;
+	KModelIndex(KModelIndex&&) = delete;
+	KModelIndex& operator=(KModelIndex&&) = delete;
+};
+
+// builds a custom model when parsing and returns the root element of the model.
+// uses KXMLPullParser. the input is tokenized in place without copying it.
+// supports UTF-8 and UTF-16LE files. names and values are passed to the model as null terminated wchar_t strings.
+class KXMLReader {
+protected:
+	enum class InputType : int
+	{
+		None,
+		UTF8,
+		UTF16,
+		WideChar
+	};
+
+	enum class SliceType : int
+	{
+		Name,
+		AttributeValue,
+		Text,
+		CDATA
+	};
+
+	KMappedFile mappedFile;
+	const void* input;
+	size_t inputLength; // in code units
+	InputType inputType;
+
+	// reusable buffers for the converted names and values. each parsing thread has its own.
+	struct ConversionBuffers
+	{
+		wchar_t* nameBuffer;
+		size_t nameBufferSize;
+		wchar_t* valueBuffer;
+		size_t valueBufferSize;
+
+		void init() noexcept
 		{
-			stream->Release();
-			stream = nullptr;
+			nameBuffer = nullptr;
+			nameBufferSize = 0;
+			valueBuffer = nullptr;
+			valueBufferSize = 0;
 		}
 
-		if (length == 0)
+		void release() noexcept
 		{
-			length = (UINT)::wcslen(text);
-			if (length == 0)
-				return false;
+			if (nameBuffer)
+				::free(nameBuffer);
+
+			if (valueBuffer)
+				::free(valueBuffer);
+
+			init();
 		}
+	};
 
-		stream = ::SHCreateMemStream((const BYTE*)text, sizeof(wchar_t) * (length + 1));
+	ConversionBuffers buffers;
+	KModelIndex* index;
 
-		if (!stream)
-			return false;
+	static inline wchar_t* writeCodePoint(wchar_t* out, unsigned int codePoint) noexcept
+	{
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			if (codePoint >= 0x10000)
+			{
+				codePoint -= 0x10000;
+				*out++ = (wchar_t)(0xD800 + (codePoint >> 10));
+				*out++ = (wchar_t)(0xDC00 + (codePoint & 0x3FF));
+				return out;
+			}
+		}
+
+		*out++ = (wchar_t)codePoint;
+		return out;
+	}
 
-		if (reader->SetInput(stream) != S_OK)
+	/**
+		Converts the slice into a null terminated wchar_t string inside the given buffer.
+		Decodes entity references and normalizes line ends and attribute whitespace.
+		The converted text never has more code units than the slice. (+1 for null)
+	*/
+	template<typename CharT>
+	static const wchar_t* convertSlice(KXMLSlice<CharT> slice, SliceType sliceType,
+		wchar_t** buffer, size_t* bufferSize, UINT* length) noexcept
+	{
+		if (*bufferSize <= slice.length)
 		{
-			stream->Release();
-			stream = nullptr;
-			return false;
+			const size_t newSize = (slice.length + 64) * 2;
+			wchar_t* newBuffer = (wchar_t*)::realloc(*buffer, newSize * sizeof(wchar_t));
+			if (newBuffer == nullptr)
+			{
+				*length = 0;
+				return L"";
+			}
+
+			*buffer = newBuffer;
+			*bufferSize = newSize;
 		}
 
-		return true;
+		const CharT* position = slice.text;
+		const CharT* end = slice.text + slice.length;
+		wchar_t* out = *buffer;
+
+		if constexpr (sizeof(CharT) == sizeof(wchar_t))
+		{
+			bool plain = true;
+			if (sliceType != SliceType::Name)
+			{
+				for (const CharT* p = position; p < end; ++p)
+				{
+					const CharT c = *p;
+					if ((c == '\r') || ((c == '&') && (sliceType != SliceType::CDATA)) ||
+						((sliceType == SliceType::AttributeValue) && ((c == '\n') || (c == '\t'))))
+					{
+						plain = false;
+						break;
+					}
+				}
+			}
+
+			if (plain) // same encoding and nothing to decode
+			{
+				::memcpy(out, position, slice.length * sizeof(wchar_t));
+				out[slice.length] = 0;
+				*length = (UINT)slice.length;
+				return out;
+			}
+		}
+
+		while (position < end)
+		{
+			const unsigned int c = KXMLPullParser<CharT>::toCodeUnit(*position);
+			unsigned int codePoint;
+
+			if ((c == '&') && (sliceType != SliceType::Name) && (sliceType != SliceType::CDATA))
+			{
+				const size_t used = KXMLPullParser<CharT>::readEntity(position, (size_t)(end - position), &codePoint);
+				if (used)
+				{
+					out = writeCodePoint(out, codePoint);
+					position += used;
+					continue;
+				}
+			}
+
+			if (c == '\r') // "\r\n" and "\r" become "\n"
+			{
+				++position;
+				if ((position < end) && (*position == '\n'))
+					++position;
+
+				*out++ = (sliceType == SliceType::AttributeValue) ? L' ' : L'\n';
+				continue;
+			}
+
+			if (c < 0x80)
+			{
+				if ((sliceType == SliceType::AttributeValue) && ((c == '\n') || (c == '\t')))
+					*out++ = L' ';
+				else
+					*out++ = (wchar_t)c;
+
+				++position;
+				continue;
+			}
+
+			position += KXMLPullParser<CharT>::readCodePoint(position, (size_t)(end - position), &codePoint);
+			out = writeCodePoint(out, codePoint);
+		}
+
+		*out = 0;
+		*length = (UINT)(out - *buffer);
+		return *buffer;
 	}
 
-	// returns the root model element. There can be only one root element in xml.
-	KModelElement* parse(KModelElementFactory* factory) noexcept
+	// fragment: buffer has a sequence of elements. they are returned as a sibling list without parent.
+	template<typename CharT>
+	static KModelElement* parseBuffer(const CharT* buffer, size_t length, KModelElementFactory* factory,
+		ConversionBuffers* buffers, KModelIndex* index, bool fragment = false) noexcept
 	{
-		if ((!reader) || (!stream) || (!factory))
-			return nullptr;
+		KXMLPullParser<CharT> parser(buffer, length, fragment);
 
 		KModelElement* rootElement = nullptr;
 		KModelElement* lastElement = nullptr;
 		KModelElement* lastElementWhichExpectedChild = nullptr;
 
-		XmlNodeType nodeType = XmlNodeType_None;
+		KXMLToken token;
+		UINT nameLength, valueLength;
 
 		bool expectChild = false;
-		while (S_OK == reader->Read(&nodeType))
+		while (((token = parser.next()) != KXMLToken::EndOfDocument) && (token != KXMLToken::Error))
 		{
-			switch (nodeType)
+			switch (token)
 			{
-				case XmlNodeType_Element:
+				case KXMLToken::StartElement:
 				{
-					PCWSTR elementName = nullptr;
-					UINT elementNameLength = 0;
+					const wchar_t* elementName = convertSlice(KXMLPullParser<CharT>::getLocalName(parser.getName()),
+						SliceType::Name, &buffers->nameBuffer, &buffers->nameBufferSize, &nameLength);
 
-					// localName is valid before calling MoveToFirstAttribute
-					reader->GetLocalName(&elementName, &elementNameLength);
+					KModelElement* newElement = factory->createModelElement(elementName, nameLength);
+					if (!newElement) // out of memory
+						return rootElement;
 
-					bool selfClosingElement = reader->IsEmptyElement(); // call before MoveToFirstAttribute
+					if (index)
+						index->addElement(newElement);
 
-					KModelElement* newElement = factory->createModelElement(elementName, elementNameLength);
 					if (!rootElement)
 						rootElement = newElement;
 
@@ -196,23 +603,21 @@ public:
 						}
 					}
 
-					PCWSTR attribName = nullptr;
-					PCWSTR attribValue = nullptr;
-					UINT attribNameLength = 0;
-					UINT attribValueLength = 0;
-
-					for (HRESULT result = reader->MoveToFirstAttribute();
-						S_OK == result;
-						result = reader->MoveToNextAttribute())
+					KXMLSlice<CharT> attribName, attribValue;
+					while (parser.nextAttribute(&attribName, &attribValue))
 					{
-						reader->GetLocalName(&attribName, &attribNameLength);
-						reader->GetValue(&attribValue, &attribValueLength);
+						const wchar_t* name = convertSlice(KXMLPullParser<CharT>::getLocalName(attribName),
+							SliceType::Name, &buffers->nameBuffer, &buffers->nameBufferSize, &nameLength);
+						const wchar_t* value = convertSlice(attribValue, SliceType::AttributeValue,
+							&buffers->valueBuffer, &buffers->valueBufferSize, &valueLength);
+
+						newElement->setAttribute(name, nameLength, value, valueLength);
 
-						newElement->setAttribute(attribName, attribNameLength,
-							attribValue, attribValueLength);
+						if (index)
+							index->addAttribute(newElement, name, nameLength, value, valueLength);
 					}
 
-					if (selfClosingElement)
+					if (parser.isEmptyElement()) // valid after reading all the attributes
 					{
 						expectChild = false;
 					}
@@ -226,19 +631,20 @@ public:
 
 					break;
 				}
-				case XmlNodeType_Text:
+				case KXMLToken::Text:
 				{
 					if (lastElement)
 					{
-						UINT elementContentLength = 0;
-						PCWSTR elementContent = nullptr;
-						reader->GetValue(&elementContent, &elementContentLength);
-						lastElement->setContent(elementContent, elementContentLength);
+						const wchar_t* content = convertSlice(parser.getText(),
+							parser.isCDATA() ? SliceType::CDATA : SliceType::Text,
+							&buffers->valueBuffer, &buffers->valueBufferSize, &valueLength);
+
+						lastElement->setContent(content, valueLength);
 					}
 
 					break;
 				}
-				case XmlNodeType_EndElement:
+				case KXMLToken::EndElement:
 				{
 					expectChild = false;
 					if (lastElementWhichExpectedChild)
@@ -261,14 +667,404 @@ public:
 		return rootElement;
 	}
 
-	virtual ~KXMLReader() noexcept
+	KModelElement* parseInputParallel(KModelElementFactory* factory, KThreadPool* threadPool, KArena* documentArena) noexcept
 	{
-		if (stream)
-			stream->Release();
+		if ((!factory) || (!threadPool))
+			return nullptr;
+
+		if ((!documentArena) && factory->getArena()) // shared arena cannot be used by the threads
+			return parse(factory);
 
-		if (reader)
-			reader->Release();
+		switch (inputType)
+		{
+			case InputType::UTF8:
+				return parseBufferParallel<char>((const char*)input, inputLength, factory, threadPool, documentArena);
+			case InputType::UTF16:
+				return parseBufferParallel<char16_t>((const char16_t*)input, inputLength, factory, threadPool, documentArena);
+			case InputType::WideChar:
+				return parseBufferParallel<wchar_t>((const wchar_t*)input, inputLength, factory, threadPool, documentArena);
+			default:
+				return nullptr;
+		}
 	}
+
+	template<typename CharT>
+	KModelElement* parseBufferParallel(const CharT* buffer, size_t length, KModelElementFactory* factory,
+		KThreadPool* threadPool, KArena* documentArena) noexcept
+	{
+		// structural scan. finds the top level children of the root without any callback.
+		KXMLPullParser<CharT> parser(buffer, length);
+		KXMLToken token;
+
+		size_t* childOffsets = nullptr;
+		size_t childCount = 0;
+		size_t childCapacity = 0;
+		size_t contentEnd = 0;
+		bool completed = false;
+
+		while (((token = parser.next()) != KXMLToken::EndOfDocument) && (token != KXMLToken::Error))
+		{
+			if (token == KXMLToken::StartElement)
+			{
+				if (parser.getDepth() == 1) // root
+					continue;
+
+				if (childCount == childCapacity)
+				{
+					childCapacity = (childCapacity == 0) ? 1024 : (childCapacity * 2);
+					size_t* newOffsets = (size_t*)::realloc(childOffsets, childCapacity * sizeof(size_t));
+					if (newOffsets == nullptr)
+						break;
+
+					childOffsets = newOffsets;
+				}
+
+				childOffsets[childCount++] = parser.getTokenStart(buffer);
+
+				if (!parser.skipElement())
+					break;
+			}
+			else if ((token == KXMLToken::EndElement) && (parser.getDepth() == 0))
+			{
+				contentEnd = parser.getTokenStart(buffer);
+				completed = (parser.next() == KXMLToken::EndOfDocument);
+				break;
+			}
+		}
+
+		// malformed or small document. serial parsing gives the same result as before.
+		if ((!completed) || (childCount < 2))
+		{
+			if (childOffsets)
+				::free(childOffsets);
+
+			return parseBuffer<CharT>(buffer, length, factory, &buffers, index);
+		}
+
+		// root element and its text before the first child.
+		parser.setInput(buffer, childOffsets[0]);
+		parser.next();
+
+		UINT nameLength, valueLength;
+		const wchar_t* elementName = convertSlice(KXMLPullParser<CharT>::getLocalName(parser.getName()),
+			SliceType::Name, &buffers.nameBuffer, &buffers.nameBufferSize, &nameLength);
+
+		KModelElement* rootElement = factory->createModelElement(elementName, nameLength);
+		if (!rootElement)
+		{
+			::free(childOffsets);
+			return nullptr;
+		}
+
+		if (index)
+			index->addElement(rootElement);
+
+		KXMLSlice<CharT> attribName, attribValue;
+		while (parser.nextAttribute(&attribName, &attribValue))
+		{
+			const wchar_t* name = convertSlice(KXMLPullParser<CharT>::getLocalName(attribName),
+				SliceType::Name, &buffers.nameBuffer, &buffers.nameBufferSize, &nameLength);
+			const wchar_t* value = convertSlice(attribValue, SliceType::AttributeValue,
+				&buffers.valueBuffer, &buffers.valueBufferSize, &valueLength);
+
+			rootElement->setAttribute(name, nameLength, value, valueLength);
+
+			if (index)
+				index->addAttribute(rootElement, name, nameLength, value, valueLength);
+		}
+
+		while (parser.next() == KXMLToken::Text) // ends with an error at the first child
+		{
+			const wchar_t* content = convertSlice(parser.getText(), parser.isCDATA() ? SliceType::CDATA : SliceType::Text,
+				&buffers.valueBuffer, &buffers.valueBufferSize, &valueLength);
+
+			rootElement->setContent(content, valueLength);
+		}
+
+		// split the children into batches of about the same size. text after a child belongs to its batch.
+		const int threadCount = threadPool->getWorkerCount() + 1;
+		const size_t contentSize = contentEnd - childOffsets[0];
+		const size_t batchSize = (contentSize / ((size_t)threadCount * 8)) + 1;
+
+		size_t* batchOffsets = childOffsets; // reuses the same array. batch count <= child count.
+		int batchCount = 0;
+		size_t lastOffset = 0;
+
+		for (size_t i = 0; i < childCount; i++)
+		{
+			if ((batchCount == 0) || ((childOffsets[i] - lastOffset) >= batchSize))
+			{
+				lastOffset = childOffsets[i];
+				batchOffsets[batchCount++] = lastOffset;
+			}
+		}
+
+		KModelElement** batchElements = (KModelElement**)::calloc(batchCount, sizeof(KModelElement*));
+		KArena** batchArenas = documentArena ? (KArena**)::calloc(batchCount, sizeof(KArena*)) : nullptr;
+		KModelIndex** batchIndexes = index ? (KModelIndex**)::calloc(batchCount, sizeof(KModelIndex*)) : nullptr;
+
+		if ((batchElements == nullptr) || (documentArena && (batchArenas == nullptr)) || (index && (batchIndexes == nullptr)))
+		{
+			::free(batchElements);
+			::free(batchArenas);
+			::free(batchIndexes);
+			::free(childOffsets);
+			return rootElement;
+		}
+
+		// index is not thread safe either. batch indexes are merged in document order.
+		for (int i = 0; batchIndexes && (i < batchCount); i++)
+			batchIndexes[i] = new KModelIndex(index->getIdAttributeName());
+
+		// arena is not thread safe. each batch gets its own arena which is destroyed with the document arena.
+		for (int i = 0; batchArenas && (i < batchCount); i++)
+			batchArenas[i] = documentArena->create<KArena>(64 * 1024);
+
+		threadPool->parallelFor(0, batchCount, [&](int batchIndex) {
+			const size_t start = batchOffsets[batchIndex];
+			const size_t end = (batchIndex == (batchCount - 1)) ? contentEnd : batchOffsets[batchIndex + 1];
+
+			ConversionBuffers batchBuffers;
+			batchBuffers.init();
+
+			if (batchArenas)
+				KModelElementFactory::setThreadArena(batchArenas[batchIndex]);
+
+			batchElements[batchIndex] = parseBuffer<CharT>(buffer + start, end - start, factory, &batchBuffers,
+				batchIndexes ? batchIndexes[batchIndex] : nullptr, true);
+
+			if (batchArenas)
+				KModelElementFactory::setThreadArena(nullptr);
+
+			batchBuffers.release();
+		}, 1);
+
+		// splice the fragments under the root in document order.
+		KModelElement* lastChild = nullptr;
+		for (int i = 0; i < batchCount; i++)
+		{
+			for (KModelElement* element = batchElements[i]; element; element = element->next)
+			{
+				element->parent = rootElement;
+
+				if (element == batchElements[i])
+				{
+					element->prev = lastChild;
+					if (lastChild)
+						lastChild->next = element;
+					else
+						rootElement->firstChild = element;
+				}
+
+				lastChild = element;
+			}
+		}
+
+		for (int i = 0; batchIndexes && (i < batchCount); i++)
+		{
+			index->merge(batchIndexes[i]);
+			delete batchIndexes[i];
+		}
+
+		::free(batchElements);
+		::free(batchArenas);
+		::free(batchIndexes);
+		::free(childOffsets);
+
+		return rootElement;
+	}
+
+public:
+	KXMLReader() noexcept
+	{
+		input = nullptr;
+		inputLength = 0;
+		inputType = InputType::None;
+
+		buffers.init();
+		index = nullptr;
+	}
+
+	/**
+		The index is filled by the next parse calls. pass null to disable.
+		The reader does not clear the index before parsing.
+	*/
+	void setIndex(KModelIndex* index) noexcept
+	{
+		this->index = index;
+	}
+
+	KModelIndex* getIndex() const noexcept
+	{
+		return index;
+	}
+
+	/**
+		The file is memory mapped and stays open until the next load call or destructor.
+		UTF-8 (with or without BOM) and UTF-16LE (with BOM) files are supported.
+	*/
+	bool loadFromFile(const wchar_t* filePath) noexcept
+	{
+		inputType = InputType::None;
+
+		if (!mappedFile.openFile(filePath))
+			return false;
+
+		return loadFromData(mappedFile.getData(), mappedFile.getSize());
+	}
+
+	/**
+		Text is not copied. It must be valid until the parse call returns.
+	*/
+	bool loadFromString(const wchar_t* text, UINT length = 0) noexcept
+	{
+		inputType = InputType::None;
+
+		if (!text)
+			return false;
+
+		if (length == 0)
+		{
+			length = (UINT)::wcslen(text);
+			if (length == 0)
+				return false;
+		}
+
+		input = text;
+		inputLength = length;
+		inputType = InputType::WideChar;
+
+		return true;
+	}
+
+	/**
+		Encoded xml document in memory. Data is not copied. It must be valid until the parse call returns.
+		Encoding is detected using the BOM. UTF-8 is assumed when there is no BOM
+		unless the data starts with "<\0" which is treated as UTF-16LE.
+	*/
+	bool loadFromData(const void* data, size_t size) noexcept
+	{
+		inputType = InputType::None;
+
+		if ((!data) || (size == 0))
+			return false;
+
+		const BYTE* bytes = (const BYTE*)data;
+
+		if ((size >= 3) && (bytes[0] == 0xEF) && (bytes[1] == 0xBB) && (bytes[2] == 0xBF))
+		{
+			input = bytes + 3;
+			inputLength = size - 3;
+			inputType = InputType::UTF8;
+		}
+		else if ((size >= 2) && (bytes[0] == 0xFE) && (bytes[1] == 0xFF)) // UTF-16BE is not supported
+		{
+			return false;
+		}
+		else if ((size >= 2) && (((bytes[0] == 0xFF) && (bytes[1] == 0xFE)) || ((bytes[0] == '<') && (bytes[1] == 0))))
+		{
+			const size_t bomSize = (bytes[0] == 0xFF) ? 2 : 0;
+			if (((size_t)(bytes + bomSize) % alignof(char16_t)) != 0)
+				return false;
+
+			input = bytes + bomSize;
+			inputLength = (size - bomSize) / sizeof(char16_t);
+			inputType = InputType::UTF16;
+		}
+		else
+		{
+			input = bytes;
+			inputLength = size;
+			inputType = InputType::UTF8;
+		}
+
+		return inputLength != 0;
+	}
+
+	/**
+		returns the root model element. There can be only one root element in xml.
+		On a syntax error, parsing stops and the elements created so far are returned.
+	*/
+	KModelElement* parse(KModelElementFactory* factory) noexcept
+	{
+		if (!factory)
+			return nullptr;
+
+		switch (inputType)
+		{
+			case InputType::UTF8:
+				return parseBuffer<char>((const char*)input, inputLength, factory, &buffers, index);
+			case InputType::UTF16:
+				return parseBuffer<char16_t>((const char16_t*)input, inputLength, factory, &buffers, index);
+			case InputType::WideChar:
+				return parseBuffer<wchar_t>((const wchar_t*)input, inputLength, factory, &buffers, index);
+			default:
+				return nullptr;
+		}
+	}
+
+	/**
+		Parses into the arena of the document. Previous content of the document is cleared.
+		Element destructors are called when the document is cleared or destroyed.
+		@returns false if there is no root element.
+	*/
+	bool parse(KModelElementFactory* factory, KModelDocument* document) noexcept
+	{
+		if ((!factory) || (!document))
+			return false;
+
+		document->clear();
+
+		KArena* previousArena = factory->getArena();
+		factory->setArena(document->getArena());
+		document->setRootElement(parse(factory));
+		factory->setArena(previousArena);
+
+		return document->getRootElement() != nullptr;
+	}
+
+	/**
+		Parses the top level children of the root element in parallel using the thread pool and the calling thread.
+		Use it for large documents which have one root with many independent children.
+		The result is same as parse. On malformed input, the elements created before the error may differ.
+
+		createModelElement of the factory and the element callbacks are called concurrently for different subtrees.
+		They must be thread safe. (allocating with createElement is safe)
+		If the pool is not started, all the work is done on the calling thread.
+	*/
+	KModelElement* parseParallel(KModelElementFactory* factory, KThreadPool* threadPool) noexcept
+	{
+		return parseInputParallel(factory, threadPool, nullptr);
+	}
+
+	/**
+		Parallel version of parse(KModelElementFactory*, KModelDocument*). see parseParallel.
+	*/
+	bool parseParallel(KModelElementFactory* factory, KThreadPool* threadPool, KModelDocument* document) noexcept
+	{
+		if ((!factory) || (!document))
+			return false;
+
+		document->clear();
+
+		KArena* previousArena = factory->getArena();
+		factory->setArena(document->getArena());
+		document->setRootElement(parseInputParallel(factory, threadPool, document->getArena()));
+		factory->setArena(previousArena);
+
+		return document->getRootElement() != nullptr;
+	}
+
+	virtual ~KXMLReader() noexcept
+	{
+		buffers.release();
+	}
+
+	// no copy/movable
+	KXMLReader(const KXMLReader&) = delete;
+	KXMLReader& operator=(const KXMLReader&) = delete;
+	KXMLReader(KXMLReader&&) = delete;
+	KXMLReader& operator=(KXMLReader&&) = delete;
 };
 
 
@@ -364,17 +1160,17 @@ public:
 	{
 		if (::wcscmp(elementName, L"Label") == 0)
 		{
-			LabelElement* element = new LabelElement();
+			LabelElement* element = createElement<LabelElement>();
 			return element;
 		}
 		else if (::wcscmp(elementName, L"Panel") == 0)
 		{
-			PanelElement* element = new PanelElement();
+			PanelElement* element = createElement<PanelElement>();
 			return element;
 		}
 		else // unknown element
 		{
-			return new KModelElement();
+			return createElement<KModelElement>();
 		}
 	}
 };
@@ -465,6 +1261,14 @@ public:
 				::wprintf(L"\n===========================\n\n");
 				delete rootElement;
 			}
+
+			KModelDocument document; // same tree inside an arena
+			if (xmlReader.parse(&factory, &document))
+			{
+				KModelElement* root = document.getRootElement();
+				for (KModelElement* element = root; element; element = element->getNextElement(root))
+					::wprintf(L"%s\n", getElementName(element));
+			}
 		}
 	}
 };
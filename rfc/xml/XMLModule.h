@@ -21,7 +21,7 @@
 
 #pragma once
 
+#include "KXMLPullParser.h"
 #include "KXMLReader.h"
+#include "KModelQuery.h"
 
-#pragma comment(lib,"Xmllite.lib")
-#pragma comment(lib,"Shlwapi.lib")
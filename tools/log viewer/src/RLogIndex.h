@@ -0,0 +1,327 @@
+
+/*
+	Portable event index for the log files generated by KLogger.
+	Does not depend on windows or rfc. So it can be tested on other platforms too.
+*/
+
+#ifndef _RLOG_INDEX_H_
+#define _RLOG_INDEX_H_
+
+#include "RLogParser.h"
+
+/**
+	Sparse offset index of the events. Keeps the offset of every STRIDE'th event & the offsets of the format definitions.
+	A row is decoded by seeking to its checkpoint and skipping at most STRIDE - 1 events.
+	Sequential rows continue from the previous one without seeking.
+
+	Records don't have sync markers. So a file cannot be split into chunks which are scanned in parallel.
+	Instead, the index can be saved into a sidecar file and loaded next time. (see serialize & deserialize)
+
+	Index file format:
+		header:					'R' 'I' 'D' 'X'
+		stride:					int32
+		log file size:			int64
+		log file signature:		int32		; (FNV-1a of first & last 4KB)
+		event count:			int64
+		type counts:			int64 * 3	; (information|warning|error)
+		checkpoint count:		int64
+		format count:			int64
+		checkpoints:			int64 * checkpoint count
+		format offsets:			int64 * format count
+*/
+class RLogIndex
+{
+protected:
+	unsigned long long* checkpoints;
+	size_t checkpointCount;
+	size_t checkpointCapacity;
+
+	unsigned long long* formatOffsets;
+	size_t formatCount;
+	size_t formatCapacity;
+
+	size_t eventCount;
+	size_t typeCounts[4]; // indexed by event type. (0 is unused)
+
+	// position after the last decoded row
+	size_t nextRow;
+	size_t nextRowPosition;
+
+	enum { HEADER_SIZE = 68 };
+
+	static bool append(unsigned long long** items, size_t* count, size_t* capacity, unsigned long long value)
+	{
+		if (*count == *capacity)
+		{
+			const size_t newCapacity = *capacity ? (*capacity * 2) : 1024;
+			unsigned long long* newItems = (unsigned long long*)::realloc(*items, newCapacity * sizeof(unsigned long long));
+			if (newItems == NULL)
+				return false;
+
+			*items = newItems;
+			*capacity = newCapacity;
+		}
+
+		(*items)[(*count)++] = value;
+		return true;
+	}
+
+	static unsigned int getSignature(const unsigned char* data, size_t size)
+	{
+		const size_t partSize = (size < 4096) ? size : 4096;
+		unsigned int hash = 2166136261u;
+
+		for (size_t i = 0; i < partSize; i++)
+			hash = (hash ^ data[i]) * 16777619u;
+
+		for (size_t i = size - partSize; i < size; i++)
+			hash = (hash ^ data[i]) * 16777619u;
+
+		return hash;
+	}
+
+	template<typename T>
+	static unsigned char* writeValue(unsigned char* destination, T value)
+	{
+		::memcpy(destination, &value, sizeof(T));
+		return destination + sizeof(T);
+	}
+
+	template<typename T>
+	static const unsigned char* readValue(const unsigned char* source, T* value)
+	{
+		::memcpy(value, source, sizeof(T));
+		return source + sizeof(T);
+	}
+
+	bool loadFormats(RLogParser* parser)
+	{
+		RLogEvent event;
+		for (size_t i = 0; i < formatCount; i++)
+		{
+			if (!parser->seek((size_t)formatOffsets[i]) || (parser->readRecord(&event) != RLOG_RECORD_FORMAT))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	enum { STRIDE = 32 };
+
+	RLogIndex()
+	{
+		checkpoints = NULL;
+		checkpointCount = 0;
+		checkpointCapacity = 0;
+
+		formatOffsets = NULL;
+		formatCount = 0;
+		formatCapacity = 0;
+
+		clear();
+	}
+
+	void clear()
+	{
+		checkpointCount = 0;
+		formatCount = 0;
+		eventCount = 0;
+		::memset(typeCounts, 0, sizeof(typeCounts));
+		nextRow = 0;
+		nextRowPosition = 0;
+	}
+
+	size_t getEventCount() const { return eventCount; }
+
+	// number of events which have given type. (RLOG_EVT_INFORMATION, RLOG_EVT_WARNING or RLOG_EVT_ERROR)
+	size_t getEventCount(unsigned char eventType) const
+	{
+		return (eventType < 4) ? typeCounts[eventType] : 0;
+	}
+
+	/**
+		Scans the whole file. Format definitions are loaded into the parser.
+		@param shouldStop scanning is cancelled when it becomes true. can be null.
+		@returns false if cancelled or out of memory. events before invalid data are indexed.
+	*/
+	bool build(RLogParser* parser, const volatile bool* shouldStop = NULL)
+	{
+		clear();
+		if (!parser->seek(parser->getDataStart()))
+			return false;
+
+		RLogEvent event;
+		while (true)
+		{
+			const size_t offset = parser->getPosition();
+			const int recordType = parser->readRecord(&event);
+
+			if (recordType == RLOG_RECORD_EVENT)
+			{
+				if (((eventCount % STRIDE) == 0) && !append(&checkpoints, &checkpointCount, &checkpointCapacity, offset))
+					return false;
+
+				++eventCount;
+				if (event.type < 4)
+					++typeCounts[event.type];
+
+				if (shouldStop && ((eventCount % 65536) == 0) && *shouldStop)
+					return false;
+			}
+			else if (recordType == RLOG_RECORD_FORMAT)
+			{
+				if (!append(&formatOffsets, &formatCount, &formatCapacity, offset))
+					return false;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+		Decodes the event of given row.
+	*/
+	bool readEvent(RLogParser* parser, size_t row, RLogEvent* event)
+	{
+		if (row >= eventCount)
+			return false;
+
+		size_t skipCount;
+		if ((row == nextRow) && (nextRowPosition != 0))
+		{
+			parser->seek(nextRowPosition);
+			skipCount = 0;
+		}
+		else
+		{
+			parser->seek((size_t)checkpoints[row / STRIDE]);
+			skipCount = row % STRIDE;
+		}
+
+		do
+		{
+			if (!parser->next(event))
+			{
+				nextRowPosition = 0;
+				return false;
+			}
+		} while (skipCount--);
+
+		nextRow = row + 1;
+		nextRowPosition = parser->getPosition();
+		return true;
+	}
+
+	size_t getSerializedSize() const
+	{
+		return HEADER_SIZE + (checkpointCount + formatCount) * sizeof(unsigned long long);
+	}
+
+	/**
+		@param buffer must have getSerializedSize bytes.
+	*/
+	void serialize(void* buffer, const RLogParser& parser) const
+	{
+		unsigned char* destination = (unsigned char*)buffer;
+		::memcpy(destination, "RIDX", 4);
+		destination += 4;
+
+		destination = writeValue(destination, (unsigned int)STRIDE);
+		destination = writeValue(destination, (unsigned long long)parser.getSize());
+		destination = writeValue(destination, getSignature(parser.getData(), parser.getSize()));
+		destination = writeValue(destination, (unsigned long long)eventCount);
+		for (int i = 1; i < 4; i++)
+			destination = writeValue(destination, (unsigned long long)typeCounts[i]);
+		destination = writeValue(destination, (unsigned long long)checkpointCount);
+		destination = writeValue(destination, (unsigned long long)formatCount);
+
+		if (checkpointCount)
+			::memcpy(destination, checkpoints, checkpointCount * sizeof(unsigned long long));
+		destination += checkpointCount * sizeof(unsigned long long);
+
+		if (formatCount)
+			::memcpy(destination, formatOffsets, formatCount * sizeof(unsigned long long));
+	}
+
+	/**
+		Loads a saved index. Format definitions are loaded into the parser.
+		@returns false if the index does not belong to the file of the parser. then call build.
+	*/
+	bool deserialize(const void* buffer, size_t bufferSize, RLogParser* parser)
+	{
+		clear();
+
+		const unsigned char* source = (const unsigned char*)buffer;
+		if ((bufferSize < HEADER_SIZE) || (::memcmp(source, "RIDX", 4) != 0))
+			return false;
+		source += 4;
+
+		unsigned int stride, signature;
+		unsigned long long fileSize, savedEventCount, savedCheckpointCount, savedFormatCount;
+		unsigned long long savedTypeCounts[3];
+
+		source = readValue(source, &stride);
+		source = readValue(source, &fileSize);
+		source = readValue(source, &signature);
+		source = readValue(source, &savedEventCount);
+		for (int i = 0; i < 3; i++)
+			source = readValue(source, &savedTypeCounts[i]);
+		source = readValue(source, &savedCheckpointCount);
+		source = readValue(source, &savedFormatCount);
+
+		if ((stride != STRIDE) || (fileSize != parser->getSize()) || (signature != getSignature(parser->getData(), parser->getSize())))
+			return false;
+
+		if ((savedCheckpointCount != ((savedEventCount + STRIDE - 1) / STRIDE)) ||
+			(savedCheckpointCount > bufferSize) || (savedFormatCount > bufferSize) ||
+			(bufferSize != (HEADER_SIZE + (savedCheckpointCount + savedFormatCount) * sizeof(unsigned long long))))
+			return false;
+
+		for (size_t i = 0; i < savedCheckpointCount; i++)
+		{
+			unsigned long long offset;
+			source = readValue(source, &offset);
+			if ((offset >= fileSize) || !append(&checkpoints, &checkpointCount, &checkpointCapacity, offset))
+				return false;
+		}
+
+		for (size_t i = 0; i < savedFormatCount; i++)
+		{
+			unsigned long long offset;
+			source = readValue(source, &offset);
+			if ((offset >= fileSize) || !append(&formatOffsets, &formatCount, &formatCapacity, offset))
+				return false;
+		}
+
+		eventCount = (size_t)savedEventCount;
+		for (int i = 0; i < 3; i++)
+			typeCounts[i + 1] = (size_t)savedTypeCounts[i];
+
+		if (!loadFormats(parser))
+		{
+			clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	~RLogIndex()
+	{
+		if (checkpoints)
+			::free(checkpoints);
+
+		if (formatOffsets)
+			::free(formatOffsets);
+	}
+
+	// no copy
+	RLogIndex(const RLogIndex&) = delete;
+	RLogIndex& operator=(const RLogIndex&) = delete;
+};
+
+#endif
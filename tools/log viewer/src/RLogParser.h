@@ -0,0 +1,483 @@
+
+/*
+	Portable reader for the log files generated by KLogger.
+	Does not depend on windows or rfc. So it can be used by other tools too.
+*/
+
+#ifndef _RLOG_PARSER_H_
+#define _RLOG_PARSER_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum RLogEventTypes
+{
+	RLOG_EVT_END = 0,
+	RLOG_EVT_INFORMATION = 1,
+	RLOG_EVT_WARNING = 2,
+	RLOG_EVT_ERROR = 3,
+	RLOG_EVT_FORMAT_DEFINITION = 255, // format text of KLOG events. not an event.
+};
+
+enum RLogParamTypes
+{
+	RLOG_PARAM_STRING = 1,
+	RLOG_PARAM_INT32 = 2,
+	RLOG_PARAM_SHORT16 = 3,
+	RLOG_PARAM_FLOAT = 4,
+	RLOG_PARAM_DOUBLE = 5,
+	RLOG_PARAM_FORMAT = 6, // format id, arg types & packed args of a KLOG event
+	RLOG_PARAM_INT64 = 7, // only inside RLOG_PARAM_FORMAT
+};
+
+enum RLogRecordTypes
+{
+	RLOG_RECORD_NONE = 0,
+	RLOG_RECORD_EVENT = 1,
+	RLOG_RECORD_FORMAT = 2,
+};
+
+struct RLogFormat
+{
+	const char* text; // points into the file data. not null terminated.
+	unsigned short length;
+};
+
+struct RLogEvent
+{
+	unsigned char type;
+	unsigned char category; // always zero for v1 files
+	unsigned int threadID; // always zero for v1 files
+	unsigned long long timeNs; // time since first event. v1 files have only millisecond precision.
+	const unsigned char* params; // points into the file data. ends with RLOG_EVT_END.
+	size_t paramsSize; // without RLOG_EVT_END
+};
+
+/**
+	Reads the events of v1 ("RLOG") and v2 ("RLG2") files from memory.
+	The data must stay valid while the parser and returned events are in use.
+	KLOG format definitions are collected while reading. So formatParams can render the format text.
+*/
+class RLogParser
+{
+protected:
+	const unsigned char* data;
+	size_t size;
+	size_t position;
+	int version;
+	unsigned int eventCount;
+	bool corrupted;
+
+	RLogFormat* formats; // indexed by format id
+	unsigned int formatCapacity;
+
+	template<typename T>
+	bool readValue(T* value)
+	{
+		if ((size - position) < sizeof(T))
+			return false;
+
+		::memcpy(value, data + position, sizeof(T));
+		position += sizeof(T);
+		return true;
+	}
+
+	// returns size of the param data or -1 if the param type is unknown.
+	static int getParamDataSize(unsigned char paramType)
+	{
+		switch (paramType)
+		{
+		case RLOG_PARAM_INT32:
+		case RLOG_PARAM_FLOAT:
+			return 4;
+		case RLOG_PARAM_SHORT16:
+			return 2;
+		case RLOG_PARAM_DOUBLE:
+		case RLOG_PARAM_INT64:
+			return 8;
+		default:
+			return -1;
+		}
+	}
+
+	// skips the data of a param which starts at position. (param type is already read)
+	bool skipParam(unsigned char paramType)
+	{
+		if (paramType == RLOG_PARAM_STRING)
+		{
+			unsigned char textLength;
+			if (!readValue(&textLength) || ((size - position) < textLength))
+				return false;
+
+			position += textLength;
+			return true;
+		}
+
+		if (paramType == RLOG_PARAM_FORMAT)
+		{
+			unsigned int formatID;
+			unsigned char argCount;
+			if (!readValue(&formatID) || !readValue(&argCount) || ((size - position) < argCount))
+				return false;
+
+			const unsigned char* argTypes = data + position;
+			position += argCount;
+
+			for (unsigned int i = 0; i < argCount; i++)
+			{
+				if ((argTypes[i] == RLOG_PARAM_FORMAT) || !skipParam(argTypes[i]))
+					return false;
+			}
+			return true;
+		}
+
+		const int dataSize = getParamDataSize(paramType);
+		if ((dataSize == -1) || ((size - position) < (size_t)dataSize))
+			return false;
+
+		position += dataSize;
+		return true;
+	}
+
+	bool readFormatDefinition()
+	{
+		unsigned int formatID;
+		unsigned short textLength;
+		if (!readValue(&formatID) || !readValue(&textLength) || ((size - position) < textLength))
+			return false;
+
+		if (formatID >= formatCapacity)
+		{
+			unsigned int newCapacity = formatCapacity ? formatCapacity : 64;
+			while (newCapacity <= formatID)
+				newCapacity *= 2;
+
+			RLogFormat* newFormats = (RLogFormat*)::realloc(formats, newCapacity * sizeof(RLogFormat));
+			if (newFormats == NULL)
+				return false;
+
+			::memset(newFormats + formatCapacity, 0, (newCapacity - formatCapacity) * sizeof(RLogFormat));
+			formats = newFormats;
+			formatCapacity = newCapacity;
+		}
+
+		formats[formatID].text = (const char*)(data + position);
+		formats[formatID].length = textLength;
+		position += textLength;
+		return true;
+	}
+
+	// reads a param value at index as text. @returns index of the next param.
+	static size_t formatValue(const unsigned char* params, size_t index, unsigned char paramType, char* text, int textSize, int* textLength)
+	{
+		if (paramType == RLOG_PARAM_STRING)
+		{
+			const unsigned char dataSize = params[index++];
+			const int copySize = (dataSize < textSize) ? dataSize : (textSize - 1);
+			::memcpy(text, params + index, copySize);
+			*textLength = copySize;
+			return index + dataSize;
+		}
+
+		if (paramType == RLOG_PARAM_INT32)
+		{
+			int value;
+			::memcpy(&value, params + index, sizeof(int));
+			*textLength = ::snprintf(text, textSize, "%d", value);
+			return index + sizeof(int);
+		}
+
+		if (paramType == RLOG_PARAM_SHORT16)
+		{
+			unsigned short value;
+			::memcpy(&value, params + index, sizeof(unsigned short));
+			*textLength = ::snprintf(text, textSize, "%d", (int)value);
+			return index + sizeof(unsigned short);
+		}
+
+		if (paramType == RLOG_PARAM_FLOAT)
+		{
+			float value;
+			::memcpy(&value, params + index, sizeof(float));
+			*textLength = ::snprintf(text, textSize, "%.4f", value);
+			return index + sizeof(float);
+		}
+
+		if (paramType == RLOG_PARAM_DOUBLE)
+		{
+			double value;
+			::memcpy(&value, params + index, sizeof(double));
+			*textLength = ::snprintf(text, textSize, "%.4f", value);
+			return index + sizeof(double);
+		}
+
+		// RLOG_PARAM_INT64. next() has already validated the params
+		long long value;
+		::memcpy(&value, params + index, sizeof(long long));
+		*textLength = ::snprintf(text, textSize, "%lld", value);
+		return index + sizeof(long long);
+	}
+
+	// appends text to buffer. @returns false if the buffer is full.
+	static bool appendText(char* buffer, int bufferSize, int* length, const char* text, int textLength)
+	{
+		if (textLength < 0)
+			textLength = 0;
+
+		const int available = bufferSize - 1 - *length;
+		if (textLength > available)
+			textLength = available;
+
+		::memcpy(buffer + *length, text, textLength);
+		*length += textLength;
+		return *length < (bufferSize - 1);
+	}
+
+public:
+	RLogParser()
+	{
+		data = NULL;
+		size = 0;
+		position = 0;
+		version = 0;
+		eventCount = 0;
+		corrupted = false;
+		formats = NULL;
+		formatCapacity = 0;
+	}
+
+	~RLogParser()
+	{
+		if (formats)
+			::free(formats);
+	}
+
+	/**
+		@returns false if the data is not a log file.
+	*/
+	bool open(const void* fileData, size_t fileSize)
+	{
+		data = (const unsigned char*)fileData;
+		size = fileSize;
+		position = 0;
+		version = 0;
+		eventCount = 0;
+		corrupted = false;
+
+		if (formats)
+			::memset(formats, 0, formatCapacity * sizeof(RLogFormat));
+
+		if (size < 8)
+			return false;
+
+		if (::memcmp(data, "RLOG", 4) == 0)
+			version = 1;
+		else if (::memcmp(data, "RLG2", 4) == 0)
+			version = 2;
+		else
+			return false;
+
+		position = 4;
+		readValue(&eventCount);
+		return true;
+	}
+
+	// 1 or 2
+	int getVersion() const { return version; }
+
+	// event count stored in the header. may be smaller than actual count if the writer was not stopped properly.
+	unsigned int getEventCount() const { return eventCount; }
+
+	// true if the last call of next failed because of invalid data.
+	bool isCorrupted() const { return corrupted; }
+
+	// @returns null text if the format is not defined yet.
+	RLogFormat getFormat(unsigned int formatID) const
+	{
+		RLogFormat format = { NULL, 0 };
+		if (formatID < formatCapacity)
+			format = formats[formatID];
+		return format;
+	}
+
+	const unsigned char* getData() const { return data; }
+
+	size_t getSize() const { return size; }
+
+	// offset of the next record.
+	size_t getPosition() const { return position; }
+
+	// offset of the first record.
+	size_t getDataStart() const { return 8; }
+
+	/**
+		Moves to a record start which is taken from getPosition before.
+	*/
+	bool seek(size_t offset)
+	{
+		if ((version == 0) || (offset < getDataStart()) || (offset > size))
+			return false;
+
+		position = offset;
+		return true;
+	}
+
+	/**
+		Reads the next record. Format definitions are stored and not returned as events.
+		@returns RLOG_RECORD_NONE at the end of data or on invalid data. (check isCorrupted)
+	*/
+	int readRecord(RLogEvent* event)
+	{
+		if ((version == 0) || (position >= size))
+			return RLOG_RECORD_NONE;
+
+		const size_t recordStart = position;
+		corrupted = true;
+
+		if (!readValue(&event->type))
+			return RLOG_RECORD_NONE;
+
+		if ((version >= 2) && (event->type == RLOG_EVT_FORMAT_DEFINITION))
+		{
+			if (!readFormatDefinition())
+			{
+				position = recordStart;
+				return RLOG_RECORD_NONE;
+			}
+			corrupted = false;
+			return RLOG_RECORD_FORMAT;
+		}
+
+		if (version == 1)
+		{
+			unsigned short secs, mills;
+			if (!readValue(&secs) || !readValue(&mills))
+			{
+				position = recordStart;
+				return RLOG_RECORD_NONE;
+			}
+
+			event->category = 0;
+			event->threadID = 0;
+			event->timeNs = ((unsigned long long)secs * 1000 + mills) * 1000000;
+		}
+		else
+		{
+			if (!readValue(&event->category) || !readValue(&event->threadID) || !readValue(&event->timeNs))
+			{
+				position = recordStart;
+				return RLOG_RECORD_NONE;
+			}
+		}
+
+		event->params = data + position;
+
+		while (true) // skip params
+		{
+			unsigned char paramType;
+			if (!readValue(&paramType) || ((paramType != RLOG_EVT_END) && !skipParam(paramType)))
+			{
+				position = recordStart;
+				return RLOG_RECORD_NONE;
+			}
+
+			if (paramType == RLOG_EVT_END)
+				break;
+		}
+
+		event->paramsSize = (size_t)((data + position - 1) - event->params);
+		corrupted = false;
+		return RLOG_RECORD_EVENT;
+	}
+
+	/**
+		Reads the next event.
+		@returns false at the end of data or on invalid data. (check isCorrupted)
+	*/
+	bool next(RLogEvent* event)
+	{
+		int recordType;
+		while ((recordType = readRecord(event)) == RLOG_RECORD_FORMAT)
+		{
+		}
+
+		return recordType == RLOG_RECORD_EVENT;
+	}
+
+	/**
+		Writes the params of the event as text. Output is always null terminated.
+		"{}" of a KLOG format is replaced by the next argument.
+		@returns length of the text.
+	*/
+	int formatParams(const RLogEvent& event, char* buffer, int bufferSize) const
+	{
+		if (bufferSize <= 0)
+			return 0;
+
+		int length = 0;
+		size_t index = 0;
+		char text[320];
+		int textLength;
+
+		while ((index < event.paramsSize) && (length < (bufferSize - 1)))
+		{
+			const unsigned char paramType = event.params[index++];
+
+			if (paramType != RLOG_PARAM_FORMAT)
+			{
+				index = formatValue(event.params, index, paramType, text, sizeof(text), &textLength);
+				appendText(buffer, bufferSize, &length, text, textLength);
+				continue;
+			}
+
+			unsigned int formatID;
+			::memcpy(&formatID, event.params + index, sizeof(unsigned int));
+			const unsigned char argCount = event.params[index + 4];
+			const unsigned char* argTypes = event.params + index + 5;
+			index += 5 + argCount;
+
+			RLogFormat format = getFormat(formatID);
+			if (format.text == NULL)
+			{
+				textLength = ::snprintf(text, sizeof(text), "[format %u]", formatID);
+				appendText(buffer, bufferSize, &length, text, textLength);
+			}
+
+			unsigned int arg = 0;
+			unsigned short formatIndex = 0;
+			while (format.text && (formatIndex < format.length))
+			{
+				if ((arg < argCount) && ((formatIndex + 1) < format.length) &&
+					(format.text[formatIndex] == '{') && (format.text[formatIndex + 1] == '}'))
+				{
+					index = formatValue(event.params, index, argTypes[arg++], text, sizeof(text), &textLength);
+					appendText(buffer, bufferSize, &length, text, textLength);
+					formatIndex += 2;
+				}
+				else
+				{
+					appendText(buffer, bufferSize, &length, format.text + formatIndex, 1);
+					++formatIndex;
+				}
+			}
+
+			for (; arg < argCount; arg++) // args without a placeholder
+			{
+				appendText(buffer, bufferSize, &length, " ", 1);
+				index = formatValue(event.params, index, argTypes[arg], text, sizeof(text), &textLength);
+				appendText(buffer, bufferSize, &length, text, textLength);
+			}
+		}
+
+		buffer[length] = 0;
+		return length;
+	}
+
+	// no copy
+	RLogParser(const RLogParser&) = delete;
+	RLogParser& operator=(const RLogParser&) = delete;
+};
+
+#endif
@@ -1,25 +1,71 @@
 
 #include "rfc_amalgamated.h"
+#include "RLogIndex.h"
 
 #define COL_WARNING_TEXT RGB(0, 128, 0)
 #define COL_WARNING_BACK RGB(240, 240, 240)
 #define COL_ERROR_TEXT RGB(149, 0, 0)
 #define COL_ERROR_BACK RGB(255, 240, 240)
 
+// posted by the loader thread. wParam is true on success. lParam is the load id.
+#define WM_LOG_LOADED (WM_APP + 1)
+
+#define COL_COUNT 5
+
+/**
+	Supplies the rows of the virtual grid.
+*/
+class KLogRowProvider
+{
+public:
+	virtual int GetEventTypeOfRow(int rowIndex) = 0;
+
+	virtual void GetCellText(int rowIndex, int columnIndex, wchar_t* text, int textSize) = 0;
+};
+
 /**
-	custom drawn gridview to highlight warnings & errors.
+	virtual (LVS_OWNERDATA) gridview. rows are not stored in the control. they are decoded when they become visible.
+	custom drawn to highlight warnings & errors.
 	for some components, custom drawing is easier than owner drawing. 
 	see: https://www.codeproject.com/Articles/79/Neat-Stuff-to-Do-in-List-Controls-Using-Custom-Dra
 */
 class KLogViewingGrid : public KGridView
 {
+protected:
+	KLogRowProvider* rowProvider;
+
 public:
+	KLogViewingGrid()
+	{
+		rowProvider = 0;
+		compDwStyle |= LVS_OWNERDATA;
+	}
+
+	void SetRowProvider(KLogRowProvider* rowProvider)
+	{
+		this->rowProvider = rowProvider;
+	}
+
+	void SetRowCount(int rowCount)
+	{
+		ListView_SetItemCountEx(compHWND, rowCount, 0);
+		itemCount = rowCount;
+	}
 
 	bool EventProc(UINT msg, WPARAM wParam, LPARAM lParam, LRESULT *result)
 	{
-		if (msg == WM_NOTIFY)
+		if ((msg == WM_NOTIFY) && rowProvider)
 		{		
-			if (((LPNMHDR)lParam)->code == NM_CUSTOMDRAW) // custom drawing msg received for this component
+			if (((LPNMHDR)lParam)->code == LVN_GETDISPINFOW) // control needs the text of a visible cell
+			{
+				NMLVDISPINFOW* dispInfo = (NMLVDISPINFOW*)lParam;
+				if ((dispInfo->item.mask & LVIF_TEXT) && (dispInfo->item.cchTextMax > 0))
+					rowProvider->GetCellText(dispInfo->item.iItem, dispInfo->item.iSubItem, dispInfo->item.pszText, dispInfo->item.cchTextMax);
+
+				*result = 0;
+				return true;
+			}
+			else if (((LPNMHDR)lParam)->code == NM_CUSTOMDRAW) // custom drawing msg received for this component
 			{
 				LPNMLVCUSTOMDRAW pLVCD = (LPNMLVCUSTOMDRAW) lParam;
 
@@ -31,12 +77,15 @@ public:
 				}
 				else if ( CDDS_ITEMPREPAINT == pLVCD->nmcd.dwDrawStage ) //  prepaint stage for an item. (subitems will use same values.)
 				{
-					if (pLVCD->nmcd.lItemlParam == KLogger::EVT_ERROR)
+					// virtual list has no item lParam. so the event type is taken from the row.
+					const int eventType = rowProvider->GetEventTypeOfRow((int)pLVCD->nmcd.dwItemSpec);
+
+					if (eventType == RLOG_EVT_ERROR)
 					{
 						pLVCD->clrTextBk = COL_ERROR_BACK;
 						pLVCD->clrText = COL_ERROR_TEXT;
 					}
-					else if (pLVCD->nmcd.lItemlParam == KLogger::EVT_WARNING)
+					else if (eventType == RLOG_EVT_WARNING)
 					{
 						pLVCD->clrTextBk = COL_WARNING_BACK;
 						pLVCD->clrText = COL_WARNING_TEXT;
@@ -51,45 +100,9 @@ public:
 
 		return KGridView::EventProc(msg, wParam, lParam, result); // pass unprocessed messages to parent
 	}
-
-	void InsertRecord(KString **columnsData, int eventType)
-	{
-		LVITEMW lvi = { 0 };
-		lvi.mask = LVIF_TEXT | LVIF_PARAM;
-		lvi.pszText = (wchar_t*)(const wchar_t*)(*columnsData[0]);
-		lvi.iItem = itemCount;
-		lvi.lParam = (LPARAM)eventType;
-
-		int row = (int)::SendMessageW(compHWND, LVM_INSERTITEMW, 0, (LPARAM)&lvi);
-
-		for (int i = 1; i < colCount; i++) // first column already added, lets add the others
-		{
-			LV_ITEMW lvi = { 0 };
-			lvi.iSubItem = i;
-			lvi.pszText = (wchar_t*)(const wchar_t*)(*columnsData[i]);
-
-			::SendMessageW(compHWND, LVM_SETITEMTEXTW, (WPARAM)row, (LPARAM)&lvi);
-		}
-
-		itemCount++;
-	}
-
-	/**
-		never used, but it's just here to show that we are using LPARAM to store event type.
-	*/
-	int GetEventTypeOfRecord(int rowIndex)
-	{
-		LV_ITEMW lvi = { 0 };
-		lvi.iItem = rowIndex;
-		lvi.mask = LVIF_PARAM;
-
-		ListView_GetItem(compHWND, &lvi);
-
-		return (int)lvi.lParam;
-	}
 };
 
-class MainWindow : public KOverlappedWindow, public KGridViewListener, public KMenuItemListener, public KThread
+class MainWindow : public KOverlappedWindow, public KGridViewListener, public KMenuItemListener, public KThread, public KLogRowProvider
 {
 protected:
 	KLogViewingGrid gridView;
@@ -99,9 +112,33 @@ protected:
 
 	KString logFilePath;
 
+	// log file is mapped into memory. only the visible pages are loaded by the os.
+	HANDLE fileHandle;
+	HANDLE mappingHandle;
+	void* mappedData;
+
+	// used by the loader thread until WM_LOG_LOADED, then by the ui thread.
+	RLogParser parser;
+	RLogIndex index;
+
+	// id of the last started load. results of the cancelled loads are ignored.
+	int loadID;
+
+	// all columns of a row are requested one by one. so last decoded row is kept.
+	int cachedRow;
+	int cachedEventType;
+	wchar_t cachedCells[COL_COUNT][1024];
+
 public:
 	MainWindow()
 	{
+		fileHandle = INVALID_HANDLE_VALUE;
+		mappingHandle = NULL;
+		mappedData = NULL;
+		cachedRow = -1;
+		cachedEventType = 0;
+		loadID = 0;
+
 		this->SetSize(800, 600);
 		this->SetText(CONST_TXT("Log Viewer"));
 		this->CreateComponent();
@@ -124,14 +161,17 @@ public:
 		this->AddComponent(&gridView);
 
 		gridView.SetListener(this);
+		gridView.SetRowProvider(this);
 
 		int clientWidth, clientHeight;
 		this->GetClientAreaSize(&clientWidth, &clientHeight);
 
 		gridView.SetSize(clientWidth, clientHeight);		
-		gridView.CreateColumn(CONST_TXT("Time (sec : mills)"));
+		gridView.CreateColumn(CONST_TXT("Time (ms)"));
 		gridView.CreateColumn(CONST_TXT("Type"));
-		gridView.CreateColumn(CONST_TXT("Details"), clientWidth - (gridView.GetColumnWidth(0) + gridView.GetColumnWidth(1) + 40));
+		gridView.CreateColumn(CONST_TXT("Thread"), 70);
+		gridView.CreateColumn(CONST_TXT("Category"), 70);
+		gridView.CreateColumn(CONST_TXT("Details"), clientWidth - (gridView.GetColumnWidth(0) + gridView.GetColumnWidth(1) + 180));
 	}
 
 	void OnMenuItemPress(KMenuItem *menuItem)
@@ -140,8 +180,15 @@ public:
 		{			
 			if (KCommonDialogBox::ShowOpenFileDialog(this, L"Open Log File...", L"Log Files (*.rlog)\0*.rlog\0", &logFilePath))
 			{
-				gridView.RemoveAll();
-				this->SetText(CONST_TXT("Log Viewer"));
+				// the loader never sends messages to this thread. so waiting here is safe.
+				this->ThreadShouldStop();
+				this->WaitUntilThreadFinish();
+
+				gridView.SetRowCount(0);
+				CloseLogFile();
+
+				++loadID;
+				this->SetText(CONST_TXT("Log Viewer - Loading..."));
 				StartThread();
 			}
 		}
@@ -154,128 +201,198 @@ public:
 		}
 	}
 
-	void Run()
+	bool MapLogFile()
 	{
-		KFile logFile;
+		fileHandle = ::CreateFileW(logFilePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+			return false;
 
-		if (logFile.OpenFile(logFilePath, KFile::KREAD))
-		{
-			char header[4];
-			logFile.ReadFile(header, 4);
+		LARGE_INTEGER fileSize;
+		if (!::GetFileSizeEx(fileHandle, &fileSize) || (fileSize.QuadPart == 0) || ((unsigned __int64)fileSize.QuadPart > (size_t)-1))
+			return false; // empty or cannot be mapped into the address space
 
-			if ((header[0] = 'R') && (header[1] = 'L') && (header[2] = 'O') && (header[3] = 'G'))
-			{
-				unsigned int totalEvents = 0;
-				logFile.ReadFile(&totalEvents, sizeof(unsigned int));
+		mappingHandle = ::CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mappingHandle == NULL)
+			return false;
 
-				int errorEventsCount = 0;
-				int warningEventsCount = 0;
+		mappedData = ::MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (mappedData == NULL)
+			return false;
 
-				for (unsigned int i = 0; i < totalEvents; i++)
-				{
-					unsigned char eventType;
-					logFile.ReadFile(&eventType, 1);
+		return parser.open(mappedData, (size_t)fileSize.QuadPart); // reads both v1 & v2 files
+	}
 
-					if (eventType == KLogger::EVT_ERROR)
-						errorEventsCount++;
-					else if (eventType == KLogger::EVT_WARNING)
-						warningEventsCount++;
+	void CloseLogFile()
+	{
+		cachedRow = -1;
+		index.clear();
 
-					unsigned short secs;
-					logFile.ReadFile(&secs, sizeof(unsigned short));
+		if (mappedData)
+			::UnmapViewOfFile(mappedData);
 
-					unsigned short mills;
-					logFile.ReadFile(&mills, sizeof(unsigned short));
+		if (mappingHandle)
+			::CloseHandle(mappingHandle);
 
-					KString details;
-					while (true) // iterate through each params
-					{
-						unsigned char paramType;
-						logFile.ReadFile(&paramType, 1);
-
-						if (paramType == KLogger::PARAM_STRING)
-						{
-							unsigned char dataSize;
-							logFile.ReadFile(&dataSize, 1);
-
-							char buff[256];
-							logFile.ReadFile(buff, dataSize);
-							buff[dataSize] = 0;
-
-							details = details + KString(buff);
-						}
-						else if (paramType == KLogger::PARAM_INT32)
-						{
-							int data = 0;
-							logFile.ReadFile(&data, sizeof(int));
-
-							details = details + KString(data);
-						}
-						else if (paramType == KLogger::PARAM_SHORT16)
-						{
-							unsigned short data = 0;
-							logFile.ReadFile(&data, sizeof(unsigned short));
-
-							details = details + KString((int)data);
-						}
-						else if (paramType == KLogger::PARAM_FLOAT)
-						{
-							float data = 0;
-							logFile.ReadFile(&data, sizeof(float));
-
-							details = details + KString(data, 4, true);
-						}
-						else if (paramType == KLogger::PARAM_DOUBLE)
-						{
-							double data = 0;
-							logFile.ReadFile(&data, sizeof(double));
-
-							details = details + KString((float)data, 4, true);
-						}
-						else if (paramType == KLogger::EVT_END)
-						{
-							break;
-						}
-						else
-						{
-							MessageBoxW(this->GetHWND(), L"Invalid param type defined!", L"Error", MB_ICONERROR);
-							goto DONE;
-						}
-					}
+		if (fileHandle != INVALID_HANDLE_VALUE)
+			::CloseHandle(fileHandle);
 
-					char strMills[5];
-					sprintf(strMills, "%03d", (int)mills); // zero padded mills
-					
-					AddRecord(KString((int)secs) + CONST_TXT(" : ") + KString(strMills, KString::USE_COPY_OF_TEXT), eventType, details);
+		fileHandle = INVALID_HANDLE_VALUE;
+		mappingHandle = NULL;
+		mappedData = NULL;
+	}
 
-					if (threadShouldStop)
-						break;
-				}
-				this->SetText(CONST_TXT("Log Viewer - ") + KString(totalEvents) + CONST_TXT(" Events , ") + KString(errorEventsCount) + CONST_TXT(" Errors , ") + KString(warningEventsCount) + CONST_TXT(" Warnings"));
+	// loads the sidecar index which is saved by a previous run.
+	bool LoadIndexFile(const KString& indexFilePath)
+	{
+		KFile indexFile;
+		if (!KFile::IsFileExists(indexFilePath) || !indexFile.OpenFile(indexFilePath, KFile::KREAD))
+			return false;
+
+		const DWORD indexSize = indexFile.GetFileSize();
+		void* indexData = indexFile.ReadAsData();
+		if (indexData == NULL)
+			return false;
+
+		const bool result = index.deserialize(indexData, indexSize, &parser);
+		::free(indexData);
+
+		return result;
+	}
+
+	void SaveIndexFile(const KString& indexFilePath)
+	{
+		const size_t indexSize = index.getSerializedSize();
+		if (indexSize > 0xFFFFFFFF)
+			return;
+
+		void* indexData = ::malloc(indexSize);
+		if (indexData == NULL)
+			return;
+
+		index.serialize(indexData, parser);
+
+		if (KFile::IsFileExists(indexFilePath))
+			KFile::DeleteFile(indexFilePath);
+
+		KFile indexFile;
+		if (indexFile.OpenFile(indexFilePath, KFile::KWRITE)) // failure is ignored. (e.g. read-only folder)
+			indexFile.WriteFile(indexData, (DWORD)indexSize);
+
+		::free(indexData);
+	}
+
+	void Run()
+	{
+		bool loaded = false;
+
+		if (MapLogFile())
+		{
+			const KString indexFilePath(logFilePath + CONST_TXT(".idx"));
+
+			if (LoadIndexFile(indexFilePath))
+			{
+				loaded = true;
 			}
-			else{
-				MessageBoxW(this->GetHWND(), L"Invalid log file!", L"Error", MB_ICONERROR);
+			else if (index.build(&parser, &threadShouldStop))
+			{
+				SaveIndexFile(indexFilePath);
+				loaded = true;
 			}
 		}
-		else{
-			MessageBoxW(this->GetHWND(), L"Cannot read log file!", L"Error", MB_ICONERROR);
-		}
 
-DONE:
+		// ui thread may wait for this thread. so we cannot use SendMessage.
+		if (!threadShouldStop)
+			::PostMessageW(compHWND, WM_LOG_LOADED, (WPARAM)loaded, (LPARAM)loadID);
+
 		isThreadRunning = false;
 	}
 
-	void AddRecord(KString time, unsigned char eventType, KString details)
+	void OnLogLoaded(bool loaded)
+	{
+		if (!loaded)
+		{
+			CloseLogFile();
+			this->SetText(CONST_TXT("Log Viewer"));
+			MessageBoxW(compHWND, L"Cannot read log file!", L"Error", MB_ICONERROR);
+			return;
+		}
+
+		const size_t eventCount = index.getEventCount();
+		const int rowCount = (eventCount > 0x7FFFFFFF) ? 0x7FFFFFFF : (int)eventCount; // max rows of listview
+
+		gridView.SetRowCount(rowCount);
+
+		this->SetText(CONST_TXT("Log Viewer - ") + KString(rowCount) + CONST_TXT(" Events , ") + KString((int)index.getEventCount(RLOG_EVT_ERROR)) + 
+			CONST_TXT(" Errors , ") + KString((int)index.getEventCount(RLOG_EVT_WARNING)) + CONST_TXT(" Warnings"));
+
+		if (parser.isCorrupted())
+			MessageBoxW(compHWND, L"Log file is damaged! Only the events before the damaged part are shown.", L"Error", MB_ICONERROR);
+	}
+
+	// decodes the row into cache.
+	bool DecodeRow(int rowIndex)
 	{
+		if (rowIndex == cachedRow)
+			return true;
+
+		RLogEvent event;
+		if ((rowIndex < 0) || !index.readEvent(&parser, (size_t)rowIndex, &event))
+			return false;
+
+		const bool hasThreadInfo = (parser.getVersion() >= 2); // v1 files don't have thread id & category
 		const wchar_t *eventTypes[3] = { L"Information", L"Warning", L"Error" };
-		KString eventStr(eventTypes[eventType - 1], KString::STATIC_TEXT_DO_NOT_FREE);
 
-		KString* items[3];
-		items[0] = &time;
-		items[1] = &eventStr;
-		items[2] = &details;
+		char details[2048];
+		parser.formatParams(event, details, sizeof(details));
+
+		::_snwprintf(cachedCells[0], 1024, L"%I64u.%06u", event.timeNs / 1000000, (unsigned int)(event.timeNs % 1000000)); // mills with ns precision
+		::lstrcpynW(cachedCells[1], ((event.type >= RLOG_EVT_INFORMATION) && (event.type <= RLOG_EVT_ERROR)) ? eventTypes[event.type - 1] : L"Unknown", 1024);
+
+		if (hasThreadInfo)
+		{
+			::_snwprintf(cachedCells[2], 1024, L"%u", event.threadID);
+			::_snwprintf(cachedCells[3], 1024, L"%d", (int)event.category);
+		}
+		else
+		{
+			::lstrcpynW(cachedCells[2], L"-", 1024);
+			::lstrcpynW(cachedCells[3], L"-", 1024);
+		}
+
+		if (::MultiByteToWideChar(CP_UTF8, 0, details, -1, cachedCells[4], 1024) == 0)
+			cachedCells[4][1023] = 0; // truncated
+
+		for (int i = 0; i < 4; i++)
+			cachedCells[i][1023] = 0;
 
-		gridView.InsertRecord(items, eventType);
+		cachedEventType = event.type;
+		cachedRow = rowIndex;
+		return true;
+	}
+
+	int GetEventTypeOfRow(int rowIndex)
+	{
+		return DecodeRow(rowIndex) ? cachedEventType : 0;
+	}
+
+	void GetCellText(int rowIndex, int columnIndex, wchar_t* text, int textSize)
+	{
+		if (DecodeRow(rowIndex) && (columnIndex >= 0) && (columnIndex < COL_COUNT))
+			::lstrcpynW(text, cachedCells[columnIndex], textSize);
+		else
+			text[0] = 0;
+	}
+
+	LRESULT WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+	{
+		if (msg == WM_LOG_LOADED)
+		{
+			if ((int)lParam == loadID)
+				OnLogLoaded(wParam != 0);
+			return 0;
+		}
+
+		return KOverlappedWindow::WindowProc(hwnd, msg, wParam, lParam);
 	}
 
 	void OnGridViewItemRightClick(KGridView *gridView)
@@ -295,12 +412,14 @@ DONE:
 		gridView.SetSize(clientWidth, clientHeight);
 		gridView.SetColumnWidth(0, 100);
 		gridView.SetColumnWidth(1, 100);
-		gridView.SetColumnWidth(2, clientWidth - (gridView.GetColumnWidth(0) + gridView.GetColumnWidth(1) + 40));
+		gridView.SetColumnWidth(2, 70);
+		gridView.SetColumnWidth(3, 70);
+		gridView.SetColumnWidth(4, clientWidth - (gridView.GetColumnWidth(0) + gridView.GetColumnWidth(1) + 180));
 	}
 
 	~MainWindow()
 	{
-
+		CloseLogFile();
 	}
 };
 
@@ -0,0 +1,308 @@
+/*
+	Writes a synthetic RLG2 file, checks random row decoding through RLogIndex & the sidecar index round trip,
+	and measures index building. Uses only the C runtime, like RLogParser.h.
+
+	g++ -std=c++17 -O2 -Wall -Wextra RLogIndexTest.cpp -o RLogIndexTest
+	cl /nologo /O2 /std:c++17 RLogIndexTest.cpp
+*/
+
+#include "../src/RLogIndex.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+static int failCount = 0;
+
+#define RLOG_TEST_CHECK(condition) \
+	do { if (!(condition)) { ++failCount; ::printf("FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); } } while (0)
+
+static double getMilliseconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	::QueryPerformanceCounter(&counter);
+	::QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+	timespec time;
+	::clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec * 1000.0 + (double)time.tv_nsec / 1000000.0;
+#endif
+}
+
+static void printBenchmark(const char* name, double milliseconds, size_t operationCount)
+{
+	::printf("  %-40s %10.3f ms %10.2f ns/op\n", name, milliseconds, (milliseconds * 1000000.0) / (double)operationCount);
+}
+
+static unsigned int randomState = 12345;
+
+static unsigned int nextRandom()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+// growing output buffer of the synthetic file.
+struct Writer
+{
+	unsigned char* data;
+	size_t size;
+	size_t capacity;
+
+	template<typename T>
+	void write(T value)
+	{
+		writeBytes(&value, sizeof(T));
+	}
+
+	void writeBytes(const void* bytes, size_t count)
+	{
+		if ((size + count) > capacity)
+		{
+			capacity = (capacity + count) * 2;
+			data = (unsigned char*)::realloc(data, capacity);
+		}
+
+		::memcpy(data + size, bytes, count);
+		size += count;
+	}
+
+	void writeString(const char* text) // byte|data
+	{
+		const unsigned char length = (unsigned char)::strlen(text);
+		write(length);
+		writeBytes(text, length);
+	}
+
+	void writeFormatDefinition(unsigned int formatID, const char* text)
+	{
+		write((unsigned char)RLOG_EVT_FORMAT_DEFINITION);
+		write(formatID);
+		write((unsigned short)::strlen(text));
+		writeBytes(text, ::strlen(text));
+	}
+};
+
+static const char* formatTexts[] = { "row {} of {}", "half {}", "unused {}" };
+
+static unsigned char getEventType(size_t row) { return (unsigned char)(RLOG_EVT_INFORMATION + ((row * 7) % 3)); }
+
+static unsigned long long getEventTime(size_t row) { return (unsigned long long)row * 1000 + 7; }
+
+// params are chosen by row % 4. the text is what RLogParser::formatParams should produce.
+static int getExpectedText(size_t row, size_t eventCount, char* text, int textSize)
+{
+	switch (row % 4)
+	{
+	case 0:
+		return ::snprintf(text, textSize, "row=%d", (int)row);
+	case 1:
+		return ::snprintf(text, textSize, "row %d of %lld", (int)row, (long long)eventCount);
+	case 2:
+		return ::snprintf(text, textSize, "half %.4f", (double)row * 0.5);
+	default:
+		return ::snprintf(text, textSize, "%d/%.4f", (int)(row & 0x7FFF), 0.25f);
+	}
+}
+
+static void writeEvent(Writer* writer, size_t row, size_t eventCount)
+{
+	writer->write(getEventType(row));
+	writer->write((unsigned char)(row & 7)); // category
+	writer->write((unsigned int)(row % 5)); // thread id
+	writer->write(getEventTime(row));
+
+	switch (row % 4)
+	{
+	case 0:
+		writer->write((unsigned char)RLOG_PARAM_STRING);
+		writer->writeString("row=");
+		writer->write((unsigned char)RLOG_PARAM_INT32);
+		writer->write((int)row);
+		break;
+	case 1:
+		writer->write((unsigned char)RLOG_PARAM_FORMAT);
+		writer->write((unsigned int)0);
+		writer->write((unsigned char)2);
+		writer->write((unsigned char)RLOG_PARAM_INT32);
+		writer->write((unsigned char)RLOG_PARAM_INT64);
+		writer->write((int)row);
+		writer->write((long long)eventCount);
+		break;
+	case 2:
+		writer->write((unsigned char)RLOG_PARAM_FORMAT);
+		writer->write((unsigned int)1);
+		writer->write((unsigned char)1);
+		writer->write((unsigned char)RLOG_PARAM_DOUBLE);
+		writer->write((double)row * 0.5);
+		break;
+	default:
+		writer->write((unsigned char)RLOG_PARAM_SHORT16);
+		writer->write((unsigned short)(row & 0x7FFF));
+		writer->write((unsigned char)RLOG_PARAM_STRING);
+		writer->writeString("/");
+		writer->write((unsigned char)RLOG_PARAM_FLOAT);
+		writer->write(0.25f);
+		break;
+	}
+
+	writer->write((unsigned char)RLOG_EVT_END);
+}
+
+static bool writeLogFile(const char* path, size_t eventCount)
+{
+	Writer writer = { NULL, 0, 0 };
+	writer.writeBytes("RLG2", 4);
+	writer.write((unsigned int)eventCount);
+
+	writer.writeFormatDefinition(0, formatTexts[0]);
+	writer.writeFormatDefinition(1, formatTexts[1]);
+
+	for (size_t row = 0; row < eventCount; row++)
+	{
+		if (row == (eventCount / 2)) // format definitions can appear between events
+			writer.writeFormatDefinition(2, formatTexts[2]);
+
+		writeEvent(&writer, row, eventCount);
+	}
+
+	FILE* file = ::fopen(path, "wb");
+	bool result = (file != NULL) && (::fwrite(writer.data, 1, writer.size, file) == writer.size);
+	if (file)
+		result = (::fclose(file) == 0) && result;
+
+	::free(writer.data);
+	return result;
+}
+
+static unsigned char* readLogFile(const char* path, size_t* size)
+{
+	FILE* file = ::fopen(path, "rb");
+	if (file == NULL)
+		return NULL;
+
+	::fseek(file, 0, SEEK_END);
+	*size = (size_t)::ftell(file);
+	::fseek(file, 0, SEEK_SET);
+
+	unsigned char* data = (unsigned char*)::malloc(*size);
+	if (data && (::fread(data, 1, *size, file) != *size))
+	{
+		::free(data);
+		data = NULL;
+	}
+
+	::fclose(file);
+	return data;
+}
+
+static bool checkRow(RLogIndex* index, RLogParser* parser, size_t row, size_t eventCount)
+{
+	RLogEvent event;
+	if (!index->readEvent(parser, row, &event))
+		return false;
+
+	char text[256], expectedText[256];
+	parser->formatParams(event, text, sizeof(text));
+	getExpectedText(row, eventCount, expectedText, sizeof(expectedText));
+
+	return (event.type == getEventType(row)) && (event.category == (row & 7)) && (event.threadID == (row % 5)) &&
+		(event.timeNs == getEventTime(row)) && (::strcmp(text, expectedText) == 0);
+}
+
+// random rows, then a sequential run which continues without seeking.
+static int countBadRows(RLogIndex* index, RLogParser* parser, size_t eventCount, int randomRowCount)
+{
+	int badCount = 0;
+	for (int i = 0; i < randomRowCount; i++)
+		badCount += checkRow(index, parser, nextRandom() % eventCount, eventCount) ? 0 : 1;
+
+	for (size_t row = eventCount - 100; row < eventCount; row++)
+		badCount += checkRow(index, parser, row, eventCount) ? 0 : 1;
+
+	return badCount;
+}
+
+int main()
+{
+	const char* path = "RLogIndexTest.rlog";
+	const size_t eventCount = 1000000;
+
+	RLOG_TEST_CHECK(writeLogFile(path, eventCount));
+
+	size_t fileSize = 0;
+	unsigned char* fileData = readLogFile(path, &fileSize);
+	RLOG_TEST_CHECK(fileData != NULL);
+	if (fileData == NULL)
+		return 1;
+
+	RLogParser parser;
+	RLOG_TEST_CHECK(parser.open(fileData, fileSize) && (parser.getVersion() == 2));
+	RLOG_TEST_CHECK(parser.getEventCount() == eventCount);
+
+	RLogIndex index;
+	double startTime = getMilliseconds();
+	RLOG_TEST_CHECK(index.build(&parser));
+	const double buildTime = getMilliseconds() - startTime;
+
+	RLOG_TEST_CHECK(index.getEventCount() == eventCount);
+	RLOG_TEST_CHECK((index.getEventCount(RLOG_EVT_INFORMATION) + index.getEventCount(RLOG_EVT_WARNING) +
+		index.getEventCount(RLOG_EVT_ERROR)) == eventCount);
+	RLOG_TEST_CHECK(index.getEventCount(RLOG_EVT_WARNING) == ((eventCount + 1) / 3)); // rows 1, 4, 7...
+
+	RLogEvent event;
+	RLOG_TEST_CHECK(!index.readEvent(&parser, eventCount, &event));
+	RLOG_TEST_CHECK(parser.getFormat(2).text != NULL);
+
+	startTime = getMilliseconds();
+	RLOG_TEST_CHECK(countBadRows(&index, &parser, eventCount, 100000) == 0);
+	const double randomReadTime = getMilliseconds() - startTime;
+
+	// sidecar index round trip
+	const size_t serializedSize = index.getSerializedSize();
+	unsigned char* serialized = (unsigned char*)::malloc(serializedSize);
+	index.serialize(serialized, parser);
+
+	RLogParser loadedParser;
+	RLogIndex loadedIndex;
+	RLOG_TEST_CHECK(loadedParser.open(fileData, fileSize));
+
+	startTime = getMilliseconds();
+	RLOG_TEST_CHECK(loadedIndex.deserialize(serialized, serializedSize, &loadedParser));
+	const double loadTime = getMilliseconds() - startTime;
+
+	RLOG_TEST_CHECK(loadedIndex.getEventCount() == eventCount);
+	RLOG_TEST_CHECK(loadedIndex.getEventCount(RLOG_EVT_ERROR) == index.getEventCount(RLOG_EVT_ERROR));
+	RLOG_TEST_CHECK(loadedParser.getFormat(2).text != NULL); // formats are loaded with the index
+	RLOG_TEST_CHECK(countBadRows(&loadedIndex, &loadedParser, eventCount, 10000) == 0);
+
+	// an index of another file or a damaged one is rejected.
+	RLogIndex rejectedIndex;
+	RLogParser otherParser;
+	RLOG_TEST_CHECK(otherParser.open(fileData, fileSize - 1));
+	RLOG_TEST_CHECK(!rejectedIndex.deserialize(serialized, serializedSize, &otherParser));
+	RLOG_TEST_CHECK(!rejectedIndex.deserialize(serialized, serializedSize - 1, &loadedParser));
+
+	serialized[serializedSize - 1] ^= 0x80; // last format offset points past the file
+	RLOG_TEST_CHECK(!rejectedIndex.deserialize(serialized, serializedSize, &loadedParser));
+	RLOG_TEST_CHECK(rejectedIndex.getEventCount() == 0);
+
+	::printf("%d events, %.1f MB:\n", (int)eventCount, (double)fileSize / (1024.0 * 1024.0));
+	printBenchmark("RLogIndex::build (per event)", buildTime, eventCount);
+	printBenchmark("RLogIndex::readEvent, random rows", randomReadTime, 100000 + 100);
+	printBenchmark("RLogIndex::deserialize (per event)", loadTime, eventCount);
+	::printf("  build speed %.1f MB/s, index size %d KB\n", ((double)fileSize / (1024.0 * 1024.0)) / (buildTime / 1000.0), (int)(serializedSize / 1024));
+
+	::free(serialized);
+	::free(fileData);
+	::remove(path);
+
+	::printf("RLogIndexTest: %s\n", (failCount == 0) ? "passed" : "FAILED");
+	return (failCount == 0) ? 0 : 1;
+}